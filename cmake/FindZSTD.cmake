@@ -0,0 +1,25 @@
+# - Try to find zstd
+# Once done this will define
+#  ZSTD_FOUND - System has zstd
+#  ZSTD_INCLUDE_DIRS - The zstd include directories
+#  ZSTD_LIBRARIES - The libraries needed to use zstd
+
+FIND_LIBRARY(ZSTD_LIBRARIES
+    NAMES zstd
+)
+
+FIND_PATH(ZSTD_INCLUDE_DIRS
+    NAMES zstd.h
+)
+
+INCLUDE(FindPackageHandleStandardArgs)
+FIND_PACKAGE_HANDLE_STANDARD_ARGS(ZSTD DEFAULT_MSG
+    ZSTD_LIBRARIES
+    ZSTD_INCLUDE_DIRS
+)
+
+# Hide these vars from ccmake GUI
+MARK_AS_ADVANCED(
+	ZSTD_LIBRARIES
+	ZSTD_INCLUDE_DIRS
+)
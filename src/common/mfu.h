@@ -20,7 +20,6 @@ extern "C" {
 #define _XOPEN_SOURCE 500
 #endif
 #include <limits.h>
-#include <lustre/lustreapi.h>
 
 #include "mfu_util.h"
 #include "mfu_path.h"
@@ -31,10 +30,11 @@ extern "C" {
 #include "mfu_proc.h"
 #include "mfu_progress.h"
 #include "mfu_bz2.h"
+#include "mfu_zero.h"
+#include "mfu_layout.h"
+#include "mfu_perf.h"
+#include "mfu_trace.h"
 
-#define OST_NUMBER 24
-extern uint64_t num_tasks_per_ost[OST_NUMBER]; 
- 
 #endif /* MFU_H */
 
 /* enable C++ codes to include this header directly */
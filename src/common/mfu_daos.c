@@ -2375,11 +2375,10 @@ static int mfu_daos_flist_obj_sync(
     flist_t* flist = (flist_t*) bflist;
 
     uint64_t i;
-    const elem_t* p = flist->list_head;
-    for (i = 0; i < flist->list_count; i++) {
+    for (i = 0; i < flist->list_rows; i++) {
         daos_obj_id_t oid;
-        oid.lo = p->obj_id_lo;
-        oid.hi = p->obj_id_hi;
+        oid.lo = flist->col_obj_id_lo[i];
+        oid.hi = flist->col_obj_id_hi[i];
 
         /* Copy this object */
         rc = mfu_daos_obj_sync(da, src_coh, dst_coh, oid,
@@ -2388,8 +2387,6 @@ static int mfu_daos_flist_obj_sync(
             MFU_LOG(MFU_LOG_ERR, "mfu_daos_obj_sync return with error");
             return rc;
         }
-
-        p = p->next;
     }
 
     return rc;
@@ -12,11 +12,13 @@
 #include <stdlib.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <string.h>
 #include <unistd.h>
 #include <getopt.h>
 #include <time.h> /* asctime / localtime */
 #include <regex.h>
+#include <pthread.h>
 
 /* These headers are needed to query the Lustre MDS for stat
  * information.  This information may be incomplete, but it
@@ -151,7 +153,7 @@ static size_t list_elem_pack2(void* buf, int detail, uint64_t chars, const elem_
     mfu_pack_uint32(&ptr, (uint32_t) chars);
 
     /* copy in file name */
-    char* file = elem->file;
+    const char* file = elem->file;
     if (file != NULL) {
         strcpy(ptr, file);
     }
@@ -204,8 +206,8 @@ static size_t list_elem_unpack2(const void* buf, elem_t* elem)
     const char* file = ptr;
     ptr += chars;
 
-    /* copy path */
-    elem->file = MFU_STRDUP(file);
+    /* name is copied from the buffer when the element is inserted */
+    elem->file = file;
 
     /* set depth */
     elem->depth = mfu_flist_compute_depth(file);
@@ -256,183 +258,694 @@ void mfu_flist_increase(mfu_flist* pbflist)
     return;
 }
 
-/* add new element to running list index, allocates additional
- * capactiy for index if needed */
-static void list_index_append(flist_t* flist, elem_t* elem)
+/* names are copied into blocks that double in size from the
+ * smallest to the largest block size, a name longer than that
+ * gets a block of its own */
+#define NAME_BLOCK_MIN (4 * 1024)
+#define NAME_BLOCK_MAX (1024 * 1024)
+
+/* block of the name arena, blocks are linked newest first */
+typedef struct name_block {
+    struct name_block* next; /* next older block */
+    size_t size;             /* number of bytes for names */
+    size_t used;             /* number of bytes handed out */
+    char data[];             /* space for names */
+} name_block_t;
+
+/* copy the first n chars of name into the name arena of the list,
+ * names are never moved or freed one at a time, so the copy is valid
+ * until the list is freed */
+static const char* list_name_copyn(flist_t* flist, const char* name, size_t n)
+{
+    /* start a new block if the name does not fit in the current one */
+    size_t len = n + 1;
+    name_block_t* block = flist->names;
+    if (block == NULL || block->size - block->used < len) {
+        size_t size = NAME_BLOCK_MIN;
+        if (block != NULL) {
+            size = block->size * 2;
+            if (size > NAME_BLOCK_MAX) {
+                size = NAME_BLOCK_MAX;
+            }
+        }
+        if (size < len) {
+            size = len;
+        }
+
+        name_block_t* newblock = (name_block_t*) MFU_MALLOC(sizeof(name_block_t) + size);
+        newblock->next = block;
+        newblock->size = size;
+        newblock->used = 0;
+        flist->names = newblock;
+        block = newblock;
+    }
+
+    char* copy = block->data + block->used;
+    memcpy(copy, name, n);
+    copy[n] = '\0';
+    block->used += len;
+    return copy;
+}
+
+/* copy name into the name arena of the list */
+static const char* list_name_copy(flist_t* flist, const char* name)
 {
-    /* if we have no capacity for the index,
-     * initialize with a small array */
-    uint64_t cap = flist->list_cap;
-    if (cap == 0) {
-        /* have no index at all, initialize it */
-        uint64_t new_capacity = 32;
-        size_t index_size = new_capacity * sizeof(elem_t*);
-        flist->list_index = (elem_t**) MFU_MALLOC(index_size);
-        flist->list_cap = new_capacity;
+    return list_name_copyn(flist, name, strlen(name));
+}
+
+/* resize column to hold count items of given size */
+static void* list_column_resize(void* col, uint64_t count, size_t size)
+{
+    size_t bytes = (size_t) count * size;
+    void* newcol = realloc(col, bytes);
+    if (newcol == NULL) {
+        MFU_ABORT(-1, "Failed to allocate %llu bytes for file list",
+            (unsigned long long) bytes);
     }
+    return newcol;
+}
 
-    /* check that our index has space before we add it */
-    uint64_t count = flist->list_count;
-    if (count == cap) {
-        /* we have exhausted the current capacity of the index array,
-         * allocate a new memory region that is double the size */
-        uint64_t new_capacity = cap * 2;
-        size_t index_size = new_capacity * sizeof(elem_t*);
-        elem_t** new_index = (elem_t**) MFU_MALLOC(index_size);
+/* set to 1 to store names of new lists by directory and basename */
+int mfu_flist_compress_names = 0;
 
-        /* copy over existing list */
-        memcpy(new_index, flist->list_index, count * sizeof(elem_t*));
+/* read MFU_FLIST_COMPRESS to set mfu_flist_compress_names */
+void mfu_flist_init_names(void)
+{
+    char varname[] = "MFU_FLIST_COMPRESS";
+    const char* value = getenv(varname);
+    if (value != NULL) {
+        if (strcmp(value, "0") == 0 || strcmp(value, "1") == 0) {
+            mfu_flist_compress_names = atoi(value);
+        } else if (mfu_rank == 0) {
+            MFU_LOG(MFU_LOG_WARN, "Ignoring invalid %s: `%s'", varname, value);
+        }
+    }
+}
 
-        /* free the old index memory and assign the new one */
-        mfu_free(&flist->list_index);
-        flist->list_index = new_index;
-        flist->list_cap   = new_capacity;
+/* hash a component given the id of its parent directory */
+static uint64_t dirs_hash(uint32_t parent, const char* comp, size_t len)
+{
+    /* FNV-1a */
+    uint64_t h = 14695981039346656037ULL ^ (uint64_t) parent;
+    size_t i;
+    for (i = 0; i < len; i++) {
+        h ^= (uint64_t)(unsigned char) comp[i];
+        h *= 1099511628211ULL;
     }
+    return h;
+}
 
-    /* append the item to the index */
-    flist->list_index[count - 1] = elem;
+/* add directory id to hash table, which has a free slot */
+static void dirs_table_add(flist_dirs_t* dirs, uint32_t id)
+{
+    const char* comp = dirs->comp[id];
+    uint64_t mask = dirs->table_cap - 1;
+    uint64_t slot = dirs_hash(dirs->parent[id], comp, strlen(comp)) & mask;
+    while (dirs->table[slot] != FLIST_DIR_NONE) {
+        slot = (slot + 1) & mask;
+    }
+    dirs->table[slot] = id;
+}
 
-    return;
+/* return id of the directory with given parent and last component,
+ * adding it if it is not in the table, len is the strlen() of the
+ * full path of the directory */
+static uint32_t dirs_get(flist_t* flist, uint32_t parent, const char* comp, size_t comp_len, size_t len)
+{
+    flist_dirs_t* dirs = &flist->dirs;
+
+    /* keep the hash table at most half full */
+    if (dirs->count * 2 >= dirs->table_cap) {
+        uint64_t cap = (dirs->table_cap == 0) ? 1024 : dirs->table_cap * 2;
+        mfu_free(&dirs->table);
+        dirs->table = (uint32_t*) MFU_MALLOC(cap * sizeof(uint32_t));
+        dirs->table_cap = cap;
+
+        uint64_t i;
+        for (i = 0; i < cap; i++) {
+            dirs->table[i] = FLIST_DIR_NONE;
+        }
+        for (i = 0; i < dirs->count; i++) {
+            dirs_table_add(dirs, (uint32_t) i);
+        }
+    }
+
+    /* look for the directory */
+    uint64_t mask = dirs->table_cap - 1;
+    uint64_t slot = dirs_hash(parent, comp, comp_len) & mask;
+    while (dirs->table[slot] != FLIST_DIR_NONE) {
+        uint32_t id = dirs->table[slot];
+        const char* c = dirs->comp[id];
+        if (dirs->parent[id] == parent && strncmp(c, comp, comp_len) == 0 && c[comp_len] == '\0') {
+            return id;
+        }
+        slot = (slot + 1) & mask;
+    }
+
+    /* not found, add a new directory */
+    if (dirs->count >= (uint64_t) FLIST_DIR_NONE || len >= (size_t) UINT32_MAX) {
+        MFU_ABORT(-1, "Too many directories to compress names of file list");
+    }
+    if (dirs->count == dirs->cap) {
+        uint64_t cap = (dirs->cap == 0) ? 256 : dirs->cap * 2;
+        dirs->parent = (uint32_t*)    list_column_resize(dirs->parent, cap, sizeof(uint32_t));
+        dirs->len    = (uint32_t*)    list_column_resize(dirs->len,    cap, sizeof(uint32_t));
+        dirs->comp   = (const char**) list_column_resize(dirs->comp,   cap, sizeof(char*));
+        dirs->cap = cap;
+    }
+
+    /* copy component into the name arena */
+    uint32_t id = (uint32_t) dirs->count;
+    dirs->parent[id] = parent;
+    dirs->len[id]    = (uint32_t) len;
+    dirs->comp[id]   = list_name_copyn(flist, comp, comp_len);
+    dirs->table[slot] = id;
+    dirs->count++;
+
+    return id;
 }
 
-/* append element to tail of linked list */
-void mfu_flist_insert_elem(flist_t* flist, elem_t* elem)
+/* return id of directory given its full path of len chars,
+ * adding it and any missing parents to the table */
+static uint32_t dirs_lookup(flist_t* flist, const char* dir, size_t len)
 {
-    /* set head if this is the first item */
-    if (flist->list_head == NULL) {
-        flist->list_head = elem;
+    flist_dirs_t* dirs = &flist->dirs;
+
+    /* items are mostly inserted with their siblings, so first
+     * check whether this is the directory of the last lookup */
+    if (dirs->last != NULL && dirs->last_len == len && memcmp(dirs->last, dir, len) == 0) {
+        return dirs->last_id;
     }
 
-    /* update last element to point to this new element */
-    elem_t* tail = flist->list_tail;
-    if (tail != NULL) {
-        tail->next = elem;
+    /* otherwise walk the components from the first one */
+    uint32_t id = FLIST_DIR_NONE;
+    size_t start = 0;
+    while (1) {
+        size_t end = start;
+        while (end < len && dir[end] != '/') {
+            end++;
+        }
+        id = dirs_get(flist, id, dir + start, end - start, end);
+        if (end == len) {
+            break;
+        }
+        start = end + 1;
     }
 
-    /* make this element the new tail */
-    flist->list_tail = elem;
-    elem->next = NULL;
+    /* remember this directory for the next lookup */
+    if (dirs->last_cap < len + 1) {
+        mfu_free(&dirs->last);
+        dirs->last_cap = len + 1;
+        dirs->last = (char*) MFU_MALLOC(dirs->last_cap);
+    }
+    memcpy(dirs->last, dir, len);
+    dirs->last[len] = '\0';
+    dirs->last_len = len;
+    dirs->last_id  = id;
 
-    /* increase list count by one */
-    flist->list_count++;
+    return id;
+}
+
+/* free directory table */
+static void dirs_free(flist_dirs_t* dirs)
+{
+    mfu_free(&dirs->parent);
+    mfu_free(&dirs->len);
+    mfu_free(&dirs->comp);
+    mfu_free(&dirs->table);
+    mfu_free(&dirs->last);
+    dirs->count     = 0;
+    dirs->cap       = 0;
+    dirs->table_cap = 0;
+    dirs->last_len  = 0;
+    dirs->last_cap  = 0;
+    dirs->last_id   = FLIST_DIR_NONE;
+}
+
+/* return name of item at index idx of a list whose columns
+ * point into a cache file mapping */
+static const char* list_name_mapped(const flist_t* flist, uint64_t idx)
+{
+    uint64_t off = flist->map.name_off[idx];
+    if (off == FLIST_MAP_NAME_NONE) {
+        return NULL;
+    }
+    return flist->map.names + off;
+}
+
+/* return 1 if item at index idx has no name */
+static int list_name_null(const flist_t* flist, uint64_t idx)
+{
+    if (flist->map.name_off != NULL) {
+        return (flist->map.name_off[idx] == FLIST_MAP_NAME_NONE);
+    }
+    return (flist->col_file[idx] == NULL);
+}
+
+/* store name of item at index idx, which may be NULL */
+static void list_name_set(flist_t* flist, uint64_t idx, const char* name)
+{
+    /* names of a mapped list are read only */
+    mfu_flist_unmap(flist);
+
+    if (name == NULL) {
+        flist->col_file[idx] = NULL;
+        if (flist->compress) {
+            flist->col_dir[idx] = FLIST_DIR_NONE;
+        }
+        return;
+    }
+
+    if (! flist->compress) {
+        flist->col_file[idx] = list_name_copy(flist, name);
+        return;
+    }
+
+    /* store directory and basename, or the whole name if it has no '/' */
+    const char* slash = strrchr(name, '/');
+    if (slash == NULL) {
+        flist->col_dir[idx]  = FLIST_DIR_NONE;
+        flist->col_file[idx] = list_name_copy(flist, name);
+    } else {
+        flist->col_dir[idx]  = dirs_lookup(flist, name, (size_t)(slash - name));
+        flist->col_file[idx] = list_name_copy(flist, slash + 1);
+    }
+}
+
+/* return strlen() of name of item at index idx, which is not NULL */
+static size_t list_name_length(const flist_t* flist, uint64_t idx)
+{
+    if (flist->map.name_off != NULL) {
+        return strlen(list_name_mapped(flist, idx));
+    }
+
+    size_t len = strlen(flist->col_file[idx]);
+    if (flist->compress && flist->col_dir[idx] != FLIST_DIR_NONE) {
+        len += (size_t) flist->dirs.len[flist->col_dir[idx]] + 1;
+    }
+    return len;
+}
+
+/* number of full paths each thread holds at once for lists
+ * with compressed names */
+#define NAME_CACHE_SIZE (8)
+
+/* full paths built by one thread */
+typedef struct {
+    char*  bufs[NAME_CACHE_SIZE];
+    size_t sizes[NAME_CACHE_SIZE];
+    int    next;
+} name_cache_t;
+
+/* cache of the calling thread, a key frees it when the thread exits */
+static __thread name_cache_t* name_cache = NULL;
+static pthread_key_t  name_cache_key;
+static pthread_once_t name_cache_once = PTHREAD_ONCE_INIT;
+
+static void name_cache_delete(void* arg)
+{
+    name_cache_t* cache = (name_cache_t*) arg;
+    int i;
+    for (i = 0; i < NAME_CACHE_SIZE; i++) {
+        mfu_free(&cache->bufs[i]);
+    }
+    mfu_free(&cache);
+}
+
+static void name_cache_key_create(void)
+{
+    pthread_key_create(&name_cache_key, name_cache_delete);
+}
+
+/* return cache of the calling thread, allocating it on first use */
+static name_cache_t* name_cache_get(void)
+{
+    if (name_cache == NULL) {
+        pthread_once(&name_cache_once, name_cache_key_create);
+        name_cache = (name_cache_t*) MFU_MALLOC(sizeof(name_cache_t));
+        memset(name_cache, 0, sizeof(name_cache_t));
+        pthread_setspecific(name_cache_key, name_cache);
+    }
+    return name_cache;
+}
+
+void mfu_flist_finalize_names(void)
+{
+    /* key destructors do not run for the main thread,
+     * so it frees its cache here */
+    if (name_cache != NULL) {
+        pthread_setspecific(name_cache_key, NULL);
+        name_cache_delete(name_cache);
+        name_cache = NULL;
+    }
+}
+
+/* return name of item at index idx, builds the full path in the
+ * per-thread cache if names are compressed */
+static const char* list_name_get(const flist_t* flist, uint64_t idx)
+{
+    if (flist->map.name_off != NULL) {
+        return list_name_mapped(flist, idx);
+    }
+
+    const char* base = flist->col_file[idx];
+    if (! flist->compress || base == NULL || flist->col_dir[idx] == FLIST_DIR_NONE) {
+        return base;
+    }
+
+    /* take the oldest entry of the cache, grow it if needed */
+    size_t len = list_name_length(flist, idx);
+    name_cache_t* cache = name_cache_get();
+    int slot = cache->next;
+    cache->next = (cache->next + 1) % NAME_CACHE_SIZE;
+    if (cache->sizes[slot] < len + 1) {
+        mfu_free(&cache->bufs[slot]);
+        cache->sizes[slot] = (len + 1 > 4096) ? len + 1 : 4096;
+        cache->bufs[slot] = (char*) MFU_MALLOC(cache->sizes[slot]);
+    }
+    char* buf = cache->bufs[slot];
+
+    /* fill in from the end, basename first, then each directory
+     * up to the first component */
+    char* ptr = buf + len;
+    *ptr = '\0';
 
-    /* append address of element to our index */
-    list_index_append(flist, elem);
+    size_t n = strlen(base);
+    ptr -= n;
+    memcpy(ptr, base, n);
+
+    const flist_dirs_t* dirs = &flist->dirs;
+    uint32_t id = flist->col_dir[idx];
+    while (id != FLIST_DIR_NONE) {
+        ptr--;
+        *ptr = '/';
+
+        const char* comp = dirs->comp[id];
+        n = strlen(comp);
+        ptr -= n;
+        memcpy(ptr, comp, n);
+
+        id = dirs->parent[id];
+    }
+
+    return buf;
+}
+
+/* resize columns to have space for cap items */
+static void list_columns_alloc(flist_t* flist, uint64_t cap)
+{
+    flist->col_file       = (const char**) list_column_resize(flist->col_file, cap, sizeof(char*));
+    flist->col_depth      = (int*)      list_column_resize(flist->col_depth,      cap, sizeof(int));
+    flist->col_type       = (uint8_t*)  list_column_resize(flist->col_type,       cap, sizeof(uint8_t));
+    flist->col_detail     = (uint8_t*)  list_column_resize(flist->col_detail,     cap, sizeof(uint8_t));
+    flist->col_mode       = (uint32_t*) list_column_resize(flist->col_mode,       cap, sizeof(uint32_t));
+    flist->col_uid        = (uint64_t*) list_column_resize(flist->col_uid,        cap, sizeof(uint64_t));
+    flist->col_gid        = (uint64_t*) list_column_resize(flist->col_gid,        cap, sizeof(uint64_t));
+    flist->col_atime      = (uint64_t*) list_column_resize(flist->col_atime,      cap, sizeof(uint64_t));
+    flist->col_atime_nsec = (uint32_t*) list_column_resize(flist->col_atime_nsec, cap, sizeof(uint32_t));
+    flist->col_mtime      = (uint64_t*) list_column_resize(flist->col_mtime,      cap, sizeof(uint64_t));
+    flist->col_mtime_nsec = (uint32_t*) list_column_resize(flist->col_mtime_nsec, cap, sizeof(uint32_t));
+    flist->col_ctime      = (uint64_t*) list_column_resize(flist->col_ctime,      cap, sizeof(uint64_t));
+    flist->col_ctime_nsec = (uint32_t*) list_column_resize(flist->col_ctime_nsec, cap, sizeof(uint32_t));
+    flist->col_size       = (uint64_t*) list_column_resize(flist->col_size,       cap, sizeof(uint64_t));
+    if (flist->compress) {
+        flist->col_dir    = (uint32_t*) list_column_resize(flist->col_dir,        cap, sizeof(uint32_t));
+    }
+#ifdef DAOS_SUPPORT
+    flist->col_obj_id_lo  = (uint64_t*) list_column_resize(flist->col_obj_id_lo,  cap, sizeof(uint64_t));
+    flist->col_obj_id_hi  = (uint64_t*) list_column_resize(flist->col_obj_id_hi,  cap, sizeof(uint64_t));
+#endif
+
+    flist->list_cap = cap;
 
     return;
 }
 
-/* insert copy of specified element into list */
-static void list_insert_copy(flist_t* flist, elem_t* src)
+/* ensure columns have space for one more item, doubling
+ * their capacity when full */
+static void list_columns_grow(flist_t* flist)
 {
-    /* create new element */
-    elem_t* elem = (elem_t*) MFU_MALLOC(sizeof(elem_t));
+    /* columns of a mapped list can not grow in place */
+    mfu_flist_unmap(flist);
 
-    /* copy values from source */
-    elem->file       = MFU_STRDUP(src->file);
-    elem->depth      = src->depth;
-    elem->type       = src->type;
-    elem->detail     = src->detail;
-    elem->mode       = src->mode;
-    elem->uid        = src->uid;
-    elem->gid        = src->gid;
-    elem->atime      = src->atime;
-    elem->atime_nsec = src->atime_nsec;
-    elem->mtime      = src->mtime;
-    elem->mtime_nsec = src->mtime_nsec;
-    elem->ctime      = src->ctime;
-    elem->ctime_nsec = src->ctime_nsec;
-    elem->size       = src->size;
+    if (flist->list_rows < flist->list_cap) {
+        return;
+    }
 
-    /* append element to tail of linked list */
-    mfu_flist_insert_elem(flist, elem);
+    uint64_t cap = flist->list_cap * 2;
+    if (cap == 0) {
+        cap = 32;
+    }
+    list_columns_alloc(flist, cap);
 
     return;
 }
 
+void mfu_flist_unmap(flist_t* flist)
+{
+    if (flist->map.name_off == NULL) {
+        return;
+    }
+
+    /* hold on to the mapped columns while we allocate new ones */
+    flist_t mapped = *flist;
+    const uint64_t* name_off = flist->map.name_off;
+    flist->map.name_off   = NULL;
+    flist->col_file       = NULL;
+    flist->col_dir        = NULL;
+    flist->col_depth      = NULL;
+    flist->col_type       = NULL;
+    flist->col_detail     = NULL;
+    flist->col_mode       = NULL;
+    flist->col_uid        = NULL;
+    flist->col_gid        = NULL;
+    flist->col_atime      = NULL;
+    flist->col_atime_nsec = NULL;
+    flist->col_mtime      = NULL;
+    flist->col_mtime_nsec = NULL;
+    flist->col_ctime      = NULL;
+    flist->col_ctime_nsec = NULL;
+    flist->col_size       = NULL;
+    flist->col_obj_id_lo  = NULL;
+    flist->col_obj_id_hi  = NULL;
+
+    uint64_t rows = flist->list_rows;
+    uint64_t cap = (rows > 32) ? rows : 32;
+    list_columns_alloc(flist, cap);
+
+    size_t n = (size_t) rows;
+    memcpy(flist->col_depth,      mapped.col_depth,      n * sizeof(int));
+    memcpy(flist->col_type,       mapped.col_type,       n * sizeof(uint8_t));
+    memcpy(flist->col_detail,     mapped.col_detail,     n * sizeof(uint8_t));
+    memcpy(flist->col_mode,       mapped.col_mode,       n * sizeof(uint32_t));
+    memcpy(flist->col_uid,        mapped.col_uid,        n * sizeof(uint64_t));
+    memcpy(flist->col_gid,        mapped.col_gid,        n * sizeof(uint64_t));
+    memcpy(flist->col_atime,      mapped.col_atime,      n * sizeof(uint64_t));
+    memcpy(flist->col_atime_nsec, mapped.col_atime_nsec, n * sizeof(uint32_t));
+    memcpy(flist->col_mtime,      mapped.col_mtime,      n * sizeof(uint64_t));
+    memcpy(flist->col_mtime_nsec, mapped.col_mtime_nsec, n * sizeof(uint32_t));
+    memcpy(flist->col_ctime,      mapped.col_ctime,      n * sizeof(uint64_t));
+    memcpy(flist->col_ctime_nsec, mapped.col_ctime_nsec, n * sizeof(uint32_t));
+    memcpy(flist->col_size,       mapped.col_size,       n * sizeof(uint64_t));
+#ifdef DAOS_SUPPORT
+    memset(flist->col_obj_id_lo, 0, n * sizeof(uint64_t));
+    memset(flist->col_obj_id_hi, 0, n * sizeof(uint64_t));
+#endif
+
+    /* copy names into the arena */
+    uint64_t idx;
+    for (idx = 0; idx < rows; idx++) {
+        uint64_t off = name_off[idx];
+        const char* name = (off == FLIST_MAP_NAME_NONE) ? NULL : flist->map.names + off;
+        list_name_set(flist, idx, name);
+    }
+
+    return;
+}
+
+/* append a copy of the values in elem to the list */
+void mfu_flist_insert_elem(flist_t* flist, const elem_t* elem)
+{
+    list_columns_grow(flist);
+
+    /* copy values into next row of columns, mode and nanoseconds
+     * are stored in 32 bits since they always fit */
+    uint64_t idx = flist->list_rows;
+    list_name_set(flist, idx, elem->file);
+    flist->col_depth[idx]      = elem->depth;
+    flist->col_type[idx]       = (uint8_t)  elem->type;
+    flist->col_detail[idx]     = (uint8_t)  elem->detail;
+    flist->col_mode[idx]       = (uint32_t) elem->mode;
+    flist->col_uid[idx]        = elem->uid;
+    flist->col_gid[idx]        = elem->gid;
+    flist->col_atime[idx]      = elem->atime;
+    flist->col_atime_nsec[idx] = (uint32_t) elem->atime_nsec;
+    flist->col_mtime[idx]      = elem->mtime;
+    flist->col_mtime_nsec[idx] = (uint32_t) elem->mtime_nsec;
+    flist->col_ctime[idx]      = elem->ctime;
+    flist->col_ctime_nsec[idx] = (uint32_t) elem->ctime_nsec;
+    flist->col_size[idx]       = elem->size;
+#ifdef DAOS_SUPPORT
+    flist->col_obj_id_lo[idx]  = elem->obj_id_lo;
+    flist->col_obj_id_hi[idx]  = elem->obj_id_hi;
+#endif
+
+    /* increase list count by one */
+    flist->list_rows++;
+    flist->list_count++;
+
+    return;
+}
+
+/* copy values of item at index idx into elem, elem->file points
+ * into the list and is valid until the list is freed, except on a
+ * list with compressed names, where it points into a per-thread cache
+ * and is only valid for the next 7 name lookups by the thread */
+void mfu_flist_get_elem(const flist_t* flist, uint64_t idx, elem_t* elem)
+{
+    elem->file       = list_name_get(flist, idx);
+    elem->depth      = flist->col_depth[idx];
+    elem->type       = (mfu_filetype) flist->col_type[idx];
+    elem->detail     = (int) flist->col_detail[idx];
+    elem->mode       = flist->col_mode[idx];
+    elem->uid        = flist->col_uid[idx];
+    elem->gid        = flist->col_gid[idx];
+    elem->atime      = flist->col_atime[idx];
+    elem->atime_nsec = flist->col_atime_nsec[idx];
+    elem->mtime      = flist->col_mtime[idx];
+    elem->mtime_nsec = flist->col_mtime_nsec[idx];
+    elem->ctime      = flist->col_ctime[idx];
+    elem->ctime_nsec = flist->col_ctime_nsec[idx];
+    elem->size       = flist->col_size[idx];
+    elem->obj_id_lo  = (flist->col_obj_id_lo != NULL) ? flist->col_obj_id_lo[idx] : 0;
+    elem->obj_id_hi  = (flist->col_obj_id_hi != NULL) ? flist->col_obj_id_hi[idx] : 0;
+    return;
+}
+
 /* insert a file given its mode and optional stat data */
 void mfu_flist_insert_stat(flist_t* flist, const char* fpath, mode_t mode, const struct stat* sb)
 {
-    /* create new element to record file path, file type, and stat info */
-    elem_t* elem = (elem_t*) MFU_MALLOC(sizeof(elem_t));
+    /* record file path, file type, and stat info */
+    elem_t elem;
 
-    /* copy path */
-    elem->file = MFU_STRDUP(fpath);
+    /* name is copied on insert */
+    elem.file = fpath;
 
     /* set depth */
-    elem->depth = mfu_flist_compute_depth(fpath);
+    elem.depth = mfu_flist_compute_depth(fpath);
 
     /* set file type */
-    elem->type = mfu_flist_mode_to_filetype(mode);
+    elem.type = mfu_flist_mode_to_filetype(mode);
 
     /* copy stat info */
     if (sb != NULL) {
-        elem->detail = 1;
-        elem->mode  = (uint64_t) sb->st_mode;
-        elem->uid   = (uint64_t) sb->st_uid;
-        elem->gid   = (uint64_t) sb->st_gid;
+        elem.detail = 1;
+        elem.mode  = (uint64_t) sb->st_mode;
+        elem.uid   = (uint64_t) sb->st_uid;
+        elem.gid   = (uint64_t) sb->st_gid;
 
         uint64_t secs, nsecs;
         mfu_stat_get_atimes(sb, &secs, &nsecs);
-        elem->atime      = secs;
-        elem->atime_nsec = nsecs;
+        elem.atime      = secs;
+        elem.atime_nsec = nsecs;
 
         mfu_stat_get_mtimes(sb, &secs, &nsecs);
-        elem->mtime      = secs;
-        elem->mtime_nsec = nsecs;
+        elem.mtime      = secs;
+        elem.mtime_nsec = nsecs;
 
         mfu_stat_get_ctimes(sb, &secs, &nsecs);
-        elem->ctime      = secs;
-        elem->ctime_nsec = nsecs;
+        elem.ctime      = secs;
+        elem.ctime_nsec = nsecs;
 
-        elem->size  = (uint64_t) sb->st_size;
+        elem.size  = (uint64_t) sb->st_size;
 
         /* TODO: link to user and group names? */
     }
     else {
-        elem->detail = 0;
+        elem.detail     = 0;
+        elem.mode       = 0;
+        elem.uid        = 0;
+        elem.gid        = 0;
+        elem.atime      = 0;
+        elem.atime_nsec = 0;
+        elem.mtime      = 0;
+        elem.mtime_nsec = 0;
+        elem.ctime      = 0;
+        elem.ctime_nsec = 0;
+        elem.size       = 0;
     }
 
-    /* append element to tail of linked list */
-    mfu_flist_insert_elem(flist, elem);
+    elem.obj_id_lo = 0;
+    elem.obj_id_hi = 0;
+
+    /* append element to list */
+    mfu_flist_insert_elem(flist, &elem);
 
     return;
 }
 
-/* delete linked list of stat items */
+/* free columns and name arena of list */
 static void list_delete(flist_t* flist)
 {
-    elem_t* current = flist->list_head;
-    while (current != NULL) {
-        elem_t* next = current->next;
-        mfu_free(&current->file);
-        mfu_free(&current);
-        current = next;
-    }
-    flist->list_count = 0;
-    flist->list_head  = NULL;
-    flist->list_tail  = NULL;
+    /* columns of a mapped list are released with the mapping */
+    if (flist->map.name_off != NULL) {
+        flist->col_depth      = NULL;
+        flist->col_type       = NULL;
+        flist->col_detail     = NULL;
+        flist->col_mode       = NULL;
+        flist->col_uid        = NULL;
+        flist->col_gid        = NULL;
+        flist->col_atime      = NULL;
+        flist->col_atime_nsec = NULL;
+        flist->col_mtime      = NULL;
+        flist->col_mtime_nsec = NULL;
+        flist->col_ctime      = NULL;
+        flist->col_ctime_nsec = NULL;
+        flist->col_size       = NULL;
+        flist->map.name_off   = NULL;
+    }
+    if (flist->map.addr != NULL) {
+        munmap(flist->map.addr, flist->map.len);
+        flist->map.addr  = NULL;
+        flist->map.len   = 0;
+        flist->map.names = NULL;
+    }
+
+    name_block_t* block = flist->names;
+    while (block != NULL) {
+        name_block_t* next = block->next;
+        mfu_free(&block);
+        block = next;
+    }
+    flist->names = NULL;
+
+    dirs_free(&flist->dirs);
+
+    mfu_free(&flist->col_file);
+    mfu_free(&flist->col_dir);
+    mfu_free(&flist->col_depth);
+    mfu_free(&flist->col_type);
+    mfu_free(&flist->col_detail);
+    mfu_free(&flist->col_mode);
+    mfu_free(&flist->col_uid);
+    mfu_free(&flist->col_gid);
+    mfu_free(&flist->col_atime);
+    mfu_free(&flist->col_atime_nsec);
+    mfu_free(&flist->col_mtime);
+    mfu_free(&flist->col_mtime_nsec);
+    mfu_free(&flist->col_ctime);
+    mfu_free(&flist->col_ctime_nsec);
+    mfu_free(&flist->col_size);
+    mfu_free(&flist->col_obj_id_lo);
+    mfu_free(&flist->col_obj_id_hi);
 
-    /* delete the cached index */
-    mfu_free(&flist->list_index);
-    flist->list_cap = 0;
+    flist->list_count = 0;
+    flist->list_rows  = 0;
+    flist->list_cap   = 0;
 
     return;
 }
 
-/* given an index, return pointer to that file element,
- * NULL if index is not in range */
-static elem_t* list_get_elem(flist_t* flist, uint64_t idx)
-{
-    /* return pointer to element if index is within range */
-    uint64_t max = flist->list_count;
-    if (idx < max) {
-        elem_t* elem = flist->list_index[idx];
-        return elem;
-    }
-    return NULL;
-}
-
 static void list_compute_summary(flist_t* flist)
 {
     /* initialize summary values */
@@ -472,25 +985,22 @@ static void list_compute_summary(flist_t* flist)
     int min_depth = -1;
     int max_depth = -1;
     uint64_t max_name = 0;
-    elem_t* current = flist->list_head;
-    while (current != NULL) {
-        if (current->file != NULL) {
-            uint64_t len = (uint64_t)(strlen(current->file) + 1);
+    uint64_t idx;
+    for (idx = 0; idx < flist->list_rows; idx++) {
+        if (! list_name_null(flist, idx)) {
+            uint64_t len = (uint64_t)(list_name_length(flist, idx) + 1);
             if (len > max_name) {
                 max_name = len;
             }
-	}
+        }
 
-        int depth = current->depth;
+        int depth = flist->col_depth[idx];
         if (depth < min_depth || min_depth == -1) {
             min_depth = depth;
         }
         if (depth > max_depth || max_depth == -1) {
             max_depth = depth;
         }
-
-        /* go to next item */
-        current = current->next;
     }
 
     /* get global maximums */
@@ -542,12 +1052,48 @@ mfu_flist mfu_flist_new()
     flist->detail = 0;
     flist->total_files = 0;
 
-    /* initialize linked list */
-    flist->list_count = 0;
-    flist->list_head  = NULL;
-    flist->list_tail  = NULL;
-    flist->list_index = NULL;
-    flist->list_cap   = 0;
+    /* initialize columns, these are allocated on first insert */
+    flist->list_count     = 0;
+    flist->list_rows      = 0;
+    flist->list_cap       = 0;
+    flist->col_file       = NULL;
+    flist->col_dir        = NULL;
+    flist->col_depth      = NULL;
+    flist->col_type       = NULL;
+    flist->col_detail     = NULL;
+    flist->col_mode       = NULL;
+    flist->col_uid        = NULL;
+    flist->col_gid        = NULL;
+    flist->col_atime      = NULL;
+    flist->col_atime_nsec = NULL;
+    flist->col_mtime      = NULL;
+    flist->col_mtime_nsec = NULL;
+    flist->col_ctime      = NULL;
+    flist->col_ctime_nsec = NULL;
+    flist->col_size       = NULL;
+    flist->col_obj_id_lo  = NULL;
+    flist->col_obj_id_hi  = NULL;
+    flist->names          = NULL;
+
+    /* initialize directory table if names are compressed */
+    flist->compress        = mfu_flist_compress_names;
+    flist->dirs.count      = 0;
+    flist->dirs.cap        = 0;
+    flist->dirs.parent     = NULL;
+    flist->dirs.len        = NULL;
+    flist->dirs.comp       = NULL;
+    flist->dirs.table      = NULL;
+    flist->dirs.table_cap  = 0;
+    flist->dirs.last       = NULL;
+    flist->dirs.last_len   = 0;
+    flist->dirs.last_cap   = 0;
+    flist->dirs.last_id    = FLIST_DIR_NONE;
+
+    /* lists are only mapped when read from a cache file */
+    flist->map.addr     = NULL;
+    flist->map.len      = 0;
+    flist->map.names    = NULL;
+    flist->map.name_off = NULL;
 
     /* initialize user and group structures */
     mfu_flist_usrgrp_init(flist);
@@ -562,7 +1108,7 @@ void mfu_flist_free(mfu_flist* pbflist)
     /* convert handle to flist_t */
     flist_t* flist = *(flist_t**)pbflist;
 
-    /* delete linked list */
+    /* delete columns and names */
     list_delete(flist);
 
     /* free user and group structures */
@@ -772,22 +1318,20 @@ void mfu_flist_set_detail (mfu_flist bflist, int detail)
 
 uint64_t mfu_flist_file_get_oid_low(mfu_flist bflist, uint64_t idx)
 {
-    uint64_t oid_low;
+    uint64_t oid_low = 0;
     flist_t* flist = (flist_t*) bflist;
-    elem_t* elem = list_get_elem(flist, idx);
-    if (elem != NULL) {
-        oid_low = elem->obj_id_lo;
+    if (idx < flist->list_rows && flist->col_obj_id_lo != NULL) {
+        oid_low = flist->col_obj_id_lo[idx];
     }
     return oid_low;
 }
 
 uint64_t mfu_flist_file_get_oid_high(mfu_flist bflist, uint64_t idx)
 {
-    uint64_t oid_high;
+    uint64_t oid_high = 0;
     flist_t* flist = (flist_t*) bflist;
-    elem_t* elem = list_get_elem(flist, idx);
-    if (elem != NULL) {
-        oid_high = elem->obj_id_hi;
+    if (idx < flist->list_rows && flist->col_obj_id_hi != NULL) {
+        oid_high = flist->col_obj_id_hi[idx];
     }
     return oid_high;
 }
@@ -796,9 +1340,8 @@ const char* mfu_flist_file_get_name(mfu_flist bflist, uint64_t idx)
 {
     const char* name = NULL;
     flist_t* flist = (flist_t*) bflist;
-    elem_t* elem = list_get_elem(flist, idx);
-    if (elem != NULL) {
-        name = elem->file;
+    if (idx < flist->list_rows) {
+        name = list_name_get(flist, idx);
     }
     return name;
 }
@@ -807,9 +1350,8 @@ int mfu_flist_file_get_depth(mfu_flist bflist, uint64_t idx)
 {
     int depth = -1;
     flist_t* flist = (flist_t*) bflist;
-    elem_t* elem = list_get_elem(flist, idx);
-    if (elem != NULL) {
-        depth = elem->depth;
+    if (idx < flist->list_rows) {
+        depth = flist->col_depth[idx];
     }
     return depth;
 }
@@ -818,9 +1360,8 @@ mfu_filetype mfu_flist_file_get_type(mfu_flist bflist, uint64_t idx)
 {
     mfu_filetype type = MFU_TYPE_NULL;
     flist_t* flist = (flist_t*) bflist;
-    elem_t* elem = list_get_elem(flist, idx);
-    if (elem != NULL) {
-        type = elem->type;
+    if (idx < flist->list_rows) {
+        type = (mfu_filetype) flist->col_type[idx];
     }
     return type;
 }
@@ -829,9 +1370,8 @@ uint64_t mfu_flist_file_get_mode(mfu_flist bflist, uint64_t idx)
 {
     uint64_t mode = 0;
     flist_t* flist = (flist_t*) bflist;
-    elem_t* elem = list_get_elem(flist, idx);
-    if (elem != NULL && flist->detail > 0) {
-        mode = elem->mode;
+    if (idx < flist->list_rows && flist->detail) {
+        mode = flist->col_mode[idx];
     }
     return mode;
 }
@@ -889,9 +1429,8 @@ uint64_t mfu_flist_file_get_uid(mfu_flist bflist, uint64_t idx)
 {
     uint64_t ret = (uint64_t) - 1;
     flist_t* flist = (flist_t*) bflist;
-    elem_t* elem = list_get_elem(flist, idx);
-    if (elem != NULL && flist->detail) {
-        ret = elem->uid;
+    if (idx < flist->list_rows && flist->detail) {
+        ret = flist->col_uid[idx];
     }
     return ret;
 }
@@ -900,9 +1439,8 @@ uint64_t mfu_flist_file_get_gid(mfu_flist bflist, uint64_t idx)
 {
     uint64_t ret = (uint64_t) - 1;
     flist_t* flist = (flist_t*) bflist;
-    elem_t* elem = list_get_elem(flist, idx);
-    if (elem != NULL && flist->detail) {
-        ret = elem->gid;
+    if (idx < flist->list_rows && flist->detail) {
+        ret = flist->col_gid[idx];
     }
     return ret;
 }
@@ -911,9 +1449,8 @@ uint64_t mfu_flist_file_get_atime(mfu_flist bflist, uint64_t idx)
 {
     uint64_t ret = (uint64_t) - 1;
     flist_t* flist = (flist_t*) bflist;
-    elem_t* elem = list_get_elem(flist, idx);
-    if (elem != NULL && flist->detail) {
-        ret = elem->atime;
+    if (idx < flist->list_rows && flist->detail) {
+        ret = flist->col_atime[idx];
     }
     return ret;
 }
@@ -922,9 +1459,8 @@ uint64_t mfu_flist_file_get_atime_nsec(mfu_flist bflist, uint64_t idx)
 {
     uint64_t ret = (uint64_t) - 1;
     flist_t* flist = (flist_t*) bflist;
-    elem_t* elem = list_get_elem(flist, idx);
-    if (elem != NULL && flist->detail) {
-        ret = elem->atime_nsec;
+    if (idx < flist->list_rows && flist->detail) {
+        ret = flist->col_atime_nsec[idx];
     }
     return ret;
 }
@@ -933,9 +1469,8 @@ uint64_t mfu_flist_file_get_mtime(mfu_flist bflist, uint64_t idx)
 {
     uint64_t ret = (uint64_t) - 1;
     flist_t* flist = (flist_t*) bflist;
-    elem_t* elem = list_get_elem(flist, idx);
-    if (elem != NULL && flist->detail) {
-        ret = elem->mtime;
+    if (idx < flist->list_rows && flist->detail) {
+        ret = flist->col_mtime[idx];
     }
     return ret;
 }
@@ -944,9 +1479,8 @@ uint64_t mfu_flist_file_get_mtime_nsec(mfu_flist bflist, uint64_t idx)
 {
     uint64_t ret = (uint64_t) - 1;
     flist_t* flist = (flist_t*) bflist;
-    elem_t* elem = list_get_elem(flist, idx);
-    if (elem != NULL && flist->detail) {
-        ret = elem->mtime_nsec;
+    if (idx < flist->list_rows && flist->detail) {
+        ret = flist->col_mtime_nsec[idx];
     }
     return ret;
 }
@@ -955,9 +1489,8 @@ uint64_t mfu_flist_file_get_ctime(mfu_flist bflist, uint64_t idx)
 {
     uint64_t ret = (uint64_t) - 1;
     flist_t* flist = (flist_t*) bflist;
-    elem_t* elem = list_get_elem(flist, idx);
-    if (elem != NULL && flist->detail) {
-        ret = elem->ctime;
+    if (idx < flist->list_rows && flist->detail) {
+        ret = flist->col_ctime[idx];
     }
     return ret;
 }
@@ -966,9 +1499,8 @@ uint64_t mfu_flist_file_get_ctime_nsec(mfu_flist bflist, uint64_t idx)
 {
     uint64_t ret = (uint64_t) - 1;
     flist_t* flist = (flist_t*) bflist;
-    elem_t* elem = list_get_elem(flist, idx);
-    if (elem != NULL && flist->detail) {
-        ret = elem->ctime_nsec;
+    if (idx < flist->list_rows && flist->detail) {
+        ret = flist->col_ctime_nsec[idx];
     }
     return ret;
 }
@@ -977,9 +1509,8 @@ uint64_t mfu_flist_file_get_size(mfu_flist bflist, uint64_t idx)
 {
     uint64_t ret = (uint64_t) - 1;
     flist_t* flist = (flist_t*) bflist;
-    elem_t* elem = list_get_elem(flist, idx);
-    if (elem != NULL && flist->detail) {
-        ret = elem->size;
+    if (idx < flist->list_rows && flist->detail) {
+        ret = flist->col_size[idx];
     }
     return ret;
 }
@@ -1009,14 +1540,11 @@ const char* mfu_flist_file_get_groupname(mfu_flist bflist, uint64_t idx)
 void mfu_flist_file_set_name(mfu_flist bflist, uint64_t idx, const char* name)
 {
     flist_t* flist = (flist_t*) bflist;
-    elem_t* elem = list_get_elem(flist, idx);
-    if (elem != NULL) {
-        /* free existing name if there is one */
-        mfu_free(&elem->file);
-
-        /* set new name and compute depth */
-        elem->file = MFU_STRDUP(name);
-        elem->depth = mfu_flist_compute_depth(name);
+    if (idx < flist->list_rows) {
+        /* copy new name and compute depth, the space of the
+         * existing name is released when the list is freed */
+        list_name_set(flist, idx, name);
+        flist->col_depth[idx] = mfu_flist_compute_depth(name);
     }
     return;
 }
@@ -1025,10 +1553,11 @@ void mfu_flist_file_set_name(mfu_flist bflist, uint64_t idx, const char* name)
 void mfu_flist_file_set_oid(mfu_flist bflist, uint64_t idx, daos_obj_id_t oid)
 {
     flist_t* flist = (flist_t*) bflist;
-    elem_t* elem = list_get_elem(flist, idx);
-    if (elem != NULL) {
-        elem->obj_id_lo = oid.lo;
-        elem->obj_id_hi = oid.hi;
+    if (idx < flist->list_rows) {
+        /* mapped lists have no object id columns */
+        mfu_flist_unmap(flist);
+        flist->col_obj_id_lo[idx] = oid.lo;
+        flist->col_obj_id_hi[idx] = oid.hi;
     }
     return;
 }
@@ -1036,13 +1565,10 @@ void mfu_flist_file_set_oid(mfu_flist bflist, uint64_t idx, daos_obj_id_t oid)
 void mfu_flist_file_set_cont(mfu_flist bflist, uint64_t idx, const char* name)
 {
     flist_t* flist = (flist_t*) bflist;
-    elem_t* elem = list_get_elem(flist, idx);
-    if (elem != NULL) {
-        /* free existing name if there is one */
-        mfu_free(&elem->file);
-
-        /* set new name */
-        elem->file = MFU_STRDUP(name);
+    if (idx < flist->list_rows) {
+        /* copy new name, the space of the existing name
+         * is released when the list is freed */
+        list_name_set(flist, idx, name);
     }
     return;
 }
@@ -1051,9 +1577,8 @@ void mfu_flist_file_set_cont(mfu_flist bflist, uint64_t idx, const char* name)
 void mfu_flist_file_set_type(mfu_flist bflist, uint64_t idx, mfu_filetype type)
 {
     flist_t* flist = (flist_t*) bflist;
-    elem_t* elem = list_get_elem(flist, idx);
-    if (elem != NULL) {
-        elem->type = type;
+    if (idx < flist->list_rows) {
+        flist->col_type[idx] = (uint8_t) type;
     }
     return;
 }
@@ -1061,9 +1586,8 @@ void mfu_flist_file_set_type(mfu_flist bflist, uint64_t idx, mfu_filetype type)
 void mfu_flist_file_set_detail(mfu_flist bflist, uint64_t idx, int detail)
 {
     flist_t* flist = (flist_t*) bflist;
-    elem_t* elem = list_get_elem(flist, idx);
-    if (elem != NULL) {
-        elem->detail = detail;
+    if (idx < flist->list_rows) {
+        flist->col_detail[idx] = (uint8_t) detail;
     }
     return;
 }
@@ -1071,9 +1595,8 @@ void mfu_flist_file_set_detail(mfu_flist bflist, uint64_t idx, int detail)
 void mfu_flist_file_set_mode(mfu_flist bflist, uint64_t idx, uint64_t mode)
 {
     flist_t* flist = (flist_t*) bflist;
-    elem_t* elem = list_get_elem(flist, idx);
-    if (elem != NULL) {
-        elem->mode = mode;
+    if (idx < flist->list_rows) {
+        flist->col_mode[idx] = (uint32_t) mode;
     }
     return;
 }
@@ -1081,9 +1604,8 @@ void mfu_flist_file_set_mode(mfu_flist bflist, uint64_t idx, uint64_t mode)
 void mfu_flist_file_set_uid(mfu_flist bflist, uint64_t idx, uint64_t uid)
 {
     flist_t* flist = (flist_t*) bflist;
-    elem_t* elem = list_get_elem(flist, idx);
-    if (elem != NULL) {
-        elem->uid = uid;
+    if (idx < flist->list_rows) {
+        flist->col_uid[idx] = uid;
     }
     return;
 }
@@ -1091,9 +1613,8 @@ void mfu_flist_file_set_uid(mfu_flist bflist, uint64_t idx, uint64_t uid)
 void mfu_flist_file_set_gid(mfu_flist bflist, uint64_t idx, uint64_t gid)
 {
     flist_t* flist = (flist_t*) bflist;
-    elem_t* elem = list_get_elem(flist, idx);
-    if (elem != NULL) {
-        elem->gid = gid;
+    if (idx < flist->list_rows) {
+        flist->col_gid[idx] = gid;
     }
     return;
 }
@@ -1101,9 +1622,8 @@ void mfu_flist_file_set_gid(mfu_flist bflist, uint64_t idx, uint64_t gid)
 void mfu_flist_file_set_atime(mfu_flist bflist, uint64_t idx, uint64_t atime)
 {
     flist_t* flist = (flist_t*) bflist;
-    elem_t* elem = list_get_elem(flist, idx);
-    if (elem != NULL) {
-        elem->atime = atime;
+    if (idx < flist->list_rows) {
+        flist->col_atime[idx] = atime;
     }
     return;
 }
@@ -1111,9 +1631,8 @@ void mfu_flist_file_set_atime(mfu_flist bflist, uint64_t idx, uint64_t atime)
 void mfu_flist_file_set_atime_nsec(mfu_flist bflist, uint64_t idx, uint64_t atime_nsec)
 {
     flist_t* flist = (flist_t*) bflist;
-    elem_t* elem = list_get_elem(flist, idx);
-    if (elem != NULL) {
-        elem->atime_nsec = atime_nsec;
+    if (idx < flist->list_rows) {
+        flist->col_atime_nsec[idx] = (uint32_t) atime_nsec;
     }
     return;
 }
@@ -1121,9 +1640,8 @@ void mfu_flist_file_set_atime_nsec(mfu_flist bflist, uint64_t idx, uint64_t atim
 void mfu_flist_file_set_mtime(mfu_flist bflist, uint64_t idx, uint64_t mtime)
 {
     flist_t* flist = (flist_t*) bflist;
-    elem_t* elem = list_get_elem(flist, idx);
-    if (elem != NULL) {
-        elem->mtime = mtime;
+    if (idx < flist->list_rows) {
+        flist->col_mtime[idx] = mtime;
     }
     return;
 }
@@ -1131,9 +1649,8 @@ void mfu_flist_file_set_mtime(mfu_flist bflist, uint64_t idx, uint64_t mtime)
 void mfu_flist_file_set_mtime_nsec(mfu_flist bflist, uint64_t idx, uint64_t mtime_nsec)
 {
     flist_t* flist = (flist_t*) bflist;
-    elem_t* elem = list_get_elem(flist, idx);
-    if (elem != NULL) {
-        elem->mtime_nsec = mtime_nsec;
+    if (idx < flist->list_rows) {
+        flist->col_mtime_nsec[idx] = (uint32_t) mtime_nsec;
     }
     return;
 }
@@ -1141,9 +1658,8 @@ void mfu_flist_file_set_mtime_nsec(mfu_flist bflist, uint64_t idx, uint64_t mtim
 void mfu_flist_file_set_ctime(mfu_flist bflist, uint64_t idx, uint64_t ctime)
 {
     flist_t* flist = (flist_t*) bflist;
-    elem_t* elem = list_get_elem(flist, idx);
-    if (elem != NULL) {
-        elem->ctime = ctime;
+    if (idx < flist->list_rows) {
+        flist->col_ctime[idx] = ctime;
     }
     return;
 }
@@ -1151,9 +1667,8 @@ void mfu_flist_file_set_ctime(mfu_flist bflist, uint64_t idx, uint64_t ctime)
 void mfu_flist_file_set_ctime_nsec(mfu_flist bflist, uint64_t idx, uint64_t ctime_nsec)
 {
     flist_t* flist = (flist_t*) bflist;
-    elem_t* elem = list_get_elem(flist, idx);
-    if (elem != NULL) {
-        elem->ctime_nsec = ctime_nsec;
+    if (idx < flist->list_rows) {
+        flist->col_ctime_nsec[idx] = (uint32_t) ctime_nsec;
     }
     return;
 }
@@ -1161,9 +1676,8 @@ void mfu_flist_file_set_ctime_nsec(mfu_flist bflist, uint64_t idx, uint64_t ctim
 void mfu_flist_file_set_size(mfu_flist bflist, uint64_t idx, uint64_t size)
 {
     flist_t* flist = (flist_t*) bflist;
-    elem_t* elem = list_get_elem(flist, idx);
-    if (elem != NULL) {
-        elem->size = size;
+    if (idx < flist->list_rows) {
+        flist->col_size[idx] = size;
     }
     return;
 }
@@ -1289,10 +1803,11 @@ void mfu_flist_file_copy(mfu_flist bsrc, uint64_t idx, mfu_flist bdst)
 {
     /* convert handle to flist_t */
     flist_t* flist = (flist_t*) bsrc;
-    elem_t* elem = list_get_elem(flist, idx);
-    if (elem != NULL) {
+    if (idx < flist->list_rows) {
         flist_t* dstlist = (flist_t*) bdst;
-        list_insert_copy(dstlist, elem);
+        elem_t elem;
+        mfu_flist_get_elem(flist, idx, &elem);
+        mfu_flist_insert_elem(dstlist, &elem);
     }
     return;
 }
@@ -1308,9 +1823,10 @@ size_t mfu_flist_file_pack(void* buf, mfu_flist bflist, uint64_t idx)
 {
     /* convert handle to flist_t */
     flist_t* flist = (flist_t*) bflist;
-    elem_t* elem = list_get_elem(flist, idx);
-    if (elem != NULL) {
-        size_t size = list_elem_pack2(buf, flist->detail, flist->max_file_name, elem);
+    if (idx < flist->list_rows) {
+        elem_t elem;
+        mfu_flist_get_elem(flist, idx, &elem);
+        size_t size = list_elem_pack2(buf, flist->detail, flist->max_file_name, &elem);
         return size;
     }
     return 0;
@@ -1320,9 +1836,10 @@ size_t mfu_flist_file_unpack(const void* buf, mfu_flist bflist)
 {
     /* convert handle to flist_t */
     flist_t* flist = (flist_t*) bflist;
-    elem_t* elem = (elem_t*) MFU_MALLOC(sizeof(elem_t));
-    size_t size = list_elem_unpack2(buf, elem);
-    mfu_flist_insert_elem(flist, elem);
+    elem_t elem;
+    memset(&elem, 0, sizeof(elem));
+    size_t size = list_elem_unpack2(buf, &elem);
+    mfu_flist_insert_elem(flist, &elem);
     return size;
 }
 
@@ -1332,36 +1849,33 @@ uint64_t mfu_flist_file_create(mfu_flist bflist)
     /* convert handle to flist_t */
     flist_t* flist = (flist_t*) bflist;
 
-    elem_t* elem = (elem_t*) MFU_MALLOC(sizeof(elem_t));
-
     /* initialize all fields */
-    elem->file       = NULL;
-    elem->depth      = -1;
-    elem->type       = MFU_TYPE_NULL;
-
-    elem->detail     = 0;
-    elem->mode       = 0;
-    elem->uid        = getuid();
-    elem->gid        = getgid();
-    elem->atime      = 0;
-    elem->atime_nsec = 0;
-    elem->mtime      = 0;
-    elem->mtime_nsec = 0;
-    elem->ctime      = 0;
-    elem->ctime_nsec = 0;
-    elem->size       = 0;
+    elem_t elem;
+    elem.file       = NULL;
+    elem.depth      = -1;
+    elem.type       = MFU_TYPE_NULL;
+
+    elem.detail     = 0;
+    elem.mode       = 0;
+    elem.uid        = getuid();
+    elem.gid        = getgid();
+    elem.atime      = 0;
+    elem.atime_nsec = 0;
+    elem.mtime      = 0;
+    elem.mtime_nsec = 0;
+    elem.ctime      = 0;
+    elem.ctime_nsec = 0;
+    elem.size       = 0;
 
     /* for DAOS */
-#ifdef DAOS_SUPPORT
-    elem->obj_id_lo = 0;
-    elem->obj_id_hi = 0;
-#endif
+    elem.obj_id_lo = 0;
+    elem.obj_id_hi = 0;
 
-    /* append element to tail of linked list */
-    mfu_flist_insert_elem(flist, elem);
+    /* append element to list */
+    mfu_flist_insert_elem(flist, &elem);
 
     /* return index to element we just added */
-    uint64_t index = flist->list_count - 1;
+    uint64_t index = flist->list_rows - 1;
     return index;
 }
 
@@ -63,10 +63,22 @@ extern "C" {
 #define MFU_CHUNK_SIZE_STR "1MB"
 #define MFU_CHUNK_SIZE (1*1024*1024)
 
+/* default limit on bytes in a chunk that combines stripes */
+#define MFU_COALESCE_SIZE_STR "64MB"
+#define MFU_COALESCE_SIZE (64*1024*1024)
+
 /* default buffer size to read/write data to file system */
 #define MFU_BUFFER_SIZE_STR "1MB"
 #define MFU_BUFFER_SIZE (1*1024*1024)
 
+/* default number of open files cached for each of source and destination */
+#define MFU_FD_CACHE_SIZE_STR "16"
+#define MFU_FD_CACHE_SIZE (16)
+
+/* default number of items in each batch of a streaming copy */
+#define MFU_STREAM_BATCH_SIZE_STR "1000000"
+#define MFU_STREAM_BATCH_SIZE (1000000)
+
 /*
  * FIXME: Is this description correct?
  *
@@ -177,6 +189,19 @@ void mfu_perms_free(mfu_perms** pperms);
  * Functions to create and free lists
  ****************************************/
 
+/* set to 1 to store the names of lists created after by directory and
+ * basename, which saves memory when many items share long directory
+ * paths, initialized from MFU_FLIST_COMPRESS in mfu_init, names of
+ * such lists are only valid briefly, see mfu_flist_file_get_name */
+extern int mfu_flist_compress_names;
+
+/* read MFU_FLIST_COMPRESS to set mfu_flist_compress_names */
+void mfu_flist_init_names(void);
+
+/* free the full paths built for the calling thread
+ * from compressed names, called from mfu_finalize */
+void mfu_flist_finalize_names(void);
+
 /* create new, empty file list */
 mfu_flist mfu_flist_new(void);
 
@@ -216,6 +241,20 @@ void mfu_flist_walk_param_paths(
     mfu_file_t* mfu_file          /* IN  - I/O filesystem functions to use during the walk */
 );
 
+/* read directories in dirs from index *next onward without recursing,
+ * insert an item with stat data for each entry into flist, stop once
+ * flist holds at least max_items items, and set *next to the first
+ * directory not yet read, not collective and makes no MPI calls,
+ * so it may run on a helper thread, caller summarizes flist */
+void mfu_flist_walk_dirs(
+    mfu_flist dirs,             /* IN  - list of directories to read */
+    uint64_t* next,             /* IN/OUT - index of next directory to read */
+    uint64_t max_items,         /* IN  - stop reading once flist has this many items */
+    mfu_walk_opts_t* walk_opts, /* IN  - functions to perform during the walk */
+    mfu_flist flist,            /* OUT - flist to insert items into */
+    mfu_file_t* mfu_file        /* IN  - I/O filesystem functions to use during the walk */
+);
+
 /* skip function pointer: given a path input, along with user-provided
  * arguments, compute whether to enqueue this file in output list of
  * mfu_flist_stat, return 1 if file should be skipped, 0 if not. */
@@ -287,6 +326,20 @@ void mfu_flist_read_cache(
     mfu_flist flist
 );
 
+/* zstd level from 1 to 19 at which mfu_flist_write_cache compresses
+ * lists with stat data, 0 to not compress, initialized from
+ * MFU_CACHE_COMPRESS in mfu_init */
+extern int mfu_flist_cache_compress;
+
+/* set to 1 to have mfu_flist_write_cache write lists with stat data
+ * in version 5, which readers map in place, rather than the portable
+ * version 4, initialized from MFU_CACHE_MAP in mfu_init */
+extern int mfu_flist_cache_map;
+
+/* read MFU_CACHE_MAP and MFU_CACHE_COMPRESS to set
+ * mfu_flist_cache_map and mfu_flist_cache_compress */
+void mfu_flist_init_cache(void);
+
 /* write file list to file */
 void mfu_flist_write_cache(
     const char* name,
@@ -391,6 +444,13 @@ mfu_filetype mfu_flist_mode_to_filetype(mode_t mode);
 /* always set */
 uint64_t mfu_flist_file_get_oid_low(mfu_flist flist, uint64_t index);
 uint64_t mfu_flist_file_get_oid_high(mfu_flist flist, uint64_t index);
+/* returns the full path of the item, on a list created with
+ * MFU_FLIST_COMPRESS=1 the path is built in a small per-thread cache
+ * of 8 entries, so the pointer is only valid until the same thread
+ * gets 7 more names, from any list.  Other list calls that take the
+ * name of an item, e.g., mfu_flist_file_copy, count toward those.
+ * Copy the name with MFU_STRDUP to hold it any longer.  On other lists
+ * the pointer is valid until the list is freed. */
 const char* mfu_flist_file_get_name(mfu_flist flist, uint64_t index);
 int mfu_flist_file_get_depth(mfu_flist flist, uint64_t index);
 mfu_filetype mfu_flist_file_get_type(mfu_flist flist, uint64_t index);
@@ -492,6 +552,22 @@ int mfu_flist_copy(
     mfu_file_t* mfu_dst_file        /* IN - I/O filesystem functions to use for copy of dst */
 );
 
+/* walk source paths and copy items to destination as they are found,
+ * reading directories in steps of about batch_files items, each step
+ * is read on a helper thread while the previous one is copied, so
+ * that copying starts early and overlaps the walk, and only the
+ * directories are held for the whole copy,
+ * returns 0 on success -1 on error */
+int mfu_flist_copy_stream(
+    int numpaths,                   /* IN - number of source paths */
+    const mfu_param_path* paths,    /* IN - array of source pathts */
+    const mfu_param_path* destpath, /* IN - destination path */
+    mfu_walk_opts_t* walk_opts,     /* IN - options to be used during walk */
+    mfu_copy_opts_t* mfu_copy_opts, /* IN - options to be used during copy */
+    mfu_file_t* mfu_src_file,       /* IN - I/O filesystem functions to use for copy of src */
+    mfu_file_t* mfu_dst_file        /* IN - I/O filesystem functions to use for copy of dst */
+);
+
 /* link items in list from source paths to destination,
  * each item in source list must come from the
  * source path, returns 0 on success -1 on error */
@@ -544,6 +620,13 @@ void mfu_flist_mkdir(
     mfu_create_opts_t* opts
 );
 
+/* create a regular file at name striped according to the lustre_stripe_*
+ * fields of opts, removes any existing item first if opts->overwrite is set */
+void mfu_create_striped_file(
+    const char* name,
+    const mfu_create_opts_t* opts
+);
+
 /* create inodes for all regular files in flist, assumes directories exist */
 void mfu_flist_mknod(
     mfu_flist flist,
@@ -598,6 +681,8 @@ typedef struct mfu_file_chunk_struct {
   const char* name;        /* full path to file name */
   uint64_t offset;         /* starting byte offset in file */
   uint64_t length;         /* length of bytes process is responsible for */
+  uint64_t stride;         /* distance between starts of segments, 0 if contiguous */
+  uint64_t seg_length;     /* length of each segment, the last may be shorter */
   uint64_t file_size;      /* full size of target file */
   uint64_t ost;   //sy: add
   uint64_t rank_of_owner;  /* MPI rank acting as the owner of this file */
@@ -610,12 +695,118 @@ typedef struct mfu_file_chunk_struct {
  * is responsbile for */
 mfu_file_chunk* mfu_file_chunk_list_alloc(mfu_flist list, uint64_t chunk_size);
 
+/* like mfu_file_chunk_list_alloc, but stripes of a file on the same
+ * object may be combined into one strided chunk of up to coalesce_size
+ * bytes, which holds length bytes in segments of seg_length bytes
+ * starting every stride bytes from offset, a coalesce_size of 0
+ * returns only contiguous chunks */
+mfu_file_chunk* mfu_file_chunk_list_alloc_strided(mfu_flist list, uint64_t chunk_size, uint64_t coalesce_size);
+
+/* like mfu_file_chunk_list_alloc_strided, but given the path dests[i]
+ * each file i is copied to, chunks are assigned by the pair of source
+ * and destination objects holding them, so that a process reads from
+ * and writes to as few objects as possible, this applies to files whose
+ * destination has the same stripe size and count as the source, for
+ * others, and where dests[i] is NULL, only the source object is used */
+mfu_file_chunk* mfu_file_chunk_list_alloc_pairs(mfu_flist list, uint64_t chunk_size, uint64_t coalesce_size, const char** dests);
+
+/* predicted assignment of chunks to ranks, see mfu_file_chunk_list_plan */
+typedef struct {
+  int ranks;              /* number of ranks planned for */
+  int nodes;              /* number of compute nodes the ranks run on */
+  int* node_of;           /* node of each rank */
+  uint64_t* rank_bytes;   /* bytes assigned to each rank */
+  uint64_t* rank_chunks;  /* chunks assigned to each rank */
+  int osts;               /* number of OSTs holding data, plus one */
+  uint64_t* ost_index;    /* index of each OST, the last entry is MFU_LAYOUT_OST_NONE
+                           * and counts data not on a known OST */
+  uint64_t* ost_bytes;    /* bytes on each OST */
+  uint64_t* ost_chunks;   /* chunks on each OST */
+  int* ost_ranks;         /* number of ranks planned to serve each OST */
+} mfu_file_chunk_plan;
+
+/* predict how mfu_file_chunk_list_alloc_strided would spread the chunks
+ * of the list over the given number of ranks running on the given number
+ * of nodes, without building any chunks, the job itself may have any
+ * number of ranks, returns the same plan on all ranks, collective */
+mfu_file_chunk_plan* mfu_file_chunk_list_plan(mfu_flist list, uint64_t chunk_size, uint64_t coalesce_size, int ranks, int nodes);
+
+/* free plan and set caller's pointer to NULL */
+void mfu_file_chunk_plan_free(mfu_file_chunk_plan** pplan);
+
+/* return offset just past the last byte of a chunk */
+uint64_t mfu_file_chunk_end(const mfu_file_chunk* p);
+
 /* free the linked list allocated with mfu_file_chunk_list_alloc */
 void mfu_file_chunk_list_free(mfu_file_chunk** phead);
 
 /* return number of items in chunk list */
 uint64_t mfu_file_chunk_list_size(const mfu_file_chunk* list);
 
+/* orders in which a process may work through its chunks */
+typedef enum {
+    MFU_CHUNK_ORDER_ARRIVAL = 0, /* order in which chunks were received */
+    MFU_CHUNK_ORDER_FILE,        /* by file, then by offset within each file */
+    MFU_CHUNK_ORDER_OST,         /* one chunk from each OST in turn */
+    MFU_CHUNK_ORDER_LARGEST,     /* largest chunks first */
+} mfu_chunk_order;
+
+/* reorder the chunks of a list in place according to order,
+ * head remains the first element of the list */
+void mfu_file_chunk_list_order(mfu_file_chunk* head, mfu_chunk_order order);
+
+/* (opaque) queue through which ranks that run out of chunks
+ * take remaining chunks from the lists of other ranks */
+typedef struct mfu_file_chunk_queue_struct mfu_file_chunk_queue;
+
+/* create a queue from the chunk list of each rank, the list must not
+ * change or be freed until the queue is freed, collective */
+mfu_file_chunk_queue* mfu_file_chunk_queue_new(mfu_file_chunk* head);
+
+/* return the next chunk to work on, first from our own list in order,
+ * then from the end of the list of another rank, preferring ranks
+ * that work on the same OST and then ranks on the same node, returns
+ * NULL once no chunks are left anywhere, the returned chunk is valid
+ * until the next call */
+const mfu_file_chunk* mfu_file_chunk_queue_next(mfu_file_chunk_queue* q);
+
+/* print the number of chunks and bytes taken from other ranks, collective */
+void mfu_file_chunk_queue_report(const mfu_file_chunk_queue* q);
+
+/* free queue and set caller's pointer to NULL, collective */
+void mfu_file_chunk_queue_free(mfu_file_chunk_queue** pq);
+
+/* (opaque) bytes, time, and latency histogram of chunks copied,
+ * kept for each OST named in the ost field of the chunks */
+typedef struct mfu_file_chunk_stats_struct mfu_file_chunk_stats;
+
+/* create counters for the OSTs of the chunks in the list of any
+ * rank, collective */
+mfu_file_chunk_stats* mfu_file_chunk_stats_new(const mfu_file_chunk* head);
+
+/* record chunk p, whose copy started at the time returned by
+ * mfu_perf_start, may be called by several threads at once */
+void mfu_file_chunk_stats_add(mfu_file_chunk_stats* stats, const mfu_file_chunk* p, uint64_t start);
+
+/* return the number of values filled in by
+ * mfu_file_chunk_stats_progress_values */
+int mfu_file_chunk_stats_progress_count(const mfu_file_chunk_stats* stats);
+
+/* fill vals with the bytes and time of each OST so far,
+ * to be summed across ranks with mfu_progress */
+void mfu_file_chunk_stats_progress_values(const mfu_file_chunk_stats* stats, uint64_t* vals);
+
+/* given values summed across ranks, print OSTs whose rate so far
+ * is well below the median rate of all OSTs */
+void mfu_file_chunk_stats_progress_log(const mfu_file_chunk_stats* stats, const uint64_t* vals);
+
+/* print a table of chunks, bytes, rate, and chunk latency of each
+ * OST, flagging OSTs whose rate is well below the median, collective */
+void mfu_file_chunk_stats_report(const mfu_file_chunk_stats* stats);
+
+/* free counters and set caller's pointer to NULL */
+void mfu_file_chunk_stats_free(mfu_file_chunk_stats** pstats);
+
 /* given an flist, a file chunk list generated from that flist,
  * and an input array of flags with one element per chunk,
  * execute a LOR per item in the flist, and return the result
@@ -3,14 +3,15 @@
 #include <unistd.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stddef.h>
+#include <errno.h>
+#include <limits.h>
 
 #include "libcircle.h"
 #include "dtcmp.h"
 #include "mfu.h"
+#include "strmap.h"
 
-#include "timing.h"
-
-uint64_t num_tasks_per_ost[OST_NUMBER];
 
 /****************************************
  * Functions to divide flist into linked list of file sections
@@ -37,473 +38,1964 @@ static int map_chunk_to_rank(uint64_t offset, uint64_t cutoff, uint64_t chunks_p
 }
 
 
-/* This is a long routine, but the idea is simple.  All tasks sum up
- * the number of file chunks they have, and those are then evenly
- * distributed amongst the processes.  */
-mfu_file_chunk* mfu_file_chunk_list_alloc(mfu_flist list, uint64_t chunk_size)
+/* size of a packed chunk record: name id, offset, length,
+ * stride, segment length, and ost */
+#define MFU_CHUNK_RECORD_SIZE (6 * 8)
+
+/* largest piece of a message we pass to MPI at once,
+ * so that its count fits in an int */
+#define MFU_CHUNK_MSG_MAX ((uint64_t)1 << 30)
+
+/* The chunks of a list returned by mfu_file_chunk_list_alloc are held
+ * in one array, linked in order, along with the names they point to.
+ * The first chunk is the head of the list, which lets us find the
+ * block when freeing the list. */
+typedef struct {
+    char* names;              /* names of the chunks we kept */
+    char* recvbuf;            /* received data, holds names of received chunks */
+    mfu_file_chunk chunks[];  /* all chunks of the list */
+} mfu_chunk_block_t;
+
+/* lists of chunks we build up for each rank */
+typedef struct {
+    int rank;                /* our rank */
+    int ranks;               /* number of ranks */
+    mfu_flist list;          /* list of files the chunks come from */
+    mfu_file_chunk** head;   /* list of chunks we keep ourselves */
+    mfu_file_chunk** tail;
+    mfu_file_chunk** heads;  /* list of chunks to send to each rank */
+    mfu_file_chunk** tails;
+    uint64_t* counts;        /* number of chunks to send to each rank */
+    uint64_t* bytes;         /* packed size of chunks to send to each rank */
+    uint64_t* names;         /* number of file names to send to each rank */
+    uint64_t* last_file;     /* index of last file sent to each rank */
+    uint64_t local_count;    /* number of chunks we keep */
+    uint64_t local_names;    /* bytes of file names of chunks we keep */
+    uint64_t local_last;     /* index of last file we kept a chunk of */
+    uint64_t next_plain;     /* spreads chunks of units that have no ranks */
+    uint64_t ost_max;        /* number of entries in ost_dense */
+    int* ost_dense;          /* maps OST index to position among active OSTs, or -1 */
+    int ost_count;           /* number of active OSTs */
+    int node_count;          /* number of compute nodes in the job */
+    int* node_of;            /* node of each rank, numbered in order of lowest rank */
+    int server_count;        /* number of storage servers holding active OSTs */
+    int* server_of;          /* server of each active OST */
+
+    /* When the destination layouts are known, chunks are scheduled by
+     * the pair of source and destination objects holding them.  Each
+     * pair then takes the place of an OST, and the chunk records the
+     * source object of its pair. */
+    uint64_t pair_count;     /* number of pairs, 0 if not scheduling by pairs */
+    uint64_t* pair_src;      /* source object of each pair */
+    uint64_t* pair_dst;      /* destination object of each pair, or OST_NONE */
+
+    /* Chunks are grouped into units of work, one per active OST plus
+     * a last unit for chunks not on a known OST.  Each unit is served
+     * by a set of member ranks, each with a weight giving its share of
+     * the bytes of the unit.  Every rank splits its own bytes of a unit
+     * among the members in proportion to their weights, by filling the
+     * quota of one member before moving to the next. */
+    int units;               /* number of units, ost_count + 1 */
+    uint64_t* unit_bytes;    /* bytes we hold in each unit */
+    int* member_offsets;     /* start of members of each unit, units + 1 entries */
+    int* members;            /* ranks serving each unit */
+    double* weights;         /* weight of each member */
+    double* unit_weights;    /* sum of member weights of each unit */
+    int* cur_member;         /* member currently receiving chunks of each unit */
+    double* cur_left;        /* bytes left in quota of current member */
+
+    /* stripes of a file on the same object may be combined into
+     * one strided chunk of up to item_max bytes for its unit */
+    uint64_t chunk_size;     /* limit on bytes in a contiguous chunk */
+    uint64_t coalesce_size;  /* limit on bytes in a strided chunk, 0 to disable */
+    uint64_t* item_max;      /* limit on bytes in a strided chunk of each unit */
+
+    /* When only predicting a plan with mfu_file_chunk_list_plan, ranks
+     * is the number of ranks planned for rather than the size of the
+     * job, and chunks are tallied here instead of built into lists. */
+    uint64_t* sim_bytes;       /* bytes given to each rank, NULL if not predicting */
+    uint64_t* sim_chunks;      /* chunks given to each rank */
+    uint64_t* sim_unit_bytes;  /* bytes in each unit */
+    uint64_t* sim_unit_chunks; /* chunks in each unit */
+} mfu_chunk_assign_t;
+
+/* determine the set of OSTs holding data of the files in our list
+ * across all ranks, MFU_OST_COUNT=N marks OSTs 0 to N-1 as active
+ * in addition to those found in layouts, for N up to MFU_LAYOUT_OST_MAX,
+ * so that the binding of ranks to OSTs can match the file system rather
+ * than the files,
+ * fills in ost_max, ost_dense, and ost_count of the assign struct */
+static void mfu_chunk_discover_osts(
+    const mfu_layout* layouts,
+    uint64_t size,
+    mfu_chunk_assign_t* a)
 {
-    /* get our rank and number of ranks */
-    int rank, ranks;
-    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
-    MPI_Comm_size(MPI_COMM_WORLD, &ranks);
-	
-    mfu_file_chunk* head = NULL;
-    mfu_file_chunk* tail = NULL;
+    /* get number of OSTs specified by the user */
+    uint64_t user_count = 0;
+    char varname[] = "MFU_OST_COUNT";
+    const char* value = getenv(varname);
+    if (value != NULL && a->pair_count == 0) {
+        unsigned long long val;
+        if (mfu_abtoull(value, &val) == MFU_SUCCESS && val > 0 && val <= MFU_LAYOUT_OST_MAX) {
+            user_count = (uint64_t) val;
+            if (a->rank == 0) {
+                MFU_LOG(MFU_LOG_INFO, "%s: %llu", varname, val);
+            }
+        } else if (a->rank == 0 && mfu_abtoull(value, &val) == MFU_SUCCESS && val > 0) {
+            MFU_LOG(MFU_LOG_WARN, "Ignoring %s: `%s' is more than %d",
+                varname, value, MFU_LAYOUT_OST_MAX);
+        } else if (a->rank == 0) {
+            MFU_LOG(MFU_LOG_WARN, "Ignoring invalid %s: `%s'", varname, value);
+        }
+    }
+
+    /* find the largest OST index in our layouts */
+    uint64_t max = user_count;
+    uint64_t idx;
+    for (idx = 0; idx < size; idx++) {
+        const mfu_layout* layout = &layouts[idx];
+        int c;
+        for (c = 0; c < layout->count; c++) {
+            const mfu_layout_comp* comp = &layout->comps[c];
+            uint64_t i;
+            for (i = 0; i < comp->stripe_count; i++) {
+                uint64_t ost = comp->osts[i];
+                if (ost != MFU_LAYOUT_OST_NONE && ost + 1 > max) {
+                    max = ost + 1;
+                }
+            }
+        }
+    }
+    uint64_t all_max;
+    MPI_Allreduce(&max, &all_max, 1, MPI_UINT64_T, MPI_MAX, MPI_COMM_WORLD);
+
+    /* mfu_chunk_get_layouts drops OST indices of MFU_LAYOUT_OST_MAX or
+     * more, and pair indices are bounded by the int counts used to
+     * gather them, so this only guards the cast below */
+    if (all_max >= (uint64_t) INT_MAX) {
+        MFU_ABORT(-1, "Too many OSTs to schedule chunks: %llu",
+            (unsigned long long) all_max);
+    }
+
+    /* mark each OST we use, and those specified by the user */
+    unsigned char* used = (unsigned char*) MFU_MALLOC((size_t)all_max + 1);
+    memset(used, 0, (size_t)all_max + 1);
+    for (idx = 0; idx < user_count; idx++) {
+        used[idx] = 1;
+    }
+    for (idx = 0; idx < size; idx++) {
+        const mfu_layout* layout = &layouts[idx];
+        int c;
+        for (c = 0; c < layout->count; c++) {
+            const mfu_layout_comp* comp = &layout->comps[c];
+            uint64_t i;
+            for (i = 0; i < comp->stripe_count; i++) {
+                uint64_t ost = comp->osts[i];
+                if (ost != MFU_LAYOUT_OST_NONE) {
+                    used[ost] = 1;
+                }
+            }
+        }
+    }
+
+    /* get union of OSTs across ranks */
+    unsigned char* all_used = (unsigned char*) MFU_MALLOC((size_t)all_max + 1);
+    MPI_Allreduce(used, all_used, (int)all_max, MPI_BYTE, MPI_BOR, MPI_COMM_WORLD);
+
+    /* number active OSTs in order of their index */
+    a->ost_max   = all_max;
+    a->ost_dense = (int*) MFU_MALLOC(((size_t)all_max + 1) * sizeof(int));
+    a->ost_count = 0;
+    for (idx = 0; idx < all_max; idx++) {
+        if (all_used[idx]) {
+            a->ost_dense[idx] = a->ost_count;
+            a->ost_count++;
+        } else {
+            a->ost_dense[idx] = -1;
+        }
+    }
 
-    int rc[5];
-    uint64_t cnt = 0, ssize, start, end, ost_idx, interval, file_size;
-    int worker_number = ranks;
-    int obj_idx = 0;
-    struct llapi_layout *layout;
+    if (a->rank == 0 && a->pair_count == 0) {
+        MFU_LOG(MFU_LOG_VERBOSE, "Scheduling chunks over %d OSTs (largest index %llu)",
+            a->ost_count, (unsigned long long) (all_max > 0 ? all_max - 1 : 0));
+    }
 
+    mfu_free(&all_used);
+    mfu_free(&used);
+}
 
-    /* total up number of file chunks for all files in our list */
-    uint64_t count = 0;
+/* return the unit of work of a chunk on the given OST */
+static int mfu_chunk_unit(const mfu_chunk_assign_t* a, uint64_t ost)
+{
+    if (ost == MFU_LAYOUT_OST_NONE || ost >= a->ost_max || a->ost_dense[ost] < 0) {
+        return a->ost_count;
+    }
+    return a->ost_dense[ost];
+}
+
+/* find which ranks share a compute node, fills in node_count and
+ * node_of of the assign struct, nodes are numbered in order of the
+ * lowest rank running on each */
+static void mfu_chunk_discover_nodes(mfu_chunk_assign_t* a)
+{
+    /* split ranks into groups that share memory */
+    MPI_Comm node_comm;
+    MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, a->rank,
+        MPI_INFO_NULL, &node_comm);
+
+    /* identify each node by the lowest rank on it */
+    int leader = a->rank;
+    MPI_Allreduce(MPI_IN_PLACE, &leader, 1, MPI_INT, MPI_MIN, node_comm);
+    MPI_Comm_free(&node_comm);
+
+    int* leaders = (int*) MFU_MALLOC((size_t)a->ranks * sizeof(int));
+    MPI_Allgather(&leader, 1, MPI_INT, leaders, 1, MPI_INT, MPI_COMM_WORLD);
+
+    /* number nodes in order of their leaders, the leader of a node
+     * has the lowest rank on it, so it comes before its other ranks */
+    a->node_of = (int*) MFU_MALLOC((size_t)a->ranks * sizeof(int));
+    a->node_count = 0;
+    int r;
+    for (r = 0; r < a->ranks; r++) {
+        if (leaders[r] == r) {
+            a->node_of[r] = a->node_count;
+            a->node_count++;
+        } else {
+            a->node_of[r] = a->node_of[leaders[r]];
+        }
+    }
+
+    mfu_free(&leaders);
+}
+
+/* get the server holding each active OST, fills in server_count and
+ * server_of of the assign struct.
+ *
+ * The mapping is read from the file named by MFU_OST_MAP, which has a
+ * line for each OST giving its index and the name of its server:
+ *
+ *   <ost> <server>
+ *
+ * Blank lines and lines starting with '#' are ignored.  An OST that is
+ * not listed is taken to be on a server of its own. */
+static void mfu_chunk_discover_servers(mfu_chunk_assign_t* a)
+{
+    /* server id of each OST index, or -1 if not known,
+     * a pair of objects is on the server of its source */
+    uint64_t idx;
+    uint64_t src_max = a->ost_max;
+    if (a->pair_count > 0) {
+        src_max = 0;
+        for (idx = 0; idx < a->pair_count; idx++) {
+            if (a->pair_src[idx] + 1 > src_max) {
+                src_max = a->pair_src[idx] + 1;
+            }
+        }
+    }
+    int max = (int) src_max;
+    int* ids = (int*) MFU_MALLOC(((size_t)max + 1) * sizeof(int));
+    int i;
+    for (i = 0; i < max; i++) {
+        ids[i] = -1;
+    }
+
+    /* rank 0 reads the file and sends the map to the others */
+    char varname[] = "MFU_OST_MAP";
+    const char* value = getenv(varname);
+    if (value != NULL && a->rank == 0) {
+        FILE* fp = fopen(value, "r");
+        if (fp != NULL) {
+            MFU_LOG(MFU_LOG_INFO, "%s: %s", varname, value);
+
+            /* assign ids to servers in order of first appearance */
+            strmap* servers = strmap_new();
+            int next_id = 0;
+            char line[1024];
+            while (fgets(line, sizeof(line), fp) != NULL) {
+                unsigned long long ost;
+                char name[1024];
+                if (line[0] == '#' || sscanf(line, "%llu %1023s", &ost, name) != 2) {
+                    continue;
+                }
+                if (ost >= (unsigned long long) max) {
+                    /* OST is not used by any file we copy */
+                    continue;
+                }
+                const char* id = strmap_get(servers, name);
+                if (id == NULL) {
+                    strmap_setf(servers, "%s=%d", name, next_id);
+                    ids[ost] = next_id;
+                    next_id++;
+                } else {
+                    ids[ost] = atoi(id);
+                }
+            }
+            fclose(fp);
+            strmap_delete(&servers);
+        } else {
+            MFU_LOG(MFU_LOG_WARN, "Failed to open %s `%s' (errno=%d %s)",
+                varname, value, errno, strerror(errno));
+        }
+    }
+    if (max > 0) {
+        MPI_Bcast(ids, max, MPI_INT, 0, MPI_COMM_WORLD);
+    }
+
+    /* number the servers of active OSTs densely, giving each
+     * unmapped OST a server of its own */
+    int* dense = (int*) MFU_MALLOC((2 * (size_t)max + 1) * sizeof(int));
+    for (i = 0; i < 2 * max; i++) {
+        dense[i] = -1;
+    }
+    a->server_of = (int*) MFU_MALLOC(((size_t)a->ost_count + 1) * sizeof(int));
+    a->server_count = 0;
+    for (idx = 0; idx < a->ost_max; idx++) {
+        int unit = a->ost_dense[idx];
+        if (unit < 0) {
+            continue;
+        }
+        uint64_t ost = (a->pair_count > 0) ? a->pair_src[idx] : idx;
+        int id = (ids[ost] >= 0) ? ids[ost] : max + (int) ost;
+        if (dense[id] < 0) {
+            dense[id] = a->server_count;
+            a->server_count++;
+        }
+        a->server_of[unit] = dense[id];
+    }
+
+    mfu_free(&dense);
+    mfu_free(&ids);
+}
+
+/* sort pairs of source and destination objects */
+static int mfu_chunk_pair_cmp(const void* a, const void* b)
+{
+    const uint64_t* x = (const uint64_t*) a;
+    const uint64_t* y = (const uint64_t*) b;
+    if (x[0] != y[0]) {
+        return (x[0] < y[0]) ? -1 : 1;
+    }
+    return (x[1] < y[1]) ? -1 : (x[1] > y[1]);
+}
+
+/* sort pairs and drop duplicates, returns number of unique pairs */
+static uint64_t mfu_chunk_pair_unique(uint64_t* pairs, uint64_t count)
+{
+    if (count == 0) {
+        return 0;
+    }
+    qsort(pairs, (size_t)count, 2 * sizeof(uint64_t), mfu_chunk_pair_cmp);
+    uint64_t n = 1;
+    uint64_t i;
+    for (i = 1; i < count; i++) {
+        if (mfu_chunk_pair_cmp(&pairs[2 * i], &pairs[2 * (n - 1)]) != 0) {
+            pairs[2 * n + 0] = pairs[2 * i + 0];
+            pairs[2 * n + 1] = pairs[2 * i + 1];
+            n++;
+        }
+    }
+    return n;
+}
+
+/* find the component of a destination layout that stripes the bytes
+ * of the given source component the same way, returns NULL if none */
+static const mfu_layout_comp* mfu_chunk_pair_comp(
+    const mfu_layout* dest,
+    const mfu_layout_comp* comp,
+    uint64_t file_size)
+{
+    /* clip end of source component to the file */
+    uint64_t end = (comp->end < file_size) ? comp->end : file_size;
+
+    int c;
+    for (c = 0; c < dest->count; c++) {
+        const mfu_layout_comp* d = &dest->comps[c];
+        if (d->start == comp->start &&
+            d->end >= end &&
+            d->stripe_size  == comp->stripe_size &&
+            d->stripe_count == comp->stripe_count)
+        {
+            return d;
+        }
+    }
+    return NULL;
+}
+
+/* given the layouts of the source and destination of each file, replace
+ * each source object in the source layouts with the index of its pair
+ * of source and destination objects, and record the pairs in the
+ * assign struct.  Stripe i of a source component maps to stripe i of a
+ * destination component with the same start, stripe size, and stripe
+ * count.  The destination of other stripes is not known, so they are
+ * paired with MFU_LAYOUT_OST_NONE.  All ranks number the pairs the
+ * same way, in order of source and then destination object. */
+static void mfu_chunk_pair_layouts(
+    mfu_flist list,
+    mfu_layout* layouts,
+    const mfu_layout* dest_layouts,
+    mfu_chunk_assign_t* a)
+{
     uint64_t idx;
     uint64_t size = mfu_flist_size(list);
+
+    /* count stripes on a known object */
+    uint64_t count = 0;
     for (idx = 0; idx < size; idx++) {
-        /* get type of item */
-        mfu_filetype type = mfu_flist_file_get_type(list, idx);
+        int c;
+        for (c = 0; c < layouts[idx].count; c++) {
+            count += layouts[idx].comps[c].stripe_count;
+        }
+    }
 
-        /* if we have a file, add up its chunks */
-        if (type == MFU_TYPE_FILE) {
-            /* get size of file */
-            uint64_t file_size = mfu_flist_file_get_size(list, idx);
+    /* list the pairs of our stripes */
+    uint64_t* pairs = (uint64_t*) MFU_MALLOC(((size_t)count + 1) * 2 * sizeof(uint64_t));
+    uint64_t n = 0;
+    for (idx = 0; idx < size; idx++) {
+        uint64_t file_size = mfu_flist_file_get_size(list, idx);
+        int c;
+        for (c = 0; c < layouts[idx].count; c++) {
+            const mfu_layout_comp* comp = &layouts[idx].comps[c];
+            const mfu_layout_comp* d = mfu_chunk_pair_comp(&dest_layouts[idx], comp, file_size);
+            uint64_t i;
+            for (i = 0; i < comp->stripe_count; i++) {
+                if (comp->osts[i] != MFU_LAYOUT_OST_NONE) {
+                    pairs[2 * n + 0] = comp->osts[i];
+                    pairs[2 * n + 1] = (d != NULL) ? d->osts[i] : MFU_LAYOUT_OST_NONE;
+                    n++;
+                }
+            }
+        }
+    }
+    n = mfu_chunk_pair_unique(pairs, n);
 
-            /* compute number of chunks to copy for this file */
-            uint64_t chunks = file_size / chunk_size;
-            if (chunks * chunk_size < file_size || file_size == 0) {
-                /* this accounts for the last chunk, which may be
- *                  * partial or it adds a chunk for 0-size files */
-                chunks++;
+    /* gather pairs from all ranks */
+    int ranks = a->ranks;
+    int* recvcounts = (int*) MFU_MALLOC((size_t)ranks * sizeof(int));
+    int* displs     = (int*) MFU_MALLOC((size_t)ranks * sizeof(int));
+    int sendcount = (int) (2 * n);
+    MPI_Allgather(&sendcount, 1, MPI_INT, recvcounts, 1, MPI_INT, MPI_COMM_WORLD);
+    int r;
+    uint64_t all = 0;
+    for (r = 0; r < ranks; r++) {
+        displs[r] = (int) all;
+        all += (uint64_t) recvcounts[r];
+    }
+    uint64_t* all_pairs = (uint64_t*) MFU_MALLOC(((size_t)all + 2) * sizeof(uint64_t));
+    MPI_Allgatherv(pairs, sendcount, MPI_UINT64_T,
+        all_pairs, recvcounts, displs, MPI_UINT64_T, MPI_COMM_WORLD);
+    uint64_t pair_count = mfu_chunk_pair_unique(all_pairs, all / 2);
+
+    a->pair_count = pair_count;
+    a->pair_src = (uint64_t*) MFU_MALLOC(((size_t)pair_count + 1) * sizeof(uint64_t));
+    a->pair_dst = (uint64_t*) MFU_MALLOC(((size_t)pair_count + 1) * sizeof(uint64_t));
+    uint64_t i;
+    for (i = 0; i < pair_count; i++) {
+        a->pair_src[i] = all_pairs[2 * i + 0];
+        a->pair_dst[i] = all_pairs[2 * i + 1];
+    }
+
+    /* replace the objects in our layouts with their pair index */
+    for (idx = 0; idx < size; idx++) {
+        uint64_t file_size = mfu_flist_file_get_size(list, idx);
+        int c;
+        for (c = 0; c < layouts[idx].count; c++) {
+            mfu_layout_comp* comp = &layouts[idx].comps[c];
+            const mfu_layout_comp* d = mfu_chunk_pair_comp(&dest_layouts[idx], comp, file_size);
+            for (i = 0; i < comp->stripe_count; i++) {
+                if (comp->osts[i] != MFU_LAYOUT_OST_NONE) {
+                    uint64_t key[2];
+                    key[0] = comp->osts[i];
+                    key[1] = (d != NULL) ? d->osts[i] : MFU_LAYOUT_OST_NONE;
+                    const uint64_t* found = (const uint64_t*) bsearch(key, all_pairs,
+                        (size_t)pair_count, 2 * sizeof(uint64_t), mfu_chunk_pair_cmp);
+                    comp->osts[i] = (uint64_t) (found - all_pairs) / 2;
+                }
             }
+        }
+    }
 
-            /* include these chunks in our total */
-            count += chunks;
+    mfu_free(&all_pairs);
+    mfu_free(&displs);
+    mfu_free(&recvcounts);
+    mfu_free(&pairs);
+}
+
+/* print the total bytes on each pair of source and destination objects */
+static void mfu_chunk_report_pairs(const mfu_chunk_assign_t* a)
+{
+    uint64_t* total = NULL;
+    if (a->rank == 0) {
+        total = (uint64_t*) MFU_MALLOC((size_t)a->units * sizeof(uint64_t));
+    }
+    MPI_Reduce(a->unit_bytes, total, a->units, MPI_UINT64_T, MPI_SUM, 0, MPI_COMM_WORLD);
+
+    if (a->rank == 0) {
+        int paired = 0;
+        uint64_t idx;
+        for (idx = 0; idx < a->ost_max; idx++) {
+            /* skip pairs only used by stripes past the end of a file */
+            int u = a->ost_dense[idx];
+            if (u < 0 || total[u] == 0) {
+                continue;
+            }
+            char dst[32] = "unknown";
+            if (a->pair_dst[idx] != MFU_LAYOUT_OST_NONE) {
+                snprintf(dst, sizeof(dst), "%llu", (unsigned long long) a->pair_dst[idx]);
+                paired++;
+            }
+            double size_tmp;
+            const char* size_units;
+            mfu_format_bytes(total[u], &size_tmp, &size_units);
+            MFU_LOG(MFU_LOG_VERBOSE, "OST %llu -> OST %s: %.3lf %s",
+                (unsigned long long) a->pair_src[idx], dst, size_tmp, size_units);
         }
+
+        MFU_LOG(MFU_LOG_INFO, "Scheduling chunks over %d pairs of source and destination OSTs",
+            paired);
     }
-	printf("rank %d chunks: %d\n", rank, count);
 
-    /* compute total number of chunks across procs */
-    uint64_t total;
-    MPI_Allreduce(&count, &total, 1, MPI_UINT64_T, MPI_SUM, MPI_COMM_WORLD);
+    mfu_free(&total);
+}
+
+/* move ranks[i] down a min heap ordered by load and then rank */
+static void mfu_chunk_heap_down(int* heap, int n, const uint64_t* load, int i)
+{
+    while (1) {
+        int min = i;
+        int child;
+        for (child = 2 * i + 1; child <= 2 * i + 2 && child < n; child++) {
+            int c = heap[child];
+            int m = heap[min];
+            if (load[c] < load[m] || (load[c] == load[m] && c < m)) {
+                min = child;
+            }
+        }
+        if (min == i) {
+            return;
+        }
+        int tmp   = heap[i];
+        heap[i]   = heap[min];
+        heap[min] = tmp;
+        i = min;
+    }
+}
 
-	printf("total chunks: %d\n", total);
+/* unit of work and its total bytes, used to sort units */
+typedef struct {
+    uint64_t bytes;
+    int unit;
+} mfu_chunk_unit_bytes_t;
 
-    /* get global offset of our first chunk */
-    uint64_t offset;
-    MPI_Exscan(&count, &offset, 1, MPI_UINT64_T, MPI_SUM, MPI_COMM_WORLD);
-    if (rank == 0) {
-        offset = 0;
+/* sort units by decreasing bytes, and then by index */
+static int mfu_chunk_unit_cmp(const void* a, const void* b)
+{
+    const mfu_chunk_unit_bytes_t* x = (const mfu_chunk_unit_bytes_t*) a;
+    const mfu_chunk_unit_bytes_t* y = (const mfu_chunk_unit_bytes_t*) b;
+    if (x->bytes != y->bytes) {
+        return (x->bytes > y->bytes) ? -1 : 1;
     }
+    return (x->unit < y->unit) ? -1 : (x->unit > y->unit);
+}
 
-    /* if we have some chunks, figure out the number of ranks
- *      * we'll send to and the range of rank ids, set flags to 1 */
+/* sort loads in increasing order */
+static int mfu_chunk_load_cmp(const void* a, const void* b)
+{
+    uint64_t x = *(const uint64_t*) a;
+    uint64_t y = *(const uint64_t*) b;
+    return (x < y) ? -1 : (x > y);
+}
 
-    /* allocate a linked list for each process we'll send to */
-    mfu_file_chunk** heads = (mfu_file_chunk**) MFU_MALLOC((size_t)ranks * sizeof(mfu_file_chunk*));
-    mfu_file_chunk** tails = (mfu_file_chunk**) MFU_MALLOC((size_t)ranks * sizeof(mfu_file_chunk*));
-    uint64_t* counts  = (uint64_t*)   MFU_MALLOC((size_t)ranks * sizeof(uint64_t));
-    uint64_t* bytes   = (uint64_t*)   MFU_MALLOC((size_t)ranks * sizeof(uint64_t));
-    char** sendbufs   = (char**)      MFU_MALLOC((size_t)ranks * sizeof(char*));
-	
-    /* initialize values */
-    for (int i = 0; i < ranks; i++) {
-        heads[i]    = NULL;
-        tails[i]    = NULL;
-        counts[i]   = 0;
-        bytes[i]    = 0;
-        sendbufs[i] = NULL;
-    }
-
-    /* now iterate through files and build up list of chunks we'll
- *      * send to each task, as an optimization, we encode consecutive
- *           * chunks of the same file into a single unit */
- 
-   uint64_t current_offset = offset;
+/* a rank serving a unit of work, and its share of the bytes */
+typedef struct {
+    int unit;
+    int rank;
+    double weight;
+} mfu_chunk_member_t;
+
+/* assign the given OST units to the given ranks, adding a member for
+ * each rank serving a unit to mem and its expected bytes to load.
+ *
+ * With at least as many OSTs as ranks, each OST is given whole to one
+ * rank using greedy longest processing time first (LPT): OSTs are taken
+ * in order of decreasing bytes and each goes to the least loaded rank.
+ *
+ * With fewer OSTs than ranks, each OST gets a group of ranks sized in
+ * proportion to its bytes.  Ranks are dealt out to groups in turn, so
+ * a group is spread over the list rather than packed into a few
+ * consecutive ranks. */
+static void mfu_chunk_plan_ranks(
+    const int* units,
+    int nunits,
+    const int* ranks,
+    int nranks,
+    const uint64_t* total,
+    uint64_t* load,
+    mfu_chunk_member_t* mem,
+    int* nmem)
+{
+    int u, r;
+    if (nunits == 0 || nranks == 0) {
+        return;
+    }
+
+    if (nunits >= nranks) {
+        /* order OSTs by decreasing bytes */
+        mfu_chunk_unit_bytes_t* order = (mfu_chunk_unit_bytes_t*) MFU_MALLOC(
+            (size_t)nunits * sizeof(mfu_chunk_unit_bytes_t));
+        for (u = 0; u < nunits; u++) {
+            order[u].bytes = total[units[u]];
+            order[u].unit  = units[u];
+        }
+        qsort(order, (size_t)nunits, sizeof(mfu_chunk_unit_bytes_t), mfu_chunk_unit_cmp);
+
+        /* heap of ranks by load */
+        int* heap = (int*) MFU_MALLOC((size_t)nranks * sizeof(int));
+        for (r = 0; r < nranks; r++) {
+            heap[r] = ranks[r];
+        }
+        for (r = nranks / 2 - 1; r >= 0; r--) {
+            mfu_chunk_heap_down(heap, nranks, load, r);
+        }
+
+        /* give each OST to the least loaded rank */
+        for (u = 0; u < nunits; u++) {
+            int dest = heap[0];
+            mem[*nmem].unit   = order[u].unit;
+            mem[*nmem].rank   = dest;
+            mem[*nmem].weight = 1.0;
+            (*nmem)++;
+            load[dest] += order[u].bytes;
+            mfu_chunk_heap_down(heap, nranks, load, 0);
+        }
+
+        mfu_free(&heap);
+        mfu_free(&order);
+        return;
+    }
+
+    /* units with data each get at least one rank */
+    uint64_t sum = 0;
+    int active = 0;
+    for (u = 0; u < nunits; u++) {
+        if (total[units[u]] > 0) {
+            sum += total[units[u]];
+            active++;
+        }
+    }
+    if (active == 0) {
+        return;
+    }
+
+    /* hand out the other ranks in proportion to bytes */
+    int* counts = (int*) MFU_MALLOC((size_t)nunits * sizeof(int));
+    int assigned = 0;
+    for (u = 0; u < nunits; u++) {
+        counts[u] = 0;
+        if (total[units[u]] > 0) {
+            double share = (double) total[units[u]] / (double) sum;
+            counts[u] = 1 + (int) ((double) (nranks - active) * share);
+            assigned += counts[u];
+        }
+    }
+
+    /* give any ranks left over from rounding to the units
+     * with the most bytes per rank */
+    while (assigned < nranks) {
+        int best = -1;
+        double best_val = 0.0;
+        for (u = 0; u < nunits; u++) {
+            if (total[units[u]] > 0) {
+                double val = (double) total[units[u]] / (double) counts[u];
+                if (best < 0 || val > best_val) {
+                    best = u;
+                    best_val = val;
+                }
+            }
+        }
+        counts[best]++;
+        assigned++;
+    }
+
+    /* deal ranks out to units in turn */
+    int* filled = (int*) MFU_MALLOC((size_t)nunits * sizeof(int));
+    for (u = 0; u < nunits; u++) {
+        filled[u] = 0;
+    }
+    r = 0;
+    while (r < nranks) {
+        for (u = 0; u < nunits && r < nranks; u++) {
+            if (filled[u] < counts[u]) {
+                int dest = ranks[r];
+                mem[*nmem].unit   = units[u];
+                mem[*nmem].rank   = dest;
+                mem[*nmem].weight = 1.0;
+                (*nmem)++;
+                load[dest] += total[units[u]] / (uint64_t)counts[u];
+                filled[u]++;
+                r++;
+            }
+        }
+    }
+
+    mfu_free(&filled);
+    mfu_free(&counts);
+}
+
+/* given the bytes we hold in each unit, compute the same mapping of
+ * units to ranks on all ranks from the global byte totals of each unit.
+ *
+ * When the job spans several compute nodes and there are at least as
+ * many OSTs as nodes, OSTs are first spread over nodes by LPT, with the
+ * load of a node measured per rank, and then over the ranks of each
+ * node, so that ranks on one node work on different OSTs and the
+ * traffic of each node goes to its own set of OSTs.  If the mapping of
+ * OSTs to servers (OSS) is known, whole servers are spread over nodes
+ * instead, as long as there are at least as many servers as nodes.
+ * Otherwise, OSTs are spread over all ranks at once.
+ *
+ * Chunks not on a known OST can go anywhere, so they are then used to
+ * level the load, filling up the least loaded ranks first. */
+static void mfu_chunk_plan(mfu_chunk_assign_t* a)
+{
+    int ranks = a->ranks;
+    int units = a->units;
+    int plain = a->ost_count;
+
+    /* get total bytes in each unit */
+    uint64_t* total = (uint64_t*) MFU_MALLOC((size_t)units * sizeof(uint64_t));
+    MPI_Allreduce(a->unit_bytes, total, units, MPI_UINT64_T, MPI_SUM, MPI_COMM_WORLD);
+
+    /* each OST has at most one member per rank in its node, and
+     * the remaining unit may have all ranks */
+    size_t max_members = (size_t)units + 2 * (size_t)ranks;
+    mfu_chunk_member_t* mem = (mfu_chunk_member_t*) MFU_MALLOC(max_members * sizeof(mfu_chunk_member_t));
+    int nmem = 0;
+
+    uint64_t* load = (uint64_t*) MFU_MALLOC((size_t)ranks * sizeof(uint64_t));
+    int* all_ranks = (int*) MFU_MALLOC((size_t)ranks * sizeof(int));
+    int* all_osts  = (int*) MFU_MALLOC(((size_t)plain + 1) * sizeof(int));
+    int u, r, n;
+    for (r = 0; r < ranks; r++) {
+        load[r] = 0;
+        all_ranks[r] = r;
+    }
+    for (u = 0; u < plain; u++) {
+        all_osts[u] = u;
+    }
+
+    int nodes = a->node_count;
+    if (nodes > 1 && plain >= nodes) {
+        /* spread servers over nodes if there are enough of them,
+         * otherwise treat each OST as its own server */
+        int servers = a->server_count;
+        const int* server_of = a->server_of;
+        if (servers < nodes) {
+            servers = plain;
+            server_of = all_osts;
+        }
+
+        /* get bytes on each server, and order servers by decreasing bytes */
+        mfu_chunk_unit_bytes_t* order = (mfu_chunk_unit_bytes_t*) MFU_MALLOC(
+            (size_t)servers * sizeof(mfu_chunk_unit_bytes_t));
+        int s;
+        for (s = 0; s < servers; s++) {
+            order[s].bytes = 0;
+            order[s].unit  = s;
+        }
+        for (u = 0; u < plain; u++) {
+            order[server_of[u]].bytes += total[u];
+        }
+        qsort(order, (size_t)servers, sizeof(mfu_chunk_unit_bytes_t), mfu_chunk_unit_cmp);
+
+        /* get number of ranks on each node */
+        int* node_ranks = (int*) MFU_MALLOC((size_t)nodes * sizeof(int));
+        double* node_load = (double*) MFU_MALLOC((size_t)nodes * sizeof(double));
+        for (n = 0; n < nodes; n++) {
+            node_ranks[n] = 0;
+            node_load[n]  = 0.0;
+        }
+        for (r = 0; r < ranks; r++) {
+            node_ranks[a->node_of[r]]++;
+        }
+
+        /* give each server to the node that ends up with the least
+         * bytes per rank */
+        int* server_node = (int*) MFU_MALLOC((size_t)servers * sizeof(int));
+        for (s = 0; s < servers; s++) {
+            int best = 0;
+            double best_val = 0.0;
+            for (n = 0; n < nodes; n++) {
+                double val = (node_load[n] + (double) order[s].bytes) / (double) node_ranks[n];
+                if (n == 0 || val < best_val) {
+                    best = n;
+                    best_val = val;
+                }
+            }
+            server_node[order[s].unit] = best;
+            node_load[best] += (double) order[s].bytes;
+        }
+
+        /* spread the OSTs of each node over its ranks */
+        int* node_osts = (int*) MFU_MALLOC(((size_t)plain + 1) * sizeof(int));
+        int* node_rank_list = (int*) MFU_MALLOC((size_t)ranks * sizeof(int));
+        for (n = 0; n < nodes; n++) {
+            int nosts = 0;
+            for (u = 0; u < plain; u++) {
+                if (server_node[server_of[u]] == n) {
+                    node_osts[nosts++] = u;
+                }
+            }
+            int nranks = 0;
+            for (r = 0; r < ranks; r++) {
+                if (a->node_of[r] == n) {
+                    node_rank_list[nranks++] = r;
+                }
+            }
+            mfu_chunk_plan_ranks(node_osts, nosts, node_rank_list, nranks,
+                total, load, mem, &nmem);
+        }
+
+        mfu_free(&node_rank_list);
+        mfu_free(&node_osts);
+        mfu_free(&server_node);
+        mfu_free(&node_load);
+        mfu_free(&node_ranks);
+        mfu_free(&order);
+    } else {
+        mfu_chunk_plan_ranks(all_osts, plain, all_ranks, ranks,
+            total, load, mem, &nmem);
+    }
+
+    /* find the level to which the remaining bytes fill up
+     * the least loaded ranks */
+    if (total[plain] > 0) {
+        uint64_t* sorted = (uint64_t*) MFU_MALLOC((size_t)ranks * sizeof(uint64_t));
+        memcpy(sorted, load, (size_t)ranks * sizeof(uint64_t));
+        qsort(sorted, (size_t)ranks, sizeof(uint64_t), mfu_chunk_load_cmp);
+        double remaining = (double) total[plain];
+        double level = (double) sorted[0];
+        for (r = 0; r < ranks; r++) {
+            /* bytes needed to raise ranks 0..r up to the next load */
+            double next = (r + 1 < ranks) ? (double) sorted[r + 1] : 0.0;
+            double need = (double) (r + 1) * (next - (double) sorted[r]);
+            if (r + 1 == ranks || need >= remaining) {
+                level = (double) sorted[r] + remaining / (double) (r + 1);
+                break;
+            }
+            remaining -= need;
+        }
+        mfu_free(&sorted);
+
+        /* ranks below the level serve the remaining unit */
+        for (r = 0; r < ranks; r++) {
+            if ((double) load[r] < level) {
+                mem[nmem].unit   = plain;
+                mem[nmem].rank   = r;
+                mem[nmem].weight = level - (double) load[r];
+                nmem++;
+            }
+        }
+    }
+
+    /* sort members by unit, keeping the order within each unit */
+    int* counts = (int*) MFU_MALLOC((size_t)units * sizeof(int));
+    for (u = 0; u < units; u++) {
+        counts[u] = 0;
+    }
+    int i;
+    for (i = 0; i < nmem; i++) {
+        counts[mem[i].unit]++;
+    }
+
+    a->member_offsets = (int*) MFU_MALLOC(((size_t)units + 1) * sizeof(int));
+    a->members        = (int*) MFU_MALLOC(((size_t)nmem + 1) * sizeof(int));
+    a->weights        = (double*) MFU_MALLOC(((size_t)nmem + 1) * sizeof(double));
+    a->unit_weights   = (double*) MFU_MALLOC((size_t)units * sizeof(double));
+    a->cur_member     = (int*) MFU_MALLOC((size_t)units * sizeof(int));
+    a->cur_left       = (double*) MFU_MALLOC((size_t)units * sizeof(double));
+
+    int offset = 0;
+    for (u = 0; u < units; u++) {
+        a->member_offsets[u] = offset;
+        a->unit_weights[u] = 0.0;
+        offset += counts[u];
+    }
+    a->member_offsets[units] = offset;
+
+    int* filled = (int*) MFU_MALLOC((size_t)units * sizeof(int));
+    for (u = 0; u < units; u++) {
+        filled[u] = 0;
+    }
+    for (i = 0; i < nmem; i++) {
+        u = mem[i].unit;
+        int j = a->member_offsets[u] + filled[u];
+        a->members[j] = mem[i].rank;
+        a->weights[j] = mem[i].weight;
+        a->unit_weights[u] += mem[i].weight;
+        filled[u]++;
+    }
+
+    mfu_free(&filled);
+    mfu_free(&all_osts);
+    mfu_free(&all_ranks);
+    mfu_free(&load);
+    mfu_free(&mem);
+
+    /* combine stripes into chunks small enough that each member of
+     * a unit still gets several of them, a unit served by a single
+     * rank can use the largest chunks */
+    a->item_max = (uint64_t*) MFU_MALLOC((size_t)units * sizeof(uint64_t));
+    for (u = 0; u < units; u++) {
+        uint64_t item = a->coalesce_size;
+        if (counts[u] > 1) {
+            uint64_t share = total[u] / ((uint64_t)counts[u] * 4);
+            if (share < item) {
+                item = share;
+            }
+        }
+        if (item < a->chunk_size) {
+            item = a->chunk_size;
+        }
+        a->item_max[u] = (a->coalesce_size > 0) ? item : 0;
+    }
+
+    /* start each unit on a different member on each rank, so ranks
+     * do not all send their first chunks to the same member */
+    for (u = 0; u < units; u++) {
+        a->cur_member[u] = 0;
+        a->cur_left[u]   = 0.0;
+        if (counts[u] > 0) {
+            int m = a->rank % counts[u];
+            int i = a->member_offsets[u] + m;
+            a->cur_member[u] = m;
+            a->cur_left[u] = (double) a->unit_bytes[u] * a->weights[i] / a->unit_weights[u];
+        }
+    }
+
+    mfu_free(&counts);
+    mfu_free(&total);
+}
+
+/* pick the rank that will copy a chunk on the given object (OST) and
+ * append the chunk to the list for that rank */
+static void mfu_chunk_assign(
+    mfu_chunk_assign_t* a,
+    const char* name,
+    uint64_t idx,
+    uint64_t offset,
+    uint64_t length,
+    uint64_t stride,
+    uint64_t seg_length,
+    uint64_t file_size,
+    uint64_t ost)
+{
+    int rank = a->rank;
+    int worker_number = a->ranks;
+
+    int dest_rank;
+    int u = mfu_chunk_unit(a, ost);
+    int count = a->member_offsets[u + 1] - a->member_offsets[u];
+    if (count == 0) {
+        /* no rank was planned for this unit, which happens for
+         * empty files on OSTs without data, deal out round robin */
+        dest_rank = (int) ((a->next_plain + (uint64_t)rank) % (uint64_t)worker_number);
+        a->next_plain++;
+    } else {
+        /* give chunk to current member, and move on to the next
+         * member once its quota is used up */
+        const int* members = &a->members[a->member_offsets[u]];
+        const double* weights = &a->weights[a->member_offsets[u]];
+        dest_rank = members[a->cur_member[u]];
+        a->cur_left[u] -= (double) length;
+        int steps = 0;
+        while (length > 0 && a->cur_left[u] <= 0.0 && steps < count) {
+            int m = (a->cur_member[u] + 1) % count;
+            a->cur_member[u] = m;
+            a->cur_left[u] += (double) a->unit_bytes[u] * weights[m] / a->unit_weights[u];
+            steps++;
+        }
+    }
+
+    /* only count the chunk if we are predicting a plan */
+    if (a->sim_bytes != NULL) {
+        a->sim_bytes[dest_rank] += length;
+        a->sim_chunks[dest_rank]++;
+        a->sim_unit_bytes[u] += length;
+        a->sim_unit_chunks[u]++;
+        return;
+    }
+
+    mfu_file_chunk* elem = (mfu_file_chunk*) MFU_MALLOC(sizeof(mfu_file_chunk));
+    elem->name           = NULL; /* looked up by index on exchange */
+    elem->offset         = offset;
+    elem->length         = length;
+    elem->stride         = stride;
+    elem->seg_length     = (stride > 0) ? seg_length : length;
+    elem->file_size      = file_size;
+    elem->ost            = ost;
+    if (a->pair_count > 0 && ost != MFU_LAYOUT_OST_NONE) {
+        elem->ost = a->pair_src[ost];
+    }
+    elem->rank_of_owner  = (uint64_t) rank;
+    elem->index_of_owner = idx;
+    elem->next           = NULL;
+
+    if (dest_rank == rank) {
+        /* we keep this chunk, the name is copied once per file
+         * when we build the list we return */
+        if (a->local_count == 0 || a->local_last != idx) {
+            a->local_names += strlen(name) + 1;
+            a->local_last = idx;
+        }
+        a->local_count++;
+        if (*a->head == NULL) {
+            *a->head = elem;
+        }
+        if (*a->tail != NULL) {
+            (*a->tail)->next = elem;
+        }
+        *a->tail = elem;
+        return;
+    }
+
+    /* append element to list */
+    if (a->heads[dest_rank] == NULL) {
+        a->heads[dest_rank] = elem;
+    }
+    if (a->tails[dest_rank] != NULL) {
+        a->tails[dest_rank]->next = elem;
+    }
+    a->tails[dest_rank] = elem;
+
+    /* chunks of a file are assigned one after another, so we add
+     * an entry to the name table of a rank when the file changes */
+    if (a->counts[dest_rank] == 0) {
+        /* number of names and number of records */
+        a->bytes[dest_rank] += 2 * 8;
+    }
+    if (a->counts[dest_rank] == 0 || a->last_file[dest_rank] != idx) {
+        /* owner index, file size, and name */
+        a->bytes[dest_rank] += 2 * 8 + strlen(name) + 1;
+        a->names[dest_rank]++;
+        a->last_file[dest_rank] = idx;
+    }
+    a->counts[dest_rank]++;
+
+    /* record with name id, offset, length, stride, segment length, and ost */
+    a->bytes[dest_rank] += MFU_CHUNK_RECORD_SIZE;
+}
+
+/* print the maximum and mean bytes assigned to a rank */
+static void mfu_chunk_report_balance(const mfu_file_chunk* head)
+{
+    uint64_t bytes = 0;
+    const mfu_file_chunk* p;
+    for (p = head; p != NULL; p = p->next) {
+        bytes += p->length;
+    }
+
+    int ranks;
+    MPI_Comm_size(MPI_COMM_WORLD, &ranks);
+
+    uint64_t max_bytes, sum_bytes;
+    MPI_Reduce(&bytes, &max_bytes, 1, MPI_UINT64_T, MPI_MAX, 0, MPI_COMM_WORLD);
+    MPI_Reduce(&bytes, &sum_bytes, 1, MPI_UINT64_T, MPI_SUM, 0, MPI_COMM_WORLD);
+
+    if (mfu_rank == 0) {
+        double mean = (double) sum_bytes / (double) ranks;
+        double imbalance = (mean > 0.0) ? (double) max_bytes / mean : 1.0;
+
+        double max_tmp, mean_tmp;
+        const char* max_units;
+        const char* mean_units;
+        mfu_format_bytes(max_bytes, &max_tmp, &max_units);
+        mfu_format_bytes((uint64_t) mean, &mean_tmp, &mean_units);
+        MFU_LOG(MFU_LOG_INFO, "Chunk bytes per rank: max %.3lf %s, mean %.3lf %s, imbalance %.3lf",
+            max_tmp, max_units, mean_tmp, mean_units, imbalance);
+    }
+}
+
+/* return the number of stripes of size ssize on the given OST
+ * that may be combined into one strided chunk, 1 or less means
+ * the stripes are split into contiguous chunks */
+static uint64_t mfu_chunk_segments(const mfu_chunk_assign_t* a, uint64_t ost, uint64_t ssize)
+{
+    if (a->item_max == NULL) {
+        return 1;
+    }
+    int u = mfu_chunk_unit(a, ost);
+    return a->item_max[u] / ssize;
+}
+
+/* iterate through files and build up list of chunks we'll send
+ * to each task, chunks are cut along stripe boundaries so that each
+ * chunk lies on a single object, if tally is set, only add up the
+ * bytes in each unit of work rather than assigning chunks.
+ *
+ * Once the plan is known, stripes on the same object in consecutive
+ * rows of a component are combined into one strided chunk, which
+ * covers every stripe_count-th stripe starting at its offset, so that
+ * a widely striped file is not copied one stripe at a time. */
+static void mfu_chunk_walk(
+    mfu_flist list,
+    const mfu_layout* layouts,
+    uint64_t chunk_size,
+    mfu_chunk_assign_t* a,
+    int tally)
+{
+    uint64_t idx;
+    uint64_t size = mfu_flist_size(list);
     for (idx = 0; idx < size; idx++) {
         /* get type of item */
         mfu_filetype type = mfu_flist_file_get_type(list, idx);
 
-
         /* if we have a file, add up its chunks */
         if (type == MFU_TYPE_FILE) {
             /* get size of file */
+            const char* name   = mfu_flist_file_get_name(list, idx);
             uint64_t file_size = mfu_flist_file_get_size(list, idx);
+            const mfu_layout* layout = &layouts[idx];
+
+            /* an empty file still gets a chunk to create it */
+            if (file_size == 0 && !tally) {
+                mfu_chunk_assign(a, name, idx, 0, 0, 0, 0, 0, layout->comps[0].osts[0]);
+            }
+
+            int c;
+            for (c = 0; c < layout->count; c++) {
+                const mfu_layout_comp* comp = &layout->comps[c];
+
+                /* clip component to the file */
+                uint64_t comp_start = comp->start;
+                uint64_t comp_end   = (comp->end < file_size) ? comp->end : file_size;
+                if (comp_start >= comp_end) {
+                    continue;
+                }
+
+                /* size of one full row of stripes, guard against overflow
+                 * for layouts with a very large stripe size */
+                uint64_t ssize = comp->stripe_size;
+                uint64_t interval = MFU_LAYOUT_EOF;
+                if (ssize <= MFU_LAYOUT_EOF / comp->stripe_count) {
+                    interval = ssize * comp->stripe_count;
+                }
+
+                /* combine stripes of each object if there are several rows */
+                uint64_t i;
+                int multirow = (interval < comp_end - comp_start);
+                for (i = 0; multirow && i < comp->stripe_count; i++) {
+                    uint64_t nseg = mfu_chunk_segments(a, comp->osts[i], ssize);
+                    if (nseg < 2) {
+                        continue;
+                    }
+
+                    /* stop if stripe starts at or beyond the end */
+                    uint64_t left = comp_end - comp_start;
+                    if (i > 0 && ssize > (left - 1) / i) {
+                        break;
+                    }
+
+                    /* take up to nseg stripes of this object at a time */
+                    uint64_t start = comp_start + i * ssize;
+                    int done = 0;
+                    while (! done) {
+                        uint64_t off = start;
+                        uint64_t length = 0;
+                        uint64_t k;
+                        for (k = 0; k < nseg && ! done; k++) {
+                            uint64_t len = comp_end - start;
+                            if (len > ssize) {
+                                len = ssize;
+                            }
+                            length += len;
+                            if (interval >= comp_end - start) {
+                                done = 1;
+                            } else {
+                                start += interval;
+                            }
+                        }
 
-	uint64_t chunks = file_size /chunk_size;
-	uint64_t chunk_cnt = 0;
-        if (chunks * chunk_size < file_size || file_size == 0) {
-                chunks++;
-            }
-//	printf("rank %d idx %d # of chunks %d\n", rank, idx, chunks);
-
-            /* get layout information */
-            double start = MPI_Wtime();
-            layout = llapi_layout_get_by_path(mfu_flist_file_get_name(list, idx), 0);
-            double end = MPI_Wtime();
-            llapi_record_timing(start, end, &llapi_timing_info);
-//		printf("name: %s\n", mfu_flist_file_get_name(list, idx), 0); 
-           if (layout == NULL){
-                printf("errno: layout is NULL\n");
-            }
-            rc[0] = llapi_layout_comp_use(layout, 1);
-            if (rc[0]){
-                printf("error: layout component iteration failed\n");
-            }
-            while (1){
-                        rc[0] = llapi_layout_stripe_count_get(layout, &cnt);
-                        rc[1] = llapi_layout_stripe_size_get(layout, &ssize);
-                        rc[2] = llapi_layout_comp_extent_get(layout, &start, &end);
-                        if (rc[0] || rc[1] || rc[2]){
-                            printf("error: cannot get stripe information\n");
+                        /* with one stripe per row the stripes are adjacent */
+                        uint64_t stride = (k > 1 && interval != ssize) ? interval : 0;
+                        mfu_chunk_assign(a, name, idx, off, length, stride, ssize,
+                            file_size, comp->osts[i]);
+                    }
+                }
+
+                /* walk each row of stripes, and each stripe in the row */
+                uint64_t row = comp_start;
+                while (row < comp_end) {
+                    for (i = 0; i < comp->stripe_count; i++) {
+                        /* compute extent of this stripe in the file */
+                        uint64_t left = comp_end - row;
+                        if (i > 0 && ssize > (left - 1) / i) {
+                            /* stripe starts at or beyond the end */
+                            break;
+                        }
+
+                        /* skip stripes we combined above */
+                        if (multirow && mfu_chunk_segments(a, comp->osts[i], ssize) >= 2) {
                             continue;
-                    	}
-//			printf("cnt %d\n", cnt);
-                    interval = cnt * ssize;
-//			printf("interval %d\n", interval);
-                    end = (end < file_size) ? end : file_size;
-                    for (int i = 0; i < cnt; i++){
-                        rc[0] = llapi_layout_ost_index_get(layout, i, &ost_idx);
-                        if (rc[0]){
-                                goto here_exit;
                         }
-			int next_offset = 0;
-			for(int j=0; next_offset <=end; j++){
-//			printf("next_offset %d, rank: %d\n", next_offset, rank);
-			int off = (start + i * ssize) + (j*interval);
-//			if(off >= file_size && file_size != 0){
-			if(chunk_cnt >= chunks){
-				goto here_exit;
-			}
-                        mfu_file_chunk* elem = (mfu_file_chunk*) MFU_MALLOC(sizeof(mfu_file_chunk));
-                        elem->name             = mfu_flist_file_get_name(list, idx);
-                        elem->offset           = off;
-			next_offset = (start+i*ssize)+((j+1)*interval);
-                        elem->file_size        = file_size;
-			elem->ost	       = ost_idx;
-                        elem->rank_of_owner    = rank;
-                        elem->index_of_owner   = idx;
-                        elem->next             = NULL;
-                        int task_ost = ost_idx;
-			chunk_cnt++;
-			if (file_size < chunk_size){
-				elem -> length = file_size; 
-			}
-			else if ((elem->offset + chunk_size) > file_size){
-				elem-> length = file_size - elem->offset;
-			}
-			else{
-				elem->length = chunk_size;
-			}
-//			printf("file_size: %d, offset: %d\n", file_size, elem->offset); 
-//			printf("length: %d\n", elem->length);
-                        size_t pack_size = strlen(elem->name) + 1;
-                        pack_size += 6 * 8;
-                        int dest_rank, num_binded_worker;
-
-                        if (OST_NUMBER >= worker_number){
-                                dest_rank = task_ost % worker_number;
-//				printf("task_ost: %d worker_num: %d dest_rank: %d\n", task_ost, worker_number, dest_rank);
-			}
-                        else{
-                                int remainder = task_ost < (worker_number % OST_NUMBER) ? 1 : 0;
-                                num_binded_worker = worker_number / OST_NUMBER + remainder;
-                                dest_rank = (num_tasks_per_ost[task_ost] % num_binded_worker) * OST_NUMBER + task_ost;
-                                num_tasks_per_ost[task_ost]++;
+                        uint64_t stripe_start = row + i * ssize;
+                        uint64_t stripe_end = comp_end;
+                        if (ssize < comp_end - stripe_start) {
+                            stripe_end = stripe_start + ssize;
                         }
-			if (dest_rank == rank){
-				
-				mfu_file_chunk* p = malloc(sizeof(mfu_file_chunk));
-				p->next = NULL;
-				p->name = strdup(elem->name);
-				p->offset = off;
-				p->file_size = file_size;
-				p->length = elem->length;
-				p->ost = ost_idx;
-				p->rank_of_owner = rank;
-				p->index_of_owner = idx;			
-				
-				if(head == NULL)
-					head = p;
-				if(tail != NULL)
-					tail->next = p;
-				tail= p;
-			}
-			else{
-                        /* append element to list */
-                        if (heads[dest_rank] == NULL) {
-                            heads[dest_rank] = elem;
+
+                        /* split the stripe into chunks */
+                        uint64_t off = stripe_start;
+                        while (off < stripe_end) {
+                            uint64_t length = stripe_end - off;
+                            if (length > chunk_size) {
+                                length = chunk_size;
+                            }
+                            if (tally) {
+                                int u = mfu_chunk_unit(a, comp->osts[i]);
+                                a->unit_bytes[u] += length;
+                            } else {
+                                mfu_chunk_assign(a, name, idx, off, length, 0, 0,
+                                    file_size, comp->osts[i]);
+                            }
+                            off += length;
                         }
-                        if (tails[dest_rank] != NULL) {
-                            tails[dest_rank]->next = elem;
-                       	} 
-                        tails[dest_rank] = elem;
-                        counts[dest_rank]++;
-                        bytes[dest_rank] += pack_size;
-			}
-			} //end of inner for
-                    } //end of for 
-                   rc[0] = llapi_layout_comp_use(layout, 3);
-                    if (rc[0] == 0)
-                        continue;
-                    if (rc[0] < 0)
-                        printf("error: layout component iteration failed\n");
+                    }
+
+                    /* advance to next row */
+                    if (interval >= comp_end - row) {
                         break;
-                } //end of while
-                here_exit:
-			;		
+                    }
+                    row += interval;
+                }
+            }
+        }
+    }
+}
+
+/* return number of pieces we split a message of size bytes into */
+static uint64_t mfu_chunk_msg_pieces(uint64_t size)
+{
+    return (size + MFU_CHUNK_MSG_MAX - 1) / MFU_CHUNK_MSG_MAX;
+}
+
+/* post nonblocking sends (send=1) or receives (send=0) for a message
+ * of size bytes to or from peer, split into pieces whose counts fit in
+ * an int, messages between a pair of ranks are matched in order, so
+ * the pieces arrive in the right place, returns number of requests */
+static int mfu_chunk_msg_post(char* buf, uint64_t size, int peer, int send, MPI_Request* req)
+{
+    int n = 0;
+    uint64_t off = 0;
+    while (off < size) {
+        uint64_t len = size - off;
+        if (len > MFU_CHUNK_MSG_MAX) {
+            len = MFU_CHUNK_MSG_MAX;
+        }
+        if (send) {
+            MPI_Isend(buf + off, (int)len, MPI_BYTE, peer, 0, MPI_COMM_WORLD, &req[n]);
+        } else {
+            MPI_Irecv(buf + off, (int)len, MPI_BYTE, peer, 0, MPI_COMM_WORLD, &req[n]);
+        }
+        n++;
+        off += len;
+    }
+    return n;
+}
+
+/* Send each list of chunks built up in the assign struct to its rank,
+ * and return the list of chunks we keep and receive.
+ *
+ * The message to each rank starts with the number of file names and
+ * the number of chunk records, followed by the records and then the
+ * name table.  Each record refers to its file by its position in the
+ * name table, and each name table entry holds the index of the file in
+ * the flist of its owner, the file size, and the name, so a name is
+ * sent once per destination rather than once per chunk.  Values are
+ * packed as 64-bit integers and message sizes are 64-bit, messages
+ * larger than an int count are sent in pieces. */
+static mfu_file_chunk* mfu_chunk_exchange(mfu_chunk_assign_t* a)
+{
+    int ranks = a->ranks;
+    int i;
+
+    /* tell each rank how many bytes we'll send it */
+    uint64_t* recv_bytes = (uint64_t*) MFU_MALLOC((size_t)ranks * sizeof(uint64_t));
+    MPI_Alltoall(a->bytes, 1, MPI_UINT64_T, recv_bytes, 1, MPI_UINT64_T, MPI_COMM_WORLD);
+
+    /* compute total bytes and number of requests */
+    uint64_t send_total = 0;
+    uint64_t recv_total = 0;
+    uint64_t num_req = 0;
+    for (i = 0; i < ranks; i++) {
+        send_total += a->bytes[i];
+        recv_total += recv_bytes[i];
+        num_req += mfu_chunk_msg_pieces(a->bytes[i]);
+        num_req += mfu_chunk_msg_pieces(recv_bytes[i]);
+    }
+
+    /* pack chunks for all ranks into one buffer */
+    char* sendbuf = (char*) MFU_MALLOC((size_t)send_total + 1);
+    char* ptr = sendbuf;
+    const mfu_file_chunk* elem;
+    for (i = 0; i < ranks; i++) {
+        if (a->counts[i] == 0) {
+            continue;
+        }
+
+        mfu_pack_uint64(&ptr, a->names[i]);
+        mfu_pack_uint64(&ptr, a->counts[i]);
+
+        /* pack records, the name id advances when the file changes */
+        uint64_t name_id = 0;
+        const mfu_file_chunk* prev = NULL;
+        for (elem = a->heads[i]; elem != NULL; elem = elem->next) {
+            if (prev != NULL && elem->index_of_owner != prev->index_of_owner) {
+                name_id++;
+            }
+            mfu_pack_uint64(&ptr, name_id);
+            mfu_pack_uint64(&ptr, elem->offset);
+            mfu_pack_uint64(&ptr, elem->length);
+            mfu_pack_uint64(&ptr, elem->stride);
+            mfu_pack_uint64(&ptr, elem->seg_length);
+            mfu_pack_uint64(&ptr, elem->ost);
+            prev = elem;
+        }
+
+        /* pack name table */
+        prev = NULL;
+        for (elem = a->heads[i]; elem != NULL; elem = elem->next) {
+            if (prev == NULL || elem->index_of_owner != prev->index_of_owner) {
+                mfu_pack_uint64(&ptr, elem->index_of_owner);
+                mfu_pack_uint64(&ptr, elem->file_size);
+                const char* name = mfu_flist_file_get_name(a->list, elem->index_of_owner);
+                size_t len = strlen(name) + 1;
+                memcpy(ptr, name, len);
+                ptr += len;
+            }
+            prev = elem;
         }
     }
 
-    /* create storage to hold byte counts that we'll send
- *  *      * and receive, it would be best to use uint64_t here
- *   *           * but for that, we'd need to create a datatypen,
- *    *                * with an int, we should be careful we don't overflow */
-    int* send_counts = (int*) MFU_MALLOC((size_t)ranks * sizeof(int));
-    int* recv_counts = (int*) MFU_MALLOC((size_t)ranks * sizeof(int));
-    memset(send_counts, 0, ranks * sizeof(int));
-    memset(recv_counts, 0, ranks * sizeof(int));
-    /* initialize our send counts */
-    for (int i = 0; i < ranks; i++) {
-        /* TODO: check that we don't overflow here */
+    /* receive all data into one buffer, names of received chunks
+     * point into this buffer, so we keep it with the list */
+    char* recvbuf = (char*) MFU_MALLOC((size_t)recv_total + 1);
+    MPI_Request* req = (MPI_Request*) MFU_MALLOC(((size_t)num_req + 1) * sizeof(MPI_Request));
+    int nreq = 0;
+    char* recvptr = recvbuf;
+    for (i = 0; i < ranks; i++) {
+        nreq += mfu_chunk_msg_post(recvptr, recv_bytes[i], i, 0, &req[nreq]);
+        recvptr += recv_bytes[i];
+    }
+    char* sendptr = sendbuf;
+    for (i = 0; i < ranks; i++) {
+        nreq += mfu_chunk_msg_post(sendptr, a->bytes[i], i, 1, &req[nreq]);
+        sendptr += a->bytes[i];
+    }
+    MPI_Waitall(nreq, req, MPI_STATUSES_IGNORE);
+    mfu_free(&req);
+    mfu_free(&sendbuf);
+
+    /* count the records we received */
+    uint64_t count = a->local_count;
+    const char* packptr = recvbuf;
+    for (i = 0; i < ranks; i++) {
+        if (recv_bytes[i] > 0) {
+            const char* hdr = packptr;
+            uint64_t num_names, num_records;
+            mfu_unpack_uint64(&hdr, &num_names);
+            mfu_unpack_uint64(&hdr, &num_records);
+            count += num_records;
+        }
+        packptr += recv_bytes[i];
+    }
+
+    /* nothing to do */
+    if (count == 0) {
+        mfu_free(&recvbuf);
+        mfu_free(&recv_bytes);
+        return NULL;
+    }
+
+    /* allocate a block to hold all chunks */
+    mfu_chunk_block_t* block = (mfu_chunk_block_t*) MFU_MALLOC(
+        sizeof(mfu_chunk_block_t) + (size_t)count * sizeof(mfu_file_chunk));
+    block->names   = (char*) MFU_MALLOC((size_t)a->local_names + 1);
+    block->recvbuf = recvbuf;
+    mfu_file_chunk* chunks = block->chunks;
+
+    /* copy the chunks we keep, with one copy of each name */
+    uint64_t n = 0;
+    char* nameptr = block->names;
+    const char* name = NULL;
+    const mfu_file_chunk* prev = NULL;
+    for (elem = *a->head; elem != NULL; elem = elem->next) {
+        if (prev == NULL || elem->index_of_owner != prev->index_of_owner) {
+            const char* file = mfu_flist_file_get_name(a->list, elem->index_of_owner);
+            size_t len = strlen(file) + 1;
+            memcpy(nameptr, file, len);
+            name = nameptr;
+            nameptr += len;
+        }
+        chunks[n] = *elem;
+        chunks[n].name = name;
+        n++;
+        prev = elem;
+    }
+
+    /* unpack the chunks we received */
+    uint64_t* file_index = NULL;
+    uint64_t* file_size  = NULL;
+    const char** file_name = NULL;
+    uint64_t max_names = 0;
+    packptr = recvbuf;
+    for (i = 0; i < ranks; i++) {
+        if (recv_bytes[i] == 0) {
+            continue;
+        }
+
+        const char* msg = packptr;
+        packptr += recv_bytes[i];
+
+        uint64_t num_names, num_records;
+        mfu_unpack_uint64(&msg, &num_names);
+        mfu_unpack_uint64(&msg, &num_records);
+
+        /* read name table, which follows the records */
+        if (num_names > max_names) {
+            mfu_free(&file_index);
+            mfu_free(&file_size);
+            mfu_free(&file_name);
+            max_names  = num_names;
+            file_index = (uint64_t*) MFU_MALLOC((size_t)max_names * sizeof(uint64_t));
+            file_size  = (uint64_t*) MFU_MALLOC((size_t)max_names * sizeof(uint64_t));
+            file_name  = (const char**) MFU_MALLOC((size_t)max_names * sizeof(char*));
+        }
+        const char* table = msg + num_records * MFU_CHUNK_RECORD_SIZE;
+        uint64_t j;
+        for (j = 0; j < num_names; j++) {
+            mfu_unpack_uint64(&table, &file_index[j]);
+            mfu_unpack_uint64(&table, &file_size[j]);
+            file_name[j] = table;
+            table += strlen(table) + 1;
+        }
+
+        /* read records */
+        for (j = 0; j < num_records; j++) {
+            uint64_t name_id;
+            mfu_file_chunk* p = &chunks[n];
+            mfu_unpack_uint64(&msg, &name_id);
+            mfu_unpack_uint64(&msg, &p->offset);
+            mfu_unpack_uint64(&msg, &p->length);
+            mfu_unpack_uint64(&msg, &p->stride);
+            mfu_unpack_uint64(&msg, &p->seg_length);
+            mfu_unpack_uint64(&msg, &p->ost);
+            p->name           = file_name[name_id];
+            p->file_size      = file_size[name_id];
+            p->rank_of_owner  = (uint64_t) i;
+            p->index_of_owner = file_index[name_id];
+            n++;
+        }
+    }
+    mfu_free(&file_index);
+    mfu_free(&file_size);
+    mfu_free(&file_name);
+
+    /* link chunks in order */
+    for (n = 0; n < count; n++) {
+        chunks[n].next = (n + 1 < count) ? &chunks[n + 1] : NULL;
+    }
+
+    mfu_free(&recv_bytes);
+
+    return chunks;
+}
+
+/* replace OST indices at or above MFU_LAYOUT_OST_MAX in the given
+ * layouts with MFU_LAYOUT_OST_NONE, returns the number replaced */
+static uint64_t mfu_chunk_bound_osts(mfu_layout* layouts, uint64_t count)
+{
+    uint64_t bogus = 0;
+    uint64_t idx;
+    for (idx = 0; idx < count; idx++) {
+        int c;
+        for (c = 0; c < layouts[idx].count; c++) {
+            mfu_layout_comp* comp = &layouts[idx].comps[c];
+            uint64_t i;
+            for (i = 0; i < comp->stripe_count; i++) {
+                uint64_t ost = comp->osts[i];
+                if (ost != MFU_LAYOUT_OST_NONE && ost >= MFU_LAYOUT_OST_MAX) {
+                    comp->osts[i] = MFU_LAYOUT_OST_NONE;
+                    bogus++;
+                }
+            }
+        }
+    }
+    return bogus;
+}
+
+/* look up the layout of each item in the list, items that are not
+ * files get an empty layout, if dests is not NULL, also look up the
+ * layouts of the destination files and return them in pdest_layouts,
+ * the caller frees each layout and both arrays */
+static mfu_layout* mfu_chunk_get_layouts(mfu_flist list, const char** dests, mfu_layout** pdest_layouts)
+{
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    uint64_t idx;
+    uint64_t size = mfu_flist_size(list);
+
+    /* get layout provider, fall back to treating each file as a
+     * single object if the requested provider is not available */
+    mfu_layout_provider* prov = mfu_layout_provider_new();
+    if (prov == NULL) {
+        if (rank == 0) {
+            MFU_LOG(MFU_LOG_WARN, "Failed to create layout provider, using plain layouts");
+        }
+        prov = mfu_layout_provider_new_from_str("plain");
+    }
+
+    /* gather names and sizes of the files in our list, names are
+     * copied into one buffer since a list with compressed names
+     * only holds a few of its full paths at a time */
+    size_t name_bytes = 0;
+    for (idx = 0; idx < size; idx++) {
+        mfu_filetype type = mfu_flist_file_get_type(list, idx);
+        if (type == MFU_TYPE_FILE) {
+            name_bytes += strlen(mfu_flist_file_get_name(list, idx)) + 1;
+        }
+    }
+    char* names = (char*) MFU_MALLOC(name_bytes + 1);
+    char* name_ptr = names;
+
+    uint64_t files = 0;
+    const char** paths = (const char**) MFU_MALLOC(((size_t)size + 1) * sizeof(char*));
+    uint64_t* sizes    = (uint64_t*) MFU_MALLOC(((size_t)size + 1) * sizeof(uint64_t));
+    for (idx = 0; idx < size; idx++) {
+        mfu_filetype type = mfu_flist_file_get_type(list, idx);
+        if (type == MFU_TYPE_FILE) {
+            const char* name = mfu_flist_file_get_name(list, idx);
+            size_t len = strlen(name) + 1;
+            memcpy(name_ptr, name, len);
+            paths[files] = name_ptr;
+            sizes[files] = mfu_flist_file_get_size(list, idx);
+            name_ptr += len;
+            files++;
+        }
+    }
+
+    /* look up the layout of each file, we still copy a file
+     * if we can't get its layout by treating it as one object */
+    double layout_start = MPI_Wtime();
+    mfu_layout* file_layouts = (mfu_layout*) MFU_MALLOC(((size_t)files + 1) * sizeof(mfu_layout));
+    uint64_t queried = mfu_layout_get_list(prov, files, paths, sizes, file_layouts);
+
+    /* look up the layouts of the destination files */
+    mfu_layout* file_dest_layouts = NULL;
+    if (dests != NULL) {
+        /* list the files that have a destination, a file without
+         * one is left with an empty layout */
+        uint64_t* dest_files = (uint64_t*) MFU_MALLOC(((size_t)files + 1) * sizeof(uint64_t));
+        uint64_t file = 0;
+        uint64_t count = 0;
+        for (idx = 0; idx < size; idx++) {
+            mfu_filetype type = mfu_flist_file_get_type(list, idx);
+            if (type == MFU_TYPE_FILE) {
+                if (dests[idx] != NULL) {
+                    paths[count] = dests[idx];
+                    sizes[count] = sizes[file];
+                    dest_files[count] = file;
+                    count++;
+                }
+                file++;
+            }
+        }
+
+        mfu_layout* found = (mfu_layout*) MFU_MALLOC(((size_t)count + 1) * sizeof(mfu_layout));
+        queried += mfu_layout_get_list(prov, count, paths, sizes, found);
+
+        file_dest_layouts = (mfu_layout*) MFU_MALLOC(((size_t)files + 1) * sizeof(mfu_layout));
+        for (file = 0; file < files; file++) {
+            file_dest_layouts[file].count = 0;
+            file_dest_layouts[file].comps = NULL;
+        }
+        for (file = 0; file < count; file++) {
+            file_dest_layouts[dest_files[file]] = found[file];
+        }
+        mfu_free(&found);
+        mfu_free(&dest_files);
+    }
+    double layout_end = MPI_Wtime();
+    mfu_layout_provider_free(&prov);
+
+    /* drop object indices too large to be an OST */
+    uint64_t bogus = mfu_chunk_bound_osts(file_layouts, files);
+    if (file_dest_layouts != NULL) {
+        bogus += mfu_chunk_bound_osts(file_dest_layouts, files);
+    }
+
+    /* spread layouts out to match the list, items that are
+     * not files have no layout */
+    mfu_layout* layouts = (mfu_layout*) MFU_MALLOC(((size_t)size + 1) * sizeof(mfu_layout));
+    mfu_layout* dest_layouts = NULL;
+    if (dests != NULL) {
+        dest_layouts = (mfu_layout*) MFU_MALLOC(((size_t)size + 1) * sizeof(mfu_layout));
+    }
+    files = 0;
+    for (idx = 0; idx < size; idx++) {
+        layouts[idx].count = 0;
+        layouts[idx].comps = NULL;
+        if (dest_layouts != NULL) {
+            dest_layouts[idx].count = 0;
+            dest_layouts[idx].comps = NULL;
+        }
+
+        mfu_filetype type = mfu_flist_file_get_type(list, idx);
+        if (type == MFU_TYPE_FILE) {
+            layouts[idx] = file_layouts[files];
+            if (dest_layouts != NULL) {
+                dest_layouts[idx] = file_dest_layouts[files];
+            }
+            files++;
+        }
+    }
+    mfu_free(&file_layouts);
+    mfu_free(&file_dest_layouts);
+    mfu_free(&sizes);
+    mfu_free(&paths);
+    mfu_free(&names);
+
+    /* report time spent getting layouts */
+    uint64_t vals[3] = {files, queried, bogus};
+    uint64_t sums[3];
+    double layout_time = layout_end - layout_start;
+    double max_time;
+    MPI_Reduce(vals, sums, 3, MPI_UINT64_T, MPI_SUM, 0, MPI_COMM_WORLD);
+    MPI_Reduce(&layout_time, &max_time, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+    if (rank == 0) {
+        if (sums[2] > 0) {
+            MFU_LOG(MFU_LOG_WARN, "Ignoring %llu stripes on OST indices of %d or more",
+                (unsigned long long) sums[2], MFU_LAYOUT_OST_MAX);
+        }
+        MFU_LOG(MFU_LOG_VERBOSE, "Got layouts of %llu files (%llu queried) in %.3lf seconds",
+            (unsigned long long) sums[0], (unsigned long long) sums[1], max_time);
+    }
+
+    *pdest_layouts = dest_layouts;
+    return layouts;
+}
+
+/* free the OST maps and plan of the assign struct */
+static void mfu_chunk_assign_free(mfu_chunk_assign_t* a)
+{
+    mfu_free(&a->ost_dense);
+    mfu_free(&a->node_of);
+    mfu_free(&a->server_of);
+    mfu_free(&a->pair_src);
+    mfu_free(&a->pair_dst);
+    mfu_free(&a->unit_bytes);
+    mfu_free(&a->member_offsets);
+    mfu_free(&a->members);
+    mfu_free(&a->weights);
+    mfu_free(&a->unit_weights);
+    mfu_free(&a->cur_member);
+    mfu_free(&a->cur_left);
+    mfu_free(&a->item_max);
+}
+
+mfu_file_chunk* mfu_file_chunk_list_alloc(mfu_flist list, uint64_t chunk_size)
+{
+    return mfu_file_chunk_list_alloc_strided(list, chunk_size, 0);
+}
+
+mfu_file_chunk* mfu_file_chunk_list_alloc_strided(mfu_flist list, uint64_t chunk_size, uint64_t coalesce_size)
+{
+    return mfu_file_chunk_list_alloc_pairs(list, chunk_size, coalesce_size, NULL);
+}
+
+/* This is a long routine, but the idea is simple.  All tasks sum up
+ * the number of file chunks they have, and those are then evenly
+ * distributed amongst the processes.  */
+mfu_file_chunk* mfu_file_chunk_list_alloc_pairs(mfu_flist list, uint64_t chunk_size, uint64_t coalesce_size, const char** dests)
+{
+    MFU_TRACE_BEGIN("plan chunks");
+
+    /* get our rank and number of ranks */
+    int rank, ranks;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &ranks);
 
-        send_counts[i] = (i != rank && bytes[i] > 0) ? (int) bytes[i] : 0;
-//	printf("bytes %d send counts %d rank %d\n", bytes[i], send_counts[i], rank);
-    }
+    /* list of chunks we keep ourselves */
+    mfu_file_chunk* head = NULL;
+    mfu_file_chunk* tail = NULL;
 
+    uint64_t idx;
+    uint64_t size = mfu_flist_size(list);
 
-    /* exchange flags with ranks so everyone knows who they'll
- *      * receive data from */
-    MPI_Alltoall(send_counts, 1, MPI_INT, recv_counts, 1, MPI_INT, MPI_COMM_WORLD);
+    /* allocate a linked list for each process we'll send to */
+    mfu_file_chunk** heads = (mfu_file_chunk**) MFU_MALLOC((size_t)ranks * sizeof(mfu_file_chunk*));
+    mfu_file_chunk** tails = (mfu_file_chunk**) MFU_MALLOC((size_t)ranks * sizeof(mfu_file_chunk*));
+    uint64_t* counts    = (uint64_t*) MFU_MALLOC((size_t)ranks * sizeof(uint64_t));
+    uint64_t* bytes     = (uint64_t*) MFU_MALLOC((size_t)ranks * sizeof(uint64_t));
+    uint64_t* names     = (uint64_t*) MFU_MALLOC((size_t)ranks * sizeof(uint64_t));
+    uint64_t* last_file = (uint64_t*) MFU_MALLOC((size_t)ranks * sizeof(uint64_t));
 
-    int total_sends = 0, total_recvs = 0;
+    /* initialize values */
     for (int i = 0; i < ranks; i++) {
-        if (send_counts[i] > 0) total_sends++;
-        if (recv_counts[i] > 0) total_recvs++;
-//	printf("rank %d, from/to rank %d, send_counts %d recv_counts %d \n", rank, i, send_counts[i], recv_counts[i]);
+        heads[i]     = NULL;
+        tails[i]     = NULL;
+        counts[i]    = 0;
+        bytes[i]     = 0;
+        names[i]     = 0;
+        last_file[i] = 0;
     }
 
-//sy insert
-
-    int total_requests = total_sends + total_recvs;
+    /* look up layouts of the source files, and of the destinations if given */
+    mfu_layout* dest_layouts = NULL;
+    mfu_layout* layouts = mfu_chunk_get_layouts(list, dests, &dest_layouts);
+
+    /* state used to assign chunks to ranks */
+    mfu_chunk_assign_t assign;
+    assign.rank       = rank;
+    assign.ranks      = ranks;
+    assign.list       = list;
+    assign.head       = &head;
+    assign.tail       = &tail;
+    assign.heads      = heads;
+    assign.tails      = tails;
+    assign.counts     = counts;
+    assign.bytes      = bytes;
+    assign.names      = names;
+    assign.last_file  = last_file;
+    assign.local_count = 0;
+    assign.local_names = 0;
+    assign.local_last  = 0;
+    assign.next_plain = 0;
+    assign.chunk_size    = chunk_size;
+    assign.coalesce_size = coalesce_size;
+    assign.item_max      = NULL;
+    assign.pair_count    = 0;
+    assign.pair_src      = NULL;
+    assign.pair_dst      = NULL;
+    assign.sim_bytes     = NULL;
+
+    /* schedule by pairs of source and destination objects if we
+     * know where the data goes */
+    if (dest_layouts != NULL) {
+        mfu_chunk_pair_layouts(list, layouts, dest_layouts, &assign);
+        for (idx = 0; idx < size; idx++) {
+            mfu_layout_free(&dest_layouts[idx]);
+        }
+        mfu_free(&dest_layouts);
+    }
 
-    MPI_Request* request = (MPI_Request*) MFU_MALLOC((size_t)total_requests * sizeof(MPI_Request));
-    MPI_Status*  status  = (MPI_Status*)  MFU_MALLOC((size_t)total_requests * sizeof(MPI_Status));
+    /* find the OSTs used by the files across all ranks */
+    mfu_chunk_discover_osts(layouts, size, &assign);
+    assign.units = assign.ost_count + 1;
+    assign.unit_bytes = (uint64_t*) MFU_MALLOC((size_t)assign.units * sizeof(uint64_t));
+    memset(assign.unit_bytes, 0, (size_t)assign.units * sizeof(uint64_t));
 
-    /* post irecv to get sizes */
-/*
-int req_idx = 0;
+    /* find the compute nodes of ranks and the storage servers of OSTs,
+     * so that ranks on different nodes target different servers */
+    mfu_chunk_discover_nodes(&assign);
+    mfu_chunk_discover_servers(&assign);
+    if (rank == 0) {
+        MFU_LOG(MFU_LOG_VERBOSE, "Scheduling chunks from %d nodes over %d servers",
+            assign.node_count, assign.server_count);
+    }
 
-for (int i = 0;i < ranks; i++) {
-    if (i!= rank) {
-        MPI_Irecv(&recv_counts[i], 1, MPI_INT, i, 0, MPI_COMM_WORLD, &request[req_idx++]);
-        MPI_Irecv(&recv_counts[i], 1, MPI_INT, i, 0, MPI_COMM_WORLD, &request[i]);
+    /* add up the bytes we hold on each OST, use them to plan
+     * which ranks serve each OST, then assign the chunks */
+    mfu_chunk_walk(list, layouts, chunk_size, &assign, 1);
+    if (assign.pair_count > 0) {
+        mfu_chunk_report_pairs(&assign);
     }
-}
+    mfu_chunk_plan(&assign);
+    mfu_chunk_walk(list, layouts, chunk_size, &assign, 0);
 
-for (int i = 0; i < ranks; i++) {
-    if (i != rank) { // Skip sending to itself
-        MPI_Isend(&send_counts[i], 1, MPI_INT, i, 0, MPI_COMM_WORLD, &request[req_idx++]);
-        MPI_Isend(&send_counts[i], 1, MPI_INT, i, 0, MPI_COMM_WORLD, &request[i]);
-	}
-}
-total_requests=req_idx;
-*/
+    /* free layouts and OST maps */
+    for (idx = 0; idx < size; idx++) {
+        mfu_layout_free(&layouts[idx]);
+    }
+    mfu_free(&layouts);
+    mfu_chunk_assign_free(&assign);
 
-    /* wait for sizes to come in */
-//    MPI_Waitall(total_requests, request, status);
+    /* send chunks to the ranks that will process them */
+    mfu_file_chunk* chunks = mfu_chunk_exchange(&assign);
 
-    /* allocate memory and encode lists for sending */
+    /* free the chunk elements we built up, the names
+     * belong to the flist */
     for (int i = 0; i < ranks; i++) {
-        /* allocate buffer for this destination */
-	if (i != rank && bytes[i]>0){
-        size_t sendbuf_size = (size_t) bytes[i];
-        sendbufs[i] = (char*) MFU_MALLOC(sendbuf_size);
-
-        /* pack data into buffer */
-        char* sendptr = sendbufs[i];
         mfu_file_chunk* elem = heads[i];
         while (elem != NULL) {
-            /* pack file name */
-            strcpy(sendptr, elem->name);
-            sendptr += strlen(elem->name) + 1;
-
-            /* pack chunk id, count, and file size */
-            mfu_pack_uint64(&sendptr, elem->offset);
-            mfu_pack_uint64(&sendptr, elem->length);
-            mfu_pack_uint64(&sendptr, elem->file_size);
-            mfu_pack_uint64(&sendptr, elem->ost);
-            mfu_pack_uint64(&sendptr, elem->rank_of_owner);
-            mfu_pack_uint64(&sendptr, elem->index_of_owner);
-
-            /* go to next element */
+            mfu_file_chunk* tmp = elem;
             elem = elem->next;
+            mfu_free(&tmp);
         }
-	}
     }
-    for(int i =0; i < ranks; i++){
-        int listsize = mfu_file_chunk_list_size(heads[i]);
-    //        printf("rank %d to %d list size %d\n", rank,i, listsize);
+    mfu_file_chunk* elem = head;
+    while (elem != NULL) {
+        mfu_file_chunk* tmp = elem;
+        elem = elem->next;
+        mfu_free(&tmp);
     }
+    mfu_free(&heads);
+    mfu_free(&tails);
+    mfu_free(&counts);
+    mfu_free(&bytes);
+    mfu_free(&names);
+    mfu_free(&last_file);
 
-        int li = mfu_file_chunk_list_size(head);
-	
-//        printf("rank %d list size %d\n", rank, li);
-    /* sum up total bytes that we'll receive */
-    size_t recvbuf_size = 0;
-    for (int i = 0; i < ranks; i++) {
-	if (i != rank){
-        	recvbuf_size += (size_t) recv_counts[i];
-	}
+    /* report how evenly bytes were spread over ranks */
+    if (mfu_debug_level >= MFU_LOG_VERBOSE) {
+        mfu_chunk_report_balance(chunks);
     }
 
-    /* allocate memory for recvs */
-    char* recvbuf = (char*) MFU_MALLOC(recvbuf_size);
+    MFU_TRACE_END("plan chunks");
+    return chunks;
+}
 
-    /* post irecv for incoming data */
-    char* recvptr = recvbuf;
+/* Predict how chunks would be spread over the given number of ranks
+ * and nodes by running the planning and assignment of
+ * mfu_file_chunk_list_alloc_strided without building or sending any
+ * chunks.  The files stay with the ranks that hold them in the list,
+ * and the planned ranks are placed on nodes in blocks, so that rank r
+ * runs on node r * nodes / ranks. */
+mfu_file_chunk_plan* mfu_file_chunk_list_plan(mfu_flist list, uint64_t chunk_size, uint64_t coalesce_size, int ranks, int nodes)
+{
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
 
-//int req_idx = 0;
-//char** recv_buffers = (char**) MFU_MALLOC(ranks * sizeof(char*));
-/*for (int i = 0; i < ranks; i++) {
-    if (recv_counts[i] > 0) {
-        recv_buffers[i] = (char*) MFU_MALLOC(recv_counts[i]);
-    } else {
-        recv_buffers[i] = NULL; // No data expected from this rank
+    if (ranks < 1) {
+        ranks = 1;
+    }
+    if (nodes < 1) {
+        nodes = 1;
+    }
+    if (nodes > ranks) {
+        nodes = ranks;
     }
-}
 
+    uint64_t idx;
+    uint64_t size = mfu_flist_size(list);
 
-*/
-int req_id = 0;
-for (int i = 0; i < ranks; i++) {
-    if (recv_counts[i] > 0) {
-        MPI_Irecv(recvptr, recv_counts[i], MPI_BYTE, i, 0, MPI_COMM_WORLD, &request[req_id++]);
-	recvptr += recv_counts[i];
+    /* look up layouts of the files */
+    mfu_layout* dest_layouts = NULL;
+    mfu_layout* layouts = mfu_chunk_get_layouts(list, NULL, &dest_layouts);
+
+    /* state used to assign chunks to ranks, we never keep or send
+     * any chunks, so we need no lists */
+    mfu_chunk_assign_t assign;
+    memset(&assign, 0, sizeof(assign));
+    assign.rank          = rank;
+    assign.ranks         = ranks;
+    assign.chunk_size    = chunk_size;
+    assign.coalesce_size = coalesce_size;
+    assign.sim_bytes     = (uint64_t*) MFU_MALLOC((size_t)ranks * sizeof(uint64_t));
+    assign.sim_chunks    = (uint64_t*) MFU_MALLOC((size_t)ranks * sizeof(uint64_t));
+    memset(assign.sim_bytes,  0, (size_t)ranks * sizeof(uint64_t));
+    memset(assign.sim_chunks, 0, (size_t)ranks * sizeof(uint64_t));
+
+    /* find the OSTs used by the files across all ranks */
+    mfu_chunk_discover_osts(layouts, size, &assign);
+    int units = assign.ost_count + 1;
+    assign.units = units;
+    assign.unit_bytes      = (uint64_t*) MFU_MALLOC((size_t)units * sizeof(uint64_t));
+    assign.sim_unit_bytes  = (uint64_t*) MFU_MALLOC((size_t)units * sizeof(uint64_t));
+    assign.sim_unit_chunks = (uint64_t*) MFU_MALLOC((size_t)units * sizeof(uint64_t));
+    memset(assign.unit_bytes,      0, (size_t)units * sizeof(uint64_t));
+    memset(assign.sim_unit_bytes,  0, (size_t)units * sizeof(uint64_t));
+    memset(assign.sim_unit_chunks, 0, (size_t)units * sizeof(uint64_t));
+
+    /* place ranks on nodes in blocks */
+    int r;
+    assign.node_count = nodes;
+    assign.node_of = (int*) MFU_MALLOC((size_t)ranks * sizeof(int));
+    for (r = 0; r < ranks; r++) {
+        assign.node_of[r] = (int) (((int64_t)r * (int64_t)nodes) / (int64_t)ranks);
+    }
+    mfu_chunk_discover_servers(&assign);
+
+    /* plan and assign chunks as a copy would */
+    mfu_chunk_walk(list, layouts, chunk_size, &assign, 1);
+    mfu_chunk_plan(&assign);
+    mfu_chunk_walk(list, layouts, chunk_size, &assign, 0);
+
+    /* sum up the counts of all ranks */
+    mfu_file_chunk_plan* plan = (mfu_file_chunk_plan*) MFU_MALLOC(sizeof(mfu_file_chunk_plan));
+    plan->ranks       = ranks;
+    plan->nodes       = nodes;
+    plan->osts        = units;
+    plan->node_of     = assign.node_of;
+    plan->rank_bytes  = (uint64_t*) MFU_MALLOC((size_t)ranks * sizeof(uint64_t));
+    plan->rank_chunks = (uint64_t*) MFU_MALLOC((size_t)ranks * sizeof(uint64_t));
+    plan->ost_index   = (uint64_t*) MFU_MALLOC((size_t)units * sizeof(uint64_t));
+    plan->ost_bytes   = (uint64_t*) MFU_MALLOC((size_t)units * sizeof(uint64_t));
+    plan->ost_chunks  = (uint64_t*) MFU_MALLOC((size_t)units * sizeof(uint64_t));
+    plan->ost_ranks   = (int*) MFU_MALLOC((size_t)units * sizeof(int));
+    assign.node_of = NULL;
+
+    MPI_Allreduce(assign.sim_bytes,  plan->rank_bytes,  ranks, MPI_UINT64_T, MPI_SUM, MPI_COMM_WORLD);
+    MPI_Allreduce(assign.sim_chunks, plan->rank_chunks, ranks, MPI_UINT64_T, MPI_SUM, MPI_COMM_WORLD);
+    MPI_Allreduce(assign.sim_unit_bytes,  plan->ost_bytes,  units, MPI_UINT64_T, MPI_SUM, MPI_COMM_WORLD);
+    MPI_Allreduce(assign.sim_unit_chunks, plan->ost_chunks, units, MPI_UINT64_T, MPI_SUM, MPI_COMM_WORLD);
+
+    /* the plan is the same on all ranks */
+    int u;
+    for (idx = 0; idx < assign.ost_max; idx++) {
+        if (assign.ost_dense[idx] >= 0) {
+            plan->ost_index[assign.ost_dense[idx]] = idx;
+        }
+    }
+    plan->ost_index[units - 1] = MFU_LAYOUT_OST_NONE;
+    for (u = 0; u < units; u++) {
+        plan->ost_ranks[u] = assign.member_offsets[u + 1] - assign.member_offsets[u];
     }
-}
 
-for (int i = 0; i < ranks; i++) {
-    if (send_counts[i] > 0) {
-        MPI_Isend(sendbufs[i], send_counts[i], MPI_BYTE, i, 0, MPI_COMM_WORLD, &request[req_id++]);
+    /* free layouts, plan, and counts */
+    for (idx = 0; idx < size; idx++) {
+        mfu_layout_free(&layouts[idx]);
     }
+    mfu_free(&layouts);
+    mfu_chunk_assign_free(&assign);
+    mfu_free(&assign.sim_bytes);
+    mfu_free(&assign.sim_chunks);
+    mfu_free(&assign.sim_unit_bytes);
+    mfu_free(&assign.sim_unit_chunks);
+
+    return plan;
 }
 
-    /* waitall */
-    MPI_Waitall(total_requests, request, status);
-
-//for(int i = 0; i < ranks; i++){
-//	if(recv_counts[i] >0){
-	
-    /* iterate over all received data */
-//    const char* packptr = recv_buffers[i];
-    const char* packptr = recvbuf;
-//    const char* recvbuf_end = packptr + recv_counts[i];
-    char* recvbuf_end = recvbuf+recvbuf_size;
-    while (packptr < recvbuf_end) {
-        /* unpack file name */
-        const char* name = packptr;
-        packptr += strlen(name) + 1;
-
-        /* unpack chunk offset, count, and file size */
-        uint64_t offset, length, ost, file_size, rank_of_owner, index_of_owner;
-        mfu_unpack_uint64(&packptr, &offset);
-        mfu_unpack_uint64(&packptr, &length);
-        mfu_unpack_uint64(&packptr, &file_size);
-        mfu_unpack_uint64(&packptr, &ost);
-        mfu_unpack_uint64(&packptr, &rank_of_owner);
-        mfu_unpack_uint64(&packptr, &index_of_owner);
-
-        /* allocate memory for new struct and set next pointer to null */
-        mfu_file_chunk* p = malloc(sizeof(mfu_file_chunk));
-//        mfu_file_chunk* p = (mfu_file_chunk*) MFU_MALLOC(sizeof(mfu_file_chunk));
-        p->next = NULL;
-
-        /* set the fields of the struct */
-        p->name = strdup(name);
-        p->offset = offset;
-        p->length = length;
-        p->file_size = file_size;
-        p->ost = ost;
-        p->rank_of_owner = rank_of_owner;
-        p->index_of_owner = index_of_owner;
-
-        /* if the tail is not null then point the tail at the latest struct */
-        if (tail != NULL) {
-            tail->next = p;
-        }
-        
-        /* if head is not pointing at anything then this struct is head of list */
-        if (head == NULL) {
-            head = p;
-        }
-
-        /* have tail point at the current/last struct */
-        tail = p;
-    }
-//	}
-//}
-
-	int listsize = mfu_file_chunk_list_size(head);
-	printf("rank %d list size %d\n", rank, listsize);
-    /* free the linked lists, packed send buffers, and related arrays */
-    for (int i = 0; i < ranks; i++) {
-        mfu_free(&sendbufs[i]);
- //   mfu_free(&recv_buffers[i]); // Free individual buffers
-        /* free the element linked list for each rank.
- *          * Do not free elem->name because it is needed by the mfu_flist entry. */
-        mfu_file_chunk* elem = heads[i];
-        mfu_file_chunk* tmp;
-        while (elem != NULL) {
-            tmp = elem;
-            elem = elem->next;
-            mfu_free(&tmp);
+/* free a plan returned by mfu_file_chunk_list_plan */
+void mfu_file_chunk_plan_free(mfu_file_chunk_plan** pplan)
+{
+    if (pplan != NULL) {
+        mfu_file_chunk_plan* plan = *pplan;
+        if (plan != NULL) {
+            mfu_free(&plan->node_of);
+            mfu_free(&plan->rank_bytes);
+            mfu_free(&plan->rank_chunks);
+            mfu_free(&plan->ost_index);
+            mfu_free(&plan->ost_bytes);
+            mfu_free(&plan->ost_chunks);
+            mfu_free(&plan->ost_ranks);
         }
+        mfu_free(pplan);
     }
-    mfu_free(&heads);
-    mfu_free(&tails);
-    mfu_free(&counts);
-    mfu_free(&bytes);
-    mfu_free(&sendbufs);
-
-    //mfu_free(&recv_buffers); // Free the array of pointers
-    /* free the array for ranks recevied from */
-    //mfu_free(&recvranklist);
-
-    /* free the request and status messages */
-    mfu_free(&request);
-    mfu_free(&status);
-    
-    /* free the bytes counts arrays */
-    mfu_free(&send_counts);
-    mfu_free(&recv_counts);
-
-    /* free the receive buffer */
-    mfu_free(&recvbuf);
-
-    return head;
 }
 
-
-/* free the linked list of structs (copy elem's) */
+/* free the list of chunks allocated by mfu_file_chunk_list_alloc */
 void mfu_file_chunk_list_free(mfu_file_chunk** phead)
 {
     /* check whether we were given a pointer */
     if (phead != NULL) {
-        /* free the linked list of structs (mfu_file_chunk) */
-        mfu_file_chunk* tmp;
-        mfu_file_chunk* current = *phead;
-        while (current != NULL) {
-            /* get pointer to current element and advance current */
-            tmp = current;
-            current = current->next;
-
-            /* free the name string we had strdup'd */
-            mfu_free(&tmp->name);
-
-            /* free the element */
-            mfu_free(&tmp);
+        /* the head of the list is the first chunk in its block */
+        if (*phead != NULL) {
+            mfu_chunk_block_t* block = (mfu_chunk_block_t*)
+                ((char*)(*phead) - offsetof(mfu_chunk_block_t, chunks));
+            mfu_free(&block->names);
+            mfu_free(&block->recvbuf);
+            mfu_free(&block);
         }
 
         /* set caller's pointer to NULL to indicate it's freed */
@@ -513,6 +2005,18 @@ void mfu_file_chunk_list_free(mfu_file_chunk** phead)
     return;
 }
 
+uint64_t mfu_file_chunk_end(const mfu_file_chunk* p)
+{
+    if (p->stride == 0 || p->length == 0) {
+        return p->offset + p->length;
+    }
+
+    /* all segments are full except possibly the last */
+    uint64_t segments = (p->length + p->seg_length - 1) / p->seg_length;
+    uint64_t last = p->length - (segments - 1) * p->seg_length;
+    return p->offset + (segments - 1) * p->stride + last;
+}
+
 uint64_t mfu_file_chunk_list_size(const mfu_file_chunk* p)
 {
     uint64_t count = 0;
@@ -523,6 +2027,413 @@ uint64_t mfu_file_chunk_list_size(const mfu_file_chunk* p)
     return count;
 }
 
+/* Chunks shared through a queue are described in an exposed buffer,
+ * a fixed size record for each chunk followed by the file names. */
+#define MFU_CHUNK_QUEUE_FIELDS (10)
+#define MFU_CHUNK_QUEUE_RECORD (MFU_CHUNK_QUEUE_FIELDS * 8)
+
+/* state word of a queue holds the number of chunks taken from the
+ * front in the upper half and from the back in the lower half */
+#define MFU_CHUNK_QUEUE_FRONT(x) ((x) >> 32)
+#define MFU_CHUNK_QUEUE_BACK(x)  ((x) & 0xFFFFFFFFULL)
+
+struct mfu_file_chunk_queue_struct {
+    int rank;                /* our rank */
+    int ranks;               /* number of ranks */
+    uint64_t count;          /* number of chunks in our list */
+    mfu_file_chunk** chunks; /* our chunks in list order */
+    uint64_t* counts;        /* number of chunks on each rank */
+    uint64_t* seen;          /* last state word we saw on each rank */
+    MPI_Win state_win;       /* window holding the state word of each rank */
+    uint64_t* state;         /* our state word */
+    MPI_Win data_win;        /* window exposing our chunk descriptions */
+    char* data;              /* our chunk records and names */
+    int* victims;            /* ranks to steal from, in order of preference */
+    int next_victim;         /* position in victims of next rank to try */
+    int own_done;            /* whether we have taken all of our own chunks */
+    mfu_file_chunk stolen;   /* last chunk stolen from another rank */
+    char* stolen_name;       /* file name of stolen chunk */
+    uint64_t steals;         /* number of chunks we stole */
+    uint64_t steal_bytes;    /* bytes in chunks we stole */
+};
+
+/* take a chunk from the front (back=0) or back (back=1) of the list
+ * on rank, returns the index of the chunk we took or count if none are
+ * left.  We add one to the front or back count in the state word with
+ * a single atomic operation, which always succeeds, so a thief can't
+ * lose a race against an owner that keeps taking chunks.  If the counts
+ * already covered the list before we added ours, there was no chunk
+ * for us.  Chunks are only ever taken, so a list we saw empty stays
+ * empty and we need not look again. */
+static uint64_t mfu_chunk_queue_take(mfu_file_chunk_queue* q, int rank, int back)
+{
+    uint64_t count = q->counts[rank];
+    uint64_t cur = q->seen[rank];
+    if (MFU_CHUNK_QUEUE_FRONT(cur) + MFU_CHUNK_QUEUE_BACK(cur) >= count) {
+        return count;
+    }
+
+    uint64_t add = back ? 1 : (1ULL << 32);
+    MPI_Fetch_and_op(&add, &cur, MPI_UINT64_T, rank, 0, MPI_SUM, q->state_win);
+    MPI_Win_flush(rank, q->state_win);
+    q->seen[rank] = cur + add;
+
+    uint64_t front = MFU_CHUNK_QUEUE_FRONT(cur);
+    uint64_t taken = MFU_CHUNK_QUEUE_BACK(cur);
+    if (front + taken >= count) {
+        return count;
+    }
+    return back ? (count - 1 - taken) : front;
+}
+
+mfu_file_chunk_queue* mfu_file_chunk_queue_new(mfu_file_chunk* head)
+{
+    mfu_file_chunk_queue* q = (mfu_file_chunk_queue*) MFU_MALLOC(sizeof(mfu_file_chunk_queue));
+    MPI_Comm_rank(MPI_COMM_WORLD, &q->rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &q->ranks);
+    int rank  = q->rank;
+    int ranks = q->ranks;
+
+    /* list our chunks, and add up space for their names */
+    q->count = mfu_file_chunk_list_size(head);
+    q->chunks = (mfu_file_chunk**) MFU_MALLOC(((size_t)q->count + 1) * sizeof(mfu_file_chunk*));
+    size_t name_bytes = 0;
+    uint64_t i;
+    mfu_file_chunk* p = head;
+    for (i = 0; i < q->count; i++) {
+        q->chunks[i] = p;
+        if (i == 0 || p->name != q->chunks[i - 1]->name) {
+            name_bytes += strlen(p->name) + 1;
+        }
+        p = p->next;
+    }
+
+    /* describe each chunk, chunks of a file in a row share one name */
+    size_t data_size = (size_t)q->count * MFU_CHUNK_QUEUE_RECORD + name_bytes;
+    q->data = (char*) MFU_MALLOC(data_size + 1);
+    uint64_t* rec = (uint64_t*) q->data;
+    char* names = q->data + (size_t)q->count * MFU_CHUNK_QUEUE_RECORD;
+    uint64_t name_offset = 0;
+    uint64_t name_len = 0;
+    for (i = 0; i < q->count; i++) {
+        p = q->chunks[i];
+        if (i == 0 || p->name != q->chunks[i - 1]->name) {
+            name_offset = (uint64_t) (names - q->data);
+            name_len = strlen(p->name) + 1;
+            memcpy(names, p->name, (size_t)name_len);
+            names += name_len;
+        }
+        rec[0] = p->offset;
+        rec[1] = p->length;
+        rec[2] = p->stride;
+        rec[3] = p->seg_length;
+        rec[4] = p->file_size;
+        rec[5] = p->ost;
+        rec[6] = p->rank_of_owner;
+        rec[7] = p->index_of_owner;
+        rec[8] = name_offset;
+        rec[9] = name_len;
+        rec += MFU_CHUNK_QUEUE_FIELDS;
+    }
+
+    /* expose our state word and chunk descriptions */
+    MPI_Win_allocate((MPI_Aint)sizeof(uint64_t), (int)sizeof(uint64_t), MPI_INFO_NULL,
+        MPI_COMM_WORLD, &q->state, &q->state_win);
+    *q->state = 0;
+    MPI_Win_create(q->data, (MPI_Aint)data_size, 1, MPI_INFO_NULL,
+        MPI_COMM_WORLD, &q->data_win);
+
+    /* get number of chunks on each rank */
+    q->counts = (uint64_t*) MFU_MALLOC((size_t)ranks * sizeof(uint64_t));
+    MPI_Allgather(&q->count, 1, MPI_UINT64_T, q->counts, 1, MPI_UINT64_T, MPI_COMM_WORLD);
+    q->seen = (uint64_t*) MFU_MALLOC((size_t)ranks * sizeof(uint64_t));
+    int r;
+    for (r = 0; r < ranks; r++) {
+        q->seen[r] = 0;
+    }
+
+    /* identify our OST group by the OST holding most of our bytes */
+    uint64_t* ost_bytes = (uint64_t*) MFU_MALLOC(((size_t)q->count + 1) * 2 * sizeof(uint64_t));
+    for (i = 0; i < q->count; i++) {
+        ost_bytes[2 * i + 0] = q->chunks[i]->ost;
+        ost_bytes[2 * i + 1] = q->chunks[i]->length;
+    }
+    qsort(ost_bytes, (size_t)q->count, 2 * sizeof(uint64_t), mfu_chunk_pair_cmp);
+    uint64_t group = MFU_LAYOUT_OST_NONE;
+    uint64_t group_bytes = 0;
+    uint64_t run_bytes = 0;
+    for (i = 0; i < q->count; i++) {
+        if (i > 0 && ost_bytes[2 * i] != ost_bytes[2 * (i - 1)]) {
+            run_bytes = 0;
+        }
+        run_bytes += ost_bytes[2 * i + 1];
+        if (run_bytes > group_bytes) {
+            group = ost_bytes[2 * i];
+            group_bytes = run_bytes;
+        }
+    }
+    mfu_free(&ost_bytes);
+    uint64_t* groups = (uint64_t*) MFU_MALLOC((size_t)ranks * sizeof(uint64_t));
+    MPI_Allgather(&group, 1, MPI_UINT64_T, groups, 1, MPI_UINT64_T, MPI_COMM_WORLD);
+
+    /* identify our node by its lowest rank */
+    MPI_Comm node_comm;
+    MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL, &node_comm);
+    int leader = rank;
+    MPI_Allreduce(MPI_IN_PLACE, &leader, 1, MPI_INT, MPI_MIN, node_comm);
+    MPI_Comm_free(&node_comm);
+    int* leaders = (int*) MFU_MALLOC((size_t)ranks * sizeof(int));
+    MPI_Allgather(&leader, 1, MPI_INT, leaders, 1, MPI_INT, MPI_COMM_WORLD);
+
+    /* prefer ranks serving the same OST, so stolen chunks still go
+     * to that OST, then ranks on our node, then all others, starting
+     * after our own rank so that thieves spread over victims */
+    q->victims = (int*) MFU_MALLOC((size_t)ranks * sizeof(int));
+    int n = 0;
+    int pass;
+    for (pass = 0; pass < 3; pass++) {
+        int k;
+        for (k = 1; k < ranks; k++) {
+            r = (rank + k) % ranks;
+            int same_group = (group != MFU_LAYOUT_OST_NONE && groups[r] == group);
+            int same_node  = (leaders[r] == leader);
+            if ((pass == 0 && same_group) ||
+                (pass == 1 && !same_group && same_node) ||
+                (pass == 2 && !same_group && !same_node))
+            {
+                q->victims[n++] = r;
+            }
+        }
+    }
+    q->next_victim = 0;
+    mfu_free(&leaders);
+    mfu_free(&groups);
+
+    q->own_done    = 0;
+    q->stolen_name = NULL;
+    q->steals      = 0;
+    q->steal_bytes = 0;
+
+    /* start an access epoch to all ranks that lasts until we're done */
+    MPI_Win_lock_all(MPI_MODE_NOCHECK, q->state_win);
+    MPI_Win_lock_all(MPI_MODE_NOCHECK, q->data_win);
+
+    return q;
+}
+
+const mfu_file_chunk* mfu_file_chunk_queue_next(mfu_file_chunk_queue* q)
+{
+    /* take our own chunks from the front, in the order of our list */
+    if (! q->own_done) {
+        /* some MPI libraries only process one-sided operations that
+         * target us when we call into MPI, so poke the progress engine
+         * to serve ranks that wait to take our chunks */
+        int flag;
+        MPI_Iprobe(MPI_ANY_SOURCE, MPI_ANY_TAG, MPI_COMM_WORLD, &flag, MPI_STATUS_IGNORE);
+
+        uint64_t idx = mfu_chunk_queue_take(q, q->rank, 0);
+        if (idx < q->count) {
+            return q->chunks[idx];
+        }
+        q->own_done = 1;
+    }
+
+    /* then steal chunks from the back of the lists of other ranks */
+    int ranks = q->ranks;
+    while (q->next_victim < ranks - 1) {
+        int victim = q->victims[q->next_victim];
+        uint64_t idx = mfu_chunk_queue_take(q, victim, 1);
+        if (idx >= q->counts[victim]) {
+            /* nothing left on this rank, lists never grow,
+             * so there is no need to look here again */
+            q->next_victim++;
+            continue;
+        }
+
+        /* fetch the description of the chunk */
+        uint64_t rec[MFU_CHUNK_QUEUE_FIELDS];
+        MPI_Get(rec, MFU_CHUNK_QUEUE_FIELDS, MPI_UINT64_T, victim,
+            (MPI_Aint)(idx * MFU_CHUNK_QUEUE_RECORD), MFU_CHUNK_QUEUE_FIELDS, MPI_UINT64_T,
+            q->data_win);
+        MPI_Win_flush(victim, q->data_win);
+
+        mfu_free(&q->stolen_name);
+        q->stolen_name = (char*) MFU_MALLOC((size_t)rec[9]);
+        MPI_Get(q->stolen_name, (int)rec[9], MPI_CHAR, victim,
+            (MPI_Aint)rec[8], (int)rec[9], MPI_CHAR, q->data_win);
+        MPI_Win_flush(victim, q->data_win);
+
+        mfu_file_chunk* p = &q->stolen;
+        p->name           = q->stolen_name;
+        p->offset         = rec[0];
+        p->length         = rec[1];
+        p->stride         = rec[2];
+        p->seg_length     = rec[3];
+        p->file_size      = rec[4];
+        p->ost            = rec[5];
+        p->rank_of_owner  = rec[6];
+        p->index_of_owner = rec[7];
+        p->next           = NULL;
+
+        q->steals++;
+        q->steal_bytes += p->length;
+        return p;
+    }
+
+    return NULL;
+}
+
+void mfu_file_chunk_queue_report(const mfu_file_chunk_queue* q)
+{
+    /* get total and largest number of steals, and bytes stolen */
+    uint64_t vals[2] = {q->steals, q->steal_bytes};
+    uint64_t sums[2];
+    uint64_t max;
+    MPI_Reduce(vals, sums, 2, MPI_UINT64_T, MPI_SUM, 0, MPI_COMM_WORLD);
+    MPI_Reduce(&q->steals, &max, 1, MPI_UINT64_T, MPI_MAX, 0, MPI_COMM_WORLD);
+
+    if (q->rank == 0) {
+        double size_tmp;
+        const char* size_units;
+        mfu_format_bytes(sums[1], &size_tmp, &size_units);
+        MFU_LOG(MFU_LOG_INFO, "Stole %llu chunks (%.3lf %s), at most %llu by one rank",
+            (unsigned long long) sums[0], size_tmp, size_units, (unsigned long long) max);
+    }
+}
+
+void mfu_file_chunk_queue_free(mfu_file_chunk_queue** pq)
+{
+    if (pq != NULL && *pq != NULL) {
+        mfu_file_chunk_queue* q = *pq;
+
+        /* wait for all ranks to finish reading our chunks */
+        MPI_Win_unlock_all(q->data_win);
+        MPI_Win_unlock_all(q->state_win);
+        MPI_Win_free(&q->data_win);
+        MPI_Win_free(&q->state_win);
+
+        mfu_free(&q->stolen_name);
+        mfu_free(&q->victims);
+        mfu_free(&q->seen);
+        mfu_free(&q->counts);
+        mfu_free(&q->data);
+        mfu_free(&q->chunks);
+        mfu_free(pq);
+    }
+}
+
+/* sort chunks by file, and then by offset, a file is identified
+ * by its owner since only its owner lists it */
+static int mfu_chunk_file_cmp(const void* a, const void* b)
+{
+    const mfu_file_chunk* x = (const mfu_file_chunk*) a;
+    const mfu_file_chunk* y = (const mfu_file_chunk*) b;
+    if (x->rank_of_owner != y->rank_of_owner) {
+        return (x->rank_of_owner < y->rank_of_owner) ? -1 : 1;
+    }
+    if (x->index_of_owner != y->index_of_owner) {
+        return (x->index_of_owner < y->index_of_owner) ? -1 : 1;
+    }
+    return (x->offset < y->offset) ? -1 : (x->offset > y->offset);
+}
+
+/* sort chunks by OST, and then by file and offset */
+static int mfu_chunk_ost_cmp(const void* a, const void* b)
+{
+    const mfu_file_chunk* x = (const mfu_file_chunk*) a;
+    const mfu_file_chunk* y = (const mfu_file_chunk*) b;
+    if (x->ost != y->ost) {
+        return (x->ost < y->ost) ? -1 : 1;
+    }
+    return mfu_chunk_file_cmp(a, b);
+}
+
+/* sort chunks by decreasing length, and then by file and offset */
+static int mfu_chunk_largest_cmp(const void* a, const void* b)
+{
+    const mfu_file_chunk* x = (const mfu_file_chunk*) a;
+    const mfu_file_chunk* y = (const mfu_file_chunk*) b;
+    if (x->length != y->length) {
+        return (x->length > y->length) ? -1 : 1;
+    }
+    return mfu_chunk_file_cmp(a, b);
+}
+
+void mfu_file_chunk_list_order(mfu_file_chunk* head, mfu_chunk_order order)
+{
+    uint64_t count = mfu_file_chunk_list_size(head);
+    if (order == MFU_CHUNK_ORDER_ARRIVAL || count < 2) {
+        return;
+    }
+
+    /* copy chunks out of the list, so we can write them back to
+     * the same elements in their new order */
+    mfu_file_chunk* sorted = (mfu_file_chunk*) MFU_MALLOC((size_t)count * sizeof(mfu_file_chunk));
+    uint64_t i;
+    mfu_file_chunk* p = head;
+    for (i = 0; i < count; i++) {
+        sorted[i] = *p;
+        p = p->next;
+    }
+
+    switch (order) {
+    case MFU_CHUNK_ORDER_FILE:
+        qsort(sorted, (size_t)count, sizeof(mfu_file_chunk), mfu_chunk_file_cmp);
+        break;
+    case MFU_CHUNK_ORDER_LARGEST:
+        qsort(sorted, (size_t)count, sizeof(mfu_file_chunk), mfu_chunk_largest_cmp);
+        break;
+    case MFU_CHUNK_ORDER_OST:
+    {
+        /* group chunks by OST, then deal out one chunk
+         * from each group in turn */
+        qsort(sorted, (size_t)count, sizeof(mfu_file_chunk), mfu_chunk_ost_cmp);
+        uint64_t groups = 0;
+        uint64_t* starts = (uint64_t*) MFU_MALLOC(((size_t)count + 1) * sizeof(uint64_t));
+        for (i = 0; i < count; i++) {
+            if (i == 0 || sorted[i].ost != sorted[i - 1].ost) {
+                starts[groups++] = i;
+            }
+        }
+        starts[groups] = count;
+
+        uint64_t* next = (uint64_t*) MFU_MALLOC((size_t)groups * sizeof(uint64_t));
+        uint64_t g;
+        for (g = 0; g < groups; g++) {
+            next[g] = starts[g];
+        }
+        mfu_file_chunk* dealt = (mfu_file_chunk*) MFU_MALLOC((size_t)count * sizeof(mfu_file_chunk));
+        uint64_t n = 0;
+        while (n < count) {
+            for (g = 0; g < groups; g++) {
+                if (next[g] < starts[g + 1]) {
+                    dealt[n++] = sorted[next[g]++];
+                }
+            }
+        }
+
+        mfu_free(&sorted);
+        sorted = dealt;
+        mfu_free(&next);
+        mfu_free(&starts);
+        break;
+    }
+    default:
+        break;
+    }
+
+    /* write chunks back, keeping the links of the list */
+    p = head;
+    for (i = 0; i < count; i++) {
+        mfu_file_chunk* next = p->next;
+        *p = sorted[i];
+        p->next = next;
+        p = next;
+    }
+
+    mfu_free(&sorted);
+}
+
 /* given an flist, a file chunk list generated from that flist,
  *  * and an input array of flags with one element per chunk,
  *   * execute a LOR per item in the flist, and return the result
@@ -603,7 +2514,7 @@ void mfu_file_chunk_list_lor(mfu_flist list, const mfu_file_chunk* head, const i
 	int j = 0;
     for (i = 0; i < list_count; i++) {
         /* if we have the last byte of the file, we need to send scan result to owner */
-        if (p->offset + p->length >= p->file_size) {
+        if (mfu_file_chunk_end(p) >= p->file_size) {
             /* increment count of items that will be sent to owner */
             int owner = (int) p->rank_of_owner;
             sendcounts[owner] += 2;
@@ -675,3 +2586,345 @@ void mfu_file_chunk_list_lor(mfu_flist list, const mfu_file_chunk* head, const i
 
     return;
 }
+
+/****************************************
+ * Per-OST statistics of chunks copied
+ ***************************************/
+
+/* default fraction of the median rate below which an OST is flagged */
+#define MFU_CHUNK_STATS_SLOW (0.5)
+
+/* counters are kept for each OST in a sorted list, and for chunks
+ * with an unknown OST in one more slot at the end */
+struct mfu_file_chunk_stats_struct {
+    uint64_t ost_count; /* number of OSTs in osts */
+    uint64_t* osts;     /* sorted list of OST indices */
+    uint64_t slots;     /* ost_count + 1 */
+    double slow;        /* fraction of median rate below which to flag an OST */
+    uint64_t* sums;     /* block holding the counters below, summed across ranks */
+    uint64_t* chunks;   /* number of chunks copied per slot */
+    uint64_t* bytes;    /* bytes copied per slot */
+    uint64_t* busy;     /* nsecs spent copying chunks per slot */
+    uint64_t* hist;     /* MFU_PERF_BUCKETS latency buckets per slot */
+    uint64_t* max;      /* longest chunk per slot */
+};
+
+/* copy count sorted values, dropping duplicates, returns new count */
+static uint64_t mfu_chunk_stats_unique(uint64_t* vals, uint64_t count)
+{
+    uint64_t n = 0;
+    uint64_t i;
+    for (i = 0; i < count; i++) {
+        if (n == 0 || vals[n - 1] != vals[i]) {
+            vals[n] = vals[i];
+            n++;
+        }
+    }
+    return n;
+}
+
+mfu_file_chunk_stats* mfu_file_chunk_stats_new(const mfu_file_chunk* head)
+{
+    int rank, ranks;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &ranks);
+
+    mfu_file_chunk_stats* s = (mfu_file_chunk_stats*) MFU_MALLOC(sizeof(mfu_file_chunk_stats));
+
+    /* get fraction of the median rate below which OSTs are flagged */
+    s->slow = MFU_CHUNK_STATS_SLOW;
+    char varname[] = "MFU_OST_SLOW";
+    const char* value = getenv(varname);
+    if (value != NULL) {
+        char* end;
+        double val = strtod(value, &end);
+        if (*end == '\0' && val > 0.0 && val < 1.0) {
+            s->slow = val;
+            if (rank == 0) {
+                MFU_LOG(MFU_LOG_INFO, "%s: %s", varname, value);
+            }
+        } else if (rank == 0) {
+            MFU_LOG(MFU_LOG_WARN, "Ignoring invalid %s: `%s'", varname, value);
+        }
+    }
+
+    /* list the distinct OSTs of our chunks */
+    uint64_t count = 0;
+    const mfu_file_chunk* p;
+    for (p = head; p != NULL; p = p->next) {
+        count++;
+    }
+    uint64_t* local = (uint64_t*) MFU_MALLOC(count * sizeof(uint64_t));
+    uint64_t n = 0;
+    for (p = head; p != NULL; p = p->next) {
+        if (p->ost != MFU_LAYOUT_OST_NONE) {
+            local[n] = p->ost;
+            n++;
+        }
+    }
+    qsort(local, (size_t)n, sizeof(uint64_t), mfu_chunk_load_cmp);
+    n = mfu_chunk_stats_unique(local, n);
+
+    /* gather the OSTs of all ranks, since chunks may be copied
+     * by a rank other than the one they were assigned to */
+    int* counts = (int*) MFU_MALLOC((size_t)ranks * sizeof(int));
+    int* disps  = (int*) MFU_MALLOC((size_t)ranks * sizeof(int));
+    int mycount = (int) n;
+    MPI_Allgather(&mycount, 1, MPI_INT, counts, 1, MPI_INT, MPI_COMM_WORLD);
+    int total = 0;
+    int i;
+    for (i = 0; i < ranks; i++) {
+        disps[i] = total;
+        total += counts[i];
+    }
+    uint64_t* all = (uint64_t*) MFU_MALLOC((size_t)total * sizeof(uint64_t));
+    MPI_Allgatherv(local, mycount, MPI_UINT64_T,
+        all, counts, disps, MPI_UINT64_T, MPI_COMM_WORLD);
+    qsort(all, (size_t)total, sizeof(uint64_t), mfu_chunk_load_cmp);
+    s->ost_count = mfu_chunk_stats_unique(all, (uint64_t)total);
+    s->osts      = all;
+    s->slots     = s->ost_count + 1;
+
+    /* allocate counters in one block so they can be reduced at once */
+    uint64_t fields = 3 + MFU_PERF_BUCKETS;
+    s->sums   = (uint64_t*) MFU_MALLOC(s->slots * fields * sizeof(uint64_t));
+    s->max    = (uint64_t*) MFU_MALLOC(s->slots * sizeof(uint64_t));
+    s->chunks = s->sums;
+    s->bytes  = s->chunks + s->slots;
+    s->busy   = s->bytes + s->slots;
+    s->hist   = s->busy + s->slots;
+    memset(s->sums, 0, s->slots * fields * sizeof(uint64_t));
+    memset(s->max, 0, s->slots * sizeof(uint64_t));
+
+    mfu_free(&disps);
+    mfu_free(&counts);
+    mfu_free(&local);
+
+    return s;
+}
+
+/* return the slot counting chunks of the given OST */
+static uint64_t mfu_chunk_stats_slot(const mfu_file_chunk_stats* s, uint64_t ost)
+{
+    uint64_t lo = 0;
+    uint64_t hi = s->ost_count;
+    while (lo < hi) {
+        uint64_t mid = lo + (hi - lo) / 2;
+        if (s->osts[mid] < ost) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo < s->ost_count && s->osts[lo] == ost) {
+        return lo;
+    }
+    return s->ost_count;
+}
+
+void mfu_file_chunk_stats_add(mfu_file_chunk_stats* s, const mfu_file_chunk* p, uint64_t start)
+{
+    uint64_t nsecs = mfu_perf_start() - start;
+    uint64_t slot  = mfu_chunk_stats_slot(s, p->ost);
+    __sync_fetch_and_add(&s->chunks[slot], 1);
+    __sync_fetch_and_add(&s->bytes[slot], p->length);
+    __sync_fetch_and_add(&s->busy[slot], nsecs);
+    __sync_fetch_and_add(&s->hist[slot * MFU_PERF_BUCKETS + mfu_perf_bucket(nsecs)], 1);
+
+    /* raise the maximum unless another thread beat us to it */
+    uint64_t max = s->max[slot];
+    while (nsecs > max) {
+        if (__sync_bool_compare_and_swap(&s->max[slot], max, nsecs)) {
+            break;
+        }
+        max = s->max[slot];
+    }
+}
+
+int mfu_file_chunk_stats_progress_count(const mfu_file_chunk_stats* s)
+{
+    return (int) (2 * s->slots);
+}
+
+void mfu_file_chunk_stats_progress_values(const mfu_file_chunk_stats* s, uint64_t* vals)
+{
+    memcpy(vals, s->bytes, s->slots * sizeof(uint64_t));
+    memcpy(vals + s->slots, s->busy, s->slots * sizeof(uint64_t));
+}
+
+/* sort rates in increasing order */
+static int mfu_chunk_stats_rate_cmp(const void* a, const void* b)
+{
+    double x = *(const double*) a;
+    double y = *(const double*) b;
+    return (x < y) ? -1 : (x > y);
+}
+
+/* compute the rate in bytes/sec of each OST that has copied data,
+ * fills in rates and returns the median rate, or 0 if none */
+static double mfu_chunk_stats_rates(
+    const mfu_file_chunk_stats* s,
+    const uint64_t* bytes,
+    const uint64_t* busy,
+    double* rates)
+{
+    /* chunks with an unknown OST are not compared */
+    uint64_t n = 0;
+    uint64_t i;
+    double* sorted = (double*) MFU_MALLOC(s->slots * sizeof(double));
+    for (i = 0; i < s->ost_count; i++) {
+        rates[i] = 0.0;
+        if (busy[i] > 0) {
+            rates[i] = (double) bytes[i] / ((double) busy[i] * 1.0e-9);
+            sorted[n] = rates[i];
+            n++;
+        }
+    }
+
+    qsort(sorted, (size_t)n, sizeof(double), mfu_chunk_stats_rate_cmp);
+
+    double median = 0.0;
+    if (n > 0) {
+        median = (n % 2 == 1) ? sorted[n / 2] : 0.5 * (sorted[n / 2 - 1] + sorted[n / 2]);
+    }
+
+    mfu_free(&sorted);
+    return median;
+}
+
+void mfu_file_chunk_stats_progress_log(const mfu_file_chunk_stats* s, const uint64_t* vals)
+{
+    const uint64_t* bytes = vals;
+    const uint64_t* busy  = vals + s->slots;
+
+    double* rates = (double*) MFU_MALLOC(s->slots * sizeof(double));
+    double median = mfu_chunk_stats_rates(s, bytes, busy, rates);
+
+    /* list a few of the slow OSTs on one line */
+    char line[1024];
+    size_t len = 0;
+    line[0] = '\0';
+    uint64_t slow = 0;
+    uint64_t i;
+    for (i = 0; i < s->ost_count; i++) {
+        if (busy[i] == 0 || rates[i] >= s->slow * median) {
+            continue;
+        }
+        if (slow < 8) {
+            double rate_tmp;
+            const char* rate_units;
+            mfu_format_bw(rates[i], &rate_tmp, &rate_units);
+            int rc = snprintf(line + len, sizeof(line) - len, "%s%llu (%.3lf %s)",
+                (slow > 0) ? ", " : "", (unsigned long long) s->osts[i], rate_tmp, rate_units);
+            if (rc > 0 && (size_t)rc < sizeof(line) - len) {
+                len += (size_t)rc;
+            }
+        }
+        slow++;
+    }
+
+    if (slow > 0) {
+        double median_tmp;
+        const char* median_units;
+        mfu_format_bw(median, &median_tmp, &median_units);
+        if (slow > 8) {
+            MFU_LOG(MFU_LOG_INFO, "Slow OSTs (median %.3lf %s): %s, and %llu more",
+                median_tmp, median_units, line, (unsigned long long) (slow - 8));
+        } else {
+            MFU_LOG(MFU_LOG_INFO, "Slow OSTs (median %.3lf %s): %s",
+                median_tmp, median_units, line);
+        }
+    }
+
+    mfu_free(&rates);
+}
+
+void mfu_file_chunk_stats_report(const mfu_file_chunk_stats* s)
+{
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    /* sum counters and get the longest chunk of each OST */
+    uint64_t fields = 3 + MFU_PERF_BUCKETS;
+    uint64_t* sums = (uint64_t*) MFU_MALLOC(s->slots * fields * sizeof(uint64_t));
+    uint64_t* max  = (uint64_t*) MFU_MALLOC(s->slots * sizeof(uint64_t));
+    MPI_Reduce(s->sums, sums, (int)(s->slots * fields), MPI_UINT64_T, MPI_SUM, 0, MPI_COMM_WORLD);
+    MPI_Reduce(s->max, max, (int)s->slots, MPI_UINT64_T, MPI_MAX, 0, MPI_COMM_WORLD);
+
+    if (rank == 0) {
+        const uint64_t* chunks = sums;
+        const uint64_t* bytes  = chunks + s->slots;
+        const uint64_t* busy   = bytes + s->slots;
+        const uint64_t* hist   = busy + s->slots;
+
+        double* rates = (double*) MFU_MALLOC(s->slots * sizeof(double));
+        double median = mfu_chunk_stats_rates(s, bytes, busy, rates);
+        rates[s->ost_count] = 0.0;
+        if (busy[s->ost_count] > 0) {
+            rates[s->ost_count] = (double) bytes[s->ost_count] / ((double) busy[s->ost_count] * 1.0e-9);
+        }
+
+        MFU_LOG(MFU_LOG_INFO, "%8s %8s %12s %14s %12s %12s %12s",
+            "OST", "Chunks", "Bytes", "Rate", "p50", "p99", "Max");
+
+        uint64_t slow = 0;
+        uint64_t i;
+        for (i = 0; i < s->slots; i++) {
+            if (chunks[i] == 0) {
+                continue;
+            }
+
+            char name[32];
+            if (i < s->ost_count) {
+                snprintf(name, sizeof(name), "%llu", (unsigned long long) s->osts[i]);
+            } else {
+                snprintf(name, sizeof(name), "unknown");
+            }
+
+            double bytes_tmp, rate_tmp, p50_tmp, p99_tmp, max_tmp;
+            const char *bytes_units, *rate_units, *p50_units, *p99_units, *max_units;
+            const uint64_t* h = hist + i * MFU_PERF_BUCKETS;
+            mfu_format_bytes(bytes[i], &bytes_tmp, &bytes_units);
+            mfu_format_bw(rates[i], &rate_tmp, &rate_units);
+            mfu_perf_format_time(mfu_perf_percentile(h, chunks[i], max[i], 0.50), &p50_tmp, &p50_units);
+            mfu_perf_format_time(mfu_perf_percentile(h, chunks[i], max[i], 0.99), &p99_tmp, &p99_units);
+            mfu_perf_format_time((double) max[i], &max_tmp, &max_units);
+
+            /* flag OSTs that copy well below the median rate */
+            const char* flag = "";
+            if (i < s->ost_count && busy[i] > 0 && rates[i] < s->slow * median) {
+                flag = " SLOW";
+                slow++;
+            }
+
+            MFU_LOG(MFU_LOG_INFO, "%8s %8llu %8.3lf %-3s %8.3lf %-5s %8.3lf %-3s %8.3lf %-3s %8.3lf %-3s%s",
+                name, (unsigned long long) chunks[i], bytes_tmp, bytes_units,
+                rate_tmp, rate_units, p50_tmp, p50_units, p99_tmp, p99_units,
+                max_tmp, max_units, flag);
+        }
+
+        if (slow > 0) {
+            double median_tmp;
+            const char* median_units;
+            mfu_format_bw(median, &median_tmp, &median_units);
+            MFU_LOG(MFU_LOG_WARN, "%llu OSTs copied at less than %.0f%% of the median rate of %.3lf %s",
+                (unsigned long long) slow, s->slow * 100.0, median_tmp, median_units);
+        }
+
+        mfu_free(&rates);
+    }
+
+    mfu_free(&max);
+    mfu_free(&sums);
+}
+
+void mfu_file_chunk_stats_free(mfu_file_chunk_stats** pstats)
+{
+    if (pstats != NULL && *pstats != NULL) {
+        mfu_file_chunk_stats* s = *pstats;
+        mfu_free(&s->max);
+        mfu_free(&s->sums);
+        mfu_free(&s->osts);
+        mfu_free(pstats);
+    }
+}
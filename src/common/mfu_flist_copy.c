@@ -47,6 +47,7 @@
 
 #include <libgen.h> /* dirname */
 #include <stdbool.h>
+#include <pthread.h>
 #include "libcircle.h"
 #include "dtcmp.h"
 
@@ -82,23 +83,59 @@ typedef struct {
     int64_t  total_links;        /* sum of all symlinks */
     int64_t  total_size;         /* sum of all file sizes */
     int64_t  total_bytes_copied; /* total bytes written */
+    int64_t  total_bytes_cloned; /* bytes copied by cloning whole files (FICLONERANGE) */
+    int64_t  total_bytes_offload;/* bytes copied in the kernel with copy_file_range */
     time_t   time_started;       /* time when dcp command started */
     time_t   time_ended;         /* time when dcp command ended */
     double   wtime_started;      /* time when dcp command started */
     double   wtime_ended;        /* time when dcp command ended */
 } mfu_copy_stats_t;
 
-/* cache open file descriptor to avoid
- * opening / closing the same file */
+/* one open file in the file descriptor cache */
 typedef struct {
-    char* name;    /* name of open file (NULL if none) */
-    int   read;    /* whether file is open for read-only (1) or write (0) */
-    int   fd;      /* file descriptor */
+    char*    name;  /* name of open file (NULL if slot is empty) */
+    uint32_t hash;  /* hash of name to speed up lookups */
+    int      read;  /* whether file is open for read-only (1) or write (0) */
+    int      fd;    /* file descriptor */
 #ifdef DAOS_SUPPORT
     dfs_obj_t* obj; /* open object */
 #endif
+    uint64_t used;  /* value of cache clock when entry was last accessed */
+} mfu_copy_file_cache_entry_t;
+
+/* cache open file descriptors to avoid opening / closing the
+ * same file when a process copies interleaved chunks from many
+ * files, entries are evicted in least-recently-used order */
+typedef struct {
+    int      size;    /* number of entries in cache */
+    uint64_t clock;   /* incremented on each access for LRU tracking */
+    uint64_t opens;   /* number of files opened through the cache */
+    uint64_t closes;  /* number of files closed by the cache */
+    uint64_t hits;    /* number of lookups satisfied by an open entry */
+    uint64_t fsyncs;  /* number of fsync calls on files opened for write */
+    mfu_copy_file_cache_entry_t* entries; /* array of size entries */
 } mfu_copy_file_cache_t;
 
+/* state of the helper thread that writes data blocks in a pipelined
+ * copy, at most one write request is outstanding at any time */
+typedef struct {
+    pthread_t       thread;   /* helper thread */
+    pthread_mutex_t lock;     /* protects fields below */
+    pthread_cond_t  cond;     /* signaled when a request is posted or completed */
+    int             running;  /* whether the helper thread has been started */
+    int             shutdown; /* set to ask the helper thread to exit */
+    int             pending;  /* whether a write request is queued or in progress */
+    int             error;    /* set if a write failed since the last drain */
+    char*           src;      /* name of source file for error messages */
+    char*           dest;     /* name of destination file */
+    mfu_file_t      file;     /* copy of destination file handle */
+    const char*     buf;      /* buffer holding data to be written */
+    size_t          size;     /* number of bytes to write */
+    off_t           offset;   /* offset in destination file */
+    bool            direct;   /* whether destination is opened with O_DIRECT */
+    bool            sparse;   /* whether to skip blocks of zeros */
+} mfu_copy_writer_t;
+
 /****************************************
  * Define globals
  ***************************************/
@@ -146,9 +183,338 @@ static void mkdir_progress_fn(const uint64_t* vals, int count, int complete, int
     }
 }
 
-/** Cache most recent open file descriptor to avoid opening / closing the same file */
-static mfu_copy_file_cache_t mfu_copy_src_cache;
-static mfu_copy_file_cache_t mfu_copy_dst_cache;
+/** Helper thread to overlap writes with reads in mfu_copy_file_normal */
+static mfu_copy_writer_t mfu_copy_writer;
+
+/* write a block of data to the destination file, loop to account
+ * for short writes, returns 0 on success and -1 on error */
+static int mfu_copy_write_block(
+    const char* src,
+    const char* dest,
+    const char* buf,
+    size_t bytes_to_write,
+    off_t off,
+    bool direct,
+    mfu_file_t* mfu_dst_file)
+{
+    /* we loop to account for short writes */
+    ssize_t n = 0;
+    while (n < bytes_to_write) {
+        /* write bytes to destination file */
+        ssize_t bytes_written = mfu_file_pwrite(dest, buf + n, bytes_to_write - n, off + n, mfu_dst_file);
+
+        /* check for an error */
+        if (bytes_written < 0) {
+            MFU_LOG(MFU_LOG_ERR, "Write error when copying from `%s' to `%s' (errno=%d %s)",
+                src, dest, errno, strerror(errno));
+            return -1;
+        }
+
+        /* So long as we're not using O_DIRECT, we can handle short writes
+         * by advancing by the number of bytes written.  For O_DIRECT, we
+         * need to keep buffer, file offset, and amount to write aligned
+         * on block boundaries, so just retry the entire operation. */
+        if (!direct || bytes_written == bytes_to_write) {
+            n += bytes_written;
+        }
+    }
+
+    return 0;
+}
+
+/* write a buffer to the destination file, in sparse mode any
+ * MFU_ZERO_BLOCK_SIZE blocks that are all zero are skipped so they
+ * become holes, and the remaining data is written as one write per
+ * run of nonzero blocks, returns 0 on success and -1 on error */
+static int mfu_copy_write_extents(
+    const char* src,
+    const char* dest,
+    const char* buf,
+    size_t bytes_to_write,
+    off_t off,
+    bool direct,
+    bool sparse,
+    mfu_file_t* mfu_dst_file)
+{
+    if (! sparse) {
+        return mfu_copy_write_block(src, dest, buf, bytes_to_write,
+            off, direct, mfu_dst_file);
+    }
+
+    /* Rely on posix hole semantics to account for skipped 0 values.
+     * Destination files are truncated before a sparse copy, and
+     * if a hole is at the end of the file, the truncate after the
+     * last chunk will set the file size correctly. */
+    size_t pos = 0;
+    while (pos < bytes_to_write) {
+        /* skip over blocks of zeros */
+        pos += mfu_zero_span(buf + pos, bytes_to_write - pos, 1);
+        if (pos >= bytes_to_write) {
+            break;
+        }
+
+        /* write the run of blocks that hold data, block boundaries are
+         * aligned with the buffer and offset so this is valid for O_DIRECT */
+        size_t len = mfu_zero_span(buf + pos, bytes_to_write - pos, 0);
+        if (mfu_copy_write_block(src, dest, buf + pos, len,
+            off + (off_t)pos, direct, mfu_dst_file) != 0)
+        {
+            return -1;
+        }
+        pos += len;
+    }
+
+    return 0;
+}
+
+/* main loop of helper thread, waits for write requests and executes them */
+static void* mfu_copy_writer_main(void* arg)
+{
+    mfu_copy_writer_t* w = (mfu_copy_writer_t*) arg;
+
+    pthread_mutex_lock(&w->lock);
+    while (1) {
+        /* wait for a request or for the signal to exit */
+        while (! w->pending && ! w->shutdown) {
+            pthread_cond_wait(&w->cond, &w->lock);
+        }
+        if (! w->pending && w->shutdown) {
+            break;
+        }
+
+        /* the request fields are not modified by the main
+         * thread while pending is set, so we can drop the lock */
+        pthread_mutex_unlock(&w->lock);
+        int rc = mfu_copy_write_extents(w->src, w->dest, w->buf, w->size,
+            w->offset, w->direct, w->sparse, &w->file);
+        pthread_mutex_lock(&w->lock);
+
+        /* mark request as complete and wake the main thread */
+        if (rc != 0) {
+            w->error = 1;
+        }
+        w->pending = 0;
+        pthread_cond_broadcast(&w->cond);
+    }
+    pthread_mutex_unlock(&w->lock);
+
+    return NULL;
+}
+
+/* start the helper thread used for pipelined copies */
+static void mfu_copy_writer_start(mfu_copy_writer_t* w)
+{
+    w->running  = 0;
+    w->shutdown = 0;
+    w->pending  = 0;
+    w->error    = 0;
+    w->src      = NULL;
+    w->dest     = NULL;
+    w->buf      = NULL;
+
+    pthread_mutex_init(&w->lock, NULL);
+    pthread_cond_init(&w->cond, NULL);
+
+    int rc = pthread_create(&w->thread, NULL, mfu_copy_writer_main, w);
+    if (rc != 0) {
+        MFU_LOG(MFU_LOG_WARN, "Failed to start I/O thread, disabling pipelined copy (errno=%d %s)",
+            rc, strerror(rc));
+        pthread_cond_destroy(&w->cond);
+        pthread_mutex_destroy(&w->lock);
+        return;
+    }
+
+    w->running = 1;
+}
+
+/* wait until any outstanding write has completed,
+ * returns -1 if a write failed since the last drain, 0 otherwise */
+static int mfu_copy_writer_drain(mfu_copy_writer_t* w)
+{
+    if (! w->running) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&w->lock);
+    while (w->pending) {
+        pthread_cond_wait(&w->cond, &w->lock);
+    }
+    int rc = w->error ? -1 : 0;
+    w->error = 0;
+    pthread_mutex_unlock(&w->lock);
+
+    return rc;
+}
+
+/* hand a block to the helper thread to be written, first waits for
+ * the previous write to complete, returns -1 if that write failed,
+ * the caller must not modify buf until the next drain or post */
+static int mfu_copy_writer_post(
+    mfu_copy_writer_t* w,
+    const char* src,
+    const char* dest,
+    const char* buf,
+    size_t size,
+    off_t offset,
+    bool direct,
+    bool sparse,
+    const mfu_file_t* mfu_dst_file)
+{
+    int rc = mfu_copy_writer_drain(w);
+
+    pthread_mutex_lock(&w->lock);
+
+    /* only copy file names when they change */
+    if (w->src == NULL || strcmp(w->src, src) != 0) {
+        mfu_free(&w->src);
+        w->src = MFU_STRDUP(src);
+    }
+    if (w->dest == NULL || strcmp(w->dest, dest) != 0) {
+        mfu_free(&w->dest);
+        w->dest = MFU_STRDUP(dest);
+    }
+
+    /* capture the file handle, since the caller may open
+     * a different file in its handle before this write completes */
+    w->file    = *mfu_dst_file;
+    w->buf     = buf;
+    w->size    = size;
+    w->offset  = offset;
+    w->direct  = direct;
+    w->sparse  = sparse;
+    w->pending = 1;
+    pthread_cond_broadcast(&w->cond);
+
+    pthread_mutex_unlock(&w->lock);
+
+    return rc;
+}
+
+/* wait for outstanding writes, stop the helper thread, and free its
+ * resources, returns -1 if a write failed since the last drain */
+static int mfu_copy_writer_stop(mfu_copy_writer_t* w)
+{
+    if (! w->running) {
+        return 0;
+    }
+
+    int rc = mfu_copy_writer_drain(w);
+
+    pthread_mutex_lock(&w->lock);
+    w->shutdown = 1;
+    pthread_cond_broadcast(&w->cond);
+    pthread_mutex_unlock(&w->lock);
+
+    pthread_join(w->thread, NULL);
+    pthread_cond_destroy(&w->cond);
+    pthread_mutex_destroy(&w->lock);
+
+    mfu_free(&w->src);
+    mfu_free(&w->dest);
+    w->running = 0;
+
+    return rc;
+}
+
+/** Cache recently opened file descriptors to avoid opening / closing the same file,
+ * each I/O thread keeps its own caches */
+static __thread mfu_copy_file_cache_t mfu_copy_src_cache;
+static __thread mfu_copy_file_cache_t mfu_copy_dst_cache;
+
+/* allocate entries for a file cache with the given number of slots */
+static void mfu_copy_file_cache_init(mfu_copy_file_cache_t* cache, int size)
+{
+    /* always keep at least one file open */
+    if (size < 1) {
+        size = 1;
+    }
+
+    cache->size   = size;
+    cache->clock  = 0;
+    cache->opens  = 0;
+    cache->closes = 0;
+    cache->hits   = 0;
+    cache->fsyncs = 0;
+    cache->entries = (mfu_copy_file_cache_entry_t*) MFU_MALLOC(
+        (size_t)size * sizeof(mfu_copy_file_cache_entry_t));
+
+    int i;
+    for (i = 0; i < size; i++) {
+        mfu_copy_file_cache_entry_t* entry = &cache->entries[i];
+        entry->name = NULL;
+        entry->hash = 0;
+        entry->read = 0;
+        entry->fd   = -1;
+#ifdef DAOS_SUPPORT
+        entry->obj  = NULL;
+#endif
+        entry->used = 0;
+    }
+}
+
+/* point mfu_file at the descriptor held in a cache entry */
+static void mfu_copy_file_cache_select(
+    const mfu_copy_file_cache_entry_t* entry,
+    mfu_file_t* mfu_file)
+{
+    if (mfu_file->type == POSIX) {
+        mfu_file->fd = entry->fd;
+    }
+#ifdef DAOS_SUPPORT
+    if (mfu_file->type == DFS) {
+        mfu_file->obj = entry->obj;
+    }
+#endif
+}
+
+/* close the file held in a cache entry (fsync first if it was opened
+ * for writing) and mark the slot as empty */
+static int mfu_copy_file_cache_evict(
+    mfu_copy_file_cache_t* cache,
+    mfu_copy_file_cache_entry_t* entry,
+    mfu_file_t* mfu_file)
+{
+    int rc = 0;
+
+    char* name = entry->name;
+    if (name == NULL) {
+        return rc;
+    }
+
+    /* the helper thread may still be writing to this file */
+    if (! entry->read && mfu_copy_writer_drain(&mfu_copy_writer) != 0) {
+        rc = -1;
+    }
+
+    /* operate on a copy so that we don't clobber the
+     * descriptor the caller currently has selected */
+    mfu_file_t tmp_file = *mfu_file;
+    mfu_copy_file_cache_select(entry, &tmp_file);
+
+    /* if open for write, fsync */
+    if (! entry->read && tmp_file.type == POSIX) {
+        int sync_rc = mfu_fsync(name, tmp_file.fd);
+        if (sync_rc != 0) {
+            rc = sync_rc;
+        }
+        cache->fsyncs++;
+    }
+
+    /* close the file and delete the name string */
+    int close_rc = mfu_file_close(name, &tmp_file);
+    if (close_rc != 0) {
+        rc = close_rc;
+    }
+    cache->closes++;
+    mfu_free(&entry->name);
+
+    entry->fd = -1;
+#ifdef DAOS_SUPPORT
+    entry->obj = NULL;
+#endif
+
+    return rc;
+}
 
 /* open and cache a file.
  * Returns 0 on success; -1 otherwise */
@@ -159,22 +525,46 @@ static int mfu_copy_open_file(
     mfu_copy_opts_t* copy_opts,   /* options configuring the copy operation */
     mfu_file_t* mfu_file)         /* whether the file is in POSIX/DAOS */
 {
-    /* see if we have a cached file descriptor */
-    char* name = cache->name;
-    if (name != NULL) {
-        /* we have a cached file descriptor */
-        if (strcmp(name, file) == 0 && cache->read == read_flag) {
+    /* advance clock for LRU tracking */
+    cache->clock++;
+
+    /* see if we have a cached file descriptor, while scanning
+     * remember an empty slot or the least recently used entry
+     * in case we need to open the file */
+    uint32_t hash = mfu_hash_jenkins(file, strlen(file));
+    mfu_copy_file_cache_entry_t* victim = NULL;
+    int i;
+    for (i = 0; i < cache->size; i++) {
+        mfu_copy_file_cache_entry_t* entry = &cache->entries[i];
+        if (entry->name == NULL) {
+            /* prefer an empty slot over evicting an open file */
+            if (victim == NULL || victim->name != NULL) {
+                victim = entry;
+            }
+            continue;
+        }
+
+        if (entry->hash == hash &&
+            entry->read == read_flag &&
+            strcmp(entry->name, file) == 0)
+        {
             /* the file we're trying to open matches name and read/write mode,
              * so just return the cached descriptor */
+            entry->used = cache->clock;
+            cache->hits++;
+            mfu_copy_file_cache_select(entry, mfu_file);
             return 0;
-        } else {
-            /* the file we're trying to open is different,
-             * close the old file and delete the name */
-            mfu_file_close(name, mfu_file);
-            mfu_free(&cache->name);
+        }
+
+        if (victim == NULL || (victim->name != NULL && entry->used < victim->used)) {
+            victim = entry;
         }
     }
 
+    /* the file is not in the cache, close the least recently
+     * used file if all slots are taken */
+    mfu_copy_file_cache_evict(cache, victim, mfu_file);
+
     /* open the new file, this sets mfu_file->fd/obj */
     if (read_flag) {
         int flags = O_RDONLY;
@@ -199,9 +589,12 @@ static int mfu_copy_open_file(
             return -1;
         }
 
-        cache->name = MFU_STRDUP(file);
-        cache->fd   = mfu_file->fd;
-        cache->read = read_flag;
+        victim->name = MFU_STRDUP(file);
+        victim->hash = hash;
+        victim->fd   = mfu_file->fd;
+        victim->read = read_flag;
+        victim->used = cache->clock;
+        cache->opens++;
 
 #ifdef LUSTRE_SUPPORT
         /* Zero is an invalid ID for grouplock. */
@@ -227,40 +620,68 @@ static int mfu_copy_open_file(
             return -1;
         }
         
-        cache->name = MFU_STRDUP(file);
-        cache->read = read_flag;
-        cache->obj  = mfu_file->obj;
+        victim->name = MFU_STRDUP(file);
+        victim->hash = hash;
+        victim->read = read_flag;
+        victim->obj  = mfu_file->obj;
+        victim->used = cache->clock;
+        cache->opens++;
     }
 #endif
 
     return 0;
 }
 
-/* close a file that opened with mfu_copy_open_file */
+/* close all files that were opened with mfu_copy_open_file
+ * and free the cache entries */
 static int mfu_copy_close_file(
     mfu_copy_file_cache_t* cache,
     mfu_file_t* mfu_file)
 {
     int rc = 0;
 
-    /* close file if we have one */
-    char* name = cache->name;
-    if (name != NULL) {
-        int fd = cache->fd;
-        /* if open for write, fsync */
-        int read_flag = cache->read;
-        if (! read_flag && mfu_file->type == POSIX) {
-            rc = mfu_fsync(name, fd);
+    /* close files if we have any */
+    int i;
+    for (i = 0; i < cache->size; i++) {
+        int tmp_rc = mfu_copy_file_cache_evict(cache, &cache->entries[i], mfu_file);
+        if (tmp_rc != 0) {
+            rc = tmp_rc;
         }
-
-        /* close the file and delete the name string */
-        rc = mfu_file_close(name, mfu_file);
-        mfu_free(&cache->name);
     }
 
+    mfu_free(&cache->entries);
+    cache->size = 0;
+
     return rc;
 }
 
+/* sum open/close counters of file caches across ranks and print them */
+static void mfu_copy_file_cache_report(const char* msg)
+{
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    uint64_t values[6];
+    values[0] = mfu_copy_src_cache.opens;
+    values[1] = mfu_copy_src_cache.closes;
+    values[2] = mfu_copy_src_cache.hits;
+    values[3] = mfu_copy_dst_cache.opens;
+    values[4] = mfu_copy_dst_cache.closes;
+    values[5] = mfu_copy_dst_cache.fsyncs;
+
+    uint64_t sums[6];
+    MPI_Allreduce(values, sums, 6, MPI_UINT64_T, MPI_SUM, MPI_COMM_WORLD);
+
+    if (rank == 0) {
+        MFU_LOG(MFU_LOG_INFO, "%s: source opens=%llu closes=%llu hits=%llu, "
+            "destination opens=%llu closes=%llu fsyncs=%llu",
+            msg,
+            (unsigned long long) sums[0], (unsigned long long) sums[1],
+            (unsigned long long) sums[2], (unsigned long long) sums[3],
+            (unsigned long long) sums[4], (unsigned long long) sums[5]);
+    }
+}
+
 /* copy all extended attributes from op->operand to dest_path,
  * returns 0 on success and -1 on failure */
 static int mfu_copy_xattrs(
@@ -703,6 +1124,8 @@ static int mfu_copy_set_metadata(
     int rank;
     MPI_Comm_rank(MPI_COMM_WORLD, &rank);
 
+    MFU_TRACE_BEGIN("metadata");
+
     if (rank == 0) {
         if(copy_opts->preserve) {
             MFU_LOG(MFU_LOG_INFO, "Setting ownership, permissions, and timestamps.");
@@ -811,6 +1234,7 @@ static int mfu_copy_set_metadata(
         }
     }
 
+    MFU_TRACE_END("metadata");
     return rc;
 }
 
@@ -1084,6 +1508,8 @@ static int mfu_create_directories(
         return rc;
     }
 
+    MFU_TRACE_BEGIN("mkdir");
+
     /* indicate to user what phase we're in */
     if (rank == 0) {
         MFU_LOG(MFU_LOG_INFO, "Creating %llu directories", mkdir_total_count);
@@ -1126,6 +1552,7 @@ static int mfu_create_directories(
     /* finalize progress messages */
     mfu_progress_complete(&reduce_count, &mkdir_prog);
 
+    MFU_TRACE_END("mkdir");
     return rc;
 }
 
@@ -1205,6 +1632,38 @@ static int mfu_create_link(
     return rc;
 }
 
+/* create dest_path on Lustre with the stripe count and stripe size of
+ * src_path, so that the stripes of the two files line up one to one,
+ * returns 0 if the file was created, and -1 if the caller should create
+ * it as usual, e.g., because it already exists */
+static int mfu_create_file_mirror(const char* src_path, const char* dest_path)
+{
+    /* get striping of the source file */
+    uint64_t stripe_size  = 0;
+    uint64_t stripe_count = 0;
+    if (mfu_stripe_get(src_path, &stripe_size, &stripe_count) != 0 ||
+        stripe_size == 0 || stripe_count == 0)
+    {
+        return -1;
+    }
+
+    /* the stripes of an existing file can't be changed */
+    struct stat st;
+    if (mfu_lstat(dest_path, &st) == 0 || errno != ENOENT) {
+        return -1;
+    }
+
+    /* on failure, the caller creates the file with mknod,
+     * which reports any error that is not about striping */
+    if (mfu_stripe_create(dest_path, stripe_size, (int) stripe_count, DCOPY_DEF_PERMS_FILE) != 0) {
+        MFU_LOG(MFU_LOG_DBG, "Failed to create `%s' with source layout (errno=%d %s)",
+                dest_path, errno, strerror(errno));
+        return -1;
+    }
+
+    return 0;
+}
+
 /* creates inode in destpath for specified file, identifies source path
  * that contains source file, computes relative path to file under source path,
  * and creates file at same relative path under destpath, optionally copies
@@ -1240,10 +1699,16 @@ static int mfu_create_file(
 
     /* create file with mknod
      * for regular files, dev argument is supposed to be ignored,
-     * see makedev() to create valid dev */
+     * see makedev() to create valid dev,
+     * skip this if we created the file with the layout of its source */
     dev_t dev;
     memset(&dev, 0, sizeof(dev_t));
-    int mknod_rc = mfu_file_mknod(dest_path, DCOPY_DEF_PERMS_FILE | S_IFREG, dev, mfu_dst_file);
+    int mknod_rc = 0;
+    if (! copy_opts->mirror_layout ||
+        mfu_create_file_mirror(src_path, dest_path) != 0)
+    {
+        mknod_rc = mfu_file_mknod(dest_path, DCOPY_DEF_PERMS_FILE | S_IFREG, dev, mfu_dst_file);
+    }
     if(mknod_rc < 0) {
         if(errno == EEXIST) {
             /* destination already exists, no big deal, but print warning */
@@ -1487,6 +1952,8 @@ static int mfu_create_files(
         return rc;
     }
 
+    MFU_TRACE_BEGIN("create");
+
     /* indicate to user what phase we're in */
     if (rank == 0) {
         MFU_LOG(MFU_LOG_INFO, "Creating %llu files.", mknod_total_count);
@@ -1538,6 +2005,7 @@ static int mfu_create_files(
     /* finalize progress messages */
     mfu_progress_complete(&total_count, &create_prog); 
 
+    MFU_TRACE_END("create");
     return rc;
 }
 
@@ -1642,6 +2110,53 @@ static mfu_progress* copy_prog;
 static uint64_t copy_total_count;
 static uint64_t copy_count;
 
+/* when I/O threads copy data, they add bytes to copy_count_shared
+ * atomically and the main thread feeds that total to the progress
+ * messages, since only the main thread may call MPI */
+static int copy_threaded = 0;
+static uint64_t copy_count_shared;
+
+/* bytes, time, and latency of chunks copied from each OST */
+static mfu_file_chunk_stats* copy_ost_stats = NULL;
+
+/* values summed in progress messages, copy_count followed by the
+ * bytes and time of each OST in verbose mode */
+static uint64_t* copy_prog_vals = NULL;
+static int copy_prog_count = 0;
+
+/* contribute our current values to progress messages */
+static void mfu_copy_progress_update(void)
+{
+    if (copy_prog_vals == NULL) {
+        return;
+    }
+
+    copy_prog_vals[0] = copy_count;
+    if (copy_prog_count > 1) {
+        mfu_file_chunk_stats_progress_values(copy_ost_stats, &copy_prog_vals[1]);
+    }
+    mfu_progress_update(copy_prog_vals, copy_prog);
+}
+
+/* account for bytes copied for progress messages */
+static void mfu_copy_progress_add(uint64_t bytes)
+{
+    if (copy_threaded) {
+        __sync_fetch_and_add(&copy_count_shared, bytes);
+        return;
+    }
+
+    copy_count += bytes;
+    mfu_copy_progress_update();
+}
+
+/* add to a field of mfu_copy_stats, which may be updated
+ * by several I/O threads at once */
+static void mfu_copy_stats_add(int64_t* field, int64_t value)
+{
+    __sync_fetch_and_add(field, value);
+}
+
 /* progress message to print while copying data */
 static void copy_progress_fn(const uint64_t* vals, int count, int complete, int ranks, double secs)
 {
@@ -1678,26 +2193,20 @@ static void copy_progress_fn(const uint64_t* vals, int count, int complete, int
     if (complete < ranks) {
         MFU_LOG(MFU_LOG_INFO, "Copied %.3lf %s (%.0f%%) in %.3lf secs (%.3lf %s) %0.f secs left ...",
             agg_size_tmp, agg_size_units, percent, secs, agg_rate_tmp, agg_rate_units, secs_remaining);
+
+        /* point out OSTs that are holding up the copy */
+        if (count > 1) {
+            mfu_file_chunk_stats_progress_log(copy_ost_stats, &vals[1]);
+        }
     } else {
         MFU_LOG(MFU_LOG_INFO, "Copied %.3lf %s (%.0f%%) in %.3lf secs (%.3lf %s) done",
             agg_size_tmp, agg_size_units, percent, secs, agg_rate_tmp, agg_rate_units);
     }
 }
 
-/* return 1 if entire buffer is 0, return 0 if any byte is not 0,
- * we avoid writing NULL blocks when supporting sparse files */
-static int mfu_is_all_null(const char* buf, uint64_t buf_size)
-{
-    uint64_t i;
-    for (i = 0; i < buf_size; i++) {
-        if (buf[i] != 0) {
-            return 0;
-        }
-    }
-    return 1;
-}
-
-static int mfu_copy_file_normal(
+/* copy a chunk through user-space buffers, in pipelined mode the
+ * last write may still be in progress when this returns */
+static int mfu_copy_file_blocks(
     const char* src,
     const char* dest,
     uint64_t offset,
@@ -1711,6 +2220,10 @@ static int mfu_copy_file_normal(
     size_t buf_size = copy_opts->buf_size;
     void* buf       = copy_opts->block_buf1;
 
+    /* in pipelined mode, we alternate between our two buffers,
+     * reading into one while the helper thread writes the other */
+    int pipelined = mfu_copy_writer.running;
+
     /* for O_DIRECT, check that length is multiple of buf_size */
     if (copy_opts->direct &&           /* using O_DIRECT */
         offset + length < file_size && /* not at end of file */
@@ -1793,37 +2306,26 @@ static int mfu_copy_file_normal(
             bytes_to_write = buf_size;
         }
 
-        /* If in sparse mode, skip writing out blocks that are all 0.
-         * Rely on posix hole semantics to account for those 0 values instead.
-         * If this hole is at the end of the file, the truncate below will
-         * set the file size correctly. */
-        int skip_write = 0;
-        if (copy_opts->sparse && mfu_is_all_null(buf, bytes_to_write)) {
-            skip_write = 1;
-        }
-
-        /* write data to destination file if needed */
-        if (! skip_write) {
-            /* we loop to account for short writes */
-            ssize_t n = 0;
-            while (n < bytes_to_write) {
-                /* write bytes to destination file */
-                ssize_t bytes_written = mfu_file_pwrite(dest, ((char*)buf) + n, bytes_to_write - n, off + n, mfu_dst_file);
-
-                /* check for an error */
-                if (bytes_written < 0) {
-                    MFU_LOG(MFU_LOG_ERR, "Write error when copying from `%s' to `%s' (errno=%d %s)",
-                        src, dest, errno, strerror(errno));
-                    return -1;
-                }
-
-                /* So long as we're not using O_DIRECT, we can handle short writes
-                 * by advancing by the number of bytes written.  For O_DIRECT, we
-                 * need to keep buffer, file offset, and amount to write aligned
-                 * on block boundaries, so just retry the entire operation. */
-                if (!copy_opts->direct || bytes_written == bytes_to_write) {
-                    n += bytes_written;
-                }
+        /* write data to destination file, in sparse mode blocks
+         * that are all 0 are skipped by the writer */
+        if (pipelined) {
+            /* hand the buffer to the helper thread and switch to
+             * our other buffer for the next read */
+            if (mfu_copy_writer_post(&mfu_copy_writer, src, dest, (const char*)buf,
+                bytes_to_write, off, copy_opts->direct, copy_opts->sparse, mfu_dst_file) != 0)
+            {
+                return -1;
+            }
+            if (buf == copy_opts->block_buf1) {
+                buf = copy_opts->block_buf2;
+            } else {
+                buf = copy_opts->block_buf1;
+            }
+        } else {
+            if (mfu_copy_write_extents(src, dest, (const char*)buf, bytes_to_write,
+                off, copy_opts->direct, copy_opts->sparse, mfu_dst_file) != 0)
+            {
+                return -1;
             }
         }
 
@@ -1832,13 +2334,12 @@ static int mfu_copy_file_normal(
         total_bytes += (uint64_t) bytes_read;
 
         /* update number of bytes we have copied for progress messages */
-        copy_count += (uint64_t) bytes_read;
-        mfu_progress_update(&copy_count, copy_prog);
+        mfu_copy_progress_add((uint64_t) bytes_read);
     }
 
     /* Increment the global counter. */
-    mfu_copy_stats.total_size += (int64_t) total_bytes;
-    mfu_copy_stats.total_bytes_copied += (int64_t) total_bytes;
+    mfu_copy_stats_add(&mfu_copy_stats.total_size, (int64_t) total_bytes);
+    mfu_copy_stats_add(&mfu_copy_stats.total_bytes_copied, (int64_t) total_bytes);
 
 #if 0
     /* force data to file system */
@@ -1851,6 +2352,12 @@ static int mfu_copy_file_normal(
     off_t last_written = offset + length;
     off_t file_size_offt = (off_t) file_size;
     if (last_written >= file_size_offt || file_size == 0) {
+        /* the truncate must come after any O_DIRECT write
+         * that extends past the end of the file */
+        if (mfu_copy_writer_drain(&mfu_copy_writer) != 0) {
+            return -1;
+        }
+
         /* Use ftruncate() here rather than truncate(), because grouplock
          * of Lustre would cause block to truncate() since the fd is different
          * from the out_fd. */
@@ -1864,6 +2371,29 @@ static int mfu_copy_file_normal(
     return 0;
 }
 
+static int mfu_copy_file_normal(
+    const char* src,
+    const char* dest,
+    uint64_t offset,
+    uint64_t length,
+    uint64_t file_size,
+    mfu_copy_opts_t* copy_opts,
+    mfu_file_t* mfu_src_file,
+    mfu_file_t* mfu_dst_file)
+{
+    int rc = mfu_copy_file_blocks(src, dest, offset, length, file_size,
+        copy_opts, mfu_src_file, mfu_dst_file);
+
+    /* wait for the last write of the chunk, so that a failed write is
+     * reported for the chunk it belongs to, this limits the overlap of
+     * reads and writes to within a chunk */
+    if (mfu_copy_writer_drain(&mfu_copy_writer) != 0) {
+        rc = -1;
+    }
+
+    return rc;
+}
+
 static int mfu_copy_file_fiemap(
     const char* src,
     const char* dest,
@@ -2021,7 +2551,7 @@ static int mfu_copy_file_fiemap(
             }
 
             ext_len -= (size_t)num_written;
-            mfu_copy_stats.total_bytes_copied += (int64_t) num_written;
+            mfu_copy_stats_add(&mfu_copy_stats.total_bytes_copied, (int64_t) num_written);
         }
     }
 
@@ -2039,9 +2569,9 @@ static int mfu_copy_file_fiemap(
     }
 
     if (last_written >= file_size_offt) {
-        mfu_copy_stats.total_size += (int64_t) (file_size_offt - (off_t) offset);
+        mfu_copy_stats_add(&mfu_copy_stats.total_size, (int64_t) (file_size_offt - (off_t) offset));
     } else {
-        mfu_copy_stats.total_size += (int64_t) last_byte;
+        mfu_copy_stats_add(&mfu_copy_stats.total_size, (int64_t) last_byte);
     }
 
     free(fiemap);
@@ -2054,37 +2584,178 @@ fail_normal_copy:
     return -1;
 }
 
-static int mfu_copy_file(
+/* set once the kernel tells us that a method is not supported
+ * between our source and destination, so we don't keep trying */
+static __thread bool mfu_copy_clone_disabled = false;
+static __thread bool mfu_copy_offload_disabled = false;
+
+/* returns true if errno indicates that the kernel can't offload
+ * the copy between these two files, in which case we fall back
+ * to copying through user-space buffers, ETXTBSY is not in this
+ * list since it means the destination is a swap file, which a
+ * buffered write can't fix either */
+static bool mfu_copy_offload_unsupported(int err)
+{
+    return (err == EXDEV || err == EOPNOTSUPP || err == ENOTSUP ||
+            err == ENOSYS || err == EINVAL);
+}
+
+/* copy a chunk without moving data through user space,
+ * a chunk that covers a whole file is first cloned with
+ * FICLONERANGE, which shares extents on file systems that
+ * support reflinks (XFS, btrfs), otherwise the chunk is copied
+ * with copy_file_range, sets normal_copy_required if neither
+ * method is supported so that the caller can fall back */
+static int mfu_copy_file_offload(
     const char* src,
     const char* dest,
     uint64_t offset,
     uint64_t length,
     uint64_t file_size,
+    bool* normal_copy_required,
     mfu_copy_opts_t* copy_opts,
     mfu_file_t* mfu_src_file,
     mfu_file_t* mfu_dst_file)
 {
-    int ret;
+    *normal_copy_required = true;
 
-    /* open the input file */
-    ret = mfu_copy_open_file(src, 1, &mfu_copy_src_cache,
-                             copy_opts, mfu_src_file);
-    if (ret) {
-        MFU_LOG(MFU_LOG_ERR, "Failed to open input file `%s' (errno=%d %s)",
-            src, errno, strerror(errno));
+    /* only supported between two POSIX files */
+    if (mfu_src_file->type != POSIX || mfu_dst_file->type != POSIX) {
         return -1;
     }
 
-    /* open the output file */
-    ret = mfu_copy_open_file(dest, 0, &mfu_copy_dst_cache,
-                             copy_opts, mfu_dst_file);
-    if (ret) {
-        MFU_LOG(MFU_LOG_ERR, "Failed to open output file `%s' (errno=%d %s)",
-                dest, errno, strerror(errno));
-        return -1;
-    }
+    int src_fd = mfu_src_file->fd;
+    int dst_fd = mfu_dst_file->fd;
+    off_t file_size_offt = (off_t) file_size;
+    bool last_chunk = (offset + length >= file_size);
 
-    if (copy_opts->sparse) {
+#ifdef FICLONERANGE
+    /* clone the full file if this chunk covers all of it */
+    if (! mfu_copy_clone_disabled && offset == 0 && last_chunk && file_size > 0) {
+        struct file_clone_range range;
+        range.src_fd      = (int64_t) src_fd;
+        range.src_offset  = 0;
+        range.src_length  = 0; /* clone to end of file */
+        range.dest_offset = 0;
+
+        errno = 0;
+        if (ioctl(dst_fd, FICLONERANGE, &range) == 0) {
+            /* clone may leave a larger destination file in place */
+            if (mfu_file_ftruncate(mfu_dst_file, file_size_offt) < 0) {
+                *normal_copy_required = false;
+                MFU_LOG(MFU_LOG_ERR, "Failed to truncate destination file: %s (errno=%d %s)",
+                    dest, errno, strerror(errno));
+                return -1;
+            }
+
+            mfu_copy_stats_add(&mfu_copy_stats.total_size, (int64_t) file_size);
+            mfu_copy_stats_add(&mfu_copy_stats.total_bytes_copied, (int64_t) file_size);
+            mfu_copy_stats_add(&mfu_copy_stats.total_bytes_cloned, (int64_t) file_size);
+
+            mfu_copy_progress_add(file_size);
+            *normal_copy_required = false;
+            return 0;
+        }
+
+        if (mfu_copy_offload_unsupported(errno)) {
+            /* cross-device or no reflink support, don't try again */
+            mfu_copy_clone_disabled = true;
+        } else {
+            MFU_LOG(MFU_LOG_WARN, "Failed to clone `%s' to `%s', trying other methods (errno=%d %s)",
+                src, dest, errno, strerror(errno));
+        }
+    }
+#endif
+
+#ifdef SYS_copy_file_range
+    /* copy_file_range may fill in holes, so leave sparse copies to fiemap */
+    if (! mfu_copy_offload_disabled && ! copy_opts->sparse) {
+        loff_t in_off  = (loff_t) offset;
+        loff_t out_off = (loff_t) offset;
+        uint64_t total_bytes = 0;
+        while (total_bytes < length) {
+            size_t left = (size_t) (length - total_bytes);
+
+            errno = 0;
+            ssize_t n = (ssize_t) syscall(SYS_copy_file_range,
+                src_fd, &in_off, dst_fd, &out_off, left, 0);
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+
+                /* fall back if the kernel refused before we copied anything */
+                if (total_bytes == 0 && mfu_copy_offload_unsupported(errno)) {
+                    mfu_copy_offload_disabled = true;
+                    return -1;
+                }
+
+                *normal_copy_required = false;
+                MFU_LOG(MFU_LOG_ERR, "Failed to copy range from `%s' to `%s' (errno=%d %s)",
+                    src, dest, errno, strerror(errno));
+                return -1;
+            }
+
+            /* check for early EOF */
+            if (n == 0) {
+                *normal_copy_required = false;
+                MFU_LOG(MFU_LOG_ERR, "Source file `%s' shorter than expected size of %llu bytes",
+                    src, (unsigned long long) file_size);
+                return -1;
+            }
+
+            total_bytes += (uint64_t) n;
+
+            /* update number of bytes we have copied for progress messages */
+            mfu_copy_progress_add((uint64_t) n);
+        }
+
+        *normal_copy_required = false;
+
+        mfu_copy_stats_add(&mfu_copy_stats.total_size, (int64_t) total_bytes);
+        mfu_copy_stats_add(&mfu_copy_stats.total_bytes_copied, (int64_t) total_bytes);
+        mfu_copy_stats_add(&mfu_copy_stats.total_bytes_offload, (int64_t) total_bytes);
+
+        /* if we wrote the last chunk, truncate the file */
+        if (last_chunk || file_size == 0) {
+            if (mfu_file_ftruncate(mfu_dst_file, file_size_offt) < 0) {
+                MFU_LOG(MFU_LOG_ERR, "Failed to truncate destination file: %s (errno=%d %s)",
+                    dest, errno, strerror(errno));
+                return -1;
+            }
+        }
+
+        return 0;
+    }
+#endif
+
+    return -1;
+}
+
+/* copy a contiguous range of bytes between files that are already open */
+static int mfu_copy_file_range(
+    const char* src,
+    const char* dest,
+    uint64_t offset,
+    uint64_t length,
+    uint64_t file_size,
+    mfu_copy_opts_t* copy_opts,
+    mfu_file_t* mfu_src_file,
+    mfu_file_t* mfu_dst_file)
+{
+    int ret;
+
+    if (copy_opts->copy_offload) {
+        bool normal_copy_required;
+        ret = mfu_copy_file_offload(src, dest, offset, length, file_size,
+                               &normal_copy_required, copy_opts,
+                               mfu_src_file, mfu_dst_file);
+        if (!ret || !normal_copy_required) {
+            return ret;
+        }
+    }
+
+    if (copy_opts->sparse) {
         bool normal_copy_required;
         ret = mfu_copy_file_fiemap(src, dest, offset, length, file_size,
                                &normal_copy_required, copy_opts,
@@ -2100,11 +2771,351 @@ static int mfu_copy_file(
     return ret;
 }
 
+/* copy length bytes starting at offset, if stride is not 0, the bytes
+ * are in segments of seg_length bytes that start every stride bytes,
+ * the files are opened once and each segment is copied in turn */
+static int mfu_copy_file(
+    const char* src,
+    const char* dest,
+    uint64_t offset,
+    uint64_t length,
+    uint64_t stride,
+    uint64_t seg_length,
+    uint64_t file_size,
+    mfu_copy_opts_t* copy_opts,
+    mfu_file_t* mfu_src_file,
+    mfu_file_t* mfu_dst_file)
+{
+    int ret;
 
+    /* open the input file */
+    ret = mfu_copy_open_file(src, 1, &mfu_copy_src_cache,
+                             copy_opts, mfu_src_file);
+    if (ret) {
+        MFU_LOG(MFU_LOG_ERR, "Failed to open input file `%s' (errno=%d %s)",
+            src, errno, strerror(errno));
+        return -1;
+    }
+
+    /* open the output file */
+    ret = mfu_copy_open_file(dest, 0, &mfu_copy_dst_cache,
+                             copy_opts, mfu_dst_file);
+    if (ret) {
+        MFU_LOG(MFU_LOG_ERR, "Failed to open output file `%s' (errno=%d %s)",
+                dest, errno, strerror(errno));
+        return -1;
+    }
+
+    /* copy a contiguous chunk in one go */
+    if (stride == 0) {
+        return mfu_copy_file_range(src, dest, offset, length, file_size,
+                                   copy_opts, mfu_src_file, mfu_dst_file);
+    }
+
+    /* otherwise copy each segment, all are full but the last */
+    uint64_t off = offset;
+    uint64_t left = length;
+    while (left > 0) {
+        uint64_t len = (left < seg_length) ? left : seg_length;
+        ret = mfu_copy_file_range(src, dest, off, len, file_size,
+                                  copy_opts, mfu_src_file, mfu_dst_file);
+        if (ret) {
+            return ret;
+        }
+        left -= len;
+        off  += stride;
+    }
+
+    return 0;
+}
+
+/* copy the file section described by a single chunk, sets *val to 1
+ * if the copy fails and returns the number of bytes in the chunk,
+ * or 0 if the chunk is not under any source path */
+static uint64_t mfu_copy_chunk(
+    const mfu_file_chunk* p,
+    int numpaths,
+    const mfu_param_path* paths,
+    const mfu_param_path* destpath,
+    mfu_copy_opts_t* copy_opts,
+    mfu_file_t* mfu_src_file,
+    mfu_file_t* mfu_dst_file,
+    int* val)
+{
+    /* assume we'll succeed in copying this chunk */
+    *val = 0;
+
+    /* get name of destination file */
+    char* dest = mfu_param_path_copy_dest(p->name, numpaths,
+            paths, destpath, copy_opts, mfu_src_file, mfu_dst_file);
+    if (dest == NULL) {
+        /* No need to copy it */
+        return 0;
+    }
+
+    /* copy portion of file corresponding to this chunk,
+     * and record whether copy operation succeeded */
+    uint64_t start = mfu_perf_start();
+    int copy_rc = mfu_copy_file(p->name, dest, (uint64_t)p->offset,
+            (uint64_t)p->length, (uint64_t)p->stride, (uint64_t)p->seg_length,
+            (uint64_t)p->file_size, copy_opts, mfu_src_file, mfu_dst_file);
+    if (copy_rc < 0) {
+        /* error copying file */
+        *val = 1;
+        MFU_LOG(MFU_LOG_ERR, "Failed to copy `%s' to `%s' at offset %llu length %llu",
+            p->name, dest, (unsigned long long) p->offset, (unsigned long long) p->length);
+    }
+    if (copy_ost_stats != NULL) {
+        mfu_file_chunk_stats_add(copy_ost_stats, p, start);
+    }
+    MFU_TRACE_CHUNK("chunk", start, p->length, p->ost);
+
+    /* free the dest name */
+    mfu_free(&dest);
+
+    return (uint64_t)p->length;
+}
+
+/* chunks shared by the I/O threads of a process, threads take the
+ * next chunk by atomically incrementing next */
+typedef struct {
+    const mfu_file_chunk** chunks;   /* array of chunks assigned to this process */
+    uint64_t count;                  /* number of entries in chunks */
+    uint64_t next;                   /* index of next chunk to be copied */
+    uint64_t bytes;                  /* sum of chunk lengths copied so far */
+    int* vals;                       /* flag for each chunk, set to 1 on error */
+    int numpaths;                    /* number of source paths */
+    const mfu_param_path* paths;     /* source paths */
+    const mfu_param_path* destpath;  /* destination path */
+    mfu_copy_file_cache_t* src_totals; /* main thread caches that collect */
+    mfu_copy_file_cache_t* dst_totals; /*   counters from each thread */
+    pthread_mutex_t lock;            /* protects active and the totals */
+    pthread_cond_t  cond;            /* signaled when a thread exits */
+    int active;                      /* number of threads still copying */
+} mfu_copy_queue_t;
+
+/* state of one I/O thread */
+typedef struct {
+    pthread_t thread;         /* thread handle */
+    mfu_copy_queue_t* queue;  /* chunks shared with other threads */
+    mfu_copy_opts_t opts;     /* copy of options with buffers owned by this thread */
+    mfu_file_t src_file;      /* source file handle for this thread */
+    mfu_file_t dst_file;      /* destination file handle for this thread */
+    int rc;                   /* set to -1 if closing a file failed */
+} mfu_copy_worker_t;
+
+/* add open/close counters of a thread's file cache to the totals */
+static void mfu_copy_file_cache_accumulate(
+    mfu_copy_file_cache_t* totals,
+    const mfu_copy_file_cache_t* cache)
+{
+    totals->opens  += cache->opens;
+    totals->closes += cache->closes;
+    totals->hits   += cache->hits;
+    totals->fsyncs += cache->fsyncs;
+}
+
+/* main loop of an I/O thread, copies chunks until the queue is empty */
+static void* mfu_copy_worker_main(void* arg)
+{
+    mfu_copy_worker_t* w = (mfu_copy_worker_t*) arg;
+    mfu_copy_queue_t* q = w->queue;
+
+    /* each thread has its own open files */
+    mfu_copy_file_cache_init(&mfu_copy_src_cache, w->opts.fd_cache_size);
+    mfu_copy_file_cache_init(&mfu_copy_dst_cache, w->opts.fd_cache_size);
+    mfu_copy_clone_disabled   = false;
+    mfu_copy_offload_disabled = false;
+
+    while (1) {
+        uint64_t i = __sync_fetch_and_add(&q->next, 1);
+        if (i >= q->count) {
+            break;
+        }
+
+        uint64_t bytes = mfu_copy_chunk(q->chunks[i], q->numpaths, q->paths,
+            q->destpath, &w->opts, &w->src_file, &w->dst_file, &q->vals[i]);
+        __sync_fetch_and_add(&q->bytes, bytes);
+    }
+
+    /* close files */
+    w->rc = 0;
+    if (mfu_copy_close_file(&mfu_copy_src_cache, &w->src_file) != 0) {
+        w->rc = -1;
+    }
+    if (mfu_copy_close_file(&mfu_copy_dst_cache, &w->dst_file) != 0) {
+        w->rc = -1;
+    }
+
+    /* report counters and let the main thread know we're done */
+    pthread_mutex_lock(&q->lock);
+    mfu_copy_file_cache_accumulate(q->src_totals, &mfu_copy_src_cache);
+    mfu_copy_file_cache_accumulate(q->dst_totals, &mfu_copy_dst_cache);
+    q->active--;
+    pthread_cond_broadcast(&q->cond);
+    pthread_mutex_unlock(&q->lock);
+
+    return NULL;
+}
+
+/* copy the chunks in the list starting at head using nthreads I/O
+ * threads, each with its own buffers and open files, the calling
+ * thread updates progress messages until all threads are done,
+ * sets vals[i] for each chunk and returns the number of bytes
+ * copied, or returns 0 with *started=0 if no thread could be started */
+static uint64_t mfu_copy_chunks_threaded(
+    const mfu_file_chunk* head,
+    uint64_t list_count,
+    int* vals,
+    int nthreads,
+    int numpaths,
+    const mfu_param_path* paths,
+    const mfu_param_path* destpath,
+    mfu_copy_opts_t* copy_opts,
+    const mfu_file_t* mfu_src_file,
+    const mfu_file_t* mfu_dst_file,
+    int* started,
+    int* rc)
+{
+    /* build an array of chunks so threads can index into it */
+    mfu_copy_queue_t q;
+    q.chunks = (const mfu_file_chunk**) MFU_MALLOC(list_count * sizeof(mfu_file_chunk*));
+    uint64_t i;
+    const mfu_file_chunk* p = head;
+    for (i = 0; i < list_count; i++) {
+        q.chunks[i] = p;
+        vals[i] = 0;
+        p = p->next;
+    }
+    q.count      = list_count;
+    q.next       = 0;
+    q.bytes      = 0;
+    q.vals       = vals;
+    q.numpaths   = numpaths;
+    q.paths      = paths;
+    q.destpath   = destpath;
+    q.src_totals = &mfu_copy_src_cache;
+    q.dst_totals = &mfu_copy_dst_cache;
+    q.active     = 0;
+    pthread_mutex_init(&q.lock, NULL);
+    pthread_cond_init(&q.cond, NULL);
+
+    /* route progress updates through the shared counter */
+    copy_count_shared = copy_count;
+    copy_threaded = 1;
+
+    /* start threads, each with a private copy of the options
+     * that points to its own aligned buffers */
+    size_t alignment = 1024*1024;
+    mfu_copy_worker_t* workers = (mfu_copy_worker_t*) MFU_MALLOC(
+        (size_t)nthreads * sizeof(mfu_copy_worker_t));
+    int t;
+    int nstarted = 0;
+    for (t = 0; t < nthreads; t++) {
+        mfu_copy_worker_t* w = &workers[nstarted];
+        w->queue      = &q;
+        w->opts       = *copy_opts;
+        w->opts.block_buf1 = (char*) MFU_MEMALIGN(copy_opts->buf_size, alignment);
+        w->opts.block_buf2 = (char*) MFU_MEMALIGN(copy_opts->buf_size, alignment);
+        w->src_file   = *mfu_src_file;
+        w->dst_file   = *mfu_dst_file;
+        w->rc         = 0;
+
+        pthread_mutex_lock(&q.lock);
+        q.active++;
+        pthread_mutex_unlock(&q.lock);
+
+        int create_rc = pthread_create(&w->thread, NULL, mfu_copy_worker_main, w);
+        if (create_rc != 0) {
+            MFU_LOG(MFU_LOG_WARN, "Failed to start I/O thread %d of %d (errno=%d %s)",
+                t, nthreads, create_rc, strerror(create_rc));
+            pthread_mutex_lock(&q.lock);
+            q.active--;
+            pthread_mutex_unlock(&q.lock);
+            mfu_free(&w->opts.block_buf1);
+            mfu_free(&w->opts.block_buf2);
+            continue;
+        }
+        nstarted++;
+    }
+
+    /* update progress messages while the threads copy data,
+     * waking up periodically even if no thread has exited */
+    pthread_mutex_lock(&q.lock);
+    while (q.active > 0) {
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        ts.tv_nsec += 100 * 1000 * 1000;
+        if (ts.tv_nsec >= 1000 * 1000 * 1000) {
+            ts.tv_sec++;
+            ts.tv_nsec -= 1000 * 1000 * 1000;
+        }
+        pthread_cond_timedwait(&q.cond, &q.lock, &ts);
+
+        pthread_mutex_unlock(&q.lock);
+        copy_count = __sync_fetch_and_add(&copy_count_shared, 0);
+        mfu_copy_progress_update();
+        pthread_mutex_lock(&q.lock);
+    }
+    pthread_mutex_unlock(&q.lock);
+
+    /* wait for threads and free their buffers */
+    for (t = 0; t < nstarted; t++) {
+        mfu_copy_worker_t* w = &workers[t];
+        pthread_join(w->thread, NULL);
+        if (w->rc != 0) {
+            *rc = -1;
+        }
+        mfu_free(&w->opts.block_buf1);
+        mfu_free(&w->opts.block_buf2);
+    }
+
+    copy_threaded = 0;
+    copy_count = copy_count_shared;
+
+    uint64_t bytes = q.bytes;
+
+    pthread_cond_destroy(&q.cond);
+    pthread_mutex_destroy(&q.lock);
+    mfu_free(&workers);
+    mfu_free(&q.chunks);
+
+    *started = nstarted;
+    return bytes;
+}
+
+/* select the order in which each process copies its chunks */
+static mfu_chunk_order mfu_copy_chunk_order(void)
+{
+    /* default to working through one file at a time */
+    mfu_chunk_order order = MFU_CHUNK_ORDER_FILE;
+
+    /* allow override of order via environment variable */
+    char varname[] = "MFU_CHUNK_ORDER";
+    const char* value = getenv(varname);
+    if (value != NULL) {
+        if (strcmp(value, "ARRIVAL") == 0) {
+            order = MFU_CHUNK_ORDER_ARRIVAL;
+        } else if (strcmp(value, "FILE") == 0) {
+            order = MFU_CHUNK_ORDER_FILE;
+        } else if (strcmp(value, "OST") == 0) {
+            order = MFU_CHUNK_ORDER_OST;
+        } else if (strcmp(value, "LARGEST") == 0) {
+            order = MFU_CHUNK_ORDER_LARGEST;
+        } else {
+            if (mfu_rank == 0) {
+                MFU_LOG(MFU_LOG_ERR, "%s: Unknown value: %s", varname, value);
+            }
+            return order;
+        }
+        if (mfu_rank == 0) {
+            MFU_LOG(MFU_LOG_INFO, "%s: %s", varname, value);
+        }
+    }
+
+    return order;
+}
 
-/* slices files in list at boundaries of chunk size, evenly distributes
- * chunks, and copies data from source to destination file,
- * returns 0 on success and -1 on error */
 static int mfu_copy_files(
     mfu_flist list,
     int numpaths,
@@ -2114,6 +3125,8 @@ static int mfu_copy_files(
     mfu_file_t* mfu_src_file,
     mfu_file_t* mfu_dst_file)
 {
+    MFU_TRACE_BEGIN("copy data");
+
     /* assume we'll succeed */
     int rc = 0;
 
@@ -2153,14 +3166,75 @@ static int mfu_copy_files(
     double total_start = MPI_Wtime();
     uint64_t total_count = 0;
 
-    /* start up progress messages for the copy */
-    copy_count = 0;
-    copy_prog = mfu_progress_start(mfu_progress_timeout, 1, MPI_COMM_WORLD, copy_progress_fn);
-
     /* split file list into a linked list of file sections,
-     * this evenly spreads the file sections across processes */
-    mfu_file_chunk* head = mfu_file_chunk_list_alloc(list, copy_opts->chunk_size);
+     * this evenly spreads the file sections across processes,
+     * stripes on the same object may be combined into one section */
+    mfu_file_chunk* head = NULL;
+    if (copy_opts->mirror_layout) {
+        /* the stripes of each destination file line up with those of
+         * its source, so schedule each stripe by its pair of source
+         * and destination objects */
+        const char** dests = (const char**) MFU_MALLOC(((size_t)size + 1) * sizeof(char*));
+        for (idx = 0; idx < size; idx++) {
+            dests[idx] = NULL;
+            if (mfu_flist_file_get_type(list, idx) == MFU_TYPE_FILE) {
+                const char* name = mfu_flist_file_get_name(list, idx);
+                dests[idx] = mfu_param_path_copy_dest(name, numpaths,
+                    paths, destpath, copy_opts, mfu_src_file, mfu_dst_file);
+            }
+        }
+        head = mfu_file_chunk_list_alloc_pairs(list,
+            copy_opts->chunk_size, copy_opts->coalesce_size, dests);
+        for (idx = 0; idx < size; idx++) {
+            mfu_free(&dests[idx]);
+        }
+        mfu_free(&dests);
+    } else {
+        head = mfu_file_chunk_list_alloc_strided(list,
+            copy_opts->chunk_size, copy_opts->coalesce_size);
+    }
+
+    /* chunks arrive grouped by the rank that sent them, reorder
+     * them so that we work through files in a sensible order */
+    mfu_file_chunk_list_order(head, mfu_copy_chunk_order());
+
+    /* count what we copy from each OST */
+    copy_ost_stats = mfu_file_chunk_stats_new(head);
+
+    /* start up progress messages for the copy, in verbose mode
+     * these also name OSTs that are falling behind */
+    copy_count = 0;
+    copy_prog_count = 1;
+    if (verbose) {
+        copy_prog_count += mfu_file_chunk_stats_progress_count(copy_ost_stats);
+    }
+    copy_prog_vals = (uint64_t*) MFU_MALLOC((size_t)copy_prog_count * sizeof(uint64_t));
+    memset(copy_prog_vals, 0, (size_t)copy_prog_count * sizeof(uint64_t));
+    copy_prog = mfu_progress_start(mfu_progress_timeout, copy_prog_count, MPI_COMM_WORLD, copy_progress_fn);
+
+    /* set up caches of open source and destination files */
+    mfu_copy_file_cache_init(&mfu_copy_src_cache, copy_opts->fd_cache_size);
+    mfu_copy_file_cache_init(&mfu_copy_dst_cache, copy_opts->fd_cache_size);
+
+    /* probe kernel copy offload again for each copy */
+    mfu_copy_clone_disabled   = false;
+    mfu_copy_offload_disabled = false;
+
+    /* use a pool of I/O threads if requested, the threads have their
+     * own buffers and open files, so this is only done for POSIX files */
+    int nthreads = copy_opts->io_threads;
+    if (nthreads > 1 && (mfu_src_file->type != POSIX || mfu_dst_file->type != POSIX)) {
+        if (rank == 0) {
+            MFU_LOG(MFU_LOG_WARN, "I/O threads are only supported for POSIX files, using one thread");
+        }
+        nthreads = 1;
+    }
 
+    /* start helper thread to overlap reads and writes,
+     * I/O threads already keep several writes in flight */
+    if (copy_opts->pipeline && nthreads <= 1) {
+        mfu_copy_writer_start(&mfu_copy_writer);
+    }
 
     /* get a count of how many items are the chunk list */
     uint64_t list_count = mfu_file_chunk_list_size(head);
@@ -2168,52 +3242,110 @@ static int mfu_copy_files(
      * will store 0 to mean copy of this chunk succeeded and 1 otherwise
      * to be used as input to logical OR to determine state of entire file */
     int* vals = (int*) MFU_MALLOC(list_count * sizeof(int));
+    memset(vals, 0, list_count * sizeof(int));
+
+    /* let processes that finish their chunks early take chunks from
+     * processes that are still busy, the queue is driven by a single
+     * thread, so this is only done without I/O threads */
+    mfu_file_chunk_queue* queue = NULL;
+    if (copy_opts->steal) {
+        if (nthreads > 1) {
+            if (rank == 0) {
+                MFU_LOG(MFU_LOG_WARN, "Stealing chunks is not supported with I/O threads, copying assigned chunks");
+            }
+        } else {
+            queue = mfu_file_chunk_queue_new(head);
+        }
+    }
+
+    /* copy data with I/O threads, falls back to the loop
+     * below if no thread could be started */
+    int threads_started = 0;
+    if (nthreads > 1 && list_count > 0) {
+        total_count += mfu_copy_chunks_threaded(head, list_count, vals, nthreads,
+            numpaths, paths, destpath, copy_opts, mfu_src_file, mfu_dst_file,
+            &threads_started, &rc);
+    }
 
     /* loop over and copy data for each file section we're responsible for */
     uint64_t i;
     const mfu_file_chunk* p = head;
-    for (i = 0; i < list_count; i++) {
-         /* assume we'll succeed in copying this chunk */
-         vals[i] = 0;
-
-        /* get name of destination file */
-        char* dest = mfu_param_path_copy_dest(p->name, numpaths,
-                paths, destpath, copy_opts, mfu_src_file, mfu_dst_file);
-        if (dest == NULL) {
-            /* No need to copy it */
-            p = p->next;
-            continue;
+    if (queue != NULL) {
+        /* copy our own chunks, and then those we can take from others */
+        while ((p = mfu_file_chunk_queue_next(queue)) != NULL) {
+            int val;
+            total_count += mfu_copy_chunk(p, numpaths, paths, destpath,
+                copy_opts, mfu_src_file, mfu_dst_file, &val);
+            if (val != 0) {
+                rc = -1;
+            }
         }
-
+    }
+    for (i = 0; i < list_count && threads_started == 0 && queue == NULL; i++) {
         /* add bytes to our running total */
-        total_count += (uint64_t)p->length;
-
-        /* copy portion of file corresponding to this chunk,
-         * and record whether copy operation succeeded */
-        int copy_rc = mfu_copy_file(p->name, dest, (uint64_t)p->offset,  // sy: where actual copy occurs
-                (uint64_t)p->length, (uint64_t)p->file_size, copy_opts,
-                mfu_src_file, mfu_dst_file);
-	
-        if (copy_rc < 0) {
-            /* error copying file */
-            vals[i] = 1;
-		printf ("error copying file\n");
-        }
-
-        /* free the dest name */
-        mfu_free(&dest);
+        total_count += mfu_copy_chunk(p, numpaths, paths, destpath,
+            copy_opts, mfu_src_file, mfu_dst_file, &vals[i]);
 
         /* update pointer to next element */
         p = p->next;
     }
 
+    /* the copy fails if any of our chunks failed to copy */
+    for (i = 0; i < list_count; i++) {
+        if (vals[i] != 0) {
+            rc = -1;
+        }
+    }
+
+    /* wait for the last pipelined write and stop the helper thread */
+    if (mfu_copy_writer_stop(&mfu_copy_writer) != 0) {
+        rc = -1;
+    }
+
     /* close files */
     mfu_copy_close_file(&mfu_copy_src_cache, mfu_src_file);
     mfu_copy_close_file(&mfu_copy_dst_cache, mfu_dst_file);
 
+    /* record when we finished copying data */
+    double finish_time = MPI_Wtime() - total_start;
+
+    /* wait for other processes to stop taking our chunks */
+    if (queue != NULL) {
+        if (verbose) {
+            mfu_file_chunk_queue_report(queue);
+        }
+        mfu_file_chunk_queue_free(&queue);
+    }
+
+    /* report the spread in time at which processes finished */
+    if (verbose) {
+        double min_time, max_time, sum_time;
+        MPI_Reduce(&finish_time, &min_time, 1, MPI_DOUBLE, MPI_MIN, 0, MPI_COMM_WORLD);
+        MPI_Reduce(&finish_time, &max_time, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+        MPI_Reduce(&finish_time, &sum_time, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+        if (rank == 0) {
+            int ranks;
+            MPI_Comm_size(MPI_COMM_WORLD, &ranks);
+            MFU_LOG(MFU_LOG_INFO, "Copy finish time: min %.3lf, mean %.3lf, max %.3lf seconds, spread %.3lf seconds",
+                min_time, sum_time / (double) ranks, max_time, max_time - min_time);
+        }
+    }
+
+    /* report how each OST performed */
+    if (verbose) {
+        mfu_file_chunk_stats_report(copy_ost_stats);
+    }
+
+    /* report how often we had to open and close files */
+    if (verbose) {
+        mfu_copy_file_cache_report("File cache");
+    }
+
     /* barrier to ensure all files are closed,
      * may try to unlink bad destination files below */
+    MFU_TRACE_BEGIN("barrier");
     MPI_Barrier(MPI_COMM_WORLD);
+    MFU_TRACE_END("barrier");
 
     /* allocate a flag for each item in our file list */
 //    int* results = (int*) MFU_MALLOC(size * sizeof(int));
@@ -2268,9 +3400,8 @@ static int mfu_copy_files(
     }
 */
     /* free the list of success/fail for each chunk */
+    mfu_free(&vals);
 
-
-//   mfu_free(&vals);
     /* free copy flags */
     mfu_free(&results);
 
@@ -2278,7 +3409,13 @@ static int mfu_copy_files(
     mfu_file_chunk_list_free(&head);
 
     /* finalize progress messages for the copy */
-    mfu_progress_complete(&copy_count, &copy_prog);
+    copy_prog_vals[0] = copy_count;
+    if (copy_prog_count > 1) {
+        mfu_file_chunk_stats_progress_values(copy_ost_stats, &copy_prog_vals[1]);
+    }
+    mfu_progress_complete(copy_prog_vals, &copy_prog);
+    mfu_free(&copy_prog_vals);
+    mfu_file_chunk_stats_free(&copy_ost_stats);
 
     /* stop timer and report total count */
     MPI_Barrier(MPI_COMM_WORLD);
@@ -2315,6 +3452,7 @@ static int mfu_copy_files(
         }
     }
 
+    MFU_TRACE_END("copy data");
     return rc;
 }
 
@@ -2323,6 +3461,7 @@ static void mfu_sync_all(const char* msg)
     int rank;
     MPI_Comm_rank(MPI_COMM_WORLD, &rank);
 
+    MFU_TRACE_BEGIN("sync");
     MPI_Barrier(MPI_COMM_WORLD);
     double start = MPI_Wtime();
 
@@ -2337,6 +3476,7 @@ static void mfu_sync_all(const char* msg)
     if (rank == 0) {
         MFU_LOG(MFU_LOG_INFO, "Sync completed in %.3lf seconds.", (end - start));
     }
+    MFU_TRACE_END("sync");
 }
 
 static void print_summary(mfu_flist flist)
@@ -2419,24 +3559,162 @@ static void print_summary(mfu_flist flist)
         MFU_LOG(MFU_LOG_INFO, "  Links: %llu", (unsigned long long) all_links);
         /* MFU_LOG("  Unknown: %lu", (unsigned long long) all_unknown); */
 
-        if (mfu_flist_have_detail(flist)) {
-            double agg_size_tmp;
-            const char* agg_size_units;
-            mfu_format_bytes(all_bytes, &agg_size_tmp, &agg_size_units);
+        if (mfu_flist_have_detail(flist)) {
+            double agg_size_tmp;
+            const char* agg_size_units;
+            mfu_format_bytes(all_bytes, &agg_size_tmp, &agg_size_units);
+
+            uint64_t size_per_file = 0.0;
+            if (all_files > 0) {
+                size_per_file = (uint64_t)((double)all_bytes / (double)all_files);
+            }
+            double size_per_file_tmp;
+            const char* size_per_file_units;
+            mfu_format_bytes(size_per_file, &size_per_file_tmp, &size_per_file_units);
+
+            MFU_LOG(MFU_LOG_INFO, "Data: %.3lf %s (%.3lf %s per file)", agg_size_tmp, agg_size_units, size_per_file_tmp, size_per_file_units);
+        }
+    }
+
+    return;
+}
+
+/* reset copy statistics and note the start time for the epilogue */
+static void mfu_copy_stats_start(void)
+{
+    time(&(mfu_copy_stats.time_started));
+    mfu_copy_stats.wtime_started = MPI_Wtime();
+
+    /* Initialize statistics */
+    mfu_copy_stats.total_dirs  = 0;
+    mfu_copy_stats.total_files = 0;
+    mfu_copy_stats.total_links = 0;
+    mfu_copy_stats.total_size  = 0;
+    mfu_copy_stats.total_bytes_copied = 0;
+    mfu_copy_stats.total_bytes_cloned = 0;
+    mfu_copy_stats.total_bytes_offload = 0;
+}
+
+/* turn off mirror_layout unless the destination is on Lustre */
+static void mfu_copy_check_mirror_layout(
+    const mfu_param_path* destpath, /* destination path to copy items to */
+    mfu_copy_opts_t* copy_opts)     /* options to configure how copy is executed */
+{
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    if (copy_opts->mirror_layout) {
+        int on_lustre = 0;
+        if (rank == 0) {
+            mfu_path* dirpath = mfu_path_from_str(destpath->path);
+            if (! copy_opts->copy_into_dir) {
+                mfu_path_dirname(dirpath);
+            }
+            const char* dir = mfu_path_strdup(dirpath);
+            on_lustre = (int) mfu_is_lustre(dir);
+            mfu_free(&dir);
+            mfu_path_delete(&dirpath);
+        }
+        MPI_Bcast(&on_lustre, 1, MPI_INT, 0, MPI_COMM_WORLD);
+        if (! on_lustre) {
+            if (rank == 0) {
+                MFU_LOG(MFU_LOG_WARN, "Destination is not on Lustre, not mirroring source layouts");
+            }
+            copy_opts->mirror_layout = false;
+        }
+    }
+}
+
+/* print time, item counts, and rate of copy since mfu_copy_stats_start */
+static void mfu_copy_stats_report(const mfu_copy_opts_t* copy_opts)
+{
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    /* Determine the actual and relative end time for the epilogue. */
+    mfu_copy_stats.wtime_ended = MPI_Wtime();
+    time(&(mfu_copy_stats.time_ended));
+
+    /* compute time */
+    double rel_time = mfu_copy_stats.wtime_ended - \
+                      mfu_copy_stats.wtime_started;
+
+    /* prep our values into buffer */
+    int64_t values[7];
+    values[0] = mfu_copy_stats.total_dirs;
+    values[1] = mfu_copy_stats.total_files;
+    values[2] = mfu_copy_stats.total_links;
+    values[3] = mfu_copy_stats.total_size;
+    values[4] = mfu_copy_stats.total_bytes_copied;
+    values[5] = mfu_copy_stats.total_bytes_cloned;
+    values[6] = mfu_copy_stats.total_bytes_offload;
+
+    /* sum values across processes */
+    int64_t sums[7];
+    MPI_Allreduce(values, sums, 7, MPI_INT64_T, MPI_SUM, MPI_COMM_WORLD);
+
+    /* extract results from allreduce */
+    int64_t agg_dirs    = sums[0];
+    int64_t agg_files   = sums[1];
+    int64_t agg_links   = sums[2];
+    int64_t agg_size    = sums[3];
+    int64_t agg_copied  = sums[4];
+    int64_t agg_cloned  = sums[5];
+    int64_t agg_offload = sums[6];
+
+    /* compute rate of copy */
+    double agg_rate = (double)agg_copied / rel_time;
+    if (rel_time > 0.0) {
+        agg_rate = (double)agg_copied / rel_time;
+    }
+
+    if(rank == 0) {
+        /* format start time */
+        char starttime_str[256];
+        struct tm* localstart = localtime(&(mfu_copy_stats.time_started));
+        strftime(starttime_str, 256, "%b-%d-%Y,%H:%M:%S", localstart);
+
+        /* format end time */
+        char endtime_str[256];
+        struct tm* localend = localtime(&(mfu_copy_stats.time_ended));
+        strftime(endtime_str, 256, "%b-%d-%Y,%H:%M:%S", localend);
+
+        /* total number of items */
+        int64_t agg_items = agg_dirs + agg_files + agg_links;
+
+        /* convert size to units */
+        double agg_size_tmp;
+        const char* agg_size_units;
+        mfu_format_bytes((uint64_t)agg_size, &agg_size_tmp, &agg_size_units);
+
+        /* convert bandwidth to units */
+        double agg_rate_tmp;
+        const char* agg_rate_units;
+        mfu_format_bw(agg_rate, &agg_rate_tmp, &agg_rate_units);
 
-            uint64_t size_per_file = 0.0;
-            if (all_files > 0) {
-                size_per_file = (uint64_t)((double)all_bytes / (double)all_files);
-            }
-            double size_per_file_tmp;
-            const char* size_per_file_units;
-            mfu_format_bytes(size_per_file, &size_per_file_tmp, &size_per_file_units);
+        MFU_LOG(MFU_LOG_INFO, "Started: %s", starttime_str);
+        MFU_LOG(MFU_LOG_INFO, "Completed: %s", endtime_str);
+        MFU_LOG(MFU_LOG_INFO, "Seconds: %.3lf", rel_time);
+        MFU_LOG(MFU_LOG_INFO, "Items: %" PRId64, agg_items);
+        MFU_LOG(MFU_LOG_INFO, "  Directories: %" PRId64, agg_dirs);
+        MFU_LOG(MFU_LOG_INFO, "  Files: %" PRId64, agg_files);
+        MFU_LOG(MFU_LOG_INFO, "  Links: %" PRId64, agg_links);
+        MFU_LOG(MFU_LOG_INFO, "Data: %.3lf %s (%" PRId64 " bytes)",
+            agg_size_tmp, agg_size_units, agg_size);
 
-            MFU_LOG(MFU_LOG_INFO, "Data: %.3lf %s (%.3lf %s per file)", agg_size_tmp, agg_size_units, size_per_file_tmp, size_per_file_units);
+        MFU_LOG(MFU_LOG_INFO, "Rate: %.3lf %s " \
+            "(%.3" PRId64 " bytes in %.3lf seconds)", \
+            agg_rate_tmp, agg_rate_units, agg_copied, rel_time);
+
+        /* report how data was moved when kernel offload was requested */
+        if (copy_opts->copy_offload) {
+            int64_t agg_user = agg_copied - agg_cloned - agg_offload;
+            MFU_LOG(MFU_LOG_INFO, "Copy methods:");
+            MFU_LOG(MFU_LOG_INFO, "  Reflink: %" PRId64 " bytes", agg_cloned);
+            MFU_LOG(MFU_LOG_INFO, "  copy_file_range: %" PRId64 " bytes", agg_offload);
+            MFU_LOG(MFU_LOG_INFO, "  Read/write: %" PRId64 " bytes", agg_user);
         }
     }
-
-    return;
 }
 
 int mfu_flist_copy(
@@ -2448,6 +3726,8 @@ int mfu_flist_copy(
     mfu_file_t* mfu_src_file,       /* whether source items are coming from POSIX/DAOS */
     mfu_file_t* mfu_dst_file)       /* whether destination is in POSIX/DAOS */
 {
+    MFU_TRACE_BEGIN("copy");
+
     /* assume we'll succeed */
     int rc = 0;
 
@@ -2480,19 +3760,7 @@ int mfu_flist_copy(
     copy_opts->block_buf2 = (char*) MFU_MEMALIGN(copy_opts->buf_size, alignment);
 
     /* Grab a relative and actual start time for the epilogue. */
-    time(&(mfu_copy_stats.time_started));
-    mfu_copy_stats.wtime_started = MPI_Wtime();
-
-    /* Initialize statistics */
-    mfu_copy_stats.total_dirs  = 0;
-    mfu_copy_stats.total_files = 0;
-    mfu_copy_stats.total_links = 0;
-    mfu_copy_stats.total_size  = 0;
-    mfu_copy_stats.total_bytes_copied = 0;
-
-    /* Initialize file cache */
-    mfu_copy_src_cache.name = NULL;
-    mfu_copy_dst_cache.name = NULL;
+    mfu_copy_stats_start();
 
     /* split items in file list into sublists depending on their
      * directory depth */
@@ -2509,6 +3777,9 @@ int mfu_flist_copy(
         rc = -1;
     }
 
+    /* source layouts can only be mirrored onto Lustre */
+    mfu_copy_check_mirror_layout(destpath, copy_opts);
+
     /* operate on files in batches if batch size is given */
     uint64_t batch_size = copy_opts->batch_files;
     if (batch_size > 0) {
@@ -2711,77 +3982,322 @@ int mfu_flist_copy(
     mfu_free(&copy_opts->block_buf1);
     mfu_free(&copy_opts->block_buf2);
 
-    /* Determine the actual and relative end time for the epilogue. */
-    mfu_copy_stats.wtime_ended = MPI_Wtime();
-    time(&(mfu_copy_stats.time_ended));
+    /* print totals for the whole copy */
+    mfu_copy_stats_report(copy_opts);
 
-    /* compute time */
-    double rel_time = mfu_copy_stats.wtime_ended - \
-                      mfu_copy_stats.wtime_started;
+    /* determine whether any process reported an error,
+     * inputs should are either 0 or -1, so min will be -1 on any -1 */
+    int all_rc;
+    MPI_Allreduce(&rc, &all_rc, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+    rc = all_rc;
 
-    /* prep our values into buffer */
-    int64_t values[5];
-    values[0] = mfu_copy_stats.total_dirs;
-    values[1] = mfu_copy_stats.total_files;
-    values[2] = mfu_copy_stats.total_links;
-    values[3] = mfu_copy_stats.total_size;
-    values[4] = mfu_copy_stats.total_bytes_copied;
+    MFU_TRACE_END("copy");
+    return rc;
+}
 
-    /* sum values across processes */
-    int64_t sums[5];
-    MPI_Allreduce(values, sums, 5, MPI_INT64_T, MPI_SUM, MPI_COMM_WORLD);
+/* state of the thread that reads directories for the next batch
+ * of a streaming copy while the main thread copies the current one,
+ * the thread makes no MPI calls, so MPI only needs to be initialized
+ * for a single thread */
+typedef struct {
+    mfu_flist dirs;             /* directories to read, not modified while running */
+    uint64_t next;              /* index of next directory to read in dirs */
+    uint64_t max_items;         /* stop once this many items have been found */
+    mfu_walk_opts_t* walk_opts; /* options to configure the walk */
+    mfu_flist flist;            /* list to add items found to */
+    mfu_file_t* mfu_file;       /* whether source items are coming from POSIX/DAOS */
+    pthread_t thread;
+    int running;                /* set while the thread has not been joined */
+} mfu_copy_walker_t;
+
+static void* mfu_copy_walker_main(void* arg)
+{
+    mfu_copy_walker_t* w = (mfu_copy_walker_t*) arg;
+    mfu_flist_walk_dirs(w->dirs, &w->next, w->max_items, w->walk_opts,
+        w->flist, w->mfu_file);
+    return NULL;
+}
 
-    /* extract results from allreduce */
-    int64_t agg_dirs   = sums[0];
-    int64_t agg_files  = sums[1];
-    int64_t agg_links  = sums[2];
-    int64_t agg_size   = sums[3];
-    int64_t agg_copied = sums[4];
+/* start reading directories from dirs into flist in the background,
+ * if the thread can't be started, or the source is not POSIX, the
+ * directories are read before returning */
+static void mfu_copy_walker_start(
+    mfu_copy_walker_t* w,
+    mfu_flist dirs,
+    uint64_t max_items,
+    mfu_walk_opts_t* walk_opts,
+    mfu_flist flist,
+    mfu_file_t* mfu_file)
+{
+    w->dirs      = dirs;
+    w->next      = 0;
+    w->max_items = max_items;
+    w->walk_opts = walk_opts;
+    w->flist     = flist;
+    w->mfu_file  = mfu_file;
+    w->running   = 0;
+
+    /* DAOS handles are not shared between threads */
+    if (mfu_file->type == POSIX) {
+        int rc = pthread_create(&w->thread, NULL, mfu_copy_walker_main, w);
+        if (rc == 0) {
+            w->running = 1;
+            return;
+        }
+        MFU_LOG(MFU_LOG_WARN, "Failed to start walk thread, reading directories between batches (errno=%d %s)",
+            rc, strerror(rc));
+    }
 
-    /* compute rate of copy */
-    double agg_rate = (double)agg_copied / rel_time;
-    if (rel_time > 0.0) {
-        agg_rate = (double)agg_copied / rel_time;
+    mfu_copy_walker_main(w);
+}
+
+/* wait for the directories to be read, returns the index
+ * of the first directory in dirs that was not read */
+static uint64_t mfu_copy_walker_wait(mfu_copy_walker_t* w)
+{
+    if (w->running) {
+        pthread_join(w->thread, NULL);
+        w->running = 0;
     }
+    return w->next;
+}
 
-    if(rank == 0) {
-        /* format start time */
-        char starttime_str[256];
-        struct tm* localstart = localtime(&(mfu_copy_stats.time_started));
-        strftime(starttime_str, 256, "%b-%d-%Y,%H:%M:%S", localstart);
+/* create directories found in one batch of a streaming copy, then
+ * create and copy the files and links, metadata on directories is
+ * left to the caller */
+static int mfu_copy_stream_batch(
+    mfu_flist batch,                /* items found by this step of the walk */
+    int numpaths,                   /* number of entries in paths array below */
+    const mfu_param_path* paths,    /* list of source paths */
+    const mfu_param_path* destpath, /* destination path to copy items to */
+    mfu_copy_opts_t* copy_opts,     /* options to configure how copy is executed */
+    mfu_file_t* mfu_src_file,       /* whether source items are coming from POSIX/DAOS */
+    mfu_file_t* mfu_dst_file)       /* whether destination is in POSIX/DAOS */
+{
+    int rc = 0;
 
-        /* format end time */
-        char endtime_str[256];
-        struct tm* localend = localtime(&(mfu_copy_stats.time_ended));
-        strftime(endtime_str, 256, "%b-%d-%Y,%H:%M:%S", localend);
+    /* create directories, from top down, the parent of each was
+     * created in an earlier batch */
+    int levels, minlevel;
+    mfu_flist* lists;
+    mfu_flist_array_by_depth(batch, &levels, &minlevel, &lists);
+    int tmp_rc = mfu_create_directories(levels, minlevel, lists, numpaths,
+            paths, destpath, copy_opts, mfu_src_file, mfu_dst_file);
+    if (tmp_rc < 0) {
+        rc = -1;
+    }
+    mfu_flist_array_free(levels, &lists);
 
-        /* total number of items */
-        int64_t agg_items = agg_dirs + agg_files + agg_links;
+    /* split directories from other items, we leave metadata on
+     * directories until the end, since creating items within a
+     * directory changes its timestamps and may need write permission */
+    mfu_flist files = mfu_flist_subset(batch);
+    uint64_t idx;
+    uint64_t size = mfu_flist_size(batch);
+    for (idx = 0; idx < size; idx++) {
+        mfu_filetype type = mfu_flist_file_get_type(batch, idx);
+        if (type != MFU_TYPE_DIR) {
+            mfu_flist_file_copy(batch, idx, files);
+        }
+    }
+    mfu_flist_summarize(files);
 
-        /* convert size to units */
-        double agg_size_tmp;
-        const char* agg_size_units;
-        mfu_format_bytes((uint64_t)agg_size, &agg_size_tmp, &agg_size_units);
+    /* if this batch is all directories, skip this part */
+    if (mfu_flist_global_size(files) > 0) {
+        /* spread items evenly over ranks */
+        mfu_flist spreadlist = mfu_flist_spread(files);
+        mfu_flist_array_by_depth(spreadlist, &levels, &minlevel, &lists);
 
-        /* convert bandwidth to units */
-        double agg_rate_tmp;
-        const char* agg_rate_units;
-        mfu_format_bw(agg_rate, &agg_rate_tmp, &agg_rate_units);
+        /* create files and links */
+        tmp_rc = mfu_create_files(levels, minlevel, lists, numpaths,
+                paths, destpath, copy_opts, mfu_src_file, mfu_dst_file);
+        if (tmp_rc < 0) {
+            rc = -1;
+        }
 
-        MFU_LOG(MFU_LOG_INFO, "Started: %s", starttime_str);
-        MFU_LOG(MFU_LOG_INFO, "Completed: %s", endtime_str);
-        MFU_LOG(MFU_LOG_INFO, "Seconds: %.3lf", rel_time);
-        MFU_LOG(MFU_LOG_INFO, "Items: %" PRId64, agg_items);
-        MFU_LOG(MFU_LOG_INFO, "  Directories: %" PRId64, agg_dirs);
-        MFU_LOG(MFU_LOG_INFO, "  Files: %" PRId64, agg_files);
-        MFU_LOG(MFU_LOG_INFO, "  Links: %" PRId64, agg_links);
-        MFU_LOG(MFU_LOG_INFO, "Data: %.3lf %s (%" PRId64 " bytes)",
-            agg_size_tmp, agg_size_units, agg_size);
+        /* copy data */
+        tmp_rc = mfu_copy_files(spreadlist, numpaths, paths, destpath,
+            copy_opts, mfu_src_file, mfu_dst_file);
+        if (tmp_rc < 0) {
+            rc = -1;
+        }
 
-        MFU_LOG(MFU_LOG_INFO, "Rate: %.3lf %s " \
-            "(%.3" PRId64 " bytes in %.3lf seconds)", \
-            agg_rate_tmp, agg_rate_units, agg_copied, rel_time);
+        /* force data to backend to avoid the following metadata
+         * setting mismatch, which may happen on lustre */
+        mfu_sync_all("Syncing data to disk.");
+
+        /* set permissions, ownership, and timestamps if needed */
+        tmp_rc = mfu_copy_set_metadata(levels, minlevel, lists, numpaths,
+                paths, destpath, copy_opts, mfu_src_file, mfu_dst_file);
+        if (tmp_rc < 0) {
+            rc = -1;
+        }
+
+        mfu_flist_array_free(levels, &lists);
+        mfu_flist_free(&spreadlist);
+    }
+
+    mfu_flist_free(&files);
+
+    return rc;
+}
+
+int mfu_flist_copy_stream(
+    int numpaths,                   /* number of entries in paths array below */
+    const mfu_param_path* paths,    /* list of source paths to walk and copy */
+    const mfu_param_path* destpath, /* destination path to copy items to */
+    mfu_walk_opts_t* walk_opts,     /* options to configure the walk */
+    mfu_copy_opts_t* copy_opts,     /* options to configure how copy is executed */
+    mfu_file_t* mfu_src_file,       /* whether source items are coming from POSIX/DAOS */
+    mfu_file_t* mfu_dst_file)       /* whether destination is in POSIX/DAOS */
+{
+    MFU_TRACE_BEGIN("copy");
+
+    /* assume we'll succeed */
+    int rc = 0;
+
+    /* get our rank and number of ranks */
+    int rank, ranks;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &ranks);
+
+    /* copy the destination path to user opts structure */
+    copy_opts->dest_path = MFU_STRDUP((*destpath).path);
+
+    /* each rank reads directories until it has found its share of a batch */
+    uint64_t batch_size = copy_opts->batch_files;
+    if (batch_size == 0) {
+        batch_size = MFU_STREAM_BATCH_SIZE;
+    }
+    uint64_t rank_items = (batch_size + (uint64_t)ranks - 1) / (uint64_t)ranks;
+
+    if (rank == 0) {
+        MFU_LOG(MFU_LOG_INFO, "Copying to %s in batches of %llu items",
+            copy_opts->dest_path, (unsigned long long) batch_size);
+    }
+
+    /* allocate buffer to read/write files, aligned on 1MB boundaraies */
+    size_t alignment = 1024*1024;
+    copy_opts->block_buf1 = (char*) MFU_MEMALIGN(copy_opts->buf_size, alignment);
+    copy_opts->block_buf2 = (char*) MFU_MEMALIGN(copy_opts->buf_size, alignment);
+
+    /* Grab a relative and actual start time for the epilogue. */
+    mfu_copy_stats_start();
+
+    /* source layouts can only be mirrored onto Lustre */
+    mfu_copy_check_mirror_layout(destpath, copy_opts);
+
+    /* the first batch is the source paths themselves */
+    mfu_flist input = mfu_flist_new();
+    if (rank == 0) {
+        int i;
+        for (i = 0; i < numpaths; i++) {
+            uint64_t idx = mfu_flist_file_create(input);
+            mfu_flist_file_set_name(input, idx, paths[i].path);
+        }
+    }
+    mfu_flist_summarize(input);
+    mfu_flist batch = mfu_flist_new();
+    mfu_flist_stat(input, batch, NULL, NULL, walk_opts->dereference, mfu_src_file);
+    mfu_flist_free(&input);
+
+    /* directories still to be read, we keep all directories to
+     * set their metadata once everything below them is copied */
+    mfu_flist pending = mfu_flist_subset(batch);
+    mfu_flist dirs    = mfu_flist_subset(batch);
+    uint64_t next = 0;
+
+    uint64_t all_items = 0;
+    uint64_t batches   = 0;
+    while (1) {
+        /* directories still to be read are those the last step of
+         * the walk did not get to and those found in this batch,
+         * spread them evenly so each rank has a share to read */
+        mfu_flist unread = mfu_flist_subset(pending);
+        uint64_t idx;
+        uint64_t size = mfu_flist_size(pending);
+        for (idx = next; idx < size; idx++) {
+            mfu_flist_file_copy(pending, idx, unread);
+        }
+        size = mfu_flist_size(batch);
+        for (idx = 0; idx < size; idx++) {
+            mfu_filetype type = mfu_flist_file_get_type(batch, idx);
+            if (type == MFU_TYPE_DIR) {
+                mfu_flist_file_copy(batch, idx, unread);
+                mfu_flist_file_copy(batch, idx, dirs);
+            }
+        }
+        mfu_flist_summarize(unread);
+        mfu_flist_free(&pending);
+        pending = mfu_flist_spread(unread);
+        mfu_flist_free(&unread);
+        uint64_t all_pending = mfu_flist_global_size(pending);
+
+        /* take the next step of the walk while we copy this batch,
+         * the walk only reads the source, and the parents of the items
+         * it finds are created by this batch before the next starts */
+        mfu_copy_walker_t walker;
+        mfu_flist next_batch = MFU_FLIST_NULL;
+        if (all_pending > 0) {
+            next_batch = mfu_flist_subset(pending);
+            mfu_copy_walker_start(&walker, pending, rank_items, walk_opts,
+                next_batch, mfu_src_file);
+        }
+
+        /* copy what we found in the last step of the walk */
+        uint64_t batch_items = mfu_flist_global_size(batch);
+        int tmp_rc = mfu_copy_stream_batch(batch, numpaths,
+                paths, destpath, copy_opts, mfu_src_file, mfu_dst_file);
+        if (tmp_rc < 0) {
+            rc = -1;
+        }
+        mfu_flist_free(&batch);
+        all_items += batch_items;
+        batches++;
+
+        if (rank == 0) {
+            MFU_LOG(MFU_LOG_INFO, "Copied %llu items in %llu batches, %llu directories left to read",
+                (unsigned long long) all_items, (unsigned long long) batches,
+                (unsigned long long) all_pending);
+        }
+
+        /* stop once the walk has read every directory */
+        if (all_pending == 0) {
+            break;
+        }
+
+        /* time spent here is time the walk took beyond the copy */
+        MFU_TRACE_BEGIN("walk");
+        next = mfu_copy_walker_wait(&walker);
+        batch = next_batch;
+        mfu_flist_summarize(batch);
+        MFU_TRACE_END("walk");
+    }
+    mfu_flist_free(&pending);
+
+    /* set permissions, ownership, and timestamps on directories,
+     * now that nothing more will be created in them */
+    mfu_flist_summarize(dirs);
+    int levels, minlevel;
+    mfu_flist* lists;
+    mfu_flist_array_by_depth(dirs, &levels, &minlevel, &lists);
+    int tmp_rc = mfu_copy_set_metadata_dirs(levels, minlevel, lists, numpaths,
+            paths, destpath, copy_opts, mfu_src_file, mfu_dst_file);
+    if (tmp_rc < 0) {
+        rc = -1;
     }
+    mfu_flist_array_free(levels, &lists);
+    mfu_flist_free(&dirs);
+
+    /* force updates to disk */
+    mfu_sync_all("Syncing directory updates to disk.");
+
+    /* free buffers */
+    mfu_free(&copy_opts->block_buf1);
+    mfu_free(&copy_opts->block_buf2);
+
+    /* print totals for the whole copy */
+    mfu_copy_stats_report(copy_opts);
 
     /* determine whether any process reported an error,
      * inputs should are either 0 or -1, so min will be -1 on any -1 */
@@ -2789,6 +4305,7 @@ int mfu_flist_copy(
     MPI_Allreduce(&rc, &all_rc, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
     rc = all_rc;
 
+    MFU_TRACE_END("copy");
     return rc;
 }
 
@@ -2859,13 +4376,6 @@ static int mfu_fill_file(
     }
     int out_fd = mfu_file->fd;
 
-    /* seek to offset in file */
-    if (mfu_lseek(dest, out_fd, offset, SEEK_SET) == (off_t)-1) {
-        MFU_LOG(MFU_LOG_ERR, "Couldn't seek in destination path `%s' (errno=%d %s)",
-            dest, errno, strerror(errno));
-        return -1;
-    }
-
     /* get buffer */
     size_t buf_size = copy_opts->buf_size;
     void* buf = copy_opts->block_buf1;
@@ -2891,29 +4401,20 @@ static int mfu_fill_file(
             bytes_to_write = buf_size;
         }
 
-        /* write bytes to destination file */
-        ssize_t num_of_bytes_written = mfu_write(dest, out_fd, buf, bytes_to_write);
-
-        /* check for an error */
-        if (num_of_bytes_written < 0) {
-            MFU_LOG(MFU_LOG_ERR, "Write error when writing to `%s' (errno=%d %s)",
-                dest, errno, strerror(errno));
-            return -1;
-        }
-
-        /* check that we wrote the same number of bytes that we read */
-        if ((size_t)num_of_bytes_written != bytes_to_write) {
-            MFU_LOG(MFU_LOG_ERR, "Write error when writing to `%s'",
-                dest);
+        /* write bytes to destination file, this shares the copy path's
+         * writer so that zero blocks are left as holes in sparse mode */
+        off_t off = (off_t)offset + (off_t)total_bytes;
+        if (mfu_copy_write_extents(dest, dest, (const char*)buf, bytes_to_write,
+            off, copy_opts->direct, copy_opts->sparse, mfu_file) != 0)
+        {
             return -1;
         }
 
-        /* add bytes to our total (use bytes read,
-         * which may be less than number written) */
-        total_bytes += (size_t) num_of_bytes_written;
+        /* add bytes to our total */
+        total_bytes += bytes_to_write;
 
         /* update number of bytes we have written for progress messages */
-        fill_count += (uint64_t) num_of_bytes_written;
+        fill_count += (uint64_t) bytes_to_write;
         mfu_progress_update(&fill_count, fill_prog);
     }
 
@@ -2990,6 +4491,9 @@ int mfu_flist_fill(mfu_flist list, mfu_copy_opts_t* copy_opts, mfu_file_t* mfu_f
      * this evenly spreads the file sections across processes */
     mfu_file_chunk* head = mfu_file_chunk_list_alloc(list, copy_opts->chunk_size);
 
+    /* set up cache of open destination files */
+    mfu_copy_file_cache_init(&mfu_copy_dst_cache, copy_opts->fd_cache_size);
+
     /* get a count of how many items are the chunk list */
     uint64_t list_count = mfu_file_chunk_list_size(head);
 
@@ -3142,10 +4646,8 @@ int mfu_flist_hardlink(
     mfu_copy_stats.total_links = 0;
     mfu_copy_stats.total_size  = 0;
     mfu_copy_stats.total_bytes_copied = 0;
-
-    /* Initialize file cache */
-    mfu_copy_src_cache.name = NULL;
-    mfu_copy_dst_cache.name = NULL;
+    mfu_copy_stats.total_bytes_cloned = 0;
+    mfu_copy_stats.total_bytes_offload = 0;
 
     /* split items in file list into sublists depending on their
      * directory depth */
@@ -3361,14 +4863,35 @@ mfu_copy_opts_t* mfu_copy_opts_new(void)
     /* By default, don't use sparse file. */
     opts->sparse = false;
 
+    /* By default, read and write data from a single thread. */
+    opts->pipeline = false;
+
+    /* By default, copy data through user-space buffers. */
+    opts->copy_offload = false;
+
+    /* By default, each process copies one chunk at a time. */
+    opts->io_threads = 1;
+
     /* Set default chunk size */
     opts->chunk_size = MFU_CHUNK_SIZE;
 
+    /* combine stripes on the same object into chunks of up to this size */
+    opts->coalesce_size = MFU_COALESCE_SIZE;
+
+    /* By default, stripe destination files with the file system defaults */
+    opts->mirror_layout = false;
+
+    /* By default, each process copies only the chunks assigned to it */
+    opts->steal = false;
+
     /* temporaries used during the copy operation for buffers to read/write data */
     opts->buf_size   = MFU_BUFFER_SIZE;
     opts->block_buf1 = NULL;
     opts->block_buf2 = NULL;
 
+    /* number of open files to keep in each of the source and destination caches */
+    opts->fd_cache_size = MFU_FD_CACHE_SIZE;
+
     /* Zero is invalid for the Lustre grouplock ID. */
     opts->grouplock_id = 0;
 
@@ -202,6 +202,19 @@ static void mknod_progress_fn(const uint64_t* vals, int count, int complete, int
     }
 }
 
+void mfu_create_striped_file(const char* name, const mfu_create_opts_t* opts)
+{
+    /* If we are overwriting files, preemptively delete any existing entry.
+     * Once a file exists, its striping parameters can't be changed. */
+    if (opts->overwrite) {
+        mfu_unlink(name);
+    }
+
+    uint64_t stripe_width = opts->lustre_stripe_width;
+    int stripe_count = (int) opts->lustre_stripe_count;
+    mfu_stripe_set(name, stripe_width, stripe_count);
+}
+
 static int create_file(mfu_flist list, uint64_t idx, mfu_create_opts_t* opts)
 {
     /* get source name */
@@ -219,16 +232,8 @@ static int create_file(mfu_flist list, uint64_t idx, mfu_create_opts_t* opts)
             /* got a regular file, check its size */
             uint64_t filesize = mfu_flist_file_get_size(list, idx);
             if (filesize >= opts->lustre_stripe_minsize) {
-                /* If we are overwriting files, preemptively delete any existing entry.
-                 * Once a file exists, its striping parameters can't be changed. */
-                if (opts->overwrite) {
-                    mfu_unlink(name);
-                }
-
                 /* file size is big enough, let's stripe */
-                uint64_t stripe_width = opts->lustre_stripe_width;
-                int stripe_count = (int) opts->lustre_stripe_count;
-                mfu_stripe_set(name, stripe_width, stripe_count);
+                mfu_create_striped_file(name, opts);
             }
         }
 
@@ -24,9 +24,10 @@ extern "C" {
  * Define types
  ***************************************/
 
-/* linked list element of stat data used during walk */
+/* values of a single item, used to pass an item into and out of
+ * the columns of a list */
 typedef struct list_elem {
-    char* file;             /* file name (strdup'd) */
+    const char* file;       /* file name */
     int depth;              /* depth within directory tree */
     mfu_filetype type;    /* type of file object */
     int detail;             /* flag to indicate whether we have stat data */
@@ -40,7 +41,6 @@ typedef struct list_elem {
     uint64_t ctime;         /* create time */
     uint64_t ctime_nsec;    /* create time nanoseconds */
     uint64_t size;          /* file size in bytes */
-    struct list_elem* next; /* pointer to next item */
     /* vars for a non-posix DAOS copy */
     uint64_t obj_id_lo;
     uint64_t obj_id_hi;
@@ -55,6 +55,37 @@ typedef struct {
     MPI_Datatype dt; /* MPI datatype for sending/receiving/writing to file */
 } buf_t;
 
+/* directory id of an item whose name has no '/' */
+#define FLIST_DIR_NONE (UINT32_MAX)
+
+/* table of directories used to store names by directory and basename,
+ * each directory is its parent directory plus its last component */
+typedef struct {
+    uint64_t count;      /* number of directories */
+    uint64_t cap;        /* number of directories arrays have space for */
+    uint32_t* parent;    /* parent, FLIST_DIR_NONE for the first component */
+    uint32_t* len;       /* strlen() of full path of directory */
+    const char** comp;   /* last component, points into name arena */
+    uint32_t* table;     /* hash table of directory ids, open addressing */
+    uint64_t table_cap;  /* number of slots in table, a power of two */
+    char* last;          /* full path of directory of last lookup */
+    size_t last_len;     /* strlen() of last */
+    size_t last_cap;     /* bytes allocated for last */
+    uint32_t last_id;    /* directory of last lookup */
+} flist_dirs_t;
+
+/* mapping of a version 5 cache file, the columns of a list read
+ * from such a file point into the mapping until the list is first
+ * changed in a way that needs them to grow or a name to be set,
+ * at which point they are copied into memory */
+typedef struct {
+    void* addr;                /* start of mapping, NULL if not mapped */
+    size_t len;                /* bytes in mapping */
+    const char* names;         /* start of name heap in mapping */
+    const uint64_t* name_off;  /* offset of name of each item within heap,
+                                * NULL once columns have been copied */
+} flist_map_t;
+
 /* abstraction for distributed file list */
 typedef struct flist {
     int detail;              /* set to 1 if we have stat, 0 if just file name */
@@ -68,12 +99,33 @@ typedef struct flist {
     int min_depth;           /* minimum file depth */
     int max_depth;           /* maximum file depth */
 
-    /* variables to track linked list of stat data during walk */
-    uint64_t list_count; /* number of items in list */
-    elem_t*  list_head;  /* points to item at head of list */
-    elem_t*  list_tail;  /* points to item at tail of list */
-    elem_t** list_index; /* an array with pointers to each item in list */
-    uint64_t list_cap;   /* current capacity of list_index */
+    /* items are stored by field in columns, each an array indexed
+     * by item, names are copied into blocks of a string arena */
+    uint64_t list_count;     /* number of items in list */
+    uint64_t list_rows;      /* number of items stored in columns */
+    uint64_t list_cap;       /* number of items columns have space for */
+    const char** col_file;   /* file name, or basename if compress is set,
+                              * points into name arena */
+    uint32_t* col_dir;       /* directory of item if compress is set */
+    int*      col_depth;     /* depth within directory tree */
+    uint8_t*  col_type;      /* type of file object */
+    uint8_t*  col_detail;    /* whether item has stat data */
+    uint32_t* col_mode;      /* stat mode */
+    uint64_t* col_uid;       /* user id */
+    uint64_t* col_gid;       /* group id */
+    uint64_t* col_atime;     /* access time */
+    uint32_t* col_atime_nsec;
+    uint64_t* col_mtime;     /* modify time */
+    uint32_t* col_mtime_nsec;
+    uint64_t* col_ctime;     /* create time */
+    uint32_t* col_ctime_nsec;
+    uint64_t* col_size;      /* file size in bytes */
+    uint64_t* col_obj_id_lo; /* DAOS object ids, only with DAOS_SUPPORT */
+    uint64_t* col_obj_id_hi;
+    struct name_block* names; /* newest block of name arena */
+    int compress;             /* store names by directory and basename */
+    flist_dirs_t dirs;        /* directories of items if compress is set */
+    flist_map_t map;          /* cache file columns point into, if any */
 
     /* buffers of users, groups, and files */
     buf_t users;
@@ -110,8 +162,24 @@ void mfu_flist_usrgrp_free(flist_t* flist);
 /* copy user and group structures from srclist to flist */
 void mfu_flist_usrgrp_copy(flist_t* srclist, flist_t* flist);
 
-/* append element to tail of linked list */
-void mfu_flist_insert_elem(flist_t* flist, elem_t* elem);
+/* append a copy of the values in elem to the list */
+void mfu_flist_insert_elem(flist_t* flist, const elem_t* elem);
+
+/* copy values of item at index idx into elem, elem->file points
+ * into the list and is valid until the list is freed, except on a
+ * list with compressed names, where it points into a per-thread cache
+ * and is only valid for the next 7 name lookups by the thread */
+void mfu_flist_get_elem(const flist_t* flist, uint64_t idx, elem_t* elem);
+
+/* offset in name heap of a version 5 cache file of an item
+ * without a name */
+#define FLIST_MAP_NAME_NONE (UINT64_MAX)
+
+/* copy columns of a list read from a version 5 cache file out of the
+ * mapping into memory, does nothing if columns are not mapped, the
+ * mapping itself is kept until the list is freed since names handed
+ * out earlier point into it */
+void mfu_flist_unmap(flist_t* flist);
 
 /* insert a file given its mode and optional stat data */
 void mfu_flist_insert_stat(flist_t* flist, const char* fpath, mode_t mode, const struct stat* sb);
@@ -11,6 +11,7 @@
 #include <stdlib.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <string.h>
 #include <unistd.h>
 #include <getopt.h>
@@ -22,6 +23,10 @@
 #include <errno.h>
 #include <string.h>
 
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
 #include "dtcmp.h"
 #include "mfu.h"
 #include "mfu_flist_internal.h"
@@ -193,8 +198,8 @@ static void list_elem_decode(char* buf, elem_t* elem)
     /* get name and advance pointer */
     const char* file = strtok(buf, "|");
 
-    /* copy path */
-    elem->file = MFU_STRDUP(file);
+    /* name is copied from the buffer when the element is inserted */
+    elem->file = file;
 
     /* set depth */
     elem->depth = mfu_flist_compute_depth(file);
@@ -246,7 +251,7 @@ static size_t list_elem_pack(void* buf, int detail, uint64_t chars, const elem_t
     char* ptr = start;
 
     /* copy in file name */
-    char* file = elem->file;
+    const char* file = elem->file;
     strncpy(ptr, file, chars);
     ptr += chars;
 
@@ -281,8 +286,8 @@ static size_t list_elem_unpack(const void* buf, int detail, uint64_t chars, elem
     const char* file = ptr;
     ptr += chars;
 
-    /* copy path */
-    elem->file = MFU_STRDUP(file);
+    /* name is copied from the buffer when the element is inserted */
+    elem->file = file;
 
     /* set depth */
     elem->depth = mfu_flist_compute_depth(file);
@@ -317,13 +322,14 @@ static size_t list_elem_unpack(const void* buf, int detail, uint64_t chars, elem
 static void list_insert_decode(flist_t* flist, char* buf)
 {
     /* create new element to record file path, file type, and stat info */
-    elem_t* elem = (elem_t*) MFU_MALLOC(sizeof(elem_t));
+    elem_t elem;
+    memset(&elem, 0, sizeof(elem));
 
     /* decode buffer and store values in element */
-    list_elem_decode(buf, elem);
+    list_elem_decode(buf, &elem);
 
-    /* append element to tail of linked list */
-    mfu_flist_insert_elem(flist, elem);
+    /* append element to list */
+    mfu_flist_insert_elem(flist, &elem);
 
     return;
 }
@@ -332,13 +338,14 @@ static void list_insert_decode(flist_t* flist, char* buf)
 static size_t list_insert_ptr(flist_t* flist, char* ptr, int detail, uint64_t chars)
 {
     /* create new element to record file path, file type, and stat info */
-    elem_t* elem = (elem_t*) MFU_MALLOC(sizeof(elem_t));
+    elem_t elem;
+    memset(&elem, 0, sizeof(elem));
 
     /* get name and advance pointer */
-    size_t bytes = list_elem_unpack(ptr, detail, chars, elem);
+    size_t bytes = list_elem_unpack(ptr, detail, chars, &elem);
 
-    /* append element to tail of linked list */
-    mfu_flist_insert_elem(flist, elem);
+    /* append element to list */
+    mfu_flist_insert_elem(flist, &elem);
 
     return bytes;
 }
@@ -1080,6 +1087,592 @@ static void read_cache_v4(
     return;
 }
 
+/* version 5 stores items by column, so that a reader can map the file
+ * and access its items in place rather than read and unpack them,
+ * all values are in network order except for the columns and the
+ * byte order word, which are in the order of the host that wrote them:
+ *
+ *   header: version, byte order, items, users, user chars, groups,
+ *     group chars, max name, min depth, max depth, writer ranks,
+ *     offset of columns, offset of name heap, bytes in name heap,
+ *     offset of footer
+ *   users and groups, packed as in version 4
+ *   columns, each an array of one value per item that starts on an
+ *     8 byte boundary, in the order listed in cache_v5_widths
+ *   name heap, the NUL-terminated name of each item in item order
+ *   footer: for each writer rank, its first item, number of items,
+ *     offset of its names within the heap, and bytes of names */
+
+/* number of uint64 values in the version 5 header */
+#define CACHE_V5_HEADER (15)
+
+/* written in host order to detect a file from a host that
+ * orders bytes differently */
+#define CACHE_V5_BYTE_ORDER (0x0102030405060708ULL)
+
+/* number of uint64 values in the footer for each writer rank */
+#define CACHE_V5_FOOTER (4)
+
+/* bytes per item of each column: name offset in heap, depth, type,
+ * detail, mode, uid, gid, atime, atime_nsec, mtime, mtime_nsec,
+ * ctime, ctime_nsec, size */
+#define CACHE_V5_COLUMNS (14)
+static const uint64_t cache_v5_widths[CACHE_V5_COLUMNS] = {
+    8, sizeof(int), 1, 1, 4, 8, 8, 8, 4, 8, 4, 8, 4, 8
+};
+
+/* round bytes up to a multiple of 8 */
+static uint64_t cache_v5_align(uint64_t bytes)
+{
+    return (bytes + 7) / 8 * 8;
+}
+
+/* compute offset of each column given offset of first column and
+ * total number of items, returns offset of name heap */
+static uint64_t cache_v5_columns(uint64_t start, uint64_t all_count, uint64_t* offsets)
+{
+    uint64_t off = start;
+    int c;
+    for (c = 0; c < CACHE_V5_COLUMNS; c++) {
+        offsets[c] = off;
+        off += cache_v5_align(cache_v5_widths[c] * all_count);
+    }
+    return off;
+}
+
+/* rank 0 reads users or groups from disp in file and broadcasts
+ * them, returns bytes read */
+static MPI_Offset read_cache_buft(
+    const char* name,
+    MPI_Offset disp,
+    MPI_File fh,
+    const char* datarep,
+    buf_t* items)
+{
+    MPI_Status status;
+
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    if (items->count == 0 || items->chars == 0) {
+        return 0;
+    }
+
+    /* create type and allocate memory to hold data */
+    mfu_flist_usrgrp_create_stridtype((int)items->chars, &(items->dt));
+    MPI_Aint lb, extent;
+    MPI_Type_get_extent(items->dt, &lb, &extent);
+    items->bufsize = items->count * (size_t)extent;
+    items->buf = (void*) MFU_MALLOC(items->bufsize);
+
+    int mpirc = MPI_File_set_view(fh, disp, MPI_BYTE, MPI_BYTE, datarep, MPI_INFO_NULL);
+    if (mpirc != MPI_SUCCESS) {
+        MPI_Error_string(mpirc, mpierrstr, &mpierrlen);
+        MFU_ABORT(1, "Failed to set view on file: `%s' rc=%d %s", name, mpirc, mpierrstr);
+    }
+
+    int pack_size = (int) buft_pack_size(items);
+    if (rank == 0) {
+        char* buf = (char*) MFU_MALLOC(pack_size);
+        mpirc = MPI_File_read_at(fh, 0, buf, pack_size, MPI_BYTE, &status);
+        if (mpirc != MPI_SUCCESS) {
+            MPI_Error_string(mpirc, mpierrstr, &mpierrlen);
+            MFU_ABORT(1, "Failed to read file: `%s' rc=%d %s", name, mpirc, mpierrstr);
+        }
+        buft_unpack(buf, items);
+        mfu_free(&buf);
+    }
+    MPI_Bcast(items->buf, (int)items->count, items->dt, 0, MPI_COMM_WORLD);
+
+    return (MPI_Offset) pack_size;
+}
+
+/* maps the columns of our slice of a version 5 file into the list,
+ * the summary of the list is taken from the header, so the list is
+ * ready without touching any item */
+static void read_cache_v5(
+    const char* name,
+    MPI_Offset* outdisp,
+    MPI_File fh,
+    const char* datarep,
+    flist_t* flist)
+{
+    MPI_Status status;
+
+    MPI_Offset disp = *outdisp;
+
+    /* indicate that we have stat data */
+    flist->detail = 1;
+
+    buf_t* users  = &flist->users;
+    buf_t* groups = &flist->groups;
+
+    int rank, ranks;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &ranks);
+
+    /* rank 0 reads and broadcasts header, which follows the version */
+    uint64_t header[CACHE_V5_HEADER - 1];
+    int header_size = (CACHE_V5_HEADER - 1) * 8;
+    int mpirc = MPI_File_set_view(fh, disp, MPI_BYTE, MPI_BYTE, datarep, MPI_INFO_NULL);
+    if (mpirc != MPI_SUCCESS) {
+        MPI_Error_string(mpirc, mpierrstr, &mpierrlen);
+        MFU_ABORT(1, "Failed to set view on file: `%s' rc=%d %s", name, mpirc, mpierrstr);
+    }
+
+    if (rank == 0) {
+        uint64_t header_packed[CACHE_V5_HEADER - 1];
+        mpirc = MPI_File_read_at(fh, 0, header_packed, header_size, MPI_BYTE, &status);
+        if (mpirc != MPI_SUCCESS) {
+            MPI_Error_string(mpirc, mpierrstr, &mpierrlen);
+            MFU_ABORT(1, "Failed to read file: `%s' rc=%d %s", name, mpirc, mpierrstr);
+        }
+
+        /* columns are used in place, so they must be in our byte order */
+        if (header_packed[0] != CACHE_V5_BYTE_ORDER) {
+            MFU_ABORT(1, "File was written on a host with a different byte order: `%s'", name);
+        }
+
+        header[0] = header_packed[0];
+        const char* ptr = (const char*) &header_packed[1];
+        int i;
+        for (i = 1; i < CACHE_V5_HEADER - 1; i++) {
+            mfu_unpack_io_uint64(&ptr, &header[i]);
+        }
+    }
+    MPI_Bcast(header, CACHE_V5_HEADER - 1, MPI_UINT64_T, 0, MPI_COMM_WORLD);
+    disp += header_size;
+
+    uint64_t all_count   = header[1];
+    users->count         = header[2];
+    users->chars         = header[3];
+    groups->count        = header[4];
+    groups->chars        = header[5];
+    uint64_t max_name    = header[6];
+    uint64_t min_depth   = header[7];
+    uint64_t max_depth   = header[8];
+    uint64_t writers     = header[9];
+    uint64_t columns_off = header[10];
+    uint64_t heap_off    = header[11];
+    uint64_t heap_bytes  = header[12];
+    uint64_t footer_off  = header[13];
+
+    /* read users and groups */
+    disp += read_cache_buft(name, disp, fh, datarep, users);
+    disp += read_cache_buft(name, disp, fh, datarep, groups);
+
+    /* rank 0 reads and broadcasts the footer */
+    uint64_t footer_count = writers * CACHE_V5_FOOTER;
+    uint64_t* footer = (uint64_t*) MFU_MALLOC(footer_count * sizeof(uint64_t));
+    mpirc = MPI_File_set_view(fh, (MPI_Offset)footer_off, MPI_BYTE, MPI_BYTE, datarep, MPI_INFO_NULL);
+    if (mpirc != MPI_SUCCESS) {
+        MPI_Error_string(mpirc, mpierrstr, &mpierrlen);
+        MFU_ABORT(1, "Failed to set view on file: `%s' rc=%d %s", name, mpirc, mpierrstr);
+    }
+    if (rank == 0) {
+        int footer_size = (int)(footer_count * 8);
+        char* footer_packed = (char*) MFU_MALLOC(footer_size);
+        mpirc = MPI_File_read_at(fh, 0, footer_packed, footer_size, MPI_BYTE, &status);
+        if (mpirc != MPI_SUCCESS) {
+            MPI_Error_string(mpirc, mpierrstr, &mpierrlen);
+            MFU_ABORT(1, "Failed to read file: `%s' rc=%d %s", name, mpirc, mpierrstr);
+        }
+
+        const char* ptr = footer_packed;
+        uint64_t i;
+        for (i = 0; i < footer_count; i++) {
+            mfu_unpack_io_uint64(&ptr, &footer[i]);
+        }
+        mfu_free(&footer_packed);
+    }
+    MPI_Bcast(footer, (int)footer_count, MPI_UINT64_T, 0, MPI_COMM_WORLD);
+
+    /* with as many ranks as wrote the file, each rank takes the items
+     * it wrote, which keeps the order of the walk, otherwise split
+     * items evenly */
+    uint64_t first, count;
+    if (writers == (uint64_t)ranks) {
+        first = footer[rank * CACHE_V5_FOOTER + 0];
+        count = footer[rank * CACHE_V5_FOOTER + 1];
+    } else {
+        count = all_count / (uint64_t)ranks;
+        uint64_t remainder = all_count - count * (uint64_t)ranks;
+        if ((uint64_t)rank < remainder) {
+            count++;
+        }
+        MPI_Exscan(&count, &first, 1, MPI_UINT64_T, MPI_SUM, MPI_COMM_WORLD);
+        if (rank == 0) {
+            first = 0;
+        }
+    }
+    mfu_free(&footer);
+
+    /* map the columns and name heap, pages are only read as items
+     * are accessed, and the mapping is private so that setting a
+     * field of an item does not change the file */
+    if (count > 0) {
+        int fd = open(name, O_RDONLY);
+        if (fd < 0) {
+            MFU_ABORT(1, "Failed to open file: `%s' errno=%d (%s)", name, errno, strerror(errno));
+        }
+        size_t len = (size_t)(heap_off + heap_bytes);
+        void* addr = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        if (addr == MAP_FAILED) {
+            MFU_ABORT(1, "Failed to map file: `%s' errno=%d (%s)", name, errno, strerror(errno));
+        }
+        close(fd);
+
+        uint64_t col[CACHE_V5_COLUMNS];
+        cache_v5_columns(columns_off, all_count, col);
+
+        char* base = (char*) addr;
+        flist->map.addr       = addr;
+        flist->map.len        = len;
+        flist->map.names      = base + heap_off;
+        flist->map.name_off   = (const uint64_t*)(base + col[0]) + first;
+        flist->col_depth      = (int*)      (base + col[1])  + first;
+        flist->col_type       = (uint8_t*)  (base + col[2])  + first;
+        flist->col_detail     = (uint8_t*)  (base + col[3])  + first;
+        flist->col_mode       = (uint32_t*) (base + col[4])  + first;
+        flist->col_uid        = (uint64_t*) (base + col[5])  + first;
+        flist->col_gid        = (uint64_t*) (base + col[6])  + first;
+        flist->col_atime      = (uint64_t*) (base + col[7])  + first;
+        flist->col_atime_nsec = (uint32_t*) (base + col[8])  + first;
+        flist->col_mtime      = (uint64_t*) (base + col[9])  + first;
+        flist->col_mtime_nsec = (uint32_t*) (base + col[10]) + first;
+        flist->col_ctime      = (uint64_t*) (base + col[11]) + first;
+        flist->col_ctime_nsec = (uint32_t*) (base + col[12]) + first;
+        flist->col_size       = (uint64_t*) (base + col[13]) + first;
+        flist->list_count     = count;
+        flist->list_rows      = count;
+        flist->list_cap       = count;
+    }
+
+    /* set summary from header */
+    flist->total_files    = all_count;
+    flist->offset         = first;
+    flist->max_file_name  = max_name;
+    flist->min_depth      = (int) min_depth;
+    flist->max_depth      = (int) max_depth;
+    flist->total_users    = users->count;
+    flist->total_groups   = groups->count;
+    flist->max_user_name  = users->chars;
+    flist->max_group_name = groups->chars;
+
+    /* create maps of users and groups */
+    mfu_flist_usrgrp_create_map(&flist->users, flist->user_id2name);
+    mfu_flist_usrgrp_create_map(&flist->groups, flist->group_id2name);
+
+    *outdisp = disp;
+    return;
+}
+
+#ifdef HAVE_ZSTD
+/* version 6 holds the same items as version 5, but in blocks of
+ * runs of items that are each compressed on their own, so that each
+ * rank can compress and decompress its blocks in parallel, all
+ * values are in network order:
+ *
+ *   header: version, codec, items, users, user chars, groups,
+ *     group chars, blocks, offset of block data, offset of block
+ *     table, writer ranks
+ *   users and groups, packed as in version 4
+ *   compressed blocks of each writer rank in rank order
+ *   block table: for each block, its offset in the file, compressed
+ *     bytes, uncompressed bytes, number of items, and writer rank
+ *
+ * a block holds the fields of its items by column, the name length
+ * of each item (strlen()+1 or 0 if it has no name), the names with
+ * their terminating NUL, depth, type, detail, mode, uid, gid, atime,
+ * atime_nsec, mtime, mtime_nsec, ctime, ctime_nsec, and size */
+
+/* number of uint64 values in the version 6 header */
+#define CACHE_V6_HEADER (11)
+
+/* number of uint64 values in a block table entry */
+#define CACHE_V6_ENTRY (5)
+
+/* codec used to compress blocks */
+#define CACHE_V6_CODEC_ZSTD (1)
+
+/* number of items in each block */
+#define CACHE_V6_BLOCK_ITEMS (16384)
+
+/* bytes in a block for each item besides its name */
+#define CACHE_V6_ITEM_BYTES (4 + 4 + 1 + 1 + 4 + 8 + 8 + 8 + 4 + 8 + 4 + 8 + 4 + 8)
+
+/* insert the count items of an uncompressed block into the list */
+static void cache_v6_unpack_block(flist_t* flist, const char* buf, uint64_t count)
+{
+    /* find start of each column */
+    const char* lens = buf;
+    const char* names = lens + count * 4;
+    const char* ptr = lens;
+    uint64_t i;
+    uint64_t names_bytes = 0;
+    for (i = 0; i < count; i++) {
+        uint32_t len;
+        mfu_unpack_io_uint32(&ptr, &len);
+        names_bytes += len;
+    }
+    const char* depth      = names + names_bytes;
+    const char* type       = depth + count * 4;
+    const char* detail     = type + count;
+    const char* mode       = detail + count;
+    const char* uid        = mode + count * 4;
+    const char* gid        = uid + count * 8;
+    const char* atime      = gid + count * 8;
+    const char* atime_nsec = atime + count * 8;
+    const char* mtime      = atime_nsec + count * 4;
+    const char* mtime_nsec = mtime + count * 8;
+    const char* ctime      = mtime_nsec + count * 4;
+    const char* ctime_nsec = ctime + count * 8;
+    const char* size       = ctime_nsec + count * 4;
+
+    for (i = 0; i < count; i++) {
+        elem_t elem;
+        memset(&elem, 0, sizeof(elem));
+
+        uint32_t len, val32;
+        mfu_unpack_io_uint32(&lens, &len);
+        elem.file = (len > 0) ? names : NULL;
+        names += len;
+
+        mfu_unpack_io_uint32(&depth, &val32);
+        elem.depth = (int) val32;
+        elem.type   = (mfu_filetype) *(const uint8_t*)type;
+        elem.detail = (int) *(const uint8_t*)detail;
+        type++;
+        detail++;
+
+        mfu_unpack_io_uint32(&mode, &val32);
+        elem.mode = val32;
+        mfu_unpack_io_uint64(&uid,   &elem.uid);
+        mfu_unpack_io_uint64(&gid,   &elem.gid);
+        mfu_unpack_io_uint64(&atime, &elem.atime);
+        mfu_unpack_io_uint32(&atime_nsec, &val32);
+        elem.atime_nsec = val32;
+        mfu_unpack_io_uint64(&mtime, &elem.mtime);
+        mfu_unpack_io_uint32(&mtime_nsec, &val32);
+        elem.mtime_nsec = val32;
+        mfu_unpack_io_uint64(&ctime, &elem.ctime);
+        mfu_unpack_io_uint32(&ctime_nsec, &val32);
+        elem.ctime_nsec = val32;
+        mfu_unpack_io_uint64(&size, &elem.size);
+
+        mfu_flist_insert_elem(flist, &elem);
+    }
+}
+
+/* read bytes into buf from offset in file, split into reads
+ * whose size fits in an int */
+static void read_cache_at(
+    const char* name,
+    MPI_File fh,
+    MPI_Offset offset,
+    void* buf,
+    uint64_t bytes)
+{
+    MPI_Status status;
+    uint64_t maxread = 1024 * 1024 * 1024;
+    char* ptr = (char*) buf;
+    while (bytes > 0) {
+        int read_count = (int) ((bytes < maxread) ? bytes : maxread);
+        int mpirc = MPI_File_read_at(fh, offset, ptr, read_count, MPI_BYTE, &status);
+        if (mpirc != MPI_SUCCESS) {
+            MPI_Error_string(mpirc, mpierrstr, &mpierrlen);
+            MFU_ABORT(1, "Failed to read file: `%s' rc=%d %s", name, mpirc, mpierrstr);
+        }
+        offset += (MPI_Offset) read_count;
+        ptr    += read_count;
+        bytes  -= (uint64_t) read_count;
+    }
+}
+
+/* each rank reads a contiguous run of blocks with collective reads
+ * and decompresses them into its list */
+static void read_cache_v6(
+    const char* name,
+    MPI_Offset* outdisp,
+    MPI_File fh,
+    const char* datarep,
+    flist_t* flist)
+{
+    MPI_Status status;
+
+    MPI_Offset disp = *outdisp;
+
+    /* indicate that we have stat data */
+    flist->detail = 1;
+
+    buf_t* users  = &flist->users;
+    buf_t* groups = &flist->groups;
+
+    int rank, ranks;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &ranks);
+
+    /* rank 0 reads and broadcasts header, which follows the version */
+    uint64_t header[CACHE_V6_HEADER - 1];
+    int header_size = (CACHE_V6_HEADER - 1) * 8;
+    int mpirc = MPI_File_set_view(fh, disp, MPI_BYTE, MPI_BYTE, datarep, MPI_INFO_NULL);
+    if (mpirc != MPI_SUCCESS) {
+        MPI_Error_string(mpirc, mpierrstr, &mpierrlen);
+        MFU_ABORT(1, "Failed to set view on file: `%s' rc=%d %s", name, mpirc, mpierrstr);
+    }
+
+    if (rank == 0) {
+        uint64_t header_packed[CACHE_V6_HEADER - 1];
+        mpirc = MPI_File_read_at(fh, 0, header_packed, header_size, MPI_BYTE, &status);
+        if (mpirc != MPI_SUCCESS) {
+            MPI_Error_string(mpirc, mpierrstr, &mpierrlen);
+            MFU_ABORT(1, "Failed to read file: `%s' rc=%d %s", name, mpirc, mpierrstr);
+        }
+
+        const char* ptr = (const char*) header_packed;
+        int i;
+        for (i = 0; i < CACHE_V6_HEADER - 1; i++) {
+            mfu_unpack_io_uint64(&ptr, &header[i]);
+        }
+
+        if (header[0] != CACHE_V6_CODEC_ZSTD) {
+            MFU_ABORT(1, "Unknown codec %llu in file: `%s'", (unsigned long long)header[0], name);
+        }
+    }
+    MPI_Bcast(header, CACHE_V6_HEADER - 1, MPI_UINT64_T, 0, MPI_COMM_WORLD);
+    disp += header_size;
+
+    uint64_t all_count = header[1];
+    users->count       = header[2];
+    users->chars       = header[3];
+    groups->count      = header[4];
+    groups->chars      = header[5];
+    uint64_t blocks    = header[6];
+    uint64_t table_off = header[8];
+    uint64_t writers   = header[9];
+
+    /* read users and groups */
+    disp += read_cache_buft(name, disp, fh, datarep, users);
+    disp += read_cache_buft(name, disp, fh, datarep, groups);
+
+    /* the table is broadcast with an int count, a larger table can only
+     * come from a damaged file, since each block holds many items */
+    if (blocks > (uint64_t)INT_MAX / CACHE_V6_ENTRY) {
+        MFU_ABORT(1, "Invalid block count %llu in file: `%s'", (unsigned long long)blocks, name);
+    }
+
+    /* rank 0 reads and broadcasts the block table */
+    uint64_t table_count = blocks * CACHE_V6_ENTRY;
+    uint64_t* table = (uint64_t*) MFU_MALLOC(table_count * sizeof(uint64_t));
+    mpirc = MPI_File_set_view(fh, 0, MPI_BYTE, MPI_BYTE, datarep, MPI_INFO_NULL);
+    if (mpirc != MPI_SUCCESS) {
+        MPI_Error_string(mpirc, mpierrstr, &mpierrlen);
+        MFU_ABORT(1, "Failed to set view on file: `%s' rc=%d %s", name, mpirc, mpierrstr);
+    }
+    if (rank == 0) {
+        uint64_t table_bytes = table_count * 8;
+        char* table_packed = (char*) MFU_MALLOC((size_t)table_bytes);
+        read_cache_at(name, fh, (MPI_Offset)table_off, table_packed, table_bytes);
+
+        const char* ptr = table_packed;
+        uint64_t i;
+        for (i = 0; i < table_count; i++) {
+            mfu_unpack_io_uint64(&ptr, &table[i]);
+        }
+        mfu_free(&table_packed);
+    }
+    MPI_Bcast(table, (int)table_count, MPI_UINT64_T, 0, MPI_COMM_WORLD);
+
+    /* with as many ranks as wrote the file, each rank takes the blocks
+     * it wrote, otherwise give each block to the rank whose share of
+     * an even split holds the first item of the block, either way the
+     * blocks of a rank are contiguous in the file */
+    uint64_t b;
+    uint64_t first_block = blocks;
+    uint64_t end_block = blocks;
+    uint64_t first_item = 0;
+    for (b = 0; b < blocks; b++) {
+        const uint64_t* entry = &table[b * CACHE_V6_ENTRY];
+        uint64_t owner = entry[4];
+        if (writers != (uint64_t)ranks) {
+            owner = first_item * (uint64_t)ranks / all_count;
+        }
+        if (owner == (uint64_t)rank && first_block == blocks) {
+            first_block = b;
+        }
+        if (owner > (uint64_t)rank) {
+            end_block = b;
+            break;
+        }
+        first_item += entry[3];
+    }
+    if (first_block == blocks) {
+        end_block = blocks;
+    }
+
+    /* find range of bytes holding our blocks */
+    uint64_t read_start = 0;
+    uint64_t bytes = 0;
+    uint64_t max_raw = 0;
+    for (b = first_block; b < end_block; b++) {
+        const uint64_t* entry = &table[b * CACHE_V6_ENTRY];
+        if (b == first_block) {
+            read_start = entry[0];
+        }
+        bytes = entry[0] + entry[1] - read_start;
+        if (entry[2] > max_raw) {
+            max_raw = entry[2];
+        }
+    }
+
+    /* limit the size of each read to fit in an int */
+    uint64_t maxread = 1024 * 1024 * 1024;
+    uint64_t iters = (bytes + maxread - 1) / maxread;
+    uint64_t all_iters;
+    MPI_Allreduce(&iters, &all_iters, 1, MPI_UINT64_T, MPI_MAX, MPI_COMM_WORLD);
+
+    /* collective reads of our blocks */
+    char* buf = (char*) MFU_MALLOC((size_t)bytes);
+    MPI_Offset read_offset = (MPI_Offset)read_start;
+    uint64_t done = 0;
+    while (all_iters > 0) {
+        uint64_t remaining = bytes - done;
+        int read_count = (int) ((remaining < maxread) ? remaining : maxread);
+        mpirc = MPI_File_read_at_all(fh, read_offset, buf + done, read_count, MPI_BYTE, &status);
+        if (mpirc != MPI_SUCCESS) {
+            MPI_Error_string(mpirc, mpierrstr, &mpierrlen);
+            MFU_ABORT(1, "Failed to read file: `%s' rc=%d %s", name, mpirc, mpierrstr);
+        }
+        read_offset += (MPI_Offset) read_count;
+        done        += (uint64_t) read_count;
+        all_iters--;
+    }
+
+    /* decompress each block and insert its items */
+    char* raw = (char*) MFU_MALLOC((size_t)max_raw);
+    for (b = first_block; b < end_block; b++) {
+        const uint64_t* entry = &table[b * CACHE_V6_ENTRY];
+        const char* block = buf + (entry[0] - read_start);
+        size_t rc = ZSTD_decompress(raw, (size_t)entry[2], block, (size_t)entry[1]);
+        if (ZSTD_isError(rc) || rc != (size_t)entry[2]) {
+            MFU_ABORT(1, "Failed to decompress block %llu of file: `%s' %s",
+                (unsigned long long)b, name, ZSTD_isError(rc) ? ZSTD_getErrorName(rc) : "short block");
+        }
+        cache_v6_unpack_block(flist, raw, entry[3]);
+    }
+    mfu_free(&raw);
+    mfu_free(&buf);
+    mfu_free(&table);
+
+    /* create maps of users and groups */
+    mfu_flist_usrgrp_create_map(&flist->users, flist->user_id2name);
+    mfu_flist_usrgrp_create_map(&flist->groups, flist->group_id2name);
+
+    *outdisp = disp;
+    return;
+}
+#endif /* HAVE_ZSTD */
+
 void mfu_flist_read_cache(
     const char* name,
     mfu_flist bflist)
@@ -1139,7 +1732,15 @@ void mfu_flist_read_cache(
     disp += 1 * 8; /* 9 consecutive uint64_t types in external32 */
 
     /* read data from file */
-    if (version == 4) {
+    if (version == 6) {
+#ifdef HAVE_ZSTD
+        read_cache_v6(name, &disp, fh, datarep, flist);
+#else
+        MFU_ABORT(1, "Reading compressed file requires support for zstd: `%s'", name);
+#endif
+    } else if (version == 5) {
+        read_cache_v5(name, &disp, fh, datarep, flist);
+    } else if (version == 4) {
         read_cache_v4(name, &disp, fh, datarep, flist);
     } else if (version == 3) {
         /* need a couple of dummy params to record walk start and end times */
@@ -1159,8 +1760,10 @@ void mfu_flist_read_cache(
         MFU_ABORT(1, "Failed to close file: `%s' rc=%d %s", name, mpirc, mpierrstr);
     }
 
-    /* compute global summary */
-    mfu_flist_summarize(bflist);
+    /* compute global summary, which version 5 records in its header */
+    if (version != 5) {
+        mfu_flist_summarize(bflist);
+    }
 
     /* end timer */
     double end_read = MPI_Wtime();
@@ -1193,7 +1796,11 @@ void mfu_flist_read_cache(
  * 2: version, start, end, files, file chars, list (file, type)
  * 3: version, start, end, files, users, user chars, groups, group chars,
  *    files, file chars, list (user, userid), list (group, groupid),
- *    list (stat) */
+ *    list (stat)
+ * 4: version, users, user chars, groups, group chars, files, file chars,
+ *    list (user, userid), list (group, groupid), list (stat)
+ * 5: see read_cache_v5
+ * 6: see read_cache_v6 */
 
 /* write each record in ASCII format, terminated with newlines */
 static void write_cache_readdir_variable(
@@ -1212,15 +1819,16 @@ static void write_cache_readdir_variable(
     /* walk the list to determine the number of bytes we'll write */
     uint64_t bytes = 0;
     uint64_t recmax = 0;
-    const elem_t* current = flist->list_head;
-    while (current != NULL) {
+    uint64_t idx;
+    elem_t current;
+    for (idx = 0; idx < flist->list_rows; idx++) {
         /* <name>|<type={D,F,L}>\n */
-        uint64_t reclen = (uint64_t) list_elem_encode_size(current);
+        mfu_flist_get_elem(flist, idx, &current);
+        uint64_t reclen = (uint64_t) list_elem_encode_size(&current);
         if (recmax < reclen) {
             recmax = reclen;
         }
         bytes += reclen;
-        current = current->next;
     }
 
     /* compute byte offset for each task */
@@ -1279,22 +1887,24 @@ static void write_cache_readdir_variable(
     MPI_Offset write_offset = (MPI_Offset)offset;
 
     /* iterate with multiple writes until all records are written */
-    current = flist->list_head;
-    while (current != NULL) {
+    idx = 0;
+    while (idx < flist->list_rows) {
         /* copy stat data into write buffer */
         char* ptr = (char*) buf;
         size_t packsize = 0;
-        size_t recsize = list_elem_encode_size(current);
-        while (current != NULL && (packsize + recsize) <= bufsize) {
+        mfu_flist_get_elem(flist, idx, &current);
+        size_t recsize = list_elem_encode_size(&current);
+        while (idx < flist->list_rows && (packsize + recsize) <= bufsize) {
             /* pack item into buffer and advance pointer */
-            size_t encode_bytes = list_elem_encode(ptr, current);
+            size_t encode_bytes = list_elem_encode(ptr, &current);
             ptr += encode_bytes;
             packsize += encode_bytes;
 
-            /* get pointer to next element and update our recsize */
-            current = current->next;
-            if (current != NULL) {
-                recsize = list_elem_encode_size(current);
+            /* get next element and update our recsize */
+            idx++;
+            if (idx < flist->list_rows) {
+                mfu_flist_get_elem(flist, idx, &current);
+                recsize = list_elem_encode_size(&current);
             }
         }
 
@@ -1499,17 +2109,19 @@ static void write_cache_stat_v4(
     MPI_Offset write_offset = (MPI_Offset)offset * elem_size;
 
     /* iterate with multiple writes until all records are written */
-    const elem_t* current = flist->list_head;
+    uint64_t idx = 0;
     while (all_iters > 0) {
         /* copy stat data into write buffer */
         ptr = (char*) buf;
         uint64_t packcount = 0;
-        while (current != NULL && packcount < bufbytes) {
+        while (idx < flist->list_rows && packcount < bufbytes) {
             /* pack item into buffer and advance pointer */
-            size_t pack_bytes = list_elem_pack(ptr, flist->detail, (uint64_t)chars, current);
+            elem_t current;
+            mfu_flist_get_elem(flist, idx, &current);
+            size_t pack_bytes = list_elem_pack(ptr, flist->detail, (uint64_t)chars, &current);
             ptr += pack_bytes;
             packcount += (uint64_t)pack_bytes;
-            current = current->next;
+            idx++;
         }
 
         /* collective write of file info */
@@ -1543,6 +2155,613 @@ static void write_cache_stat_v4(
     return;
 }
 
+/* write bytes from buf at offset in file, split into writes
+ * whose size fits in an int */
+static void write_cache_at(
+    const char* name,
+    MPI_File fh,
+    MPI_Offset offset,
+    const void* buf,
+    uint64_t bytes)
+{
+    MPI_Status status;
+    uint64_t maxwrite = 1024 * 1024 * 1024;
+    const char* ptr = (const char*) buf;
+    while (bytes > 0) {
+        int write_count = (int) ((bytes < maxwrite) ? bytes : maxwrite);
+        int mpirc = MPI_File_write_at(fh, offset, (void*)ptr, write_count, MPI_BYTE, &status);
+        if (mpirc != MPI_SUCCESS) {
+            MPI_Error_string(mpirc, mpierrstr, &mpierrlen);
+            MFU_ABORT(1, "Failed to write to file: `%s' rc=%d %s", name, mpirc, mpierrstr);
+        }
+        offset += (MPI_Offset) write_count;
+        ptr    += write_count;
+        bytes  -= (uint64_t) write_count;
+    }
+}
+
+/* collective form of write_cache_at, every rank must call it,
+ * a rank with nothing to write passes 0 bytes */
+static void write_cache_at_all(
+    const char* name,
+    MPI_File fh,
+    MPI_Offset offset,
+    const void* buf,
+    uint64_t bytes)
+{
+    /* all ranks must make the same number of calls */
+    uint64_t maxwrite = 1024 * 1024 * 1024;
+    uint64_t iters = (bytes + maxwrite - 1) / maxwrite;
+    uint64_t all_iters;
+    MPI_Allreduce(&iters, &all_iters, 1, MPI_UINT64_T, MPI_MAX, MPI_COMM_WORLD);
+
+    MPI_Status status;
+    const char* ptr = (const char*) buf;
+    while (all_iters > 0) {
+        int write_count = (int) ((bytes < maxwrite) ? bytes : maxwrite);
+        int mpirc = MPI_File_write_at_all(fh, offset, (void*)ptr, write_count, MPI_BYTE, &status);
+        if (mpirc != MPI_SUCCESS) {
+            MPI_Error_string(mpirc, mpierrstr, &mpierrlen);
+            MFU_ABORT(1, "Failed to write to file: `%s' rc=%d %s", name, mpirc, mpierrstr);
+        }
+        offset += (MPI_Offset) write_count;
+        ptr    += write_count;
+        bytes  -= (uint64_t) write_count;
+        all_iters--;
+    }
+}
+
+static void write_cache_stat_v5(
+    const char* name,
+    flist_t* flist)
+{
+    buf_t* users  = &flist->users;
+    buf_t* groups = &flist->groups;
+
+    /* get our rank in job & number of ranks */
+    int rank, ranks;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &ranks);
+
+    /* get number of items in our list and total file count */
+    uint64_t count     = flist->list_count;
+    uint64_t all_count = flist->total_files;
+    uint64_t offset    = flist->offset;
+
+    /* compute bytes of our names and their offset in the heap */
+    uint64_t idx;
+    uint64_t heap_bytes = 0;
+    for (idx = 0; idx < count; idx++) {
+        const char* file = mfu_flist_file_get_name(flist, idx);
+        if (file != NULL) {
+            heap_bytes += (uint64_t) strlen(file) + 1;
+        }
+    }
+    uint64_t heap_start;
+    MPI_Exscan(&heap_bytes, &heap_start, 1, MPI_UINT64_T, MPI_SUM, MPI_COMM_WORLD);
+    if (rank == 0) {
+        heap_start = 0;
+    }
+    uint64_t all_heap_bytes;
+    MPI_Allreduce(&heap_bytes, &all_heap_bytes, 1, MPI_UINT64_T, MPI_SUM, MPI_COMM_WORLD);
+
+    /* lay out the file */
+    uint64_t header_bytes = CACHE_V5_HEADER * 8;
+    uint64_t user_bytes = 0;
+    if (users->count > 0 && users->chars > 0) {
+        user_bytes = (uint64_t) buft_pack_size(users);
+    }
+    uint64_t group_bytes = 0;
+    if (groups->count > 0 && groups->chars > 0) {
+        group_bytes = (uint64_t) buft_pack_size(groups);
+    }
+    uint64_t columns_off = cache_v5_align(header_bytes + user_bytes + group_bytes);
+    uint64_t col[CACHE_V5_COLUMNS];
+    uint64_t heap_off = cache_v5_columns(columns_off, all_count, col);
+    uint64_t footer_off = cache_v5_align(heap_off + all_heap_bytes);
+
+    /* use mpi io hints to stripe across OSTs */
+    MPI_Info info;
+    MPI_Info_create(&info);
+
+    /* change number of ranks to string to pass to MPI_Info */
+    char str_buf[12];
+    sprintf(str_buf, "%d", ranks);
+
+    /* no. of I/O devices for lustre striping is number of ranks */
+    MPI_Info_set(info, "striping_factor", str_buf);
+
+    /* open file */
+    MPI_File fh;
+    const char* datarep = datarep_native;
+    int amode = MPI_MODE_WRONLY | MPI_MODE_CREATE;
+    int mpirc = MPI_File_open(MPI_COMM_WORLD, (char*)name, amode, info, &fh);
+    if (mpirc != MPI_SUCCESS) {
+        MPI_Error_string(mpirc, mpierrstr, &mpierrlen);
+        MFU_ABORT(1, "Failed to open file for writing: `%s' rc=%d %s", name, mpirc, mpierrstr);
+    }
+
+    /* truncate file to 0 bytes */
+    mpirc = MPI_File_set_size(fh, 0);
+    if (mpirc != MPI_SUCCESS) {
+        MPI_Error_string(mpirc, mpierrstr, &mpierrlen);
+        MFU_ABORT(1, "Failed to truncate file: `%s' rc=%d %s", name, mpirc, mpierrstr);
+    }
+
+    mpirc = MPI_File_set_view(fh, 0, MPI_BYTE, MPI_BYTE, datarep, MPI_INFO_NULL);
+    if (mpirc != MPI_SUCCESS) {
+        MPI_Error_string(mpirc, mpierrstr, &mpierrlen);
+        MFU_ABORT(1, "Failed to set view on file: `%s' rc=%d %s", name, mpirc, mpierrstr);
+    }
+
+    /* rank 0 writes header, users, and groups */
+    uint64_t lead_bytes = 0;
+    char* lead = NULL;
+    if (rank == 0) {
+        lead_bytes = header_bytes + user_bytes + group_bytes;
+        lead = (char*) MFU_MALLOC(lead_bytes);
+
+        uint64_t* header = (uint64_t*) lead;
+        header[1] = CACHE_V5_BYTE_ORDER;
+        char* ptr = lead;
+        mfu_pack_io_uint64(&ptr, 5);                           /* file version */
+        ptr += 8;                                              /* byte order */
+        mfu_pack_io_uint64(&ptr, all_count);                   /* total number of items */
+        mfu_pack_io_uint64(&ptr, users->count);                /* number of user records */
+        mfu_pack_io_uint64(&ptr, users->chars);                /* number of chars in user name */
+        mfu_pack_io_uint64(&ptr, groups->count);               /* number of group records */
+        mfu_pack_io_uint64(&ptr, groups->chars);               /* number of chars in group name */
+        mfu_pack_io_uint64(&ptr, flist->max_file_name);        /* max strlen()+1 of name */
+        mfu_pack_io_uint64(&ptr, (uint64_t)flist->min_depth);  /* min depth */
+        mfu_pack_io_uint64(&ptr, (uint64_t)flist->max_depth);  /* max depth */
+        mfu_pack_io_uint64(&ptr, (uint64_t)ranks);             /* ranks in footer */
+        mfu_pack_io_uint64(&ptr, columns_off);                 /* offset of columns */
+        mfu_pack_io_uint64(&ptr, heap_off);                    /* offset of name heap */
+        mfu_pack_io_uint64(&ptr, all_heap_bytes);              /* bytes in name heap */
+        mfu_pack_io_uint64(&ptr, footer_off);                  /* offset of footer */
+
+        if (user_bytes > 0) {
+            buft_pack(lead + header_bytes, users);
+        }
+        if (group_bytes > 0) {
+            buft_pack(lead + header_bytes + user_bytes, groups);
+        }
+    }
+    write_cache_at_all(name, fh, 0, lead, lead_bytes);
+    mfu_free(&lead);
+
+    /* write our part of each column straight from the list, except
+     * for name offsets, which are written along with the names */
+    const void* src[CACHE_V5_COLUMNS] = {
+        NULL,
+        flist->col_depth,
+        flist->col_type,
+        flist->col_detail,
+        flist->col_mode,
+        flist->col_uid,
+        flist->col_gid,
+        flist->col_atime,
+        flist->col_atime_nsec,
+        flist->col_mtime,
+        flist->col_mtime_nsec,
+        flist->col_ctime,
+        flist->col_ctime_nsec,
+        flist->col_size,
+    };
+    int c;
+    for (c = 1; c < CACHE_V5_COLUMNS; c++) {
+        uint64_t width = cache_v5_widths[c];
+        MPI_Offset write_offset = (MPI_Offset)(col[c] + offset * width);
+        write_cache_at_all(name, fh, write_offset, src[c], count * width);
+    }
+
+    /* in order to avoid blowing out memory, we'll copy names and
+     * their offsets into smaller buffers and write them in rounds,
+     * until every rank has written all of its names */
+    size_t bufsize = 1024 * 1024;
+    char* namebuf = (char*) MFU_MALLOC(bufsize);
+    uint64_t* offbuf = (uint64_t*) MFU_MALLOC(bufsize);
+    uint64_t offmax = (uint64_t)bufsize / sizeof(uint64_t);
+    uint64_t name_written = 0;
+    idx = 0;
+    while (1) {
+        /* stop once no rank has names left to write */
+        int remaining = (idx < count);
+        int any_remaining;
+        MPI_Allreduce(&remaining, &any_remaining, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+        if (! any_remaining) {
+            break;
+        }
+
+        /* fill buffers with as many names as fit */
+        uint64_t first = idx;
+        uint64_t namelen = 0;
+        uint64_t offcount = 0;
+        while (idx < count && offcount < offmax) {
+            const char* file = mfu_flist_file_get_name(flist, idx);
+            if (file == NULL) {
+                offbuf[offcount] = FLIST_MAP_NAME_NONE;
+            } else {
+                /* leave a name that does not fit for the next round,
+                 * unless the buffer is empty, in which case grow it */
+                uint64_t len = (uint64_t) strlen(file) + 1;
+                if (namelen + len > (uint64_t)bufsize) {
+                    if (namelen > 0) {
+                        break;
+                    }
+                    mfu_free(&namebuf);
+                    bufsize = (size_t) len;
+                    namebuf = (char*) MFU_MALLOC(bufsize);
+                }
+                memcpy(namebuf + namelen, file, (size_t)len);
+                offbuf[offcount] = heap_start + name_written + namelen;
+                namelen += len;
+            }
+            offcount++;
+            idx++;
+        }
+
+        MPI_Offset write_offset = (MPI_Offset)(heap_off + heap_start + name_written);
+        write_cache_at_all(name, fh, write_offset, namebuf, namelen);
+        name_written += namelen;
+
+        write_offset = (MPI_Offset)(col[0] + (offset + first) * 8);
+        write_cache_at_all(name, fh, write_offset, offbuf, offcount * 8);
+    }
+    mfu_free(&offbuf);
+    mfu_free(&namebuf);
+
+    /* gather the range of each rank and have rank 0 write the footer */
+    uint64_t range[CACHE_V5_FOOTER];
+    char* ptr = (char*) range;
+    mfu_pack_io_uint64(&ptr, offset);
+    mfu_pack_io_uint64(&ptr, count);
+    mfu_pack_io_uint64(&ptr, heap_start);
+    mfu_pack_io_uint64(&ptr, heap_bytes);
+    uint64_t* footer = NULL;
+    uint64_t footer_bytes = 0;
+    if (rank == 0) {
+        footer_bytes = (uint64_t)ranks * sizeof(range);
+        footer = (uint64_t*) MFU_MALLOC((size_t)footer_bytes);
+    }
+    MPI_Gather(range, CACHE_V5_FOOTER, MPI_UINT64_T, footer, CACHE_V5_FOOTER, MPI_UINT64_T, 0, MPI_COMM_WORLD);
+    write_cache_at_all(name, fh, (MPI_Offset)footer_off, footer, footer_bytes);
+    mfu_free(&footer);
+
+    /* close file */
+    mpirc = MPI_File_close(&fh);
+    if (mpirc != MPI_SUCCESS) {
+        MPI_Error_string(mpirc, mpierrstr, &mpierrlen);
+        MFU_ABORT(1, "Failed to close file: `%s' rc=%d %s", name, mpirc, mpierrstr);
+    }
+
+    /* free mpi info */
+    MPI_Info_free(&info);
+
+    return;
+}
+
+#ifdef HAVE_ZSTD
+/* pack the fields of count items starting at index start into an
+ * uncompressed block, returns number of bytes */
+static size_t cache_v6_pack_block(flist_t* flist, uint64_t start, uint64_t count, char* buf)
+{
+    /* names come first, after their lengths */
+    uint64_t i;
+    char* lens = buf;
+    char* names = buf + count * 4;
+    for (i = 0; i < count; i++) {
+        const char* file = mfu_flist_file_get_name(flist, start + i);
+        uint32_t len = 0;
+        if (file != NULL) {
+            len = (uint32_t) strlen(file) + 1;
+            memcpy(names, file, len);
+            names += len;
+        }
+        mfu_pack_io_uint32(&lens, len);
+    }
+
+    char* depth      = names;
+    char* type       = depth + count * 4;
+    char* detail     = type + count;
+    char* mode       = detail + count;
+    char* uid        = mode + count * 4;
+    char* gid        = uid + count * 8;
+    char* atime      = gid + count * 8;
+    char* atime_nsec = atime + count * 8;
+    char* mtime      = atime_nsec + count * 4;
+    char* mtime_nsec = mtime + count * 8;
+    char* ctime      = mtime_nsec + count * 4;
+    char* ctime_nsec = ctime + count * 8;
+    char* size       = ctime_nsec + count * 4;
+    char* end        = size + count * 8;
+
+    for (i = 0; i < count; i++) {
+        uint64_t idx = start + i;
+        mfu_pack_io_uint32(&depth, (uint32_t) flist->col_depth[idx]);
+        *(uint8_t*)type   = flist->col_type[idx];
+        *(uint8_t*)detail = flist->col_detail[idx];
+        type++;
+        detail++;
+        mfu_pack_io_uint32(&mode,       flist->col_mode[idx]);
+        mfu_pack_io_uint64(&uid,        flist->col_uid[idx]);
+        mfu_pack_io_uint64(&gid,        flist->col_gid[idx]);
+        mfu_pack_io_uint64(&atime,      flist->col_atime[idx]);
+        mfu_pack_io_uint32(&atime_nsec, flist->col_atime_nsec[idx]);
+        mfu_pack_io_uint64(&mtime,      flist->col_mtime[idx]);
+        mfu_pack_io_uint32(&mtime_nsec, flist->col_mtime_nsec[idx]);
+        mfu_pack_io_uint64(&ctime,      flist->col_ctime[idx]);
+        mfu_pack_io_uint32(&ctime_nsec, flist->col_ctime_nsec[idx]);
+        mfu_pack_io_uint64(&size,       flist->col_size[idx]);
+    }
+
+    return (size_t)(end - buf);
+}
+
+/* each rank compresses its items in blocks at the given zstd level
+ * and the blocks are written with collective writes */
+static void write_cache_stat_v6(
+    const char* name,
+    flist_t* flist,
+    int level)
+{
+    buf_t* users  = &flist->users;
+    buf_t* groups = &flist->groups;
+
+    /* get our rank in job & number of ranks */
+    int rank, ranks;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &ranks);
+
+    /* get number of items in our list and total file count */
+    uint64_t count     = flist->list_count;
+    uint64_t all_count = flist->total_files;
+
+    /* compress our items in blocks, recording the offset of each
+     * block relative to our first block */
+    uint64_t blocks = (count + CACHE_V6_BLOCK_ITEMS - 1) / CACHE_V6_BLOCK_ITEMS;
+    uint64_t* table = (uint64_t*) MFU_MALLOC(blocks * CACHE_V6_ENTRY * sizeof(uint64_t));
+    size_t raw_size = 0;
+    char* raw = NULL;
+    size_t out_size = 0;
+    char* out = NULL;
+    uint64_t bytes = 0;
+    uint64_t b;
+    for (b = 0; b < blocks; b++) {
+        uint64_t start = b * CACHE_V6_BLOCK_ITEMS;
+        uint64_t n = count - start;
+        if (n > CACHE_V6_BLOCK_ITEMS) {
+            n = CACHE_V6_BLOCK_ITEMS;
+        }
+
+        /* make room for the uncompressed block */
+        size_t need = (size_t) n * CACHE_V6_ITEM_BYTES;
+        uint64_t i;
+        for (i = start; i < start + n; i++) {
+            const char* file = mfu_flist_file_get_name(flist, i);
+            if (file != NULL) {
+                need += strlen(file) + 1;
+            }
+        }
+        if (need > raw_size) {
+            mfu_free(&raw);
+            raw_size = need;
+            raw = (char*) MFU_MALLOC(raw_size);
+        }
+        size_t raw_bytes = cache_v6_pack_block(flist, start, n, raw);
+
+        /* make room for the compressed block at the end of our data */
+        size_t bound = ZSTD_compressBound(raw_bytes);
+        if ((size_t)bytes + bound > out_size) {
+            out_size = ((size_t)bytes + bound) * 2;
+            out = (char*) realloc(out, out_size);
+            if (out == NULL) {
+                MFU_ABORT(1, "Failed to allocate %llu bytes to compress file: `%s'",
+                    (unsigned long long)out_size, name);
+            }
+        }
+        size_t rc = ZSTD_compress(out + bytes, bound, raw, raw_bytes, level);
+        if (ZSTD_isError(rc)) {
+            MFU_ABORT(1, "Failed to compress block of file: `%s' %s", name, ZSTD_getErrorName(rc));
+        }
+
+        uint64_t* entry = &table[b * CACHE_V6_ENTRY];
+        entry[0] = bytes;
+        entry[1] = (uint64_t) rc;
+        entry[2] = (uint64_t) raw_bytes;
+        entry[3] = n;
+        entry[4] = (uint64_t) rank;
+        bytes += (uint64_t) rc;
+    }
+    mfu_free(&raw);
+
+    /* compute offsets of our data and our table entries */
+    uint64_t data_start, block_start;
+    MPI_Exscan(&bytes, &data_start, 1, MPI_UINT64_T, MPI_SUM, MPI_COMM_WORLD);
+    MPI_Exscan(&blocks, &block_start, 1, MPI_UINT64_T, MPI_SUM, MPI_COMM_WORLD);
+    if (rank == 0) {
+        data_start  = 0;
+        block_start = 0;
+    }
+    uint64_t all_bytes, all_blocks;
+    MPI_Allreduce(&bytes, &all_bytes, 1, MPI_UINT64_T, MPI_SUM, MPI_COMM_WORLD);
+    MPI_Allreduce(&blocks, &all_blocks, 1, MPI_UINT64_T, MPI_SUM, MPI_COMM_WORLD);
+
+    /* lay out the file */
+    uint64_t header_bytes = CACHE_V6_HEADER * 8;
+    uint64_t user_bytes = 0;
+    if (users->count > 0 && users->chars > 0) {
+        user_bytes = (uint64_t) buft_pack_size(users);
+    }
+    uint64_t group_bytes = 0;
+    if (groups->count > 0 && groups->chars > 0) {
+        group_bytes = (uint64_t) buft_pack_size(groups);
+    }
+    uint64_t data_off  = header_bytes + user_bytes + group_bytes;
+    uint64_t table_off = data_off + all_bytes;
+
+    /* use mpi io hints to stripe across OSTs */
+    MPI_Info info;
+    MPI_Info_create(&info);
+
+    /* change number of ranks to string to pass to MPI_Info */
+    char str_buf[12];
+    sprintf(str_buf, "%d", ranks);
+
+    /* no. of I/O devices for lustre striping is number of ranks */
+    MPI_Info_set(info, "striping_factor", str_buf);
+
+    /* open file */
+    MPI_File fh;
+    const char* datarep = datarep_native;
+    int amode = MPI_MODE_WRONLY | MPI_MODE_CREATE;
+    int mpirc = MPI_File_open(MPI_COMM_WORLD, (char*)name, amode, info, &fh);
+    if (mpirc != MPI_SUCCESS) {
+        MPI_Error_string(mpirc, mpierrstr, &mpierrlen);
+        MFU_ABORT(1, "Failed to open file for writing: `%s' rc=%d %s", name, mpirc, mpierrstr);
+    }
+
+    /* truncate file to 0 bytes */
+    mpirc = MPI_File_set_size(fh, 0);
+    if (mpirc != MPI_SUCCESS) {
+        MPI_Error_string(mpirc, mpierrstr, &mpierrlen);
+        MFU_ABORT(1, "Failed to truncate file: `%s' rc=%d %s", name, mpirc, mpierrstr);
+    }
+
+    mpirc = MPI_File_set_view(fh, 0, MPI_BYTE, MPI_BYTE, datarep, MPI_INFO_NULL);
+    if (mpirc != MPI_SUCCESS) {
+        MPI_Error_string(mpirc, mpierrstr, &mpierrlen);
+        MFU_ABORT(1, "Failed to set view on file: `%s' rc=%d %s", name, mpirc, mpierrstr);
+    }
+
+    /* rank 0 writes header, users, and groups */
+    if (rank == 0) {
+        uint64_t header[CACHE_V6_HEADER];
+        char* ptr = (char*) header;
+        mfu_pack_io_uint64(&ptr, 6);                   /* file version */
+        mfu_pack_io_uint64(&ptr, CACHE_V6_CODEC_ZSTD); /* codec of blocks */
+        mfu_pack_io_uint64(&ptr, all_count);           /* total number of items */
+        mfu_pack_io_uint64(&ptr, users->count);        /* number of user records */
+        mfu_pack_io_uint64(&ptr, users->chars);        /* number of chars in user name */
+        mfu_pack_io_uint64(&ptr, groups->count);       /* number of group records */
+        mfu_pack_io_uint64(&ptr, groups->chars);       /* number of chars in group name */
+        mfu_pack_io_uint64(&ptr, all_blocks);          /* number of blocks */
+        mfu_pack_io_uint64(&ptr, data_off);            /* offset of blocks */
+        mfu_pack_io_uint64(&ptr, table_off);           /* offset of block table */
+        mfu_pack_io_uint64(&ptr, (uint64_t)ranks);     /* writer ranks */
+        write_cache_at(name, fh, 0, header, header_bytes);
+
+        if (user_bytes > 0) {
+            char* user_buf = (char*) MFU_MALLOC(user_bytes);
+            buft_pack(user_buf, users);
+            write_cache_at(name, fh, (MPI_Offset)header_bytes, user_buf, user_bytes);
+            mfu_free(&user_buf);
+        }
+
+        if (group_bytes > 0) {
+            char* group_buf = (char*) MFU_MALLOC(group_bytes);
+            buft_pack(group_buf, groups);
+            write_cache_at(name, fh, (MPI_Offset)(header_bytes + user_bytes), group_buf, group_bytes);
+            mfu_free(&group_buf);
+        }
+    }
+
+    /* collective writes of our blocks */
+    write_cache_at_all(name, fh, (MPI_Offset)(data_off + data_start), out, bytes);
+    mfu_free(&out);
+
+    /* collective write of our table entries, with offsets in the file */
+    uint64_t table_bytes = blocks * CACHE_V6_ENTRY * 8;
+    char* table_packed = (char*) MFU_MALLOC((size_t)table_bytes);
+    char* ptr = table_packed;
+    for (b = 0; b < blocks * CACHE_V6_ENTRY; b++) {
+        uint64_t val = table[b];
+        if (b % CACHE_V6_ENTRY == 0) {
+            val += data_off + data_start;
+        }
+        mfu_pack_io_uint64(&ptr, val);
+    }
+    MPI_Offset table_offset = (MPI_Offset)(table_off + block_start * CACHE_V6_ENTRY * 8);
+    write_cache_at_all(name, fh, table_offset, table_packed, table_bytes);
+    mfu_free(&table_packed);
+    mfu_free(&table);
+
+    /* close file */
+    mpirc = MPI_File_close(&fh);
+    if (mpirc != MPI_SUCCESS) {
+        MPI_Error_string(mpirc, mpierrstr, &mpierrlen);
+        MFU_ABORT(1, "Failed to close file: `%s' rc=%d %s", name, mpirc, mpierrstr);
+    }
+
+    /* free mpi info */
+    MPI_Info_free(&info);
+
+    /* report compression ratio */
+    if (rank == 0 && all_bytes > 0) {
+        MFU_LOG(MFU_LOG_VERBOSE, "Compressed %llu items into %llu blocks totaling %llu bytes",
+            (unsigned long long)all_count, (unsigned long long)all_blocks,
+            (unsigned long long)all_bytes);
+    }
+
+    return;
+}
+#endif /* HAVE_ZSTD */
+
+/* zstd level to compress cache files with, 0 to not compress */
+int mfu_flist_cache_compress = 0;
+
+/* set to 1 to write cache files that readers map in place */
+int mfu_flist_cache_map = 0;
+
+/* read MFU_CACHE_MAP to set mfu_flist_cache_map */
+static void mfu_flist_init_cache_map(void)
+{
+    char varname[] = "MFU_CACHE_MAP";
+    const char* value = getenv(varname);
+    if (value == NULL) {
+        return;
+    }
+
+    if (strcmp(value, "0") != 0 && strcmp(value, "1") != 0) {
+        if (mfu_rank == 0) {
+            MFU_LOG(MFU_LOG_WARN, "Ignoring invalid %s: `%s'", varname, value);
+        }
+        return;
+    }
+
+    mfu_flist_cache_map = atoi(value);
+}
+
+/* read MFU_CACHE_MAP and MFU_CACHE_COMPRESS to set
+ * mfu_flist_cache_map and mfu_flist_cache_compress */
+void mfu_flist_init_cache(void)
+{
+    mfu_flist_init_cache_map();
+
+    char varname[] = "MFU_CACHE_COMPRESS";
+    const char* value = getenv(varname);
+    if (value == NULL) {
+        return;
+    }
+
+    char* end;
+    long level = strtol(value, &end, 10);
+    if (*value == '\0' || *end != '\0' || level < 0 || level > 19) {
+        if (mfu_rank == 0) {
+            MFU_LOG(MFU_LOG_WARN, "Ignoring invalid %s: `%s'", varname, value);
+        }
+        return;
+    }
+
+#ifdef HAVE_ZSTD
+    mfu_flist_cache_compress = (int) level;
+#else
+    if (level > 0 && mfu_rank == 0) {
+        MFU_LOG(MFU_LOG_WARN, "Ignoring %s, built without support for zstd", varname);
+    }
+#endif
+}
+
 void mfu_flist_write_cache(
     const char* name,
     mfu_flist bflist)
@@ -1561,9 +2780,30 @@ void mfu_flist_write_cache(
         MFU_LOG(MFU_LOG_INFO, "Writing to output file: %s", name);
     }
 
+    /* a mapped list may have been read from the file we are about
+     * to overwrite, so copy it out of the mapping first */
+    mfu_flist_unmap(flist);
+
     if (all_count > 0) {
         if (flist->detail) {
-            write_cache_stat_v4(name, flist);
+            /* version 4 is the default, older builds can't read
+             * versions 5 and 6, and version 5 is stored in the byte
+             * order of the host that wrote it */
+#ifdef HAVE_ZSTD
+            if (mfu_flist_cache_compress > 0) {
+                write_cache_stat_v6(name, flist, mfu_flist_cache_compress);
+            } else if (mfu_flist_cache_map) {
+                write_cache_stat_v5(name, flist);
+            } else {
+                write_cache_stat_v4(name, flist);
+            }
+#else
+            if (mfu_flist_cache_map) {
+                write_cache_stat_v5(name, flist);
+            } else {
+                write_cache_stat_v4(name, flist);
+            }
+#endif
         }
         else {
             write_cache_readdir_variable(name, flist);
@@ -584,6 +584,8 @@ void mfu_flist_walk_paths(uint64_t num_paths, const char** paths,
                           mfu_walk_opts_t* walk_opts, mfu_flist bflist,
                           mfu_file_t* mfu_file)
 {
+    MFU_TRACE_BEGIN("walk");
+
     /* report walk count, time, and rate */
     double start_walk = MPI_Wtime();
 
@@ -703,6 +705,7 @@ void mfu_flist_walk_paths(uint64_t num_paths, const char** paths,
     /* hold procs here until summary is printed */
     MPI_Barrier(MPI_COMM_WORLD);
 
+    MFU_TRACE_END("walk");
     return;
 }
 
@@ -742,6 +745,77 @@ void mfu_flist_walk_param_paths(uint64_t num,
     return;
 }
 
+/* read directories from dirs, starting at local index *next, without
+ * descending into subdirectories, and insert an item with stat data
+ * for each entry into flist, this is not collective so that callers
+ * can walk a tree a batch of directories at a time */
+void mfu_flist_walk_dirs(
+    mfu_flist dirs,
+    uint64_t* next,
+    uint64_t max_items,
+    mfu_walk_opts_t* walk_opts,
+    mfu_flist flist,
+    mfu_file_t* mfu_file)
+{
+    /* read directories until we have enough items, we always finish
+     * a directory once started, so a large directory may overshoot */
+    uint64_t size = mfu_flist_size(dirs);
+    while (*next < size && mfu_flist_size(flist) < max_items) {
+        /* get name of directory and advance to the next one */
+        const char* dir = mfu_flist_file_get_name(dirs, *next);
+        (*next)++;
+
+        DIR* dirp = mfu_file_opendir(dir, mfu_file);
+        if (! dirp) {
+            MFU_LOG(MFU_LOG_ERR, "Failed to open directory with opendir: '%s' (errno=%d %s)",
+                    dir, errno, strerror(errno));
+            continue;
+        }
+
+        while (1) {
+            /* read next directory entry */
+            struct dirent* entry = mfu_file_readdir(dirp, mfu_file);
+            if (entry == NULL) {
+                break;
+            }
+
+            /* We don't care about . or .. */
+            char* name = entry->d_name;
+            if (! strncmp(name, ".", 2) || ! strncmp(name, "..", 3)) {
+                continue;
+            }
+
+            /* <dir> + '/' + <name> + '/0' */
+            char newpath[CIRCLE_MAX_STRING_LEN];
+            int rc = build_path(newpath, CIRCLE_MAX_STRING_LEN, dir, name);
+            if (rc != 0) {
+                continue;
+            }
+
+            /* stat item */
+            struct stat st;
+            int status;
+            if (walk_opts->dereference) {
+                /* if symlink, stat the symlink value */
+                status = mfu_file_stat(newpath, &st, mfu_file);
+            } else {
+                /* if symlink, stat the symlink itself */
+                status = mfu_file_lstat(newpath, &st, mfu_file);
+            }
+            if (status != 0) {
+                MFU_LOG(MFU_LOG_ERR, "Failed to stat: '%s' (errno=%d %s)",
+                        newpath, errno, strerror(errno));
+                continue;
+            }
+
+            /* record info for item in list */
+            mfu_flist_insert_stat(flist, newpath, st.st_mode, &st);
+        }
+
+        mfu_file_closedir(dirp, mfu_file);
+    }
+}
+
 /* Given an input file list, stat each file and enqueue details
  * in output file list, skip entries excluded by skip function
  * and skip args */
@@ -16,7 +16,6 @@
 
 #include "mfu.h"
 #include "mfu_errors.h"
-#include "timing.h"
 
 #define MFU_IO_TRIES  (5)
 #define MFU_IO_USLEEP (100)
@@ -40,7 +39,7 @@ int mfu_file_access(const char* path, int amode, mfu_file_t* mfu_file)
 
 int mfu_access(const char* path, int amode)
 {
-    double start = MPI_Wtime();
+    uint64_t start = mfu_perf_start();
     int rc;
     int tries = MFU_IO_TRIES;
 retry:
@@ -56,8 +55,7 @@ retry:
             }
         }
     }
-    double end = MPI_Wtime();
-    md_record_timing(start, end);
+    mfu_perf_stop(MFU_PERF_STAT, start, 0);
     return rc;
 }
 
@@ -89,7 +87,7 @@ int mfu_file_faccessat(int dirfd, const char* path, int amode, int flags, mfu_fi
 
 int mfu_faccessat(int dirfd, const char* path, int amode, int flags)
 {
-    double start = MPI_Wtime();
+    uint64_t start = mfu_perf_start();
     int rc;
     int tries = MFU_IO_TRIES;
 retry:
@@ -105,8 +103,7 @@ retry:
             }
         }
     }
-    double end = MPI_Wtime();
-    md_record_timing(start, end);
+    mfu_perf_stop(MFU_PERF_STAT, start, 0);
     return rc;
 }
 
@@ -145,7 +142,7 @@ int mfu_file_lchown(const char* path, uid_t owner, gid_t group, mfu_file_t* mfu_
 
 int mfu_lchown(const char* path, uid_t owner, gid_t group)
 {
-    double start = MPI_Wtime();
+    uint64_t start = mfu_perf_start();
     int rc;
     int tries = MFU_IO_TRIES;
 retry:
@@ -161,8 +158,7 @@ retry:
             }
         }
     }
-    double end = MPI_Wtime();
-    record_timing(start, end);
+    mfu_perf_stop(MFU_PERF_SETATTR, start, 0);
     return rc;
 }
 
@@ -187,7 +183,7 @@ int daos_chmod(const char *path, mode_t mode, mfu_file_t* mfu_file)
 
 int mfu_chmod(const char* path, mode_t mode)
 {
-    double start = MPI_Wtime();
+    uint64_t start = mfu_perf_start();
     int rc;
     int tries = MFU_IO_TRIES;
 retry:
@@ -203,8 +199,7 @@ retry:
             }
         }
     }
-    double end = MPI_Wtime();
-    record_timing(start, end);
+    mfu_perf_stop(MFU_PERF_SETATTR, start, 0);
     return rc;
 }
 
@@ -241,7 +236,7 @@ int mfu_file_utimensat(int dirfd, const char* pathname, const struct timespec ti
 
 int mfu_utimensat(int dirfd, const char* pathname, const struct timespec times[2], int flags)
 {
-    double start = MPI_Wtime();
+    uint64_t start = mfu_perf_start();
     int rc;
     int tries = MFU_IO_TRIES;
 retry:
@@ -257,8 +252,7 @@ retry:
             }
         }
     }
-    double end = MPI_Wtime();
-    record_timing(start, end);
+    mfu_perf_stop(MFU_PERF_SETATTR, start, 0);
     return rc;
 }
 
@@ -293,7 +287,7 @@ int daos_stat(const char* path, struct stat* buf, mfu_file_t* mfu_file)
 }
 
 int mfu_stat(const char* path, struct stat* buf) {
-    double start = MPI_Wtime();
+    uint64_t start = mfu_perf_start();
     int rc;
     int tries = MFU_IO_TRIES;
 retry:
@@ -309,8 +303,7 @@ retry:
             }
         }
     }
-    double end = MPI_Wtime();
-    md_record_timing(start, end);
+    mfu_perf_stop(MFU_PERF_STAT, start, 0);
     return rc;
 }
 
@@ -341,7 +334,7 @@ int daos_lstat(const char* path, struct stat* buf, mfu_file_t* mfu_file)
 }
 
 int mfu_lstat(const char* path, struct stat* buf) {
-    double start = MPI_Wtime();
+    uint64_t start = mfu_perf_start();
     int rc;
     int tries = MFU_IO_TRIES;
 retry:
@@ -357,8 +350,7 @@ retry:
             }
         }
     }
-    double end = MPI_Wtime();
-    md_record_timing(start, end);
+    mfu_perf_stop(MFU_PERF_STAT, start, 0);
     return rc;
 }
 
@@ -379,7 +371,7 @@ int mfu_file_lstat(const char* path, struct stat* buf, mfu_file_t* mfu_file)
 /* calls lstat64, and retries a few times if we get EIO or EINTR */
 int mfu_lstat64(const char* path, struct stat64* buf)
 {
-    double start = MPI_Wtime();
+    uint64_t start = mfu_perf_start();
     int rc;
     int tries = MFU_IO_TRIES;
 retry:
@@ -395,8 +387,7 @@ retry:
             }
         }
     }
-    double end = MPI_Wtime();
-    md_record_timing(start, end);
+    mfu_perf_stop(MFU_PERF_STAT, start, 0);
     return rc;
 }
 
@@ -413,7 +404,7 @@ int daos_mknod(const char* path, mode_t mode, mfu_file_t* mfu_file)
 
 int mfu_mknod(const char* path, mode_t mode, dev_t dev)
 {
-    double start = MPI_Wtime();
+    uint64_t start = mfu_perf_start();
     int rc;
     int tries = MFU_IO_TRIES;
 retry:
@@ -429,8 +420,7 @@ retry:
             }
         }
     }
-    double end = MPI_Wtime();
-    record_timing(start, end);
+    mfu_perf_stop(MFU_PERF_MKNOD, start, 0);
     return rc;
 }
 \
@@ -466,7 +456,7 @@ int mfu_file_remove(const char* path, mfu_file_t* mfu_file)
 
 int mfu_remove(const char* path)
 {
-    double start = MPI_Wtime();
+    uint64_t start = mfu_perf_start();
     int rc;
     int tries = MFU_IO_TRIES;
 retry:
@@ -482,8 +472,7 @@ retry:
             }
         }
     }
-    double end = MPI_Wtime();
-    record_timing(start, end);
+    mfu_perf_stop(MFU_PERF_UNLINK, start, 0);
     return rc;
 }
 
@@ -515,10 +504,9 @@ char* mfu_file_realpath(const char* path, char* resolved_path, mfu_file_t* mfu_f
 
 char* mfu_realpath(const char* path, char* resolved_path)
 {
-    double start = MPI_Wtime();
+    uint64_t start = mfu_perf_start();
     char* p = realpath(path, resolved_path);
-    double end = MPI_Wtime();
-    record_timing(start, end);
+    mfu_perf_stop(MFU_PERF_LINK, start, 0);
     return p;
 }
 
@@ -554,7 +542,7 @@ ssize_t daos_readlink(const char* path, char* buf, size_t bufsize, mfu_file_t* m
 
 ssize_t mfu_readlink(const char* path, char* buf, size_t bufsize)
 {
-    double start = MPI_Wtime();
+    uint64_t start = mfu_perf_start();
     ssize_t rc;
     int tries = MFU_IO_TRIES;
 retry:
@@ -570,8 +558,7 @@ retry:
             }
         }
     }
-    double end = MPI_Wtime();
-    record_timing(start, end);
+    mfu_perf_stop(MFU_PERF_LINK, start, 0);
     return rc;
 }
 
@@ -605,7 +592,7 @@ int daos_symlink(const char* oldpath, const char* newpath, mfu_file_t* mfu_file)
 
 int mfu_symlink(const char* oldpath, const char* newpath)
 {
-    double start = MPI_Wtime();
+    uint64_t start = mfu_perf_start();
     int rc;
     int tries = MFU_IO_TRIES;
 retry:
@@ -621,8 +608,7 @@ retry:
             }
         }
     }
-    double end = MPI_Wtime();
-    record_timing(start, end);
+    mfu_perf_stop(MFU_PERF_LINK, start, 0);
     return rc;
 }
 
@@ -646,7 +632,7 @@ int mfu_file_symlink(const char* oldpath, const char* newpath, mfu_file_t* mfu_f
 /* call hardlink, retry a few times on EINTR or EIO */
 int mfu_hardlink(const char* oldpath, const char* newpath)
 {
-    double start = MPI_Wtime();
+    uint64_t start = mfu_perf_start();
     int rc;
     int tries = MFU_IO_TRIES;
 retry:
@@ -662,8 +648,7 @@ retry:
             }
         }
     }
-    double end = MPI_Wtime();
-    record_timing(start, end);
+    mfu_perf_stop(MFU_PERF_LINK, start, 0);
     return rc;
 }
 
@@ -685,7 +670,7 @@ int daos_open(const char* file, int flags, mode_t mode, mfu_file_t* mfu_file)
 
 int mfu_open(const char* file, int flags, ...)
 {
-    double start = MPI_Wtime();
+    uint64_t start = mfu_perf_start();
     /* extract the mode (see man 2 open) */
     int mode_set = 0;
     mode_t mode = 0;
@@ -731,8 +716,7 @@ int mfu_open(const char* file, int flags, ...)
              /* we could abort, but probably don't want to here */
          }
     }
-    double end = MPI_Wtime();
-    record_timing(start, end);
+    mfu_perf_stop(MFU_PERF_OPEN, start, 0);
     return fd;
 }
 
@@ -792,7 +776,7 @@ int daos_close(const char* file, mfu_file_t* mfu_file)
 
 int mfu_close(const char* file, int fd)
 {
-    double start = MPI_Wtime();
+    uint64_t start = mfu_perf_start();
     int tries = MFU_IO_TRIES;
 retry:
     errno = 0;
@@ -807,8 +791,7 @@ retry:
             }
         }
     }
-    double end = MPI_Wtime();
-    record_timing(start, end);
+    mfu_perf_stop(MFU_PERF_CLOSE, start, 0);
     return rc;
 }
 
@@ -847,7 +830,7 @@ int daos_lseek(const char* file, mfu_file_t* mfu_file, off_t pos, int whence)
 
 off_t mfu_lseek(const char* file, int fd, off_t pos, int whence)
 {
-    double start = MPI_Wtime();
+    uint64_t start = mfu_perf_start();
     int tries = MFU_IO_TRIES;
 retry:
     errno = 0;
@@ -862,8 +845,7 @@ retry:
             }
         }
     }
-    double end = MPI_Wtime();
-    record_timing(start, end);
+    mfu_perf_stop(MFU_PERF_OTHER, start, 0);
     return rc;
 }
 
@@ -917,7 +899,7 @@ ssize_t daos_read(const char* file, void* buf, size_t size, mfu_file_t* mfu_file
 
 ssize_t mfu_read(const char* file, int fd, void* buf, size_t size)
 {
-    double start = MPI_Wtime();
+    uint64_t start = mfu_perf_start();
     int tries = MFU_IO_TRIES;
     ssize_t n = 0;
     while ((size_t)n < size) {
@@ -929,14 +911,12 @@ ssize_t mfu_read(const char* file, int fd, void* buf, size_t size)
             tries = MFU_IO_TRIES;
 
             /* return, even if we got a short read */
-            double end = MPI_Wtime();
-            record_timing(start, end);
+            mfu_perf_stop(MFU_PERF_READ, start, (uint64_t) n);
             return n;
         }
         else if (rc == 0) {
             /* EOF */
-            double end = MPI_Wtime();
-            record_timing(start, end);
+            mfu_perf_stop(MFU_PERF_READ, start, (uint64_t) n);
             return n;
         }
         else {   /* (rc < 0) */
@@ -953,8 +933,7 @@ ssize_t mfu_read(const char* file, int fd, void* buf, size_t size)
             usleep(MFU_IO_USLEEP);
         }
     }
-    double end = MPI_Wtime();
-    record_timing(start, end);
+    mfu_perf_stop(MFU_PERF_READ, start, (uint64_t) n);
     return n;
 }
 
@@ -976,7 +955,7 @@ ssize_t mfu_file_write(const char* file, const void* buf, size_t size, mfu_file_
 
 ssize_t mfu_write(const char* file, int fd, const void* buf, size_t size)
 {
-    double start = MPI_Wtime();
+    uint64_t start = mfu_perf_start();
     int tries = MFU_IO_TRIES;
     ssize_t n = 0;
     while ((size_t)n < size) {
@@ -1007,8 +986,7 @@ ssize_t mfu_write(const char* file, int fd, const void* buf, size_t size)
             usleep(MFU_IO_USLEEP);
         }
     }
-    double end = MPI_Wtime();
-    record_timing(start, end);
+    mfu_perf_stop(MFU_PERF_WRITE, start, (uint64_t) n);
     return n;
 }
 
@@ -1064,21 +1042,18 @@ ssize_t daos_pread(const char* file, void* buf, size_t size, off_t offset, mfu_f
 
 ssize_t mfu_pread(const char* file, int fd, void* buf, size_t size, off_t offset)
 {
-    double start = MPI_Wtime();
+    uint64_t start = mfu_perf_start();
     int tries = MFU_IO_TRIES;
     while (1) {
         ssize_t rc = pread(fd, (char*) buf, size, offset);
         if (rc > 0) {
             /* read some data */
-            double end = MPI_Wtime();
-            pread_record_timing(start, end);
+            mfu_perf_stop(MFU_PERF_PREAD, start, (uint64_t) rc);
             return rc;
         }
         else if (rc == 0) {
             /* EOF */
-            double end = MPI_Wtime();
-            record_timing(start, end);
-            pread_record_timing(start, end);
+            mfu_perf_stop(MFU_PERF_PREAD, start, (uint64_t) rc);
             return rc;
         }
         else {   /* (rc < 0) */
@@ -1114,20 +1089,18 @@ ssize_t mfu_file_pwrite(const char* file, const void* buf, size_t size, off_t of
 
 ssize_t mfu_pwrite(const char* file, int fd, const void* buf, size_t size, off_t offset)
 {
-    double start = MPI_Wtime();
+    uint64_t start = mfu_perf_start();
     int tries = MFU_IO_TRIES;
     while (1) {
         ssize_t rc = pwrite(fd, (const char*) buf, size, offset);
         if (rc > 0) {
             /* wrote some data */
-            double end = MPI_Wtime();
-            record_timing(start, end);
+            mfu_perf_stop(MFU_PERF_PWRITE, start, (uint64_t) rc);
             return rc;
         }
         else if (rc == 0) {
             /* didn't write anything, but not an error either */
-            double end = MPI_Wtime();
-            record_timing(start, end);
+            mfu_perf_stop(MFU_PERF_PWRITE, start, (uint64_t) rc);
             return rc;
         }
         else { /* (rc < 0) */
@@ -1179,7 +1152,7 @@ int mfu_file_truncate(const char* file, off_t length, mfu_file_t* mfu_file)
 
 int mfu_truncate(const char* file, off_t length)
 {
-    double start = MPI_Wtime();
+    uint64_t start = mfu_perf_start();
     int rc;
     int tries = MFU_IO_TRIES;
 retry:
@@ -1195,8 +1168,7 @@ retry:
             }
         }
     }
-    double end = MPI_Wtime();
-    record_timing(start, end);
+    mfu_perf_stop(MFU_PERF_SETATTR, start, 0);
     return rc;
 }
 
@@ -1224,7 +1196,7 @@ int daos_ftruncate(mfu_file_t* mfu_file, off_t length)
 
 int mfu_ftruncate(int fd, off_t length)
 {
-    double start = MPI_Wtime();
+    uint64_t start = mfu_perf_start();
     int rc;
     int tries = MFU_IO_TRIES;
 retry:
@@ -1240,8 +1212,7 @@ retry:
             }
         }
     }
-    double end = MPI_Wtime();
-    record_timing(start, end);
+    mfu_perf_stop(MFU_PERF_SETATTR, start, 0);
     return rc;
 }
 
@@ -1287,7 +1258,7 @@ int daos_unlink(const char* file, mfu_file_t* mfu_file)
 
 int mfu_unlink(const char* file)
 {
-    double start = MPI_Wtime();
+    uint64_t start = mfu_perf_start();
     int rc;
     int tries = MFU_IO_TRIES;
 retry:
@@ -1303,8 +1274,7 @@ retry:
             }
         }
     }
-    double end = MPI_Wtime();
-    record_timing(start, end);
+    mfu_perf_stop(MFU_PERF_UNLINK, start, 0);
     return rc;
 }
 
@@ -1312,7 +1282,7 @@ retry:
 /* force flush of written data */
 int mfu_fsync(const char* file, int fd)
 {
-    double start = MPI_Wtime();
+    uint64_t start = mfu_perf_start();
     int rc;
     int tries = MFU_IO_TRIES;
 retry:
@@ -1328,8 +1298,7 @@ retry:
             }
         }
     }
-    double end = MPI_Wtime();
-    record_timing(start, end);
+    mfu_perf_stop(MFU_PERF_FSYNC, start, 0);
     return rc;
 }
 
@@ -1340,7 +1309,7 @@ retry:
 /* get current working directory, abort if fail or buffer too small */
 void mfu_getcwd(char* buf, size_t size)
 {
-    double start = MPI_Wtime();
+    uint64_t start = mfu_perf_start();
     errno = 0;
     char* p = getcwd(buf, size);
     if (p == NULL) {
@@ -1348,8 +1317,7 @@ void mfu_getcwd(char* buf, size_t size)
                     errno, strerror(errno)
                    );
     }
-    double end = MPI_Wtime();
-    record_timing(start, end);
+    mfu_perf_stop(MFU_PERF_OTHER, start, 0);
 }
 
 
@@ -1366,7 +1334,7 @@ int daos_mkdir(const char* dir, mode_t mode, mfu_file_t* mfu_file)
 
 int mfu_mkdir(const char* dir, mode_t mode)
 {
-    double start = MPI_Wtime();
+    uint64_t start = mfu_perf_start();
     int rc;
     int tries = MFU_IO_TRIES;
 retry:
@@ -1382,8 +1350,7 @@ retry:
             }
         }
     }
-    double end = MPI_Wtime();
-    record_timing(start, end);
+    mfu_perf_stop(MFU_PERF_MKDIR, start, 0);
     return rc;
 }
 
@@ -1419,7 +1386,7 @@ int mfu_file_rmdir(const char* dir, mfu_file_t* mfu_file)
 
 int mfu_rmdir(const char* dir)
 {
-    double start = MPI_Wtime();
+    uint64_t start = mfu_perf_start();
     int rc;
     int tries = MFU_IO_TRIES;
 retry:
@@ -1435,8 +1402,7 @@ retry:
             }
         }
     }
-    double end = MPI_Wtime();
-    record_timing(start, end);
+    mfu_perf_stop(MFU_PERF_UNLINK, start, 0);
     return rc;
 }
 
@@ -1470,7 +1436,7 @@ DIR* daos_opendir(const char* dir, mfu_file_t* mfu_file)
 
 DIR* mfu_opendir(const char* dir)
 {
-    double start = MPI_Wtime();
+    uint64_t start = mfu_perf_start();
     DIR* dirp;
     int tries = MFU_IO_TRIES;
 retry:
@@ -1486,8 +1452,7 @@ retry:
             }
         }
     }
-    double end = MPI_Wtime();
-    md_record_timing(start, end);
+    mfu_perf_stop(MFU_PERF_OPEN, start, 0);
     return dirp;
 }
 
@@ -1519,7 +1484,7 @@ int daos_closedir(DIR* dirp, mfu_file_t* mfu_file)
 
 int mfu_closedir(DIR* dirp)
 {
-    double start = MPI_Wtime();
+    uint64_t start = mfu_perf_start();
     int rc;
     int tries = MFU_IO_TRIES;
 retry:
@@ -1535,8 +1500,7 @@ retry:
             }
         }
     }
-    double end = MPI_Wtime();
-    record_timing(start, end);
+    mfu_perf_stop(MFU_PERF_CLOSE, start, 0);
     return rc;
 }
 
@@ -1574,7 +1538,7 @@ struct dirent* daos_readdir(DIR* dirp, mfu_file_t* mfu_file)
 
 struct dirent* mfu_readdir(DIR* dirp)
 {
-    double start = MPI_Wtime();
+    uint64_t start = mfu_perf_start();
     /* read next directory entry, retry a few times */
     struct dirent* entry;
     int tries = MFU_IO_TRIES;
@@ -1591,8 +1555,7 @@ retry:
             }
         }
     }
-    double end = MPI_Wtime();
-    record_timing(start, end);
+    mfu_perf_stop(MFU_PERF_READDIR, start, 0);
     return entry;
 }
 
@@ -1628,10 +1591,9 @@ ssize_t mfu_file_llistxattr(const char* path, char* list, size_t size, mfu_file_
 
 ssize_t mfu_llistxattr(const char* path, char* list, size_t size)
 {
-    double start = MPI_Wtime();
+    uint64_t start = mfu_perf_start();
     ssize_t rc = llistxattr(path, list, size);
-    double end = MPI_Wtime();
-    md_record_timing(start, end);
+    mfu_perf_stop(MFU_PERF_XATTR, start, 0);
     return rc;
 }
 
@@ -1667,10 +1629,9 @@ ssize_t mfu_file_listxattr(const char* path, char* list, size_t size, mfu_file_t
 
 ssize_t mfu_listxattr(const char* path, char* list, size_t size)
 {
-    double start = MPI_Wtime();
+    uint64_t start = mfu_perf_start();
     ssize_t rc = listxattr(path, list, size);
-    double end = MPI_Wtime();
-    md_record_timing(start, end);
+    mfu_perf_stop(MFU_PERF_XATTR, start, 0);
     return rc;
 }
 
@@ -1706,10 +1667,9 @@ ssize_t mfu_file_lgetxattr(const char* path, const char* name, void* value, size
 
 ssize_t mfu_lgetxattr(const char* path, const char* name, void* value, size_t size)
 {
-    double start = MPI_Wtime();
+    uint64_t start = mfu_perf_start();
     ssize_t rc = lgetxattr(path, name, value, size);
-    double end = MPI_Wtime();
-    md_record_timing(start, end);
+    mfu_perf_stop(MFU_PERF_XATTR, start, 0);
     return rc;
 }
 
@@ -1745,10 +1705,9 @@ ssize_t mfu_file_getxattr(const char* path, const char* name, void* value, size_
 
 ssize_t mfu_getxattr(const char* path, const char* name, void* value, size_t size)
 {
-    double start = MPI_Wtime();
+    uint64_t start = mfu_perf_start();
     ssize_t rc = getxattr(path, name, value, size);
-    double end = MPI_Wtime();
-    md_record_timing(start, end);
+    mfu_perf_stop(MFU_PERF_XATTR, start, 0);
     return rc;
 }
 
@@ -1785,10 +1744,9 @@ int mfu_file_lsetxattr(const char* path, const char* name, const void* value, si
 
 int mfu_lsetxattr(const char* path, const char* name, const void* value, size_t size, int flags)
 {
-    double start = MPI_Wtime();
+    uint64_t start = mfu_perf_start();
     int rc = lsetxattr(path, name, value, size, flags);
-    double end = MPI_Wtime();
-    md_record_timing(start, end);
+    mfu_perf_stop(MFU_PERF_XATTR, start, 0);
     return rc;
 }
 
@@ -0,0 +1,652 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <ctype.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/xattr.h>
+
+#include "mfu.h"
+#include "strmap.h"
+
+#if defined(LUSTRE_SUPPORT) && defined(HAVE_LLAPI_LAYOUT)
+#include <lustre/lustreapi.h>
+#include <lustre/lustre_user.h>
+#define MFU_LAYOUT_LUSTRE_SUPPORT 1
+#endif
+
+/* name of extended attribute read by the xattr provider */
+#define MFU_LAYOUT_XATTR_NAME "user.mfu.layout"
+
+/* default number of threads used to query layouts */
+#define MFU_LAYOUT_THREADS (8)
+
+/* smallest stripe size Lustre allows, a file no larger than this
+ * lies entirely in its first stripe */
+#define MFU_LAYOUT_LUSTRE_MIN_SIZE (64 * 1024)
+
+typedef enum {
+    MFU_LAYOUT_PLAIN,  /* each file is a single object */
+    MFU_LAYOUT_LUSTRE, /* query Lustre with llapi */
+    MFU_LAYOUT_MOCK,   /* layouts read from a description file */
+    MFU_LAYOUT_XATTR,  /* layouts read from an extended attribute */
+} mfu_layout_type;
+
+struct mfu_layout_provider_struct {
+    mfu_layout_type type; /* which provider this is */
+    strmap* mock;         /* maps path to its component lines for MFU_LAYOUT_MOCK */
+    int threads;          /* number of threads mfu_layout_get_list uses to query layouts */
+    uint64_t min_size;    /* files smaller than this are not queried */
+};
+
+/* allocate space for count components in layout */
+static void mfu_layout_alloc(mfu_layout* layout, int count)
+{
+    layout->count = count;
+    layout->comps = NULL;
+    if (count > 0) {
+        layout->comps = (mfu_layout_comp*) MFU_MALLOC((size_t)count * sizeof(mfu_layout_comp));
+    }
+
+    int i;
+    for (i = 0; i < count; i++) {
+        layout->comps[i].start        = 0;
+        layout->comps[i].end          = MFU_LAYOUT_EOF;
+        layout->comps[i].stripe_size  = 0;
+        layout->comps[i].stripe_count = 0;
+        layout->comps[i].osts         = NULL;
+    }
+}
+
+/* describe a file as a single object of unknown location */
+static void mfu_layout_get_plain(uint64_t file_size, mfu_layout* layout)
+{
+    mfu_layout_alloc(layout, 1);
+
+    mfu_layout_comp* comp = &layout->comps[0];
+    comp->start        = 0;
+    comp->end          = MFU_LAYOUT_EOF;
+    comp->stripe_size  = (file_size > 0) ? file_size : 1;
+    comp->stripe_count = 1;
+    comp->osts         = (uint64_t*) MFU_MALLOC(sizeof(uint64_t));
+    comp->osts[0]      = MFU_LAYOUT_OST_NONE;
+}
+
+/* parse an unsigned value from str, the end offset
+ * of a component may be given as EOF,
+ * returns 0 on success and -1 on error */
+static int mfu_layout_parse_u64(const char* str, int allow_eof, uint64_t* val)
+{
+    if (allow_eof && strcmp(str, "EOF") == 0) {
+        *val = MFU_LAYOUT_EOF;
+        return 0;
+    }
+
+    char* end = NULL;
+    errno = 0;
+    unsigned long long v = strtoull(str, &end, 10);
+    if (errno != 0 || end == str || *end != '\0') {
+        return -1;
+    }
+
+    *val = (uint64_t) v;
+    return 0;
+}
+
+/* parse "<start> <end> <stripe_size> <ost>[,<ost>...]" into comp,
+ * returns 0 on success and -1 on error */
+static int mfu_layout_parse_comp(const char* line, mfu_layout_comp* comp)
+{
+    char start_str[64], end_str[64], size_str[64];
+    char osts_str[4096];
+    if (sscanf(line, "%63s %63s %63s %4095s", start_str, end_str, size_str, osts_str) != 4) {
+        return -1;
+    }
+
+    if (mfu_layout_parse_u64(start_str, 0, &comp->start) != 0 ||
+        mfu_layout_parse_u64(end_str,   1, &comp->end)   != 0 ||
+        mfu_layout_parse_u64(size_str,  0, &comp->stripe_size) != 0)
+    {
+        return -1;
+    }
+    if (comp->stripe_size == 0 || comp->end <= comp->start) {
+        return -1;
+    }
+
+    /* count stripes in comma-separated list */
+    uint64_t count = 1;
+    const char* c;
+    for (c = osts_str; *c != '\0'; c++) {
+        if (*c == ',') {
+            count++;
+        }
+    }
+
+    comp->stripe_count = count;
+    comp->osts = (uint64_t*) MFU_MALLOC(count * sizeof(uint64_t));
+
+    uint64_t i = 0;
+    char* saveptr = NULL;
+    char* tok = strtok_r(osts_str, ",", &saveptr);
+    while (tok != NULL && i < count) {
+        if (mfu_layout_parse_u64(tok, 0, &comp->osts[i]) != 0) {
+            mfu_free(&comp->osts);
+            return -1;
+        }
+        i++;
+        tok = strtok_r(NULL, ",", &saveptr);
+    }
+    if (i != count) {
+        mfu_free(&comp->osts);
+        return -1;
+    }
+
+    return 0;
+}
+
+/* returns 1 if line holds nothing but white space or a comment */
+static int mfu_layout_line_empty(const char* line)
+{
+    while (isspace((unsigned char) *line)) {
+        line++;
+    }
+    return (*line == '\0' || *line == '#');
+}
+
+/* parse components separated by newlines or semicolons into layout,
+ * returns 0 on success and -1 on error */
+static int mfu_layout_parse(const char* path, const char* text, mfu_layout* layout)
+{
+    /* work on a copy, since we split the string in place */
+    char* copy = MFU_STRDUP(text);
+
+    /* count lines as an upper bound on the number of components */
+    int count = 1;
+    char* c;
+    for (c = copy; *c != '\0'; c++) {
+        if (*c == '\n' || *c == ';') {
+            count++;
+        }
+    }
+    mfu_layout_alloc(layout, count);
+
+    int rc = 0;
+    int n = 0;
+    char* saveptr = NULL;
+    char* line = strtok_r(copy, "\n;", &saveptr);
+    while (line != NULL) {
+        if (! mfu_layout_line_empty(line)) {
+            if (mfu_layout_parse_comp(line, &layout->comps[n]) != 0) {
+                MFU_LOG(MFU_LOG_ERR, "Invalid layout component for `%s': `%s'", path, line);
+                rc = -1;
+                break;
+            }
+            n++;
+        }
+        line = strtok_r(NULL, "\n;", &saveptr);
+    }
+    layout->count = n;
+
+    if (rc == 0 && n == 0) {
+        MFU_LOG(MFU_LOG_ERR, "Empty layout for `%s'", path);
+        rc = -1;
+    }
+
+    if (rc != 0) {
+        mfu_layout_free(layout);
+    }
+
+    mfu_free(&copy);
+    return rc;
+}
+
+/* read a layout description file into a map from path to its component
+ * lines, returns 0 on success and -1 on error */
+static int mfu_layout_mock_read(const char* file, strmap* map)
+{
+    FILE* fp = fopen(file, "r");
+    if (fp == NULL) {
+        MFU_LOG(MFU_LOG_ERR, "Failed to open layout file `%s' (errno=%d %s)",
+            file, errno, strerror(errno));
+        return -1;
+    }
+
+    int rc = 0;
+    char line[8192];
+    int lineno = 0;
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        lineno++;
+
+        /* strip trailing newline */
+        size_t len = strlen(line);
+        if (len > 0 && line[len - 1] == '\n') {
+            line[len - 1] = '\0';
+        }
+
+        if (mfu_layout_line_empty(line)) {
+            continue;
+        }
+
+        /* split path from component */
+        char* p = line;
+        while (isspace((unsigned char) *p)) {
+            p++;
+        }
+        char* path = p;
+        while (*p != '\0' && ! isspace((unsigned char) *p)) {
+            p++;
+        }
+        if (*p == '\0') {
+            MFU_LOG(MFU_LOG_ERR, "Invalid entry in layout file `%s' line %d", file, lineno);
+            rc = -1;
+            break;
+        }
+        *p = '\0';
+        const char* comp = p + 1;
+
+        /* append component to any we already have for this path */
+        const char* prev = strmap_get(map, path);
+        if (prev == NULL) {
+            strmap_set(map, path, comp);
+        } else {
+            char* joined = MFU_STRDUPF("%s\n%s", prev, comp);
+            strmap_set(map, path, joined);
+            mfu_free(&joined);
+        }
+    }
+
+    fclose(fp);
+    return rc;
+}
+
+/* read layout from the extended attribute of a file,
+ * returns 0 on success and -1 on error */
+static int mfu_layout_get_xattr(const char* path, mfu_layout* layout)
+{
+    ssize_t size = getxattr(path, MFU_LAYOUT_XATTR_NAME, NULL, 0);
+    if (size < 0) {
+        MFU_LOG(MFU_LOG_ERR, "Failed to read %s of `%s' (errno=%d %s)",
+            MFU_LAYOUT_XATTR_NAME, path, errno, strerror(errno));
+        return -1;
+    }
+
+    char* value = (char*) MFU_MALLOC((size_t)size + 1);
+    size = getxattr(path, MFU_LAYOUT_XATTR_NAME, value, (size_t)size);
+    if (size < 0) {
+        MFU_LOG(MFU_LOG_ERR, "Failed to read %s of `%s' (errno=%d %s)",
+            MFU_LAYOUT_XATTR_NAME, path, errno, strerror(errno));
+        mfu_free(&value);
+        return -1;
+    }
+    value[size] = '\0';
+
+    int rc = mfu_layout_parse(path, value, layout);
+    mfu_free(&value);
+    return rc;
+}
+
+#ifdef MFU_LAYOUT_LUSTRE_SUPPORT
+/* query layout of a Lustre file, skipping components
+ * that have not been instantiated,
+ * returns 0 on success and -1 on error */
+static int mfu_layout_get_lustre(const char* path, uint64_t file_size, mfu_layout* layout)
+{
+    struct llapi_layout* ll = llapi_layout_get_by_path(path, 0);
+    if (ll == NULL) {
+        MFU_LOG(MFU_LOG_ERR, "Failed to get layout of `%s' (errno=%d %s)",
+            path, errno, strerror(errno));
+        return -1;
+    }
+
+    /* count components so we can allocate space for them */
+    int count = 0;
+    int rc = llapi_layout_comp_use(ll, LLAPI_LAYOUT_COMP_USE_FIRST);
+    while (rc == 0) {
+        count++;
+        rc = llapi_layout_comp_use(ll, LLAPI_LAYOUT_COMP_USE_NEXT);
+    }
+    if (rc < 0) {
+        MFU_LOG(MFU_LOG_ERR, "Failed to iterate layout components of `%s' (errno=%d %s)",
+            path, errno, strerror(errno));
+        llapi_layout_free(ll);
+        return -1;
+    }
+    mfu_layout_alloc(layout, count);
+
+    int n = 0;
+    rc = llapi_layout_comp_use(ll, LLAPI_LAYOUT_COMP_USE_FIRST);
+    while (rc == 0 && n < count) {
+        uint64_t start, end, stripe_count, stripe_size;
+        if (llapi_layout_comp_extent_get(ll, &start, &end) != 0 ||
+            llapi_layout_stripe_count_get(ll, &stripe_count) != 0 ||
+            llapi_layout_stripe_size_get(ll, &stripe_size) != 0)
+        {
+            MFU_LOG(MFU_LOG_ERR, "Failed to get stripe information of `%s' (errno=%d %s)",
+                path, errno, strerror(errno));
+            layout->count = n;
+            mfu_layout_free(layout);
+            llapi_layout_free(ll);
+            return -1;
+        }
+
+        /* components beyond the end of the file may not be instantiated */
+        if (start >= file_size && n > 0) {
+            break;
+        }
+
+        /* a component that is not instantiated reports values like
+         * LLAPI_LAYOUT_DEFAULT or LLAPI_LAYOUT_WIDE rather than a count */
+        if (stripe_count == 0 || stripe_count > LOV_MAX_STRIPE_COUNT || stripe_size == 0) {
+            if (n > 0) {
+                break;
+            }
+            MFU_LOG(MFU_LOG_DBG, "Layout of `%s' is not instantiated, stripe count %llu",
+                path, (unsigned long long) stripe_count);
+            mfu_layout_free(layout);
+            llapi_layout_free(ll);
+            return -1;
+        }
+
+        /* get object index of each stripe */
+        uint64_t* osts = (uint64_t*) MFU_MALLOC(stripe_count * sizeof(uint64_t));
+        uint64_t i;
+        for (i = 0; i < stripe_count; i++) {
+            if (llapi_layout_ost_index_get(ll, (int)i, &osts[i]) != 0) {
+                break;
+            }
+        }
+        if (i == 0) {
+            /* no objects allocated in this component */
+            mfu_free(&osts);
+            break;
+        }
+
+        mfu_layout_comp* comp = &layout->comps[n];
+        comp->start        = start;
+        comp->end          = end;
+        comp->stripe_size  = stripe_size;
+        comp->stripe_count = i;
+        comp->osts         = osts;
+        n++;
+
+        rc = llapi_layout_comp_use(ll, LLAPI_LAYOUT_COMP_USE_NEXT);
+    }
+    layout->count = n;
+
+    llapi_layout_free(ll);
+
+    /* a file without objects, e.g., an empty file with a
+     * layout that is not yet instantiated, is a single object */
+    if (n == 0) {
+        mfu_layout_free(layout);
+        mfu_layout_get_plain(file_size, layout);
+    }
+
+    return 0;
+}
+#endif /* MFU_LAYOUT_LUSTRE_SUPPORT */
+
+mfu_layout_provider* mfu_layout_provider_new_from_str(const char* spec)
+{
+    mfu_layout_provider* prov = (mfu_layout_provider*) MFU_MALLOC(sizeof(mfu_layout_provider));
+    prov->mock     = NULL;
+    prov->threads  = 1;
+    prov->min_size = 0;
+
+    if (strcmp(spec, "plain") == 0) {
+        prov->type = MFU_LAYOUT_PLAIN;
+    } else if (strcmp(spec, "lustre") == 0) {
+#ifdef MFU_LAYOUT_LUSTRE_SUPPORT
+        prov->type     = MFU_LAYOUT_LUSTRE;
+        prov->threads  = MFU_LAYOUT_THREADS;
+        prov->min_size = MFU_LAYOUT_LUSTRE_MIN_SIZE;
+#else
+        MFU_LOG(MFU_LOG_ERR, "Lustre layout provider requires Lustre support");
+        mfu_free(&prov);
+        return NULL;
+#endif
+    } else if (strncmp(spec, "mock:", 5) == 0) {
+        prov->type = MFU_LAYOUT_MOCK;
+        prov->mock = strmap_new();
+        if (mfu_layout_mock_read(spec + 5, prov->mock) != 0) {
+            mfu_layout_provider_free(&prov);
+            return NULL;
+        }
+    } else if (strcmp(spec, "xattr") == 0) {
+        prov->type    = MFU_LAYOUT_XATTR;
+        prov->threads = MFU_LAYOUT_THREADS;
+    } else {
+        MFU_LOG(MFU_LOG_ERR, "Unknown layout provider `%s'", spec);
+        mfu_free(&prov);
+        return NULL;
+    }
+
+    return prov;
+}
+
+mfu_layout_provider* mfu_layout_provider_new(void)
+{
+    mfu_layout_provider* prov;
+
+    /* allow override of provider via environment variable */
+    char varname[] = "MFU_LAYOUT";
+    const char* value = getenv(varname);
+    if (value != NULL) {
+        if (mfu_rank == 0) {
+            MFU_LOG(MFU_LOG_INFO, "%s: %s", varname, value);
+        }
+        prov = mfu_layout_provider_new_from_str(value);
+    } else {
+#ifdef MFU_LAYOUT_LUSTRE_SUPPORT
+        prov = mfu_layout_provider_new_from_str("lustre");
+#else
+        prov = mfu_layout_provider_new_from_str("plain");
+#endif
+    }
+    if (prov == NULL) {
+        return NULL;
+    }
+
+    /* allow override of number of query threads */
+    char threads_name[] = "MFU_LAYOUT_THREADS";
+    value = getenv(threads_name);
+    if (value != NULL) {
+        int threads = atoi(value);
+        if (threads > 0) {
+            prov->threads = threads;
+            if (mfu_rank == 0) {
+                MFU_LOG(MFU_LOG_INFO, "%s: %d", threads_name, threads);
+            }
+        } else if (mfu_rank == 0) {
+            MFU_LOG(MFU_LOG_WARN, "Ignoring invalid %s: `%s'", threads_name, value);
+        }
+    }
+
+    /* allow override of size below which files are not queried */
+    char size_name[] = "MFU_LAYOUT_MIN_SIZE";
+    value = getenv(size_name);
+    if (value != NULL) {
+        unsigned long long bytes;
+        if (mfu_abtoull(value, &bytes) == MFU_SUCCESS) {
+            prov->min_size = (uint64_t) bytes;
+            if (mfu_rank == 0) {
+                MFU_LOG(MFU_LOG_INFO, "%s: %llu", size_name, bytes);
+            }
+        } else if (mfu_rank == 0) {
+            MFU_LOG(MFU_LOG_WARN, "Ignoring invalid %s: `%s'", size_name, value);
+        }
+    }
+
+    return prov;
+}
+
+void mfu_layout_provider_free(mfu_layout_provider** pprov)
+{
+    if (pprov != NULL && *pprov != NULL) {
+        mfu_layout_provider* prov = *pprov;
+        if (prov->mock != NULL) {
+            strmap_delete(&prov->mock);
+        }
+        mfu_free(pprov);
+    }
+}
+
+const char* mfu_layout_provider_name(const mfu_layout_provider* prov)
+{
+    switch (prov->type) {
+    case MFU_LAYOUT_LUSTRE:
+        return "lustre";
+    case MFU_LAYOUT_MOCK:
+        return "mock";
+    case MFU_LAYOUT_XATTR:
+        return "xattr";
+    case MFU_LAYOUT_PLAIN:
+    default:
+        return "plain";
+    }
+}
+
+int mfu_layout_get(
+    mfu_layout_provider* prov,
+    const char* path,
+    uint64_t file_size,
+    mfu_layout* layout)
+{
+    layout->count = 0;
+    layout->comps = NULL;
+
+    switch (prov->type) {
+    case MFU_LAYOUT_PLAIN:
+        mfu_layout_get_plain(file_size, layout);
+        return 0;
+    case MFU_LAYOUT_LUSTRE:
+#ifdef MFU_LAYOUT_LUSTRE_SUPPORT
+        return mfu_layout_get_lustre(path, file_size, layout);
+#else
+        return -1;
+#endif
+    case MFU_LAYOUT_MOCK:
+        {
+            /* files missing from the description are single objects */
+            const char* text = strmap_get(prov->mock, path);
+            if (text == NULL) {
+                mfu_layout_get_plain(file_size, layout);
+                return 0;
+            }
+            return mfu_layout_parse(path, text, layout);
+        }
+    case MFU_LAYOUT_XATTR:
+        return mfu_layout_get_xattr(path, layout);
+    }
+
+    return -1;
+}
+
+void mfu_layout_free(mfu_layout* layout)
+{
+    int i;
+    for (i = 0; i < layout->count; i++) {
+        mfu_free(&layout->comps[i].osts);
+    }
+    mfu_free(&layout->comps);
+    layout->count = 0;
+}
+
+/* state shared by threads of mfu_layout_get_list */
+typedef struct {
+    mfu_layout_provider* prov;
+    uint64_t count;
+    const char** paths;
+    const uint64_t* sizes;
+    mfu_layout* layouts;
+    uint64_t next;    /* index of next file to query, updated atomically */
+    uint64_t queried; /* number of files queried, updated atomically */
+} mfu_layout_list_t;
+
+/* get the layout of one file in the list, fall back to a single
+ * object if the file is too small to query or the query fails */
+static void mfu_layout_list_get(mfu_layout_list_t* l, uint64_t idx)
+{
+    const char* path = l->paths[idx];
+    uint64_t size    = l->sizes[idx];
+    mfu_layout* layout = &l->layouts[idx];
+
+    /* a small file lies in its first stripe, so the only thing a
+     * query would tell us is which object that is */
+    if (size < l->prov->min_size || l->prov->type == MFU_LAYOUT_PLAIN) {
+        mfu_layout_get_plain(size, layout);
+        return;
+    }
+
+    uint64_t start = mfu_perf_start();
+    int rc = mfu_layout_get(l->prov, path, size, layout);
+    mfu_perf_stop(MFU_PERF_LAYOUT, start, 0);
+    __sync_fetch_and_add(&l->queried, 1);
+
+    if (rc != 0) {
+        mfu_layout_get_plain(size, layout);
+    }
+}
+
+/* take files from the list until none are left */
+static void* mfu_layout_list_main(void* arg)
+{
+    mfu_layout_list_t* l = (mfu_layout_list_t*) arg;
+    while (1) {
+        uint64_t idx = __sync_fetch_and_add(&l->next, 1);
+        if (idx >= l->count) {
+            break;
+        }
+        mfu_layout_list_get(l, idx);
+    }
+    return NULL;
+}
+
+uint64_t mfu_layout_get_list(
+    mfu_layout_provider* prov,
+    uint64_t count,
+    const char** paths,
+    const uint64_t* sizes,
+    mfu_layout* layouts)
+{
+    mfu_layout_list_t l;
+    l.prov    = prov;
+    l.count   = count;
+    l.paths   = paths;
+    l.sizes   = sizes;
+    l.layouts = layouts;
+    l.next    = 0;
+    l.queried = 0;
+
+    /* queries to the file system spend most of their time waiting,
+     * so several run at once, the calling thread is one of them */
+    int threads = prov->threads;
+    if ((uint64_t) threads > count) {
+        threads = (int) count;
+    }
+    pthread_t* tids = NULL;
+    int started = 0;
+    if (threads > 1) {
+        tids = (pthread_t*) MFU_MALLOC((size_t)threads * sizeof(pthread_t));
+        int i;
+        for (i = 0; i < threads - 1; i++) {
+            if (pthread_create(&tids[started], NULL, mfu_layout_list_main, &l) != 0) {
+                /* carry on with the threads we have */
+                break;
+            }
+            started++;
+        }
+    }
+
+    mfu_layout_list_main(&l);
+
+    int i;
+    for (i = 0; i < started; i++) {
+        pthread_join(tids[i], NULL);
+    }
+    mfu_free(&tids);
+
+    return l.queried;
+}
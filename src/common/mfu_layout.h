@@ -0,0 +1,123 @@
+/* Query how a file is striped across storage objects.
+ *
+ * The chunk scheduler uses the layout of each file to assign chunks
+ * to the processes that serve the object (e.g., Lustre OST) holding
+ * them.  The layout is obtained from a provider, which is selected
+ * with the MFU_LAYOUT environment variable:
+ *
+ *   MFU_LAYOUT=lustre       - query Lustre with llapi_layout_*
+ *   MFU_LAYOUT=plain        - treat each file as a single object
+ *   MFU_LAYOUT=mock:<file>  - read layouts from a description file
+ *   MFU_LAYOUT=xattr        - read layouts from the user.mfu.layout
+ *                             extended attribute of each file
+ *
+ * The default is lustre when built with Lustre support, and plain
+ * otherwise.  The mock and xattr providers describe each component
+ * of a layout with one line of text:
+ *
+ *   <path> <start> <end> <stripe_size> <ost>[,<ost>...]
+ *
+ * where end may be EOF to extend the component to the end of the
+ * file, and a file with several components has one line per component.
+ * In the xattr value the path field is omitted and components are
+ * separated by newlines or semicolons.  Blank lines and lines starting
+ * with '#' are ignored.  For example:
+ *
+ *   /scratch/a 0 1048576 1048576 3
+ *   /scratch/a 1048576 EOF 4194304 0,1,2,5
+ *
+ * mfu_layout_get_list gets the layouts of many files at once, running
+ * several queries concurrently.  It skips the query for files smaller
+ * than the smallest stripe size, since such a file is in its first
+ * stripe.  The number of threads and the size below which files are
+ * not queried may be set with MFU_LAYOUT_THREADS and MFU_LAYOUT_MIN_SIZE.
+ *
+ * The walk does not record layouts, so every file at or above that size
+ * is queried when chunks are planned, even if the list was just walked. */
+
+/* enable C++ codes to include this header directly */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef MFU_LAYOUT_H
+#define MFU_LAYOUT_H
+
+#include <stdint.h>
+
+/* end offset of a component that extends to the end of the file */
+#define MFU_LAYOUT_EOF (UINT64_MAX)
+
+/* object index used when a provider does not know which
+ * storage object holds the data */
+#define MFU_LAYOUT_OST_NONE (UINT64_MAX)
+
+/* OST indices at or above this are taken as MFU_LAYOUT_OST_NONE when
+ * planning chunks, Lustre stores an OST index in 16 bits, so this
+ * only discards bogus values that would otherwise size the maps of
+ * the chunk scheduler */
+#define MFU_LAYOUT_OST_MAX (65536)
+
+/* one component of a layout, covering bytes [start, end) */
+typedef struct {
+    uint64_t start;        /* first byte offset covered by this component */
+    uint64_t end;          /* offset after last byte, or MFU_LAYOUT_EOF */
+    uint64_t stripe_size;  /* bytes written to one object before moving to the next */
+    uint64_t stripe_count; /* number of objects in osts */
+    uint64_t* osts;        /* object index holding each stripe */
+} mfu_layout_comp;
+
+/* layout of a file as a list of components sorted by start offset */
+typedef struct {
+    int count;              /* number of components */
+    mfu_layout_comp* comps; /* array of components */
+} mfu_layout;
+
+/* (opaque) layout provider */
+typedef struct mfu_layout_provider_struct mfu_layout_provider;
+
+/* create provider named by MFU_LAYOUT, or the default provider if
+ * it is not set, returns NULL if the provider cannot be created */
+mfu_layout_provider* mfu_layout_provider_new(void);
+
+/* create provider from a string as accepted by MFU_LAYOUT,
+ * returns NULL if the string is not valid */
+mfu_layout_provider* mfu_layout_provider_new_from_str(const char* spec);
+
+/* free provider and set caller's pointer to NULL */
+void mfu_layout_provider_free(mfu_layout_provider** pprov);
+
+/* return name of provider, e.g., "lustre" */
+const char* mfu_layout_provider_name(const mfu_layout_provider* prov);
+
+/* get layout of the file at path with the given size,
+ * on success fills in layout and returns 0, the caller must free
+ * it with mfu_layout_free, returns -1 on error */
+int mfu_layout_get(
+    mfu_layout_provider* prov,
+    const char* path,
+    uint64_t file_size,
+    mfu_layout* layout
+);
+
+/* free memory allocated for components in layout */
+void mfu_layout_free(mfu_layout* layout);
+
+/* get layouts of count files with the given paths and sizes into the
+ * layouts array, a file whose layout is not queried or can't be
+ * obtained is described as a single object, the caller must free each
+ * layout with mfu_layout_free, returns the number of files queried */
+uint64_t mfu_layout_get_list(
+    mfu_layout_provider* prov,
+    uint64_t count,
+    const char** paths,
+    const uint64_t* sizes,
+    mfu_layout* layouts
+);
+
+#endif /* MFU_LAYOUT_H */
+
+/* enable C++ codes to include this header directly */
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
@@ -137,10 +137,17 @@ typedef struct {
     bool         direct;           /* whether to use O_DIRECT */
     bool         open_noatime;     /* whether to use O_NOATIME */
     bool         sparse;           /* whether to create sparse files */
+    bool         pipeline;         /* whether to overlap reads and writes using a helper thread */
+    bool         copy_offload;     /* whether to try reflink and copy_file_range before read/write */
+    int          io_threads;       /* number of I/O threads each process uses to copy data */
     size_t       chunk_size;       /* size to chunk files by */
+    uint64_t     coalesce_size;    /* limit on bytes in a chunk that combines stripes, 0 to disable */
+    bool         mirror_layout;    /* whether to stripe destination files like their source */
+    bool         steal;            /* whether ranks that run out of chunks take chunks from others */
     size_t       buf_size;         /* buffer size to read/write to file system */
     char*        block_buf1;       /* buffer to read / write data */
     char*        block_buf2;       /* another buffer to read / write data */
+    int          fd_cache_size;    /* number of open source/destination files to cache */
     int          grouplock_id;     /* Lustre grouplock ID */
     uint64_t     batch_files;      /* max batch size to copy files, 0 implies no limit */
 } mfu_copy_opts_t;
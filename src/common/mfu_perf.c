@@ -0,0 +1,281 @@
+/* Counters and latency histograms for file system calls,
+ * see mfu_perf.h for a description. */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "mpi.h"
+#include "mfu.h"
+#include "mfu_perf.h"
+
+/* counters for one operation type */
+typedef struct {
+    uint64_t count;                   /* number of calls */
+    uint64_t bytes;                   /* bytes transferred */
+    uint64_t time;                    /* total time in nsecs */
+    uint64_t max;                     /* longest call in nsecs */
+    uint64_t hist[MFU_PERF_BUCKETS];  /* calls by log2 of latency */
+} mfu_perf_counter;
+
+static mfu_perf_counter mfu_perf_counters[MFU_PERF_OPS];
+
+static const char* mfu_perf_names[MFU_PERF_OPS] = {
+    "open",
+    "close",
+    "read",
+    "pread",
+    "write",
+    "pwrite",
+    "stat",
+    "mkdir",
+    "mknod",
+    "unlink",
+    "readdir",
+    "link",
+    "setattr",
+    "xattr",
+    "fsync",
+    "layout",
+    "other",
+};
+
+/* fields of the record each process contributes per operation
+ * type to the reduction in mfu_perf_report, followed by the
+ * histogram buckets */
+enum {
+    MFU_PERF_REC_COUNT = 0, /* sum of calls */
+    MFU_PERF_REC_BYTES,     /* sum of bytes */
+    MFU_PERF_REC_TIME,      /* sum of time */
+    MFU_PERF_REC_MAX,       /* longest call on any process */
+    MFU_PERF_REC_MIN_TIME,  /* least total time on one process */
+    MFU_PERF_REC_MIN_RANK,  /* process with least total time */
+    MFU_PERF_REC_MAX_TIME,  /* most total time on one process */
+    MFU_PERF_REC_MAX_RANK,  /* process with most total time */
+    MFU_PERF_REC_HIST,      /* first histogram bucket */
+    MFU_PERF_REC_SIZE = MFU_PERF_REC_HIST + MFU_PERF_BUCKETS
+};
+
+int mfu_perf_bucket(uint64_t nsecs)
+{
+    if (nsecs == 0) {
+        return 0;
+    }
+    int bucket = 64 - __builtin_clzll(nsecs);
+    if (bucket >= MFU_PERF_BUCKETS) {
+        bucket = MFU_PERF_BUCKETS - 1;
+    }
+    return bucket;
+}
+
+void mfu_perf_add(mfu_perf_op op, uint64_t nsecs, uint64_t bytes)
+{
+    mfu_perf_counter* c = &mfu_perf_counters[op];
+    __sync_fetch_and_add(&c->count, 1);
+    __sync_fetch_and_add(&c->bytes, bytes);
+    __sync_fetch_and_add(&c->time, nsecs);
+    __sync_fetch_and_add(&c->hist[mfu_perf_bucket(nsecs)], 1);
+
+    /* raise the maximum unless another thread beat us to it */
+    uint64_t max = c->max;
+    while (nsecs > max) {
+        if (__sync_bool_compare_and_swap(&c->max, max, nsecs)) {
+            break;
+        }
+        max = c->max;
+    }
+}
+
+void mfu_perf_stop(mfu_perf_op op, uint64_t start, uint64_t bytes)
+{
+    uint64_t end = mfu_perf_start();
+    mfu_perf_add(op, end - start, bytes);
+}
+
+const char* mfu_perf_name(mfu_perf_op op)
+{
+    return mfu_perf_names[op];
+}
+
+void mfu_perf_reset(void)
+{
+    memset(mfu_perf_counters, 0, sizeof(mfu_perf_counters));
+}
+
+/* combine records of one operation type at a time,
+ * ties on min/max time go to the lower rank */
+static void mfu_perf_reduce_op(void* invec, void* inoutvec, int* len, MPI_Datatype* type)
+{
+    const uint64_t* a = (const uint64_t*) invec;
+    uint64_t* b = (uint64_t*) inoutvec;
+
+    int i;
+    for (i = 0; i < *len; i++) {
+        b[MFU_PERF_REC_COUNT] += a[MFU_PERF_REC_COUNT];
+        b[MFU_PERF_REC_BYTES] += a[MFU_PERF_REC_BYTES];
+        b[MFU_PERF_REC_TIME]  += a[MFU_PERF_REC_TIME];
+        if (a[MFU_PERF_REC_MAX] > b[MFU_PERF_REC_MAX]) {
+            b[MFU_PERF_REC_MAX] = a[MFU_PERF_REC_MAX];
+        }
+        if (a[MFU_PERF_REC_MIN_TIME] < b[MFU_PERF_REC_MIN_TIME] ||
+            (a[MFU_PERF_REC_MIN_TIME] == b[MFU_PERF_REC_MIN_TIME] &&
+             a[MFU_PERF_REC_MIN_RANK] < b[MFU_PERF_REC_MIN_RANK]))
+        {
+            b[MFU_PERF_REC_MIN_TIME] = a[MFU_PERF_REC_MIN_TIME];
+            b[MFU_PERF_REC_MIN_RANK] = a[MFU_PERF_REC_MIN_RANK];
+        }
+        if (a[MFU_PERF_REC_MAX_TIME] > b[MFU_PERF_REC_MAX_TIME] ||
+            (a[MFU_PERF_REC_MAX_TIME] == b[MFU_PERF_REC_MAX_TIME] &&
+             a[MFU_PERF_REC_MAX_RANK] < b[MFU_PERF_REC_MAX_RANK]))
+        {
+            b[MFU_PERF_REC_MAX_TIME] = a[MFU_PERF_REC_MAX_TIME];
+            b[MFU_PERF_REC_MAX_RANK] = a[MFU_PERF_REC_MAX_RANK];
+        }
+
+        int j;
+        for (j = 0; j < MFU_PERF_BUCKETS; j++) {
+            b[MFU_PERF_REC_HIST + j] += a[MFU_PERF_REC_HIST + j];
+        }
+
+        a += MFU_PERF_REC_SIZE;
+        b += MFU_PERF_REC_SIZE;
+    }
+}
+
+void mfu_perf_format_time(double nsecs, double* val, const char** units)
+{
+    if (nsecs >= 1.0e9) {
+        *val   = nsecs / 1.0e9;
+        *units = "s";
+    } else if (nsecs >= 1.0e6) {
+        *val   = nsecs / 1.0e6;
+        *units = "ms";
+    } else if (nsecs >= 1.0e3) {
+        *val   = nsecs / 1.0e3;
+        *units = "us";
+    } else {
+        *val   = nsecs;
+        *units = "ns";
+    }
+}
+
+double mfu_perf_percentile(const uint64_t* hist, uint64_t count, uint64_t max, double fraction)
+{
+    uint64_t target = (uint64_t) (fraction * (double) count + 0.5);
+    if (target == 0) {
+        target = 1;
+    }
+
+    /* find the bucket holding the target call */
+    uint64_t sum = 0;
+    int i;
+    for (i = 0; i < MFU_PERF_BUCKETS - 1; i++) {
+        sum += hist[i];
+        if (sum >= target) {
+            break;
+        }
+    }
+
+    double edge = (double) (1ULL << i);
+    return (edge < (double) max) ? edge : (double) max;
+}
+
+void mfu_perf_report(MPI_Comm comm)
+{
+    int rank, ranks;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &ranks);
+
+    /* pack our counters, we read them without a lock,
+     * so values may be slightly out of step if threads are
+     * still recording, which is fine for reporting */
+    uint64_t* recs = (uint64_t*) MFU_MALLOC(MFU_PERF_OPS * MFU_PERF_REC_SIZE * sizeof(uint64_t));
+    uint64_t* all  = (uint64_t*) MFU_MALLOC(MFU_PERF_OPS * MFU_PERF_REC_SIZE * sizeof(uint64_t));
+    int op;
+    for (op = 0; op < MFU_PERF_OPS; op++) {
+        const mfu_perf_counter* c = &mfu_perf_counters[op];
+        uint64_t* rec = recs + op * MFU_PERF_REC_SIZE;
+        rec[MFU_PERF_REC_COUNT]    = c->count;
+        rec[MFU_PERF_REC_BYTES]    = c->bytes;
+        rec[MFU_PERF_REC_TIME]     = c->time;
+        rec[MFU_PERF_REC_MAX]      = c->max;
+        rec[MFU_PERF_REC_MIN_TIME] = c->time;
+        rec[MFU_PERF_REC_MIN_RANK] = (uint64_t) rank;
+        rec[MFU_PERF_REC_MAX_TIME] = c->time;
+        rec[MFU_PERF_REC_MAX_RANK] = (uint64_t) rank;
+        memcpy(&rec[MFU_PERF_REC_HIST], c->hist, sizeof(c->hist));
+    }
+
+    /* reduce whole records so that the op never sees a record
+     * split across segments of a pipelined reduction */
+    MPI_Datatype rectype;
+    MPI_Type_contiguous(MFU_PERF_REC_SIZE, MPI_UINT64_T, &rectype);
+    MPI_Type_commit(&rectype);
+
+    MPI_Op reduce_op;
+    MPI_Op_create(mfu_perf_reduce_op, 1, &reduce_op);
+
+    MPI_Reduce(recs, all, MFU_PERF_OPS, rectype, reduce_op, 0, comm);
+
+    MPI_Op_free(&reduce_op);
+    MPI_Type_free(&rectype);
+
+    if (rank == 0) {
+        int header = 0;
+        for (op = 0; op < MFU_PERF_OPS; op++) {
+            const uint64_t* rec = all + op * MFU_PERF_REC_SIZE;
+            uint64_t count = rec[MFU_PERF_REC_COUNT];
+            if (count == 0) {
+                continue;
+            }
+
+            if (! header) {
+                MFU_LOG(MFU_LOG_INFO, "File system calls over %d ranks:", ranks);
+                header = 1;
+            }
+
+            const uint64_t* hist = &rec[MFU_PERF_REC_HIST];
+            uint64_t max = rec[MFU_PERF_REC_MAX];
+
+            double mean_val, p50_val, p90_val, p99_val, max_val;
+            const char *mean_units, *p50_units, *p90_units, *p99_units, *max_units;
+            double mean = (double) rec[MFU_PERF_REC_TIME] / (double) count;
+            mfu_perf_format_time(mean, &mean_val, &mean_units);
+            mfu_perf_format_time(mfu_perf_percentile(hist, count, max, 0.50), &p50_val, &p50_units);
+            mfu_perf_format_time(mfu_perf_percentile(hist, count, max, 0.90), &p90_val, &p90_units);
+            mfu_perf_format_time(mfu_perf_percentile(hist, count, max, 0.99), &p99_val, &p99_units);
+            mfu_perf_format_time((double) max, &max_val, &max_units);
+
+            double bytes_val;
+            const char* bytes_units;
+            mfu_format_bytes(rec[MFU_PERF_REC_BYTES], &bytes_val, &bytes_units);
+
+            MFU_LOG(MFU_LOG_INFO, "  %-8s %llu calls, %.3lf %s, latency mean %.3lf %s, "
+                "p50 %.3lf %s, p90 %.3lf %s, p99 %.3lf %s, max %.3lf %s",
+                mfu_perf_names[op], (unsigned long long) count, bytes_val, bytes_units,
+                mean_val, mean_units, p50_val, p50_units, p90_val, p90_units,
+                p99_val, p99_units, max_val, max_units
+            );
+
+            /* the spread of total time per rank points at stragglers */
+            double rank_min_val, rank_mean_val, rank_max_val;
+            const char *rank_min_units, *rank_mean_units, *rank_max_units;
+            double rank_mean = (double) rec[MFU_PERF_REC_TIME] / (double) ranks;
+            double rank_max  = (double) rec[MFU_PERF_REC_MAX_TIME];
+            mfu_perf_format_time((double) rec[MFU_PERF_REC_MIN_TIME], &rank_min_val, &rank_min_units);
+            mfu_perf_format_time(rank_mean, &rank_mean_val, &rank_mean_units);
+            mfu_perf_format_time(rank_max, &rank_max_val, &rank_max_units);
+
+            double ratio = (rank_mean > 0.0) ? rank_max / rank_mean : 1.0;
+            MFU_LOG(MFU_LOG_INFO, "  %-8s time per rank min %.3lf %s (rank %llu), "
+                "mean %.3lf %s, max %.3lf %s (rank %llu, %.2lfx mean)",
+                "", rank_min_val, rank_min_units, (unsigned long long) rec[MFU_PERF_REC_MIN_RANK],
+                rank_mean_val, rank_mean_units, rank_max_val, rank_max_units,
+                (unsigned long long) rec[MFU_PERF_REC_MAX_RANK], ratio
+            );
+        }
+    }
+
+    mfu_free(&all);
+    mfu_free(&recs);
+}
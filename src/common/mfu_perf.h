@@ -0,0 +1,98 @@
+/* Lightweight instrumentation of file system calls.
+ *
+ * The wrappers in mfu_io.c and the layout queries time each call and
+ * record it under an operation type.  For each type, a process keeps
+ * the number of calls, the total bytes and time, the longest call, and
+ * a histogram of call latencies in power-of-two buckets of nanoseconds.
+ * Counters are updated with atomic adds, so I/O threads may record
+ * concurrently without taking a lock.
+ *
+ * mfu_perf_report combines the counters of all processes with a single
+ * reduction and prints, for each operation type, latency percentiles
+ * estimated from the histogram along with the least and most time any
+ * process spent in that operation, naming the slowest process.
+ * mfu_finalize calls it when the log level is verbose or higher. */
+
+/* enable C++ codes to include this header directly */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef MFU_PERF_H
+#define MFU_PERF_H
+
+#include <stdint.h>
+#include <time.h>
+#include "mpi.h"
+
+/* operation types that are counted separately */
+typedef enum {
+    MFU_PERF_OPEN = 0, /* open, opendir */
+    MFU_PERF_CLOSE,    /* close, closedir */
+    MFU_PERF_READ,     /* read */
+    MFU_PERF_PREAD,    /* pread */
+    MFU_PERF_WRITE,    /* write */
+    MFU_PERF_PWRITE,   /* pwrite */
+    MFU_PERF_STAT,     /* stat, lstat, access */
+    MFU_PERF_MKDIR,    /* mkdir */
+    MFU_PERF_MKNOD,    /* mknod */
+    MFU_PERF_UNLINK,   /* unlink, remove, rmdir */
+    MFU_PERF_READDIR,  /* readdir */
+    MFU_PERF_LINK,     /* symlink, link, readlink, realpath */
+    MFU_PERF_SETATTR,  /* chmod, chown, utimensat, truncate */
+    MFU_PERF_XATTR,    /* list, get, and set extended attributes */
+    MFU_PERF_FSYNC,    /* fsync */
+    MFU_PERF_LAYOUT,   /* layout queries, e.g., llapi_layout_get_by_path */
+    MFU_PERF_OTHER,    /* everything else, e.g., lseek, getcwd */
+    MFU_PERF_OPS       /* number of operation types */
+} mfu_perf_op;
+
+/* number of histogram buckets, bucket i counts calls that took
+ * less than 2^i nanoseconds (and at least 2^(i-1)), the last bucket
+ * also counts anything longer */
+#define MFU_PERF_BUCKETS (42)
+
+/* return current time in nanoseconds from a monotonic clock,
+ * on Linux this is read from the vDSO without a system call */
+static inline uint64_t mfu_perf_start(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+/* record one call of type op that started at the time returned
+ * by mfu_perf_start and transferred the given number of bytes */
+void mfu_perf_stop(mfu_perf_op op, uint64_t start, uint64_t bytes);
+
+/* record one call of type op that took nsecs nanoseconds */
+void mfu_perf_add(mfu_perf_op op, uint64_t nsecs, uint64_t bytes);
+
+/* return name of operation type, e.g., "pread" */
+const char* mfu_perf_name(mfu_perf_op op);
+
+/* return the histogram bucket that counts a call of nsecs */
+int mfu_perf_bucket(uint64_t nsecs);
+
+/* given a histogram of count calls, the longest of which took max
+ * nsecs, estimate the latency below which the given fraction of
+ * calls completed, this is the upper edge of the bucket holding
+ * that call, capped at max */
+double mfu_perf_percentile(const uint64_t* hist, uint64_t count, uint64_t max, double fraction);
+
+/* scale a time in nsecs to a value and units for printing */
+void mfu_perf_format_time(double nsecs, double* val, const char** units);
+
+/* zero all counters of the calling process */
+void mfu_perf_reset(void);
+
+/* combine counters across processes in comm and print a summary
+ * on rank 0, must be called by all processes in comm */
+void mfu_perf_report(MPI_Comm comm);
+
+#endif /* MFU_PERF_H */
+
+/* enable C++ codes to include this header directly */
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
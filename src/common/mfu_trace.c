@@ -0,0 +1,265 @@
+/* Per-rank event trace written in Chrome trace event format,
+ * see mfu_trace.h for a description. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "mpi.h"
+#include "mfu.h"
+#include "mfu_trace.h"
+
+/* default number of events held by each rank */
+#define MFU_TRACE_DEFAULT_EVENTS (65536)
+
+/* bytes reserved to format one event */
+#define MFU_TRACE_EVENT_SIZE (256)
+
+/* one entry in the event buffer */
+typedef struct {
+    const char* name; /* name of phase or chunk */
+    char phase;       /* 'B', 'E', or 'X' */
+    int tid;          /* thread that recorded the event */
+    uint64_t ts;      /* nsecs since trace start */
+    uint64_t dur;     /* duration in nsecs of 'X' events */
+    uint64_t bytes;   /* bytes of 'X' events */
+    uint64_t ost;     /* OST of 'X' events */
+} mfu_trace_entry;
+
+int mfu_trace_enabled = 0;
+
+static char* mfu_trace_path = NULL;       /* file to write trace to */
+static mfu_trace_entry* mfu_trace_events = NULL;
+static uint64_t mfu_trace_capacity = 0;   /* number of entries in buffer */
+static uint64_t mfu_trace_next = 0;       /* count of events recorded */
+static uint64_t mfu_trace_start = 0;      /* time of trace start in nsecs */
+static int mfu_trace_threads = 0;         /* number of thread ids given out */
+static __thread int mfu_trace_tid = -1;   /* id of calling thread */
+
+void mfu_trace_event(char phase, const char* name, uint64_t start, uint64_t bytes, uint64_t ost)
+{
+    uint64_t now = mfu_perf_start();
+
+    /* number threads in the order they first record an event */
+    if (mfu_trace_tid < 0) {
+        mfu_trace_tid = __sync_fetch_and_add(&mfu_trace_threads, 1);
+    }
+
+    /* take the next entry, replacing the oldest once full */
+    uint64_t idx = __sync_fetch_and_add(&mfu_trace_next, 1);
+    mfu_trace_entry* e = &mfu_trace_events[idx % mfu_trace_capacity];
+    e->name  = name;
+    e->phase = phase;
+    e->tid   = mfu_trace_tid;
+    e->bytes = bytes;
+    e->ost   = ost;
+    if (phase == 'X') {
+        e->ts  = (start > mfu_trace_start) ? start - mfu_trace_start : 0;
+        e->dur = now - start;
+    } else {
+        e->ts  = now - mfu_trace_start;
+        e->dur = 0;
+    }
+}
+
+void mfu_trace_init(void)
+{
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    /* read settings on rank 0, so all ranks agree on whether to trace */
+    const char* value = NULL;
+    uint64_t capacity = MFU_TRACE_DEFAULT_EVENTS;
+    if (rank == 0) {
+        char varname[] = "MFU_TRACE";
+        value = getenv(varname);
+        if (value != NULL && strcmp(value, "") == 0) {
+            value = NULL;
+        }
+
+        char eventsname[] = "MFU_TRACE_EVENTS";
+        const char* events = getenv(eventsname);
+        if (value != NULL && events != NULL) {
+            unsigned long long val;
+            if (mfu_abtoull(events, &val) == MFU_SUCCESS && val > 0) {
+                capacity = (uint64_t) val;
+                MFU_LOG(MFU_LOG_INFO, "%s: %llu", eventsname, val);
+            } else {
+                MFU_LOG(MFU_LOG_WARN, "Ignoring invalid %s: `%s'", eventsname, events);
+            }
+        }
+    }
+
+    char* path = NULL;
+    mfu_bcast_strdup(value, &path, 0, MPI_COMM_WORLD);
+    if (path == NULL) {
+        return;
+    }
+    MPI_Bcast(&capacity, 1, MPI_UINT64_T, 0, MPI_COMM_WORLD);
+
+    mfu_trace_path     = path;
+    mfu_trace_capacity = capacity;
+    mfu_trace_events   = (mfu_trace_entry*) MFU_MALLOC(mfu_trace_capacity * sizeof(mfu_trace_entry));
+    mfu_trace_next     = 0;
+    mfu_trace_threads  = 0;
+    mfu_trace_tid      = -1;
+
+    /* start the clock on all ranks at about the same time */
+    MPI_Barrier(MPI_COMM_WORLD);
+    mfu_trace_start   = mfu_perf_start();
+    mfu_trace_enabled = 1;
+}
+
+/* format entry e of the given rank into buf, returns number of chars */
+static size_t mfu_trace_format(char* buf, int rank, const mfu_trace_entry* e)
+{
+    int rc;
+    unsigned long long ts = (unsigned long long) e->ts;
+    if (e->phase == 'X') {
+        unsigned long long dur = (unsigned long long) e->dur;
+        char ost[32] = "null";
+        if (e->ost != MFU_LAYOUT_OST_NONE) {
+            snprintf(ost, sizeof(ost), "%llu", (unsigned long long) e->ost);
+        }
+        rc = snprintf(buf, MFU_TRACE_EVENT_SIZE,
+            "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,"
+            "\"ts\":%llu.%03llu,\"dur\":%llu.%03llu,"
+            "\"args\":{\"bytes\":%llu,\"ost\":%s}}",
+            e->name, rank, e->tid, ts / 1000, ts % 1000, dur / 1000, dur % 1000,
+            (unsigned long long) e->bytes, ost);
+    } else {
+        rc = snprintf(buf, MFU_TRACE_EVENT_SIZE,
+            "{\"name\":\"%s\",\"ph\":\"%c\",\"pid\":%d,\"tid\":%d,\"ts\":%llu.%03llu}",
+            e->name, e->phase, rank, e->tid, ts / 1000, ts % 1000);
+    }
+
+    /* snprintf returns the length it wanted, an event that does not
+     * fit is cut short, which only happens for absurdly long names */
+    if (rc < 0) {
+        return 0;
+    }
+    if (rc >= MFU_TRACE_EVENT_SIZE) {
+        return MFU_TRACE_EVENT_SIZE - 1;
+    }
+    return (size_t) rc;
+}
+
+void mfu_trace_finalize(void)
+{
+    if (! mfu_trace_enabled) {
+        return;
+    }
+    mfu_trace_enabled = 0;
+
+    int rank, ranks;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &ranks);
+
+    /* get the events still in the buffer, oldest first */
+    uint64_t count = mfu_trace_next;
+    uint64_t first = 0;
+    uint64_t dropped = 0;
+    if (count > mfu_trace_capacity) {
+        first   = count % mfu_trace_capacity;
+        dropped = count - mfu_trace_capacity;
+        count   = mfu_trace_capacity;
+    }
+
+    /* name each rank after its host, so the viewer groups by node */
+    char host[MPI_MAX_PROCESSOR_NAME];
+    int hostlen;
+    MPI_Get_processor_name(host, &hostlen);
+
+    /* format our events, each preceded by a separator, except for
+     * the first event of rank 0 which follows the header */
+    size_t bufsize = (size_t)(count + 2) * (MFU_TRACE_EVENT_SIZE + 2) + MPI_MAX_PROCESSOR_NAME;
+    char* buf = (char*) MFU_MALLOC(bufsize);
+    size_t len = 0;
+    if (rank == 0) {
+        len += (size_t) sprintf(buf + len, "{\"traceEvents\":[\n");
+    } else {
+        len += (size_t) sprintf(buf + len, ",\n");
+    }
+    len += (size_t) snprintf(buf + len, bufsize - len,
+        "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"rank %d (%s)\"}}",
+        rank, rank, host);
+
+    uint64_t i;
+    for (i = 0; i < count; i++) {
+        const mfu_trace_entry* e = &mfu_trace_events[(first + i) % mfu_trace_capacity];
+        len += (size_t) sprintf(buf + len, ",\n");
+        len += mfu_trace_format(buf + len, rank, e);
+    }
+    if (rank == ranks - 1) {
+        len += (size_t) sprintf(buf + len, "\n],\"displayTimeUnit\":\"ms\"}\n");
+    }
+
+    /* report events that did not fit in the buffer */
+    uint64_t all_dropped = 0;
+    MPI_Reduce(&dropped, &all_dropped, 1, MPI_UINT64_T, MPI_SUM, 0, MPI_COMM_WORLD);
+    if (rank == 0 && all_dropped > 0) {
+        MFU_LOG(MFU_LOG_WARN, "Trace dropped the oldest %llu events, set MFU_TRACE_EVENTS to keep more",
+            (unsigned long long) all_dropped);
+    }
+
+    /* compute offset of our events in the file */
+    uint64_t bytes = (uint64_t) len;
+    uint64_t offset = 0;
+    MPI_Exscan(&bytes, &offset, 1, MPI_UINT64_T, MPI_SUM, MPI_COMM_WORLD);
+    if (rank == 0) {
+        offset = 0;
+    }
+
+    /* limit the size of each write to fit in an int */
+    uint64_t maxwrite = 1024 * 1024 * 1024;
+    uint64_t iters = (bytes + maxwrite - 1) / maxwrite;
+    uint64_t all_iters;
+    MPI_Allreduce(&iters, &all_iters, 1, MPI_UINT64_T, MPI_MAX, MPI_COMM_WORLD);
+
+    /* open and truncate file */
+    char mpierrstr[MPI_MAX_ERROR_STRING];
+    int mpierrlen;
+    MPI_File fh;
+    int amode = MPI_MODE_WRONLY | MPI_MODE_CREATE;
+    int mpirc = MPI_File_open(MPI_COMM_WORLD, mfu_trace_path, amode, MPI_INFO_NULL, &fh);
+    if (mpirc != MPI_SUCCESS) {
+        MPI_Error_string(mpirc, mpierrstr, &mpierrlen);
+        if (rank == 0) {
+            MFU_LOG(MFU_LOG_ERR, "Failed to open trace file `%s' rc=%d %s",
+                mfu_trace_path, mpirc, mpierrstr);
+        }
+    } else {
+        MPI_File_set_size(fh, 0);
+
+        /* collective write of our events */
+        MPI_Status status;
+        MPI_Offset write_offset = (MPI_Offset) offset;
+        char* ptr = buf;
+        uint64_t written = 0;
+        while (all_iters > 0) {
+            uint64_t remaining = bytes - written;
+            int write_count = (int) ((remaining < maxwrite) ? remaining : maxwrite);
+            mpirc = MPI_File_write_at_all(fh, write_offset, ptr, write_count, MPI_CHAR, &status);
+            if (mpirc != MPI_SUCCESS) {
+                MPI_Error_string(mpirc, mpierrstr, &mpierrlen);
+                MFU_LOG(MFU_LOG_ERR, "Failed to write trace file `%s' rc=%d %s",
+                    mfu_trace_path, mpirc, mpierrstr);
+            }
+            write_offset += (MPI_Offset) write_count;
+            ptr          += write_count;
+            written      += (uint64_t) write_count;
+            all_iters--;
+        }
+
+        MPI_File_close(&fh);
+
+        if (rank == 0) {
+            MFU_LOG(MFU_LOG_INFO, "Wrote trace to `%s'", mfu_trace_path);
+        }
+    }
+
+    mfu_free(&buf);
+    mfu_free(&mfu_trace_events);
+    mfu_free(&mfu_trace_path);
+}
@@ -0,0 +1,77 @@
+/* Record a timeline of events on each rank and write it as a trace.
+ *
+ * Set MFU_TRACE=<file> to record the begin and end of phases such as
+ * walking, planning chunks, creating directories, and copying data,
+ * along with each chunk copied.  Events are recorded into a buffer of
+ * MFU_TRACE_EVENTS entries (65536 by default) allocated on each rank
+ * in mfu_init, once the buffer is full the oldest events are replaced.
+ * mfu_finalize writes the events of all ranks to the file with MPI-IO
+ * in the Chrome trace event format, which can be loaded into
+ * chrome://tracing or https://ui.perfetto.dev, each rank appears as a
+ * process and each I/O thread of a rank as a thread.
+ *
+ * Timestamps are taken from each rank's monotonic clock relative to a
+ * barrier in mfu_init, so events of ranks on different nodes line up
+ * to within the skew of that barrier.
+ *
+ * When tracing is off, each macro below costs a test of a global flag. */
+
+/* enable C++ codes to include this header directly */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef MFU_TRACE_H
+#define MFU_TRACE_H
+
+#include <stdint.h>
+
+/* set to 1 on all ranks if MFU_TRACE names a file */
+extern int mfu_trace_enabled;
+
+/* begin a phase named by the string literal name on the calling thread */
+#define MFU_TRACE_BEGIN(name) \
+    do { \
+        if (mfu_trace_enabled) { \
+            mfu_trace_event('B', (name), 0, 0, 0); \
+        } \
+    } while (0)
+
+/* end the phase begun with MFU_TRACE_BEGIN(name) */
+#define MFU_TRACE_END(name) \
+    do { \
+        if (mfu_trace_enabled) { \
+            mfu_trace_event('E', (name), 0, 0, 0); \
+        } \
+    } while (0)
+
+/* record a chunk of work that started at the time returned by
+ * mfu_perf_start and ends now, with the number of bytes and the
+ * OST it touched, or MFU_LAYOUT_OST_NONE */
+#define MFU_TRACE_CHUNK(name, start, bytes, ost) \
+    do { \
+        if (mfu_trace_enabled) { \
+            mfu_trace_event('X', (name), (start), (bytes), (ost)); \
+        } \
+    } while (0)
+
+/* record an event, phase is 'B' (begin), 'E' (end), or 'X' (complete,
+ * starting at start), name must remain valid until the trace is
+ * written, so it should be a string literal, use the macros above
+ * rather than calling this directly */
+void mfu_trace_event(char phase, const char* name, uint64_t start, uint64_t bytes, uint64_t ost);
+
+/* read MFU_TRACE on rank 0 and allocate buffers if it is set,
+ * called from mfu_init, collective */
+void mfu_trace_init(void);
+
+/* write events of all ranks to the trace file and free buffers,
+ * called from mfu_finalize, collective */
+void mfu_trace_finalize(void);
+
+#endif /* MFU_TRACE_H */
+
+/* enable C++ codes to include this header directly */
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
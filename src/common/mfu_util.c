@@ -52,6 +52,9 @@ int mfu_init()
         DTCMP_Init();
         mfu_init_filesystem_list();
         mfu_initialized++;
+        mfu_trace_init();
+        mfu_flist_init_names();
+        mfu_flist_init_cache();
     }
 
     return MFU_SUCCESS;
@@ -60,6 +63,18 @@ int mfu_init()
 /* finalize mfu library */
 int mfu_finalize()
 {
+    if (mfu_initialized == 1) {
+        /* summarize file system calls made by this run */
+        if (mfu_debug_level >= MFU_LOG_VERBOSE) {
+            mfu_perf_report(MPI_COMM_WORLD);
+        }
+
+        /* write trace if MFU_TRACE is set */
+        mfu_trace_finalize();
+
+        /* free paths built from compressed names */
+        mfu_flist_finalize_names();
+    }
     if (mfu_initialized > 0) {
         DTCMP_Finalize();
         mfu_initialized--;
@@ -1094,6 +1109,43 @@ void mfu_stripe_set(const char *path, uint64_t stripe_size, int stripe_count)
 #endif
 }
 
+/* create a striped lustre file without aborting on failure */
+int mfu_stripe_create(const char *path, uint64_t stripe_size, int stripe_count, mode_t mode)
+{
+#ifdef LUSTRE_SUPPORT
+#if defined(HAVE_LLAPI_LAYOUT)
+    /* create a new llapi_layout for file creation */
+    struct llapi_layout *layout = llapi_layout_alloc();
+    if (layout == NULL) {
+        return -1;
+    }
+    llapi_layout_stripe_count_set(layout, stripe_count);
+    llapi_layout_stripe_size_set(layout, stripe_size);
+
+    /* create the file, saving errno across the free */
+    int fd = llapi_layout_file_create(path, 0, mode, layout);
+    int err = errno;
+    llapi_layout_free(layout);
+    if (fd < 0) {
+        errno = err;
+        return -1;
+    }
+    close(fd);
+    return 0;
+#elif defined(HAVE_LLAPI_FILE_CREATE)
+    int rc = llapi_file_create(path, stripe_size, 0, stripe_count, LOV_PATTERN_RAID0);
+    if (rc < 0) {
+        errno = -rc;
+        return -1;
+    }
+    chmod(path, mode);
+    return 0;
+#endif
+#endif
+    errno = ENOTSUP;
+    return -1;
+}
+
 /* given a path, return true if on Lustre, false otherwise */
 bool mfu_is_lustre(const char* path)
 {
@@ -272,6 +272,11 @@ int mfu_stripe_get(const char *path, uint64_t *stripe_size, uint64_t *stripe_cou
 /* create a striped lustre file at the path provided with the specified stripe size and count */
 void mfu_stripe_set(const char *path, uint64_t stripe_size, int stripe_count);
 
+/* create a lustre file with the given stripe size and count and mode bits,
+ * unlike mfu_stripe_set this does not abort, returns 0 on success and
+ * -1 with errno set on failure */
+int mfu_stripe_create(const char *path, uint64_t stripe_size, int stripe_count, mode_t mode);
+
 /* return true if path is on lustre, false otherwise */
 bool mfu_is_lustre(const char* path);
 
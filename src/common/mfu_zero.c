@@ -0,0 +1,217 @@
+/* Detect blocks of zero bytes in data buffers.
+ *
+ * A kernel is selected on first use based on the instruction sets
+ * the CPU supports.  Each kernel ORs together wide loads and tests the
+ * accumulated value once per iteration, so the loop does a handful of
+ * vector operations per cache line rather than one compare per byte.
+ * Set MFU_ZERO_KERNEL to word, sse2, avx2, or avx512 to force a
+ * particular kernel, e.g., to compare performance, a kernel the CPU
+ * does not support is ignored with a warning. */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "mfu.h"
+#include "mfu_zero.h"
+
+/* x86 kernels are compiled with function-specific target attributes
+ * and selected at run time, so the library itself can still be built
+ * for a baseline CPU */
+#if defined(__x86_64__) && (defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 5))
+#define MFU_ZERO_X86 1
+#include <immintrin.h>
+#endif
+
+typedef int (*mfu_zero_fn)(const unsigned char* buf, size_t size);
+
+static mfu_zero_fn mfu_zero_kernel = NULL;
+static const char* mfu_zero_name = NULL;
+static pthread_once_t mfu_zero_once = PTHREAD_ONCE_INIT;
+
+/* portable kernel, checks 64 bytes at a time using 64-bit words */
+static int mfu_zero_check_word(const unsigned char* buf, size_t size)
+{
+    /* check leading bytes until we reach an 8-byte boundary */
+    while (size > 0 && ((uintptr_t)buf & (sizeof(uint64_t) - 1)) != 0) {
+        if (*buf != 0) {
+            return 0;
+        }
+        buf++;
+        size--;
+    }
+
+    /* OR together a cache line worth of words before testing */
+    const uint64_t* p = (const uint64_t*) buf;
+    while (size >= 8 * sizeof(uint64_t)) {
+        uint64_t acc = p[0] | p[1] | p[2] | p[3] |
+                       p[4] | p[5] | p[6] | p[7];
+        if (acc != 0) {
+            return 0;
+        }
+        p    += 8;
+        size -= 8 * sizeof(uint64_t);
+    }
+    while (size >= sizeof(uint64_t)) {
+        if (*p != 0) {
+            return 0;
+        }
+        p++;
+        size -= sizeof(uint64_t);
+    }
+
+    /* check any trailing bytes */
+    buf = (const unsigned char*) p;
+    while (size > 0) {
+        if (*buf != 0) {
+            return 0;
+        }
+        buf++;
+        size--;
+    }
+
+    return 1;
+}
+
+#ifdef MFU_ZERO_X86
+__attribute__((target("sse2")))
+static int mfu_zero_check_sse2(const unsigned char* buf, size_t size)
+{
+    const __m128i zero = _mm_setzero_si128();
+    while (size >= 64) {
+        __m128i a = _mm_loadu_si128((const __m128i*)(buf +  0));
+        __m128i b = _mm_loadu_si128((const __m128i*)(buf + 16));
+        __m128i c = _mm_loadu_si128((const __m128i*)(buf + 32));
+        __m128i d = _mm_loadu_si128((const __m128i*)(buf + 48));
+        __m128i acc = _mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(acc, zero)) != 0xFFFF) {
+            return 0;
+        }
+        buf  += 64;
+        size -= 64;
+    }
+    return mfu_zero_check_word(buf, size);
+}
+
+__attribute__((target("avx2")))
+static int mfu_zero_check_avx2(const unsigned char* buf, size_t size)
+{
+    while (size >= 128) {
+        __m256i a = _mm256_loadu_si256((const __m256i*)(buf +  0));
+        __m256i b = _mm256_loadu_si256((const __m256i*)(buf + 32));
+        __m256i c = _mm256_loadu_si256((const __m256i*)(buf + 64));
+        __m256i d = _mm256_loadu_si256((const __m256i*)(buf + 96));
+        __m256i acc = _mm256_or_si256(_mm256_or_si256(a, b), _mm256_or_si256(c, d));
+        if (! _mm256_testz_si256(acc, acc)) {
+            return 0;
+        }
+        buf  += 128;
+        size -= 128;
+    }
+    return mfu_zero_check_word(buf, size);
+}
+
+__attribute__((target("avx512f")))
+static int mfu_zero_check_avx512(const unsigned char* buf, size_t size)
+{
+    while (size >= 256) {
+        __m512i a = _mm512_loadu_si512((const void*)(buf +   0));
+        __m512i b = _mm512_loadu_si512((const void*)(buf +  64));
+        __m512i c = _mm512_loadu_si512((const void*)(buf + 128));
+        __m512i d = _mm512_loadu_si512((const void*)(buf + 192));
+        __m512i acc = _mm512_or_si512(_mm512_or_si512(a, b), _mm512_or_si512(c, d));
+        if (_mm512_test_epi64_mask(acc, acc) != 0) {
+            return 0;
+        }
+        buf  += 256;
+        size -= 256;
+    }
+    return mfu_zero_check_word(buf, size);
+}
+#endif /* MFU_ZERO_X86 */
+
+/* pick the widest kernel supported by this CPU,
+ * honoring MFU_ZERO_KERNEL if it names a supported kernel */
+static void mfu_zero_select(void)
+{
+    mfu_zero_kernel = mfu_zero_check_word;
+    mfu_zero_name   = "word";
+
+    const char* request = getenv("MFU_ZERO_KERNEL");
+    if (request != NULL && strcmp(request, "word") == 0) {
+        return;
+    }
+
+#ifdef MFU_ZERO_X86
+    __builtin_cpu_init();
+
+    /* try each kernel from widest to narrowest */
+    struct {
+        const char* name;
+        int supported;
+        mfu_zero_fn fn;
+    } kernels[] = {
+        {"avx512", __builtin_cpu_supports("avx512f"), mfu_zero_check_avx512},
+        {"avx2",   __builtin_cpu_supports("avx2"),    mfu_zero_check_avx2},
+        {"sse2",   __builtin_cpu_supports("sse2"),    mfu_zero_check_sse2},
+    };
+
+    int i;
+    int count = (int) (sizeof(kernels) / sizeof(kernels[0]));
+    for (i = 0; i < count; i++) {
+        if (! kernels[i].supported) {
+            continue;
+        }
+        if (request != NULL && strcmp(request, kernels[i].name) != 0) {
+            continue;
+        }
+        mfu_zero_kernel = kernels[i].fn;
+        mfu_zero_name   = kernels[i].name;
+        break;
+    }
+#endif
+
+    /* tell the user if the kernel they asked for is not used */
+    if (request != NULL && strcmp(request, mfu_zero_name) != 0 && mfu_rank == 0) {
+        MFU_LOG(MFU_LOG_WARN, "Ignoring MFU_ZERO_KERNEL: `%s' is unknown or not supported by this CPU, using %s",
+            request, mfu_zero_name);
+    }
+}
+
+int mfu_zero_check(const void* buf, size_t size)
+{
+    pthread_once(&mfu_zero_once, mfu_zero_select);
+    return (*mfu_zero_kernel)((const unsigned char*) buf, size);
+}
+
+size_t mfu_zero_span(const void* buf, size_t size, int zero)
+{
+    pthread_once(&mfu_zero_once, mfu_zero_select);
+
+    const unsigned char* ptr = (const unsigned char*) buf;
+    size_t span = 0;
+    while (span < size) {
+        /* the final block may be short */
+        size_t len = size - span;
+        if (len > MFU_ZERO_BLOCK_SIZE) {
+            len = MFU_ZERO_BLOCK_SIZE;
+        }
+
+        /* stop at the first block that does not match */
+        int is_zero = (*mfu_zero_kernel)(ptr + span, len);
+        if (is_zero != (zero != 0)) {
+            break;
+        }
+
+        span += len;
+    }
+
+    return span;
+}
+
+const char* mfu_zero_kernel_name(void)
+{
+    pthread_once(&mfu_zero_once, mfu_zero_select);
+    return mfu_zero_name;
+}
@@ -0,0 +1,39 @@
+/* routines to detect blocks of zero bytes in data buffers,
+ * used to skip writing holes when creating sparse files */
+
+/* enable C++ codes to include this header directly */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef MFU_ZERO_H
+#define MFU_ZERO_H
+
+#include <stddef.h>
+
+/* granularity in bytes at which holes are detected within a buffer,
+ * this matches the block size of most file systems, so that a
+ * skipped region can become a hole in the destination file */
+#define MFU_ZERO_BLOCK_SIZE (4096)
+
+/* returns 1 if all size bytes in buf are 0, and 0 otherwise,
+ * uses the fastest kernel supported by the current CPU */
+int mfu_zero_check(const void* buf, size_t size);
+
+/* given a buffer of size bytes, scan forward in units of
+ * MFU_ZERO_BLOCK_SIZE and return the number of leading bytes
+ * that are all zero (if zero=1) or that contain data (if zero=0),
+ * the returned length is a multiple of MFU_ZERO_BLOCK_SIZE
+ * unless it reaches the end of the buffer */
+size_t mfu_zero_span(const void* buf, size_t size, int zero);
+
+/* return name of the zero detection kernel selected for this CPU,
+ * e.g., "avx512", "avx2", "sse2", or "word" */
+const char* mfu_zero_kernel_name(void);
+
+#endif /* MFU_ZERO_H */
+
+/* enable C++ codes to include this header directly */
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
@@ -19,8 +19,6 @@
 
 #include "mfu_errors.h"
 
-#include "timing.h"
-
 static int input_flist_skip(const char* name, void *args)
 {
     /* nothing to do if args are NULL */
@@ -81,6 +79,10 @@ void print_usage(void)
 #endif
     printf("  -b, --bufsize <SIZE>     - IO buffer size in bytes (default " MFU_BUFFER_SIZE_STR ")\n");
     printf("  -k, --chunksize <SIZE>   - work size per task in bytes (default " MFU_CHUNK_SIZE_STR ")\n");
+    printf("      --coalesce <SIZE>    - combine stripes on one object into chunks of up to SIZE bytes, 0 disables (default " MFU_COALESCE_SIZE_STR ")\n");
+    printf("      --mirror-layout      - stripe each destination file like its source and schedule by OST pair (Lustre)\n");
+    printf("      --fd-cache <N>       - number of open files to cache per process (default " MFU_FD_CACHE_SIZE_STR ")\n");
+    printf("      --io-threads <N>     - number of I/O threads per process to copy data (default 1)\n");
     printf("  -X, --xattrs <OPT>       - copy xattrs (none, all, non-lustre, libattr)\n");
 #ifdef DAOS_SUPPORT
     printf("      --daos-api           - DAOS API in {DFS, DAOS} (default uses DFS for POSIX containers)\n");
@@ -96,6 +98,11 @@ void print_usage(void)
     printf("  -s, --direct             - open files with O_DIRECT\n");
     printf("      --open-noatime       - open files with O_NOATIME\n");
     printf("  -S, --sparse             - create sparse files when possible\n");
+    printf("      --pipeline           - overlap reads and writes using a helper I/O thread\n");
+    printf("      --copy-offload       - copy in the kernel with reflink or copy_file_range when possible\n");
+    printf("      --steal              - processes that finish early take chunks from busy processes\n");
+    printf("      --stream             - copy items in batches as the walk finds them\n");
+    printf("      --batch-files <N>    - copy items in batches of N (default " MFU_STREAM_BATCH_SIZE_STR " with --stream)\n");
     printf("      --progress <N>       - print progress every N seconds\n");
     printf("  -G  --gid <GID>          - Set the group id to perform copy\n");
     printf("  -U  --uid <UID>          - Set the user id to perform copy\n");
@@ -123,12 +130,6 @@ int main(int argc, char** argv)
     int rank;
     MPI_Comm_rank(MPI_COMM_WORLD, &rank);
 
-    // if (rank == 0) {
-    //    printf("check: Starting dcp\n");
-    // }
-
-    double starttime = MPI_Wtime();
-
     /* pointer to mfu_file src and dest objects */
     mfu_file_t* mfu_src_file = mfu_file_new();
     mfu_file_t* mfu_dst_file = mfu_file_new();
@@ -163,6 +164,10 @@ int main(int argc, char** argv)
         {"daos-preserve"        , required_argument, 0, 'D'},
         {"input"                , required_argument, 0, 'i'},
         {"chunksize"            , required_argument, 0, 'k'},
+        {"coalesce"             , required_argument, 0, 'C'},
+        {"mirror-layout"        , no_argument      , 0, 'M'},
+        {"fd-cache"             , required_argument, 0, 'F'},
+        {"io-threads"           , required_argument, 0, 'T'},
         {"xattrs"               , required_argument, 0, 'X'},
         {"dereference"          , no_argument      , 0, 'L'},
         {"no-dereference"       , no_argument      , 0, 'P'},
@@ -171,6 +176,11 @@ int main(int argc, char** argv)
         {"direct"               , no_argument      , 0, 's'},
         {"open-noatime"         , no_argument      , 0, 'A'},
         {"sparse"               , no_argument      , 0, 'S'},
+        {"pipeline"             , no_argument      , 0, 'W'},
+        {"copy-offload"         , no_argument      , 0, 'O'},
+        {"steal"                , no_argument      , 0, 'K'},
+        {"stream"               , no_argument      , 0, 'E'},
+        {"batch-files"          , required_argument, 0, 'B'},
         {"progress"             , required_argument, 0, 'R'},
         {"gid"                  , required_argument, 0, 'G'},
         {"uid"                  , required_argument, 0, 'U'},
@@ -180,6 +190,9 @@ int main(int argc, char** argv)
         {0                      , 0                , 0, 0  }
     };
 
+    /* whether to walk and copy in batches */
+    int stream = 0;
+
     /* Parse options */
     unsigned long long bytes = 0;
     int usage = 0;
@@ -298,6 +311,43 @@ int main(int argc, char** argv)
                     mfu_copy_opts->chunk_size = bytes;
                 }
                 break;
+            case 'C':
+                if (mfu_abtoull(optarg, &bytes) != MFU_SUCCESS) {
+                    if (rank == 0) {
+                        MFU_LOG(MFU_LOG_ERR,
+                                "Failed to parse coalesce size: '%s'", optarg);
+                    }
+                    usage = 1;
+                } else {
+                    mfu_copy_opts->coalesce_size = (uint64_t) bytes;
+                }
+                break;
+            case 'F':
+                mfu_copy_opts->fd_cache_size = atoi(optarg);
+                if (mfu_copy_opts->fd_cache_size < 1) {
+                    if (rank == 0) {
+                        MFU_LOG(MFU_LOG_ERR,
+                                "File cache size must be positive: '%s'", optarg);
+                    }
+                    usage = 1;
+                }
+                break;
+            case 'T':
+                mfu_copy_opts->io_threads = atoi(optarg);
+                if (mfu_copy_opts->io_threads < 1) {
+                    if (rank == 0) {
+                        MFU_LOG(MFU_LOG_ERR,
+                                "Number of I/O threads must be positive: '%s'", optarg);
+                    }
+                    usage = 1;
+                }
+                break;
+            case 'M':
+                mfu_copy_opts->mirror_layout = true;
+                if(rank == 0) {
+                    MFU_LOG(MFU_LOG_INFO, "Mirroring source layouts onto destination files");
+                }
+                break;
             case 'L':
                 /* turn on dereference.
                  * turn off no_dereference */
@@ -336,6 +386,41 @@ int main(int argc, char** argv)
                     MFU_LOG(MFU_LOG_INFO, "Using sparse file");
                 }
                 break;
+            case 'W':
+                mfu_copy_opts->pipeline = true;
+                if(rank == 0) {
+                    MFU_LOG(MFU_LOG_INFO, "Using pipelined reads and writes");
+                }
+                break;
+            case 'O':
+                mfu_copy_opts->copy_offload = true;
+                if(rank == 0) {
+                    MFU_LOG(MFU_LOG_INFO, "Using kernel copy offload when possible");
+                }
+                break;
+            case 'K':
+                mfu_copy_opts->steal = true;
+                if(rank == 0) {
+                    MFU_LOG(MFU_LOG_INFO, "Stealing chunks from busy processes");
+                }
+                break;
+            case 'E':
+                stream = 1;
+                if(rank == 0) {
+                    MFU_LOG(MFU_LOG_INFO, "Copying items as they are walked");
+                }
+                break;
+            case 'B':
+                if (mfu_abtoull(optarg, &bytes) != MFU_SUCCESS || bytes == 0) {
+                    if (rank == 0) {
+                        MFU_LOG(MFU_LOG_ERR,
+                                "Failed to parse batch size: '%s'", optarg);
+                    }
+                    usage = 1;
+                } else {
+                    mfu_copy_opts->batch_files = (uint64_t) bytes;
+                }
+                break;
             case 'R':
                 mfu_progress_timeout = atoi(optarg);
                 break;
@@ -375,6 +460,14 @@ int main(int argc, char** argv)
         usage = 1;
     }
 
+    /* a streaming copy walks the source paths itself */
+    if (stream && inputname != NULL) {
+        if (rank == 0) {
+            MFU_LOG(MFU_LOG_ERR, "Cannot use --stream with --input");
+        }
+        usage = 1;
+    }
+
     /* If we need to print the usage
      * then do so before internal processing */
     if (usage) {
@@ -516,27 +609,34 @@ int main(int argc, char** argv)
         }
 
         /* perform POSIX copy */
-        if (inputname == NULL) {
-            /* if daos is set to SRC then use daos_ functions on walk */
-            mfu_flist_walk_param_paths(numpaths_src, paths, walk_opts, flist, mfu_src_file);
+        if (stream) {
+            /* walk and copy items in batches as they are found */
+            rc = mfu_flist_copy_stream(numpaths_src, paths,
+                                       destpath, walk_opts, mfu_copy_opts,
+                                       mfu_src_file, mfu_dst_file);
         } else {
-            struct mfu_flist_skip_args skip_args;
-
-            /* otherwise, read list of files from input, but then stat each one */
-            mfu_flist input_flist = mfu_flist_new();
-            mfu_flist_read_cache(inputname, input_flist);
+            if (inputname == NULL) {
+                /* if daos is set to SRC then use daos_ functions on walk */
+                mfu_flist_walk_param_paths(numpaths_src, paths, walk_opts, flist, mfu_src_file);
+            } else {
+                struct mfu_flist_skip_args skip_args;
+
+                /* otherwise, read list of files from input, but then stat each one */
+                mfu_flist input_flist = mfu_flist_new();
+                mfu_flist_read_cache(inputname, input_flist);
+
+                skip_args.numpaths = numpaths_src;
+                skip_args.paths = paths;
+                mfu_flist_stat(input_flist, flist, input_flist_skip, (void *)&skip_args,
+                               walk_opts->dereference, mfu_src_file);
+                mfu_flist_free(&input_flist);
+            }
 
-            skip_args.numpaths = numpaths_src;
-            skip_args.paths = paths;
-            mfu_flist_stat(input_flist, flist, input_flist_skip, (void *)&skip_args,
-                           walk_opts->dereference, mfu_src_file);
-            mfu_flist_free(&input_flist);
+            /* copy flist into destination */ 
+            rc = mfu_flist_copy(flist, numpaths_src, paths,
+                                destpath, mfu_copy_opts, mfu_src_file,
+                                mfu_dst_file);
         }
-
-        /* copy flist into destination */ 
-        rc = mfu_flist_copy(flist, numpaths_src, paths,
-                            destpath, mfu_copy_opts, mfu_src_file,
-                            mfu_dst_file);
         if (rc < 0) {
             /* hit some sort of error during copy */
             rc = 1;
@@ -602,81 +702,6 @@ daos_cleanup:
         }
     }
 
-    double endtime = MPI_Wtime();
-    int size;
-
-    MPI_Comm_size(MPI_COMM_WORLD, &size);
-
-    // Total time
-    double total_time = timing_info.total_time;
-    double sum_time, max_time, min_time;
-    MPI_Reduce(&total_time, &sum_time, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
-    MPI_Reduce(&total_time, &max_time, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
-    MPI_Reduce(&total_time, &min_time, 1, MPI_DOUBLE, MPI_MIN, 0, MPI_COMM_WORLD);
-
-    // Pread total time
-    double pread_total_time = pread_timing_info.total_time;
-    double pread_sum_time, pread_max_time, pread_min_time;
-    MPI_Reduce(&pread_total_time, &pread_sum_time, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
-    MPI_Reduce(&pread_total_time, &pread_max_time, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
-    MPI_Reduce(&pread_total_time, &pread_min_time, 1, MPI_DOUBLE, MPI_MIN, 0, MPI_COMM_WORLD);
-
-    // Pread count
-    double pread_count = pread_timing_info.count;
-    double sum_pread_count, max_pread_count, min_pread_count;
-    MPI_Reduce(&pread_count, &sum_pread_count, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
-    MPI_Reduce(&pread_count, &max_pread_count, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
-    MPI_Reduce(&pread_count, &min_pread_count, 1, MPI_DOUBLE, MPI_MIN, 0, MPI_COMM_WORLD);
-
-    // Metadata total time
-    double md_total_time = md_timing_info.total_time;
-    double md_sum_time, md_max_time, md_min_time;
-    MPI_Reduce(&md_total_time, &md_sum_time, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
-    MPI_Reduce(&md_total_time, &md_max_time, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
-    MPI_Reduce(&md_total_time, &md_min_time, 1, MPI_DOUBLE, MPI_MIN, 0, MPI_COMM_WORLD);
-
-    // Metadata count
-    double md_count = md_timing_info.count;
-    double sum_md_count, max_md_count, min_md_count;
-    MPI_Reduce(&md_count, &sum_md_count, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
-    MPI_Reduce(&md_count, &max_md_count, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
-    MPI_Reduce(&md_count, &min_md_count, 1, MPI_DOUBLE, MPI_MIN, 0, MPI_COMM_WORLD);
-
-    // llapi total time
-    double llapi_total_time = llapi_timing_info.total_time;
-    double llapi_sum_time, llapi_max_time, llapi_min_time;
-    MPI_Reduce(&llapi_total_time, &llapi_sum_time, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
-    MPI_Reduce(&llapi_total_time, &llapi_max_time, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
-    MPI_Reduce(&llapi_total_time, &llapi_min_time, 1, MPI_DOUBLE, MPI_MIN, 0, MPI_COMM_WORLD);
-
-    if (rank == 0) {
-        printf("check: exec time: %f seconds\n", endtime - starttime);
-        
-        printf("check: Avg io time: %f seconds\n", sum_time/size);
-        printf("check: Max io time: %f seconds\n", max_time);
-        printf("check: Min io time: %f seconds\n", min_time);
-
-        printf("check: Avg pread time: %f seconds\n", pread_sum_time/size);
-        printf("check: Max pread time: %f seconds\n", pread_max_time);
-        printf("check: Min pread time: %f seconds\n", pread_min_time);
-
-        printf("check: Total pread count: %f\n", sum_pread_count);
-        printf("check: Max pread count: %f\n", max_pread_count);
-        printf("check: Min pread count: %f\n", min_pread_count);
-
-        printf("check: Avg metadata time: %f seconds\n", md_sum_time/size);
-        printf("check: Max metadata time: %f seconds\n", md_max_time);
-        printf("check: Min metadata time: %f seconds\n", md_min_time);
-
-        printf("check: Total metadata count: %f\n", sum_md_count);
-        printf("check: Max metadata count: %f\n", max_md_count);
-        printf("check: Min metadata count: %f\n", min_md_count);
-
-        printf("check: Avg llapi time: %f seconds\n", llapi_sum_time/size);
-        printf("check: Max llapi time: %f seconds\n", llapi_max_time);
-        printf("check: Min llapi time: %f seconds\n", llapi_min_time);
-    }
-
     mfu_finalize();
 
     /* shut down MPI */
@@ -0,0 +1,452 @@
+/* Predict how dcp would spread the chunks of a list of files over
+ * processes, without copying any data.
+ *
+ * dplan reads a list written by dwalk --output, looks up the layout of
+ * each file with the provider named by MFU_LAYOUT (or --layout), and
+ * runs the chunk planner for a given number of processes and nodes,
+ * which need not match the size of the job running dplan.  It then
+ * reports the bytes and chunks given to each process, the load on each
+ * OST, and the time to copy the data under a simple bandwidth model, in
+ * which each process, node, and OST moves data at a fixed rate and the
+ * copy takes as long as the busiest of them. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <getopt.h>
+
+#include "mpi.h"
+#include "mfu.h"
+
+static void print_usage(void)
+{
+    printf("\n");
+    printf("Usage: dplan [options] --input <file>\n");
+    printf("\n");
+    printf("Options:\n");
+    printf("  -i, --input <file>     - read list from file\n");
+    printf("  -n, --procs <N>        - number of processes to plan for (default size of job)\n");
+    printf("  -N, --nodes <N>        - number of nodes the processes run on (default 1)\n");
+    printf("  -k, --chunksize <SIZE> - work size per task in bytes (default " MFU_CHUNK_SIZE_STR ")\n");
+    printf("      --coalesce <SIZE>  - combine stripes on one object into chunks of up to SIZE bytes, 0 disables (default " MFU_COALESCE_SIZE_STR ")\n");
+    printf("      --layout <SPEC>    - get layouts from SPEC as accepted by MFU_LAYOUT, e.g., mock:<file>\n");
+    printf("      --ost-count <N>    - schedule over OSTs 0 to N-1 as MFU_OST_COUNT does\n");
+    printf("      --ost-map <file>   - read server of each OST from file as MFU_OST_MAP does\n");
+    printf("      --proc-bw <SIZE>   - bytes per second one process copies (default 1GB)\n");
+    printf("      --node-bw <SIZE>   - bytes per second one node copies, 0 for no limit (default 0)\n");
+    printf("      --ost-bw <SIZE>    - bytes per second one OST serves, 0 for no limit (default 1GB)\n");
+    printf("  -p, --print-procs      - print bytes and chunks of each process\n");
+    printf("  -o, --print-osts       - print bytes and chunks of each OST\n");
+    printf("  -v, --verbose          - verbose output\n");
+    printf("  -q, --quiet            - quiet output\n");
+    printf("  -h, --help             - print usage\n");
+    printf("For more information see https://mpifileutils.readthedocs.io.\n");
+    printf("\n");
+    fflush(stdout);
+}
+
+/* find the least, mean, and largest of count values */
+static void dplan_range(
+    const uint64_t* vals,
+    int count,
+    uint64_t* min,
+    double* mean,
+    uint64_t* max)
+{
+    uint64_t sum = 0;
+    *min = (count > 0) ? vals[0] : 0;
+    *max = (count > 0) ? vals[0] : 0;
+    int i;
+    for (i = 0; i < count; i++) {
+        sum += vals[i];
+        if (vals[i] < *min) {
+            *min = vals[i];
+        }
+        if (vals[i] > *max) {
+            *max = vals[i];
+        }
+    }
+    *mean = (count > 0) ? (double) sum / (double) count : 0.0;
+}
+
+/* print least, mean, and largest bytes over a set of items */
+static void dplan_print_bytes(const char* what, const uint64_t* vals, int count)
+{
+    uint64_t min, max;
+    double mean;
+    dplan_range(vals, count, &min, &mean, &max);
+
+    double min_tmp, mean_tmp, max_tmp;
+    const char* min_units;
+    const char* mean_units;
+    const char* max_units;
+    mfu_format_bytes(min, &min_tmp, &min_units);
+    mfu_format_bytes((uint64_t) mean, &mean_tmp, &mean_units);
+    mfu_format_bytes(max, &max_tmp, &max_units);
+    double imbalance = (mean > 0.0) ? (double) max / mean : 1.0;
+    MFU_LOG(MFU_LOG_INFO, "Bytes per %s: min %.3lf %s, mean %.3lf %s, max %.3lf %s, imbalance %.3lf",
+        what, min_tmp, min_units, mean_tmp, mean_units, max_tmp, max_units, imbalance);
+}
+
+/* print least, mean, and largest chunks over a set of items */
+static void dplan_print_chunks(const char* what, const uint64_t* vals, int count)
+{
+    uint64_t min, max;
+    double mean;
+    dplan_range(vals, count, &min, &mean, &max);
+    MFU_LOG(MFU_LOG_INFO, "Chunks per %s: min %llu, mean %.1lf, max %llu",
+        what, (unsigned long long) min, mean, (unsigned long long) max);
+}
+
+/* seconds to move bytes at bw bytes per second, 0 if bw is not limited */
+static double dplan_secs(uint64_t bytes, uint64_t bw)
+{
+    if (bw == 0) {
+        return 0.0;
+    }
+    return (double) bytes / (double) bw;
+}
+
+/* print the plan and the time predicted by the bandwidth model */
+static void dplan_report(
+    const mfu_file_chunk_plan* plan,
+    uint64_t proc_bw,
+    uint64_t node_bw,
+    uint64_t ost_bw,
+    int print_procs,
+    int print_osts)
+{
+    int ranks = plan->ranks;
+    int nodes = plan->nodes;
+    int osts  = plan->osts;
+    int r, n, u;
+
+    /* add up bytes on each node */
+    uint64_t* node_bytes = (uint64_t*) MFU_MALLOC((size_t)nodes * sizeof(uint64_t));
+    for (n = 0; n < nodes; n++) {
+        node_bytes[n] = 0;
+    }
+    uint64_t total_bytes  = 0;
+    uint64_t total_chunks = 0;
+    for (r = 0; r < ranks; r++) {
+        node_bytes[plan->node_of[r]] += plan->rank_bytes[r];
+        total_bytes  += plan->rank_bytes[r];
+        total_chunks += plan->rank_chunks[r];
+    }
+
+    /* count OSTs holding data, the last entry counts data
+     * not on a known OST and does not limit the rate */
+    int active = 0;
+    for (u = 0; u < osts - 1; u++) {
+        if (plan->ost_bytes[u] > 0) {
+            active++;
+        }
+    }
+
+    double total_tmp;
+    const char* total_units;
+    mfu_format_bytes(total_bytes, &total_tmp, &total_units);
+    MFU_LOG(MFU_LOG_INFO, "Planned %llu chunks with %.3lf %s for %d processes on %d nodes over %d OSTs",
+        (unsigned long long) total_chunks, total_tmp, total_units, ranks, nodes, osts - 1);
+    dplan_print_bytes("process", plan->rank_bytes, ranks);
+    dplan_print_chunks("process", plan->rank_chunks, ranks);
+    if (nodes > 1) {
+        dplan_print_bytes("node", node_bytes, nodes);
+    }
+    if (osts > 1) {
+        dplan_print_bytes("OST", plan->ost_bytes, osts - 1);
+        dplan_print_chunks("OST", plan->ost_chunks, osts - 1);
+    }
+    if (plan->ost_bytes[osts - 1] > 0) {
+        double tmp;
+        const char* units;
+        mfu_format_bytes(plan->ost_bytes[osts - 1], &tmp, &units);
+        MFU_LOG(MFU_LOG_INFO, "Bytes not on a known OST: %.3lf %s in %llu chunks",
+            tmp, units, (unsigned long long) plan->ost_chunks[osts - 1]);
+    }
+
+    /* the copy takes as long as the busiest process, node, or OST */
+    double makespan = 0.0;
+    const char* limit = "process";
+    int limit_idx = 0;
+    for (r = 0; r < ranks; r++) {
+        double secs = dplan_secs(plan->rank_bytes[r], proc_bw);
+        if (secs > makespan) {
+            makespan  = secs;
+            limit     = "process";
+            limit_idx = r;
+        }
+    }
+    for (n = 0; n < nodes; n++) {
+        double secs = dplan_secs(node_bytes[n], node_bw);
+        if (secs > makespan) {
+            makespan  = secs;
+            limit     = "node";
+            limit_idx = n;
+        }
+    }
+    for (u = 0; u < osts - 1; u++) {
+        double secs = dplan_secs(plan->ost_bytes[u], ost_bw);
+        if (secs > makespan) {
+            makespan  = secs;
+            limit     = "OST";
+            limit_idx = (int) plan->ost_index[u];
+        }
+    }
+
+    /* compare to the time if the bytes were spread evenly,
+     * which is limited by the slowest of the aggregate rates */
+    double ideal = dplan_secs(total_bytes, proc_bw * (uint64_t)ranks);
+    if (node_bw > 0 && dplan_secs(total_bytes, node_bw * (uint64_t)nodes) > ideal) {
+        ideal = dplan_secs(total_bytes, node_bw * (uint64_t)nodes);
+    }
+    if (ost_bw > 0 && active > 0 && dplan_secs(total_bytes, ost_bw * (uint64_t)active) > ideal) {
+        ideal = dplan_secs(total_bytes, ost_bw * (uint64_t)active);
+    }
+
+    double rate = (makespan > 0.0) ? (double) total_bytes / makespan : 0.0;
+    double rate_tmp;
+    const char* rate_units;
+    mfu_format_bw(rate, &rate_tmp, &rate_units);
+    double efficiency = (makespan > 0.0) ? ideal / makespan * 100.0 : 100.0;
+    MFU_LOG(MFU_LOG_INFO, "Predicted time: %.3lf secs (%.3lf %s), limited by %s %d",
+        makespan, rate_tmp, rate_units, limit, limit_idx);
+    MFU_LOG(MFU_LOG_INFO, "Time if evenly spread: %.3lf secs, efficiency %.1lf%%",
+        ideal, efficiency);
+
+    if (print_procs) {
+        MFU_LOG(MFU_LOG_INFO, "%8s %6s %10s %14s %10s", "Process", "Node", "Chunks", "Bytes", "Secs");
+        for (r = 0; r < ranks; r++) {
+            double tmp;
+            const char* units;
+            mfu_format_bytes(plan->rank_bytes[r], &tmp, &units);
+            MFU_LOG(MFU_LOG_INFO, "%8d %6d %10llu %10.3lf %3s %10.3lf",
+                r, plan->node_of[r], (unsigned long long) plan->rank_chunks[r],
+                tmp, units, dplan_secs(plan->rank_bytes[r], proc_bw));
+        }
+    }
+
+    if (print_osts) {
+        MFU_LOG(MFU_LOG_INFO, "%8s %6s %10s %14s %10s", "OST", "Procs", "Chunks", "Bytes", "Secs");
+        for (u = 0; u < osts; u++) {
+            double tmp;
+            const char* units;
+            mfu_format_bytes(plan->ost_bytes[u], &tmp, &units);
+            char name[32];
+            double secs = 0.0;
+            if (plan->ost_index[u] == MFU_LAYOUT_OST_NONE) {
+                snprintf(name, sizeof(name), "none");
+            } else {
+                snprintf(name, sizeof(name), "%llu", (unsigned long long) plan->ost_index[u]);
+                secs = dplan_secs(plan->ost_bytes[u], ost_bw);
+            }
+            MFU_LOG(MFU_LOG_INFO, "%8s %6d %10llu %10.3lf %3s %10.3lf",
+                name, plan->ost_ranks[u], (unsigned long long) plan->ost_chunks[u],
+                tmp, units, secs);
+        }
+    }
+
+    mfu_free(&node_bytes);
+}
+
+/* parse a rate in bytes per second, returns 1 on error */
+static int dplan_parse_bw(const char* name, const char* str, uint64_t* bw)
+{
+    unsigned long long bytes;
+    if (mfu_abtoull(str, &bytes) != MFU_SUCCESS) {
+        MFU_LOG(MFU_LOG_ERR, "Failed to parse %s: '%s'", name, str);
+        return 1;
+    }
+    *bw = (uint64_t) bytes;
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    /* initialize MPI */
+    MPI_Init(&argc, &argv);
+    mfu_init();
+
+    /* get our rank and the size of comm_world */
+    int rank, ranks;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &ranks);
+
+    char* inputname = NULL;
+    int procs = ranks;
+    int nodes = 1;
+    uint64_t chunk_size    = MFU_CHUNK_SIZE;
+    uint64_t coalesce_size = MFU_COALESCE_SIZE;
+    uint64_t proc_bw = 1024ULL * 1024ULL * 1024ULL;
+    uint64_t node_bw = 0;
+    uint64_t ost_bw  = 1024ULL * 1024ULL * 1024ULL;
+    int print_procs = 0;
+    int print_osts  = 0;
+
+    int option_index = 0;
+    static struct option long_options[] = {
+        {"input",       1, 0, 'i'},
+        {"procs",       1, 0, 'n'},
+        {"nodes",       1, 0, 'N'},
+        {"chunksize",   1, 0, 'k'},
+        {"coalesce",    1, 0, 'C'},
+        {"layout",      1, 0, 'l'},
+        {"ost-count",   1, 0, 'O'},
+        {"ost-map",     1, 0, 'M'},
+        {"proc-bw",     1, 0, 'P'},
+        {"node-bw",     1, 0, 'B'},
+        {"ost-bw",      1, 0, 'W'},
+        {"print-procs", 0, 0, 'p'},
+        {"print-osts",  0, 0, 'o'},
+        {"verbose",     0, 0, 'v'},
+        {"quiet",       0, 0, 'q'},
+        {"help",        0, 0, 'h'},
+        {0, 0, 0, 0}
+    };
+
+    /* print the report by default */
+    mfu_debug_level = MFU_LOG_INFO;
+
+    int usage = 0;
+    while (1) {
+        int c = getopt_long(
+                    argc, argv, "i:n:N:k:povqh",
+                    long_options, &option_index
+                );
+
+        if (c == -1) {
+            break;
+        }
+
+        unsigned long long bytes;
+        switch (c) {
+            case 'i':
+                mfu_free(&inputname);
+                inputname = MFU_STRDUP(optarg);
+                break;
+            case 'n':
+                procs = atoi(optarg);
+                if (procs < 1) {
+                    if (rank == 0) {
+                        MFU_LOG(MFU_LOG_ERR, "Number of processes must be positive: '%s'", optarg);
+                    }
+                    usage = 1;
+                }
+                break;
+            case 'N':
+                nodes = atoi(optarg);
+                if (nodes < 1) {
+                    if (rank == 0) {
+                        MFU_LOG(MFU_LOG_ERR, "Number of nodes must be positive: '%s'", optarg);
+                    }
+                    usage = 1;
+                }
+                break;
+            case 'k':
+                if (mfu_abtoull(optarg, &bytes) != MFU_SUCCESS || bytes == 0) {
+                    if (rank == 0) {
+                        MFU_LOG(MFU_LOG_ERR, "Failed to parse chunk size: '%s'", optarg);
+                    }
+                    usage = 1;
+                } else {
+                    chunk_size = (uint64_t) bytes;
+                }
+                break;
+            case 'C':
+                if (mfu_abtoull(optarg, &bytes) != MFU_SUCCESS) {
+                    if (rank == 0) {
+                        MFU_LOG(MFU_LOG_ERR, "Failed to parse coalesce size: '%s'", optarg);
+                    }
+                    usage = 1;
+                } else {
+                    coalesce_size = (uint64_t) bytes;
+                }
+                break;
+            case 'l':
+                /* the planner reads these settings from the environment */
+                setenv("MFU_LAYOUT", optarg, 1);
+                break;
+            case 'O':
+                setenv("MFU_OST_COUNT", optarg, 1);
+                break;
+            case 'M':
+                setenv("MFU_OST_MAP", optarg, 1);
+                break;
+            case 'P':
+                usage |= dplan_parse_bw("process bandwidth", optarg, &proc_bw);
+                if (proc_bw == 0) {
+                    if (rank == 0) {
+                        MFU_LOG(MFU_LOG_ERR, "Process bandwidth must be positive: '%s'", optarg);
+                    }
+                    usage = 1;
+                }
+                break;
+            case 'B':
+                usage |= dplan_parse_bw("node bandwidth", optarg, &node_bw);
+                break;
+            case 'W':
+                usage |= dplan_parse_bw("OST bandwidth", optarg, &ost_bw);
+                break;
+            case 'p':
+                print_procs = 1;
+                break;
+            case 'o':
+                print_osts = 1;
+                break;
+            case 'v':
+                mfu_debug_level = MFU_LOG_VERBOSE;
+                break;
+            case 'q':
+                mfu_debug_level = MFU_LOG_NONE;
+                break;
+            case 'h':
+                usage = 1;
+                break;
+            case '?':
+                usage = 1;
+                break;
+            default:
+                if (rank == 0) {
+                    printf("?? getopt returned character code 0%o ??\n", c);
+                }
+        }
+    }
+
+    /* we need a list to plan */
+    if (inputname == NULL || optind != argc) {
+        usage = 1;
+    }
+
+    /* print usage if we need to */
+    if (usage) {
+        if (rank == 0) {
+            print_usage();
+        }
+        mfu_free(&inputname);
+        mfu_finalize();
+        MPI_Finalize();
+        return 1;
+    }
+
+    /* read the list */
+    mfu_flist flist = mfu_flist_new();
+    mfu_flist_read_cache(inputname, flist);
+
+    /* plan chunks and report the outcome */
+    mfu_file_chunk_plan* plan = mfu_file_chunk_list_plan(flist,
+        chunk_size, coalesce_size, procs, nodes);
+    if (rank == 0) {
+        dplan_report(plan, proc_bw, node_bw, ost_bw, print_procs, print_osts);
+    }
+    mfu_file_chunk_plan_free(&plan);
+
+    mfu_flist_free(&flist);
+    mfu_free(&inputname);
+
+    /* shut down MPI */
+    mfu_finalize();
+    MPI_Finalize();
+
+    return 0;
+}
@@ -63,6 +63,10 @@ static void print_usage(void)
     printf("  -b  --batch-files <N>   - batch files into groups of N during copy\n");
     printf("      --bufsize <SIZE>    - IO buffer size in bytes (default " MFU_BUFFER_SIZE_STR ")\n");
     printf("      --chunksize <SIZE>  - minimum work size per task in bytes (default " MFU_CHUNK_SIZE_STR ")\n");
+    printf("      --coalesce <SIZE>   - combine stripes on one object into chunks of up to SIZE bytes, 0 disables (default " MFU_COALESCE_SIZE_STR ")\n");
+    printf("      --mirror-layout     - stripe each destination file like its source and schedule by OST pair (Lustre)\n");
+    printf("      --fd-cache <N>      - number of open files to cache per process (default " MFU_FD_CACHE_SIZE_STR ")\n");
+    printf("      --io-threads <N>    - number of I/O threads per process to copy data (default 1)\n");
     printf("  -X, --xattrs <OPT>      - copy xattrs (none, all, non-lustre, libattr)\n");
 #ifdef DAOS_SUPPORT
     printf("      --daos-api          - DAOS API in {DFS, DAOS} (default uses DFS for POSIX containers)\n");
@@ -75,6 +79,9 @@ static void print_usage(void)
     printf("      --open-noatime      - open files with O_NOATIME\n");
     printf("      --link-dest <DIR>   - hardlink to files in DIR when unchanged\n");
     printf("  -S, --sparse            - create sparse files when possible\n");
+    printf("      --pipeline          - overlap reads and writes using a helper I/O thread\n");
+    printf("      --copy-offload      - copy in the kernel with reflink or copy_file_range when possible\n");
+    printf("      --steal             - processes that finish early take chunks from busy processes\n");
     printf("      --progress <N>      - print progress every N seconds\n");
     printf("  -v, --verbose           - verbose output\n");
     printf("  -q, --quiet             - quiet output\n");
@@ -3022,6 +3029,10 @@ int main(int argc, char **argv)
         {"batch-files",    1, 0, 'b'},
         {"bufsize",        1, 0, 'B'},
         {"chunksize",      1, 0, 'k'},
+        {"coalesce",       1, 0, 'C'},
+        {"mirror-layout",  0, 0, 'M'},
+        {"fd-cache",       1, 0, 'F'},
+        {"io-threads",     1, 0, 'T'},
         {"xattrs",         1, 0, 'X'},
         {"daos-api",       1, 0, 'y'},
         {"contents",       0, 0, 'c'},
@@ -3034,6 +3045,9 @@ int main(int argc, char **argv)
         {"debug",          0, 0, 'd'}, // undocumented
         {"link-dest",      1, 0, 'l'},
         {"sparse",         0, 0, 'S'},
+        {"pipeline",       0, 0, 'W'},
+        {"copy-offload",   0, 0, 'O'},
+        {"steal",          0, 0, 'K'},
         {"progress",       1, 0, 'R'},
         {"verbose",        0, 0, 'v'},
         {"quiet",          0, 0, 'q'},
@@ -3087,6 +3101,43 @@ int main(int argc, char **argv)
                 copy_opts->chunk_size = bytes;
             }
             break;
+        case 'C':
+            if (mfu_abtoull(optarg, &bytes) != MFU_SUCCESS) {
+                if (rank == 0) {
+                    MFU_LOG(MFU_LOG_ERR,
+                            "Failed to parse coalesce size: '%s'", optarg);
+                }
+                usage = 1;
+            } else {
+                copy_opts->coalesce_size = (uint64_t) bytes;
+            }
+            break;
+        case 'M':
+            copy_opts->mirror_layout = true;
+            if (rank == 0) {
+                MFU_LOG(MFU_LOG_INFO, "Mirroring source layouts onto destination files");
+            }
+            break;
+        case 'F':
+            copy_opts->fd_cache_size = atoi(optarg);
+            if (copy_opts->fd_cache_size < 1) {
+                if (rank == 0) {
+                    MFU_LOG(MFU_LOG_ERR,
+                            "File cache size must be positive: '%s'", optarg);
+                }
+                usage = 1;
+            }
+            break;
+        case 'T':
+            copy_opts->io_threads = atoi(optarg);
+            if (copy_opts->io_threads < 1) {
+                if (rank == 0) {
+                    MFU_LOG(MFU_LOG_ERR,
+                            "Number of I/O threads must be positive: '%s'", optarg);
+                }
+                usage = 1;
+            }
+            break;
         case 'X':
             copy_opts->copy_xattrs = parse_copy_xattrs_option(optarg);
             if (copy_opts->copy_xattrs == XATTR_COPY_INVAL) {
@@ -3153,6 +3204,15 @@ int main(int argc, char **argv)
         case 'S':
             copy_opts->sparse = 1;
             break;
+        case 'W':
+            copy_opts->pipeline = true;
+            break;
+        case 'O':
+            copy_opts->copy_offload = true;
+            break;
+        case 'K':
+            copy_opts->steal = true;
+            break;
         case 'R':
             mfu_progress_timeout = atoi(optarg);
             break;
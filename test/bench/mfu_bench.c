@@ -0,0 +1,636 @@
+/* Micro-benchmarks of core libmfu data structures on synthetic data.
+ *
+ * Each rank builds a list of files that exist only in memory, and each
+ * benchmark times one operation over that list, such as inserting
+ * items, packing them, sorting the list, or assigning chunks of the
+ * files to ranks with layouts read from a mock layout file.  Nothing
+ * touches the file system except the mock layout files, which are
+ * written to TMPDIR (or /tmp).
+ *
+ * A benchmark runs its operation several times.  Ranks start each run
+ * together after a barrier, and the time of a run is that of the
+ * slowest rank.  Rank 0 prints one comma-separated line per benchmark:
+ *
+ *   bench,procs,items,reps,min_secs,median_secs,max_secs,items_per_sec
+ *
+ * where items counts the items processed by all ranks in one run and
+ * items_per_sec is computed from the fastest run.  Lines starting with
+ * '#' are comments.
+ *
+ * Build with -DENABLE_BENCHMARKS=ON and run with, e.g.,
+ *
+ *   mpirun -np 4 test/bench/mfu-bench -n 100000 -r 5
+ *
+ * or "make bench", which runs it on MFU_BENCH_PROCS processes. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include "mpi.h"
+#include "mfu.h"
+#include "mfu_flist_internal.h"
+#include "strmap.h"
+
+/* number of files in each synthetic directory */
+#define BENCH_DIR_FILES (100)
+
+/* stripe size and number of OSTs in mock layouts */
+#define BENCH_STRIPE_SIZE (1024 * 1024)
+#define BENCH_OSTS (16)
+
+static int bench_rank  = 0;
+static int bench_ranks = 1;
+static uint64_t bench_items = 100000; /* items per rank */
+static int bench_reps = 5;            /* runs of each benchmark */
+static const char* bench_filter = NULL;
+
+/* sink for values read in benchmarks so the compiler keeps the reads */
+static volatile uint64_t bench_sink = 0;
+
+static void print_usage(void)
+{
+    printf("\n");
+    printf("Usage: mfu-bench [options]\n");
+    printf("\n");
+    printf("Options:\n");
+    printf("  -n, --items <N>   - number of items per process (default 100000)\n");
+    printf("  -r, --reps <N>    - number of runs of each benchmark (default 5)\n");
+    printf("  -b, --bench <STR> - only run benchmarks whose name contains STR\n");
+    printf("  -h, --help        - print usage\n");
+    printf("\n");
+    fflush(stdout);
+}
+
+/* return 1 if the named benchmark should run */
+static int bench_enabled(const char* name)
+{
+    return (bench_filter == NULL || strstr(name, bench_filter) != NULL);
+}
+
+/* sort times in increasing order */
+static int bench_time_cmp(const void* a, const void* b)
+{
+    double x = *(const double*) a;
+    double y = *(const double*) b;
+    return (x < y) ? -1 : (x > y);
+}
+
+/* start a run of a benchmark, returns the start time */
+static double bench_start(void)
+{
+    MPI_Barrier(MPI_COMM_WORLD);
+    return MPI_Wtime();
+}
+
+/* record the time of run rep that started at start on this rank */
+static void bench_stop(double* secs, int rep, double start)
+{
+    secs[rep] = MPI_Wtime() - start;
+}
+
+/* combine the times of all ranks and print a line for a benchmark
+ * that processed items items per rank in each run */
+static void bench_report(const char* name, uint64_t items, double* secs)
+{
+    double* max_secs = (double*) MFU_MALLOC((size_t)bench_reps * sizeof(double));
+    MPI_Reduce(secs, max_secs, bench_reps, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+
+    uint64_t all_items;
+    MPI_Reduce(&items, &all_items, 1, MPI_UINT64_T, MPI_SUM, 0, MPI_COMM_WORLD);
+
+    if (bench_rank == 0) {
+        qsort(max_secs, (size_t)bench_reps, sizeof(double), bench_time_cmp);
+        double min    = max_secs[0];
+        double median = max_secs[bench_reps / 2];
+        double max    = max_secs[bench_reps - 1];
+        double rate   = (min > 0.0) ? (double) all_items / min : 0.0;
+        printf("%s,%d,%llu,%d,%.6f,%.6f,%.6f,%.1f\n",
+            name, bench_ranks, (unsigned long long) all_items, bench_reps,
+            min, median, max, rate);
+        fflush(stdout);
+    }
+
+    mfu_free(&max_secs);
+}
+
+/* name of item i of the synthetic list of this rank */
+static void bench_name(char* buf, size_t size, int rank, uint64_t i)
+{
+    snprintf(buf, size, "/bench/r%d/d%llu/file_%llu.dat", rank,
+        (unsigned long long) (i / BENCH_DIR_FILES), (unsigned long long) i);
+}
+
+/* size of item i, from 1 to 8 stripes */
+static uint64_t bench_size(uint64_t i)
+{
+    return (uint64_t) ((i * 7) % 8 + 1) * BENCH_STRIPE_SIZE - (i % 1000);
+}
+
+/* add count synthetic files with stat details to list */
+static void bench_fill(mfu_flist list, int rank, uint64_t count)
+{
+    mfu_flist_set_detail(list, 1);
+
+    char name[256];
+    struct stat st;
+    memset(&st, 0, sizeof(st));
+    st.st_mode = S_IFREG | 0644;
+    st.st_uid  = 1000;
+    st.st_gid  = 1000;
+
+    uint64_t i;
+    for (i = 0; i < count; i++) {
+        bench_name(name, sizeof(name), rank, i);
+        st.st_size  = (off_t) bench_size(i);
+        st.st_atime = (time_t) (1600000000 + i);
+        st.st_mtime = (time_t) (1600000000 + (i * 7919) % 100000);
+        st.st_ctime = st.st_mtime;
+        mfu_flist_insert_stat((flist_t*) list, name, st.st_mode, &st);
+    }
+}
+
+/* build a synthetic list with count files on this rank */
+static mfu_flist bench_list(uint64_t count)
+{
+    mfu_flist list = mfu_flist_new();
+    bench_fill(list, bench_rank, count);
+    mfu_flist_summarize(list);
+    return list;
+}
+
+static void bench_flist_insert_stat(double* secs)
+{
+    int rep;
+    for (rep = 0; rep < bench_reps; rep++) {
+        mfu_flist list = mfu_flist_new();
+        double start = bench_start();
+        bench_fill(list, bench_rank, bench_items);
+        bench_stop(secs, rep, start);
+        mfu_flist_free(&list);
+    }
+    bench_report("flist_insert_stat", bench_items, secs);
+}
+
+static void bench_flist_get(double* secs)
+{
+    mfu_flist list = bench_list(bench_items);
+    uint64_t size = mfu_flist_size(list);
+
+    int rep;
+    for (rep = 0; rep < bench_reps; rep++) {
+        uint64_t sum = 0;
+        double start = bench_start();
+        uint64_t idx;
+        for (idx = 0; idx < size; idx++) {
+            const char* name = mfu_flist_file_get_name(list, idx);
+            sum += (uint64_t) name[0];
+            sum += (uint64_t) mfu_flist_file_get_type(list, idx);
+            sum += mfu_flist_file_get_mode(list, idx);
+            sum += mfu_flist_file_get_uid(list, idx);
+            sum += mfu_flist_file_get_size(list, idx);
+            sum += mfu_flist_file_get_mtime(list, idx);
+        }
+        bench_stop(secs, rep, start);
+        bench_sink += sum;
+    }
+    bench_report("flist_file_get", size, secs);
+
+    mfu_flist_free(&list);
+}
+
+static void bench_flist_pack(double* secs_pack, double* secs_unpack)
+{
+    mfu_flist list = bench_list(bench_items);
+    uint64_t size = mfu_flist_size(list);
+
+    /* pack every item into one buffer, as when sending a list */
+    size_t pack_size = mfu_flist_file_pack_size(list);
+    char* buf = (char*) MFU_MALLOC((size_t)size * pack_size + 1);
+
+    int rep;
+    for (rep = 0; rep < bench_reps; rep++) {
+        double start = bench_start();
+        char* ptr = buf;
+        uint64_t idx;
+        for (idx = 0; idx < size; idx++) {
+            ptr += mfu_flist_file_pack(ptr, list, idx);
+        }
+        bench_stop(secs_pack, rep, start);
+
+        mfu_flist unpacked = mfu_flist_subset(list);
+        start = bench_start();
+        ptr = buf;
+        for (idx = 0; idx < size; idx++) {
+            ptr += mfu_flist_file_unpack(ptr, unpacked);
+        }
+        bench_stop(secs_unpack, rep, start);
+        mfu_flist_free(&unpacked);
+    }
+    bench_report("flist_file_pack", size, secs_pack);
+    bench_report("flist_file_unpack", size, secs_unpack);
+
+    mfu_free(&buf);
+    mfu_flist_free(&list);
+}
+
+/* send each item to the rank after the one holding it */
+static int bench_map_next(mfu_flist flist, uint64_t index, int ranks, const void* args)
+{
+    int rank = *(const int*) args;
+    return (rank + 1 + (int) (index % 2)) % ranks;
+}
+
+static void bench_flist_remap(double* secs)
+{
+    mfu_flist list = bench_list(bench_items);
+    uint64_t size = mfu_flist_size(list);
+
+    int rep;
+    for (rep = 0; rep < bench_reps; rep++) {
+        double start = bench_start();
+        mfu_flist remapped = mfu_flist_remap(list, bench_map_next, &bench_rank);
+        bench_stop(secs, rep, start);
+        mfu_flist_free(&remapped);
+    }
+    bench_report("flist_remap", size, secs);
+
+    mfu_flist_free(&list);
+}
+
+static void bench_flist_spread(double* secs)
+{
+    /* rank 0 holds the items of all ranks */
+    uint64_t count = (bench_rank == 0) ? bench_items * (uint64_t)bench_ranks : 0;
+    mfu_flist list = bench_list(count);
+    uint64_t size = mfu_flist_size(list);
+
+    int rep;
+    for (rep = 0; rep < bench_reps; rep++) {
+        double start = bench_start();
+        mfu_flist spread = mfu_flist_spread(list);
+        bench_stop(secs, rep, start);
+        mfu_flist_free(&spread);
+    }
+    bench_report("flist_spread", size, secs);
+
+    mfu_flist_free(&list);
+}
+
+static void bench_flist_sort(const char* name, const char* fields, double* secs)
+{
+    mfu_flist list = bench_list(bench_items);
+    uint64_t size = mfu_flist_size(list);
+
+    int rep;
+    for (rep = 0; rep < bench_reps; rep++) {
+        double start = bench_start();
+        mfu_flist sorted = mfu_flist_sort(fields, list);
+        bench_stop(secs, rep, start);
+        mfu_flist_free(&sorted);
+    }
+    bench_report(name, size, secs);
+
+    mfu_flist_free(&list);
+}
+
+static void bench_strmap(double* secs_set, double* secs_get)
+{
+    /* build keys and values ahead of time */
+    char** keys = (char**) MFU_MALLOC((size_t)bench_items * sizeof(char*) + 1);
+    char** vals = (char**) MFU_MALLOC((size_t)bench_items * sizeof(char*) + 1);
+    char buf[256];
+    uint64_t i;
+    for (i = 0; i < bench_items; i++) {
+        bench_name(buf, sizeof(buf), bench_rank, i);
+        keys[i] = MFU_STRDUP(buf);
+        snprintf(buf, sizeof(buf), "%llu", (unsigned long long) bench_size(i));
+        vals[i] = MFU_STRDUP(buf);
+    }
+
+    int rep;
+    for (rep = 0; rep < bench_reps; rep++) {
+        strmap* map = strmap_new();
+        double start = bench_start();
+        for (i = 0; i < bench_items; i++) {
+            strmap_set(map, keys[i], vals[i]);
+        }
+        bench_stop(secs_set, rep, start);
+
+        uint64_t sum = 0;
+        start = bench_start();
+        for (i = 0; i < bench_items; i++) {
+            const char* val = strmap_get(map, keys[i]);
+            sum += (uint64_t) val[0];
+        }
+        bench_stop(secs_get, rep, start);
+        bench_sink += sum;
+
+        strmap_delete(&map);
+    }
+    bench_report("strmap_set", bench_items, secs_set);
+    bench_report("strmap_get", bench_items, secs_get);
+
+    for (i = 0; i < bench_items; i++) {
+        mfu_free(&keys[i]);
+        mfu_free(&vals[i]);
+    }
+    mfu_free(&keys);
+    mfu_free(&vals);
+}
+
+static void bench_path(double* secs)
+{
+    mfu_flist list = bench_list(bench_items);
+    uint64_t size = mfu_flist_size(list);
+    mfu_path* base = mfu_path_from_str("/bench");
+
+    /* parse, edit, and print each name, and compute its path
+     * relative to the top of the synthetic tree */
+    int rep;
+    for (rep = 0; rep < bench_reps; rep++) {
+        uint64_t sum = 0;
+        double start = bench_start();
+        uint64_t idx;
+        for (idx = 0; idx < size; idx++) {
+            const char* name = mfu_flist_file_get_name(list, idx);
+            mfu_path* path = mfu_path_from_str(name);
+            mfu_path_append_str(path, "../copy");
+            mfu_path_reduce(path);
+            mfu_path* rel = mfu_path_relative(base, path);
+            mfu_path_dirname(path);
+            char* str = mfu_path_strdup(path);
+            sum += (uint64_t) mfu_path_components(rel) + (uint64_t) str[0];
+            mfu_free(&str);
+            mfu_path_delete(&rel);
+            mfu_path_delete(&path);
+        }
+        bench_stop(secs, rep, start);
+        bench_sink += sum;
+    }
+    bench_report("path_ops", size, secs);
+
+    mfu_path_delete(&base);
+    mfu_flist_free(&list);
+}
+
+static void bench_copy_dest(double* secs)
+{
+    mfu_flist list = bench_list(bench_items);
+    uint64_t size = mfu_flist_size(list);
+
+    /* copy /bench into the directory /dest */
+    mfu_param_path src;
+    memset(&src, 0, sizeof(src));
+    src.orig = MFU_STRDUP("/bench");
+    src.path = MFU_STRDUP("/bench");
+
+    mfu_param_path dest;
+    memset(&dest, 0, sizeof(dest));
+    dest.orig = MFU_STRDUP("/dest");
+    dest.path = MFU_STRDUP("/dest");
+
+    mfu_copy_opts_t* copy_opts = mfu_copy_opts_new();
+    copy_opts->copy_into_dir = 1;
+    mfu_file_t* src_file = mfu_file_new();
+    mfu_file_t* dst_file = mfu_file_new();
+
+    int rep;
+    for (rep = 0; rep < bench_reps; rep++) {
+        uint64_t sum = 0;
+        double start = bench_start();
+        uint64_t idx;
+        for (idx = 0; idx < size; idx++) {
+            const char* name = mfu_flist_file_get_name(list, idx);
+            char* dest_name = mfu_param_path_copy_dest(name, 1, &src, &dest,
+                copy_opts, src_file, dst_file);
+            sum += (uint64_t) dest_name[0];
+            mfu_free(&dest_name);
+        }
+        bench_stop(secs, rep, start);
+        bench_sink += sum;
+    }
+    bench_report("param_path_copy_dest", size, secs);
+
+    mfu_file_delete(&dst_file);
+    mfu_file_delete(&src_file);
+    mfu_copy_opts_delete(&copy_opts);
+    mfu_free(&dest.orig);
+    mfu_free(&dest.path);
+    mfu_free(&src.orig);
+    mfu_free(&src.path);
+    mfu_flist_free(&list);
+}
+
+/* write a mock layout file describing the files in our list, striped
+ * over up to 4 of BENCH_OSTS OSTs, returns 0 on success */
+static int bench_write_layouts(const char* file, uint64_t count)
+{
+    FILE* fp = fopen(file, "w");
+    if (fp == NULL) {
+        return 1;
+    }
+
+    char name[256];
+    uint64_t i;
+    for (i = 0; i < count; i++) {
+        bench_name(name, sizeof(name), bench_rank, i);
+        uint64_t first = (i + (uint64_t)bench_rank * 5) % BENCH_OSTS;
+        uint64_t stripes = i % 4 + 1;
+        fprintf(fp, "%s 0 EOF %d", name, BENCH_STRIPE_SIZE);
+        uint64_t s;
+        for (s = 0; s < stripes; s++) {
+            fprintf(fp, "%c%llu", (s == 0) ? ' ' : ',',
+                (unsigned long long) ((first + s) % BENCH_OSTS));
+        }
+        fprintf(fp, "\n");
+    }
+
+    return (fclose(fp) != 0);
+}
+
+static void bench_chunk_list_alloc(double* secs)
+{
+    mfu_flist list = bench_list(bench_items);
+    uint64_t size = mfu_flist_size(list);
+
+    /* each rank reads the layouts of its own files from its own
+     * file, so the time to parse them does not grow with ranks */
+    const char* tmpdir = getenv("TMPDIR");
+    if (tmpdir == NULL || strcmp(tmpdir, "") == 0) {
+        tmpdir = "/tmp";
+    }
+    char file[1024];
+    snprintf(file, sizeof(file), "%s/mfu-bench.%d.%d.layout", tmpdir, (int) getpid(), bench_rank);
+    int rc = bench_write_layouts(file, size);
+
+    int all_rc;
+    MPI_Allreduce(&rc, &all_rc, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+    if (all_rc != 0) {
+        if (bench_rank == 0) {
+            printf("# chunk_list_alloc: failed to write layouts to %s\n", tmpdir);
+        }
+        unlink(file);
+        mfu_flist_free(&list);
+        return;
+    }
+
+    /* remember the provider the user asked for, if any */
+    char spec[1100];
+    snprintf(spec, sizeof(spec), "mock:%s", file);
+    char* saved = NULL;
+    if (getenv("MFU_LAYOUT") != NULL) {
+        saved = MFU_STRDUP(getenv("MFU_LAYOUT"));
+    }
+    setenv("MFU_LAYOUT", spec, 1);
+
+    uint64_t chunks = 0;
+    int rep;
+    for (rep = 0; rep < bench_reps; rep++) {
+        double start = bench_start();
+        mfu_file_chunk* head = mfu_file_chunk_list_alloc(list, MFU_CHUNK_SIZE);
+        bench_stop(secs, rep, start);
+        chunks = mfu_file_chunk_list_size(head);
+        mfu_file_chunk_list_free(&head);
+    }
+    bench_report("chunk_list_alloc", size, secs);
+
+    /* report the number of chunks made from the files */
+    uint64_t all_chunks;
+    MPI_Reduce(&chunks, &all_chunks, 1, MPI_UINT64_T, MPI_SUM, 0, MPI_COMM_WORLD);
+    if (bench_rank == 0) {
+        printf("# chunk_list_alloc: %llu chunks over %d OSTs\n",
+            (unsigned long long) all_chunks, BENCH_OSTS);
+    }
+
+    if (saved != NULL) {
+        setenv("MFU_LAYOUT", saved, 1);
+        mfu_free(&saved);
+    } else {
+        unsetenv("MFU_LAYOUT");
+    }
+    unlink(file);
+    mfu_flist_free(&list);
+}
+
+int main(int argc, char** argv)
+{
+    MPI_Init(&argc, &argv);
+    mfu_init();
+
+    MPI_Comm_rank(MPI_COMM_WORLD, &bench_rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &bench_ranks);
+
+    int option_index = 0;
+    static struct option long_options[] = {
+        {"items", 1, 0, 'n'},
+        {"reps",  1, 0, 'r'},
+        {"bench", 1, 0, 'b'},
+        {"help",  0, 0, 'h'},
+        {0, 0, 0, 0}
+    };
+
+    int usage = 0;
+    while (1) {
+        int c = getopt_long(
+                    argc, argv, "n:r:b:h",
+                    long_options, &option_index
+                );
+
+        if (c == -1) {
+            break;
+        }
+
+        unsigned long long val;
+        switch (c) {
+            case 'n':
+                if (mfu_abtoull(optarg, &val) != MFU_SUCCESS || val == 0) {
+                    usage = 1;
+                } else {
+                    bench_items = (uint64_t) val;
+                }
+                break;
+            case 'r':
+                bench_reps = atoi(optarg);
+                if (bench_reps < 1) {
+                    usage = 1;
+                }
+                break;
+            case 'b':
+                bench_filter = optarg;
+                break;
+            case 'h':
+            case '?':
+            default:
+                usage = 1;
+                break;
+        }
+    }
+
+    if (usage || optind != argc) {
+        if (bench_rank == 0) {
+            print_usage();
+        }
+        mfu_finalize();
+        MPI_Finalize();
+        return 1;
+    }
+
+    /* keep library messages out of the results */
+    mfu_debug_level = MFU_LOG_ERR;
+
+    double* secs  = (double*) MFU_MALLOC((size_t)bench_reps * sizeof(double));
+    double* secs2 = (double*) MFU_MALLOC((size_t)bench_reps * sizeof(double));
+
+    if (bench_rank == 0) {
+        printf("# bench,procs,items,reps,min_secs,median_secs,max_secs,items_per_sec\n");
+        fflush(stdout);
+    }
+
+    if (bench_enabled("flist_insert_stat")) {
+        bench_flist_insert_stat(secs);
+    }
+    if (bench_enabled("flist_file_get")) {
+        bench_flist_get(secs);
+    }
+    if (bench_enabled("flist_file_pack") || bench_enabled("flist_file_unpack")) {
+        bench_flist_pack(secs, secs2);
+    }
+    if (bench_enabled("flist_remap")) {
+        bench_flist_remap(secs);
+    }
+    if (bench_enabled("flist_spread")) {
+        bench_flist_spread(secs);
+    }
+    if (bench_enabled("flist_sort_name")) {
+        bench_flist_sort("flist_sort_name", "name", secs);
+    }
+    if (bench_enabled("flist_sort_size")) {
+        bench_flist_sort("flist_sort_size", "-size", secs);
+    }
+    if (bench_enabled("strmap_set") || bench_enabled("strmap_get")) {
+        bench_strmap(secs, secs2);
+    }
+    if (bench_enabled("path_ops")) {
+        bench_path(secs);
+    }
+    if (bench_enabled("param_path_copy_dest")) {
+        bench_copy_dest(secs);
+    }
+    if (bench_enabled("chunk_list_alloc")) {
+        bench_chunk_list_alloc(secs);
+    }
+
+    mfu_free(&secs2);
+    mfu_free(&secs);
+
+    mfu_finalize();
+    MPI_Finalize();
+
+    return 0;
+}
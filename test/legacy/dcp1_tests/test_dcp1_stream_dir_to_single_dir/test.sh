@@ -0,0 +1,130 @@
+#!/bin/bash
+
+##############################################################################
+# Description:
+#
+#   A test to check if dcp1 --stream will copy a single directory and many
+#   directories to a single directory, with batches small enough that the
+#   walk of each batch overlaps the copy of the one before it.
+#
+# Expected behavior:
+#
+#   The source directories and everything below them should be copied to
+#   the destination directory.
+#
+# Reminder:
+#
+#   Lines that echo to the terminal will only be available if DEBUG is enabled
+#   in the test runner (test_all.sh).
+##############################################################################
+
+# Turn on verbose output
+#set -x
+
+# Print out the basic paths we'll be using.
+echo "Using dcp1 binary at: $DCP_TEST_BIN"
+echo "Using tmp directory at: $DCP_TEST_TMP"
+
+##############################################################################
+# Generate the paths for:
+#   * Three source directories, A has two levels of subdirectories.
+#   * Two destination directories.
+#   * Files which contain random data.
+PATH_A_DIRECTORY="$DCP_TEST_TMP/dcp1_test_stream_dir_to_single_dir.$RANDOM.tmp"
+PATH_B_DIRECTORY="$DCP_TEST_TMP/dcp1_test_stream_dir_to_single_dir.$RANDOM.tmp"
+PATH_C_DIRECTORY="$DCP_TEST_TMP/dcp1_test_stream_dir_to_single_dir.$RANDOM.tmp"
+PATH_D_DIRECTORY="$DCP_TEST_TMP/dcp1_test_stream_dir_to_single_dir.$RANDOM.tmp"
+PATH_E_DIRECTORY="$DCP_TEST_TMP/dcp1_test_stream_dir_to_single_dir.$RANDOM.tmp"
+PATH_F_RANDOM="$PATH_B_DIRECTORY/dcp1_test_stream_dir_to_single_dir.$RANDOM.tmp"
+PATH_G_RANDOM="$PATH_C_DIRECTORY/dcp1_test_stream_dir_to_single_dir.$RANDOM.tmp"
+
+# Print out the generated paths to make debugging easier.
+echo "A_DIRECTORY path at: $PATH_A_DIRECTORY"
+echo "B_DIRECTORY path at: $PATH_B_DIRECTORY"
+echo "C_DIRECTORY path at: $PATH_C_DIRECTORY"
+echo "D_DIRECTORY path at: $PATH_D_DIRECTORY"
+echo "E_DIRECTORY path at: $PATH_E_DIRECTORY"
+echo "F_RANDOM    path at: $PATH_F_RANDOM"
+echo "G_RANDOM    path at: $PATH_G_RANDOM"
+
+# Create the directories.
+mkdir $PATH_A_DIRECTORY
+mkdir $PATH_B_DIRECTORY
+mkdir $PATH_C_DIRECTORY
+mkdir $PATH_D_DIRECTORY
+mkdir $PATH_E_DIRECTORY
+
+# Create the random files, A gets a small tree so the walk takes
+# several batches.
+for i in 1 2 3; do
+    mkdir $PATH_A_DIRECTORY/dir$i
+    for j in 1 2 3; do
+        mkdir $PATH_A_DIRECTORY/dir$i/dir$j
+        for k in 1 2 3; do
+            dd if=/dev/urandom of=$PATH_A_DIRECTORY/dir$i/dir$j/file$k bs=64K count=$k
+        done
+    done
+    dd if=/dev/urandom of=$PATH_A_DIRECTORY/file$i bs=1M count=$i
+done
+dd if=/dev/urandom of=$PATH_F_RANDOM bs=3M count=3
+dd if=/dev/urandom of=$PATH_G_RANDOM bs=3M count=2
+
+##############################################################################
+# Test copying a directory to a directory. The result should be the directory
+# placed inside the directory.
+
+mpirun -n 3 $DCP_TEST_BIN --stream --batch-files 4 $PATH_A_DIRECTORY $PATH_D_DIRECTORY
+if [[ $? -ne 0 ]]; then
+    echo "Error returned when streaming a directory to a directory (A -> D)."
+    exit 1;
+fi
+
+for SRC in $(cd $PATH_A_DIRECTORY && find . -type f); do
+    $DCP_CMP_BIN "$PATH_D_DIRECTORY/$(basename $PATH_A_DIRECTORY)/$SRC" "$PATH_A_DIRECTORY/$SRC"
+    if [[ $? -ne 0 ]]; then
+        echo "CMP mismatch when streaming a directory to a directory (A -> D/A/$SRC)."
+        exit 1
+    fi
+done
+
+SRC_COUNT=$(cd $PATH_A_DIRECTORY && find . | wc -l)
+DST_COUNT=$(cd $PATH_D_DIRECTORY/$(basename $PATH_A_DIRECTORY) && find . | wc -l)
+if [[ $SRC_COUNT -ne $DST_COUNT ]]; then
+    echo "Item count mismatch when streaming a directory to a directory ($SRC_COUNT != $DST_COUNT)."
+    exit 1
+fi
+
+##############################################################################
+# Test copying several directories to a directory. The result should be the
+# directories placed inside the directory.
+
+mpirun -n 3 $DCP_TEST_BIN --stream --batch-files 2 $PATH_A_DIRECTORY $PATH_B_DIRECTORY $PATH_C_DIRECTORY $PATH_E_DIRECTORY
+if [[ $? -ne 0 ]]; then
+    echo "Error returned when streaming several directories to a directory (A,B,C -> E)."
+    exit 1;
+fi
+
+$DCP_CMP_BIN "$PATH_E_DIRECTORY/$(basename $PATH_A_DIRECTORY)/dir3/dir3/file3" "$PATH_A_DIRECTORY/dir3/dir3/file3"
+if [[ $? -ne 0 ]]; then
+    echo "CMP mismatch when streaming several directories to a directory (A -> E/A)."
+    exit 1
+fi
+
+$DCP_CMP_BIN "$PATH_E_DIRECTORY/$(basename $PATH_B_DIRECTORY)/$(basename $PATH_F_RANDOM)" $PATH_F_RANDOM
+if [[ $? -ne 0 ]]; then
+    echo "CMP mismatch when streaming several directories to a directory (B -> E/B/F)."
+    exit 1
+fi
+
+$DCP_CMP_BIN "$PATH_E_DIRECTORY/$(basename $PATH_C_DIRECTORY)/$(basename $PATH_G_RANDOM)" $PATH_G_RANDOM
+if [[ $? -ne 0 ]]; then
+    echo "CMP mismatch when streaming several directories to a directory (C -> E/C/G)."
+    exit 1
+fi
+
+##############################################################################
+# Since we didn't find any problems, exit with success.
+
+exit 0
+
+# EOF
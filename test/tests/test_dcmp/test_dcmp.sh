@@ -420,3 +420,29 @@ test_10()
 }
 
 run_test 10 "Same, extras and diff comparison"
+
+test_11()
+{
+	# a tree deep enough that names are built from several components
+	for d in a b c; do
+		mkdir -p $TEST_SRC/$tdir/$d/sub/subsub
+		mkdir -p $TEST_DST/$tdir/$d/sub/subsub
+		for i in 0 1 2 3 4 5 6 7 8 9; do
+			echo "$d $i" > $TEST_SRC/$tdir/$d/sub/subsub/$tfile.$i
+			echo "$d $i" > $TEST_DST/$tdir/$d/sub/subsub/$tfile.$i
+		done
+	done
+
+	# same size, different contents
+	echo "b X" > $TEST_DST/$tdir/b/sub/subsub/$tfile.7
+
+	MFU_FLIST_COMPRESS=1 $DCMP $TEST_DST $TEST_SRC -o CONTENT=DIFFER:$OUTPUT_FILE
+	in_flist $OUTPUT_FILE $TEST_SRC/$tdir/b/sub/subsub/$tfile.7 \
+		|| error "$TEST_SRC/$tdir/b/sub/subsub/$tfile.7 is not printed"
+	in_flist $OUTPUT_FILE $TEST_SRC/$tdir/b/sub/subsub/$tfile.6 \
+		&& error "$TEST_SRC/$tdir/b/sub/subsub/$tfile.6 is printed"
+	in_flist $OUTPUT_FILE $TEST_SRC/$tdir/c/sub/subsub/$tfile.7 \
+		&& error "$TEST_SRC/$tdir/c/sub/subsub/$tfile.7 is printed"
+	return 0
+}
+run_test 11 "check CONTENT = DIFFER with compressed names"
@@ -0,0 +1,86 @@
+#!/bin/bash
+
+##############################################################################
+# Description:
+#
+#   A test to check that dcp copies files correctly with each order of
+#   chunks selected by MFU_CHUNK_ORDER.  Stripes are spread over several
+#   OSTs with the mock layout provider, so the OST order has more than one
+#   OST to rotate through on any file system.
+#
+##############################################################################
+
+# Turn on verbose output
+#set -x
+
+DCP_TEST_BIN=${DCP_TEST_BIN:-${1}}
+DCP_MPIRUN_BIN=${DCP_MPIRUN_BIN:-${2}}
+DCP_CMP_BIN=${DCP_CMP_BIN:-${3}}
+DCP_SRC_DIR=${DCP_SRC_DIR:-${4}}
+DCP_DEST_DIR=${DCP_DEST_DIR:-${5}}
+DCP_TMP_FILE=${DCP_TMP_FILE:-${6}}
+
+echo "Using dcp binary at: $DCP_TEST_BIN"
+echo "Using mpirun binary at: $DCP_MPIRUN_BIN"
+echo "Using cmp binary at: $DCP_CMP_BIN"
+echo "Using src directory at: $DCP_SRC_DIR"
+echo "Using dest directory at: $DCP_DEST_DIR"
+
+# layouts are looked up by absolute path
+SRC_BASE=`cd $DCP_SRC_DIR && pwd`/$DCP_TMP_FILE
+LAYOUT_FILE=$DCP_DEST_DIR/$DCP_TMP_FILE.layout
+
+function cleanup {
+	rm -f $SRC_BASE.1 $SRC_BASE.2 $SRC_BASE.3
+	rm -f $DCP_DEST_DIR/$DCP_TMP_FILE.1 $DCP_DEST_DIR/$DCP_TMP_FILE.2 $DCP_DEST_DIR/$DCP_TMP_FILE.3
+	rm -f $LAYOUT_FILE
+}
+
+function test_order {
+	MFU_CHUNK_ORDER=$1 MFU_LAYOUT=mock:$LAYOUT_FILE $DCP_MPIRUN_BIN -np 4 $DCP_TEST_BIN -k 1MB $SRC_BASE.1 $SRC_BASE.2 $SRC_BASE.3 $DCP_DEST_DIR
+	if [[ $? -ne 0 ]]; then
+		echo "Failed to run cmd: MFU_CHUNK_ORDER=$1 MFU_LAYOUT=mock:$LAYOUT_FILE $DCP_MPIRUN_BIN -np 4 $DCP_TEST_BIN -k 1MB $SRC_BASE.1 $SRC_BASE.2 $SRC_BASE.3 $DCP_DEST_DIR"
+		cleanup
+		exit 1
+	fi
+
+	for i in 1 2 3; do
+		$DCP_CMP_BIN $SRC_BASE.$i $DCP_DEST_DIR/$DCP_TMP_FILE.$i
+		if [[ $? -ne 0 ]]; then
+			echo "CMP mismatch: $SRC_BASE.$i $DCP_DEST_DIR/$DCP_TMP_FILE.$i with MFU_CHUNK_ORDER=$1"
+			cleanup
+			exit 1
+		fi
+	done
+
+	rm -f $DCP_DEST_DIR/$DCP_TMP_FILE.1 $DCP_DEST_DIR/$DCP_TMP_FILE.2 $DCP_DEST_DIR/$DCP_TMP_FILE.3
+}
+
+cleanup
+
+# Create source files of different sizes that do not end on a chunk boundary.
+dd if=/dev/urandom of=$SRC_BASE.1 bs=1M count=23
+dd if=/dev/urandom of=$SRC_BASE.1 bs=1 count=999 seek=24117248 conv=notrunc
+dd if=/dev/urandom of=$SRC_BASE.2 bs=1M count=7
+dd if=/dev/urandom of=$SRC_BASE.3 bs=1M count=2
+
+cat > $LAYOUT_FILE <<LAYOUT
+$SRC_BASE.1 0 EOF 1048576 0,1,2,3,4,5
+$SRC_BASE.2 0 EOF 2097152 4,2
+$SRC_BASE.3 0 EOF 1048576 1
+LAYOUT
+
+echo "Subtest 1, chunks in the order they arrive."
+test_order ARRIVAL
+
+echo "Subtest 2, chunks in order of file and offset."
+test_order FILE
+
+echo "Subtest 3, chunks in turn from each OST."
+test_order OST
+
+echo "Subtest 4, largest chunks first."
+test_order LARGEST
+
+cleanup
+exit 0
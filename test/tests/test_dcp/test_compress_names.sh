@@ -0,0 +1,92 @@
+#!/bin/bash
+
+##############################################################################
+# Description:
+#
+#   A test to check that dcp copies a tree correctly when file lists store
+#   names by directory and basename with MFU_FLIST_COMPRESS=1.  The tree
+#   has many items in deep directories, so names are built from several
+#   components while more names than the per-thread name cache holds are
+#   in use.
+#
+##############################################################################
+
+# Turn on verbose output
+#set -x
+
+DCP_TEST_BIN=${DCP_TEST_BIN:-${1}}
+DCP_MPIRUN_BIN=${DCP_MPIRUN_BIN:-${2}}
+DCP_CMP_BIN=${DCP_CMP_BIN:-${3}}
+DCP_SRC_DIR=${DCP_SRC_DIR:-${4}}
+DCP_DEST_DIR=${DCP_DEST_DIR:-${5}}
+DCP_TMP_FILE=${DCP_TMP_FILE:-${6}}
+
+echo "Using dcp binary at: $DCP_TEST_BIN"
+echo "Using mpirun binary at: $DCP_MPIRUN_BIN"
+echo "Using cmp binary at: $DCP_CMP_BIN"
+echo "Using src directory at: $DCP_SRC_DIR"
+echo "Using dest directory at: $DCP_DEST_DIR"
+
+SRC_TREE=$DCP_SRC_DIR/$DCP_TMP_FILE
+DEST_TREE=$DCP_DEST_DIR/$DCP_TMP_FILE
+
+function cleanup {
+	rm -rf $SRC_TREE
+	rm -rf $DEST_TREE
+}
+
+function test_compress {
+	MFU_FLIST_COMPRESS=1 $DCP_MPIRUN_BIN -np 3 $DCP_TEST_BIN -k 1MB $@ $SRC_TREE $DCP_DEST_DIR
+	if [[ $? -ne 0 ]]; then
+		echo "Failed to run cmd: MFU_FLIST_COMPRESS=1 $DCP_MPIRUN_BIN -np 3 $DCP_TEST_BIN -k 1MB $@ $SRC_TREE $DCP_DEST_DIR"
+		cleanup
+		exit 1
+	fi
+
+	# every file must match its source
+	for f in `cd $SRC_TREE && find . -type f`; do
+		$DCP_CMP_BIN $SRC_TREE/$f $DEST_TREE/$f
+		if [[ $? -ne 0 ]]; then
+			echo "CMP mismatch: $SRC_TREE/$f $DEST_TREE/$f with MFU_FLIST_COMPRESS=1 $@"
+			cleanup
+			exit 1
+		fi
+	done
+
+	# and the trees must hold the same items
+	SRC_ITEMS=`cd $SRC_TREE && find . | sort`
+	DEST_ITEMS=`cd $DEST_TREE && find . | sort`
+	if [[ "$SRC_ITEMS" != "$DEST_ITEMS" ]]; then
+		echo "Items of $SRC_TREE and $DEST_TREE differ with MFU_FLIST_COMPRESS=1 $@"
+		cleanup
+		exit 1
+	fi
+
+	rm -rf $DEST_TREE
+}
+
+cleanup
+
+# Create a tree of several levels with small files, links, and a file
+# of several chunks.
+for a in 0 1 2; do
+	for b in 0 1 2 3; do
+		DIR=$SRC_TREE/level_one_$a/level_two_$b/level_three
+		mkdir -p $DIR
+		for c in 0 1 2 3 4 5 6 7 8 9; do
+			echo "$a $b $c" > $DIR/file_$c
+		done
+		ln -s file_0 $DIR/link_0
+	done
+done
+dd if=/dev/urandom of=$SRC_TREE/level_one_1/level_two_2/large bs=1M count=5
+dd if=/dev/urandom of=$SRC_TREE/level_one_1/level_two_2/large bs=1 count=333 seek=5242880 conv=notrunc
+
+echo "Subtest 1, copy a tree with compressed names."
+test_compress
+
+echo "Subtest 2, copy a tree with compressed names and preserve attributes."
+test_compress -p
+
+cleanup
+exit 0
@@ -0,0 +1,17 @@
+#!/usr/bin/env python2
+import subprocess
+
+# change paths here for bash script as necessary
+mpifu_path     = "~/mpifileutils/test/tests/test_dcp/test_io_threads.sh"
+
+# vars in bash script
+dcp_test_bin   = "/root/mpifileutils/install/bin/dcp"
+dcp_mpirun_bin = "mpirun"
+dcp_cmp_bin    = "cmp"
+dcp_src_dir    = "/tmp"
+dcp_dest_dir   = "/tmp/dest"
+dcp_tmp_file   = "file_test_io_threads_XXX"
+
+def test_io_threads():
+        p = subprocess.Popen(["%s %s %s %s %s %s %s" % (mpifu_path, dcp_test_bin, dcp_mpirun_bin,
+          dcp_cmp_bin, dcp_src_dir, dcp_dest_dir, dcp_tmp_file)], shell=True, executable="/bin/bash").communicate()
@@ -0,0 +1,87 @@
+#!/bin/bash
+
+##############################################################################
+# Description:
+#
+#   A test to check dcp --io-threads.  Files of several chunks are copied
+#   with several threads per process and compared.  Then a file that
+#   reads back shorter than its size is copied, and dcp must report the
+#   failed chunk with a non-zero exit code.
+#
+##############################################################################
+
+# Turn on verbose output
+#set -x
+
+DCP_TEST_BIN=${DCP_TEST_BIN:-${1}}
+DCP_MPIRUN_BIN=${DCP_MPIRUN_BIN:-${2}}
+DCP_CMP_BIN=${DCP_CMP_BIN:-${3}}
+DCP_SRC_DIR=${DCP_SRC_DIR:-${4}}
+DCP_DEST_DIR=${DCP_DEST_DIR:-${5}}
+DCP_TMP_FILE=${DCP_TMP_FILE:-${6}}
+
+echo "Using dcp binary at: $DCP_TEST_BIN"
+echo "Using mpirun binary at: $DCP_MPIRUN_BIN"
+echo "Using cmp binary at: $DCP_CMP_BIN"
+echo "Using src directory at: $DCP_SRC_DIR"
+echo "Using dest directory at: $DCP_DEST_DIR"
+
+SRC_FILE1=$DCP_SRC_DIR/$DCP_TMP_FILE.1
+SRC_FILE2=$DCP_SRC_DIR/$DCP_TMP_FILE.2
+DEST_FILE1=$DCP_DEST_DIR/$DCP_TMP_FILE.1
+DEST_FILE2=$DCP_DEST_DIR/$DCP_TMP_FILE.2
+
+# sysfs files report a size of a page, but read back only a few bytes
+SHORT_FILE=/sys/devices/system/cpu/online
+SHORT_DEST=$DCP_DEST_DIR/online
+
+function cleanup {
+	rm -f $SRC_FILE1 $SRC_FILE2
+	rm -f $DEST_FILE1 $DEST_FILE2 $SHORT_DEST
+}
+
+function test_io_threads {
+	$DCP_MPIRUN_BIN -np 3 $DCP_TEST_BIN --io-threads $1 -k 1MB $SRC_FILE1 $SRC_FILE2 $DCP_DEST_DIR
+	if [[ $? -ne 0 ]]; then
+		echo "Failed to run cmd: $DCP_MPIRUN_BIN -np 3 $DCP_TEST_BIN --io-threads $1 -k 1MB $SRC_FILE1 $SRC_FILE2 $DCP_DEST_DIR"
+		cleanup
+		exit 1
+	fi
+
+	for i in 1 2; do
+		$DCP_CMP_BIN $DCP_SRC_DIR/$DCP_TMP_FILE.$i $DCP_DEST_DIR/$DCP_TMP_FILE.$i
+		if [[ $? -ne 0 ]]; then
+			echo "CMP mismatch: $DCP_SRC_DIR/$DCP_TMP_FILE.$i $DCP_DEST_DIR/$DCP_TMP_FILE.$i with --io-threads $1"
+			cleanup
+			exit 1
+		fi
+	done
+
+	rm -f $DEST_FILE1 $DEST_FILE2
+}
+
+cleanup
+
+# Create source files that do not end on a chunk boundary.
+dd if=/dev/urandom of=$SRC_FILE1 bs=1M count=13
+dd if=/dev/urandom of=$SRC_FILE1 bs=1 count=777 seek=13631488 conv=notrunc
+dd if=/dev/urandom of=$SRC_FILE2 bs=1M count=4
+
+echo "Subtest 1, two I/O threads."
+test_io_threads 2
+
+echo "Subtest 2, more I/O threads than chunks per process."
+test_io_threads 8
+
+if [[ -r $SHORT_FILE ]]; then
+	echo "Subtest 3, failed chunk with I/O threads."
+	$DCP_MPIRUN_BIN -np 2 $DCP_TEST_BIN --io-threads 2 $SHORT_FILE $DCP_DEST_DIR
+	if [[ $? -eq 0 ]]; then
+		echo "Expected dcp to fail to copy $SHORT_FILE"
+		cleanup
+		exit 1
+	fi
+fi
+
+cleanup
+exit 0
@@ -0,0 +1,123 @@
+#!/bin/bash
+
+##############################################################################
+# Description:
+#
+#   A test to check that dcp copies files correctly when chunks are
+#   scheduled from stripe layouts.  Layouts are described with the mock
+#   and xattr layout providers, so this runs on any file system.
+#
+##############################################################################
+
+# Turn on verbose output
+#set -x
+
+DCP_TEST_BIN=${DCP_TEST_BIN:-${1}}
+DCP_MPIRUN_BIN=${DCP_MPIRUN_BIN:-${2}}
+DCP_CMP_BIN=${DCP_CMP_BIN:-${3}}
+DCP_SRC_DIR=${DCP_SRC_DIR:-${4}}
+DCP_DEST_DIR=${DCP_DEST_DIR:-${5}}
+DCP_TMP_FILE=${DCP_TMP_FILE:-${6}}
+
+echo "Using dcp binary at: $DCP_TEST_BIN"
+echo "Using mpirun binary at: $DCP_MPIRUN_BIN"
+echo "Using cmp binary at: $DCP_CMP_BIN"
+echo "Using src directory at: $DCP_SRC_DIR"
+echo "Using dest directory at: $DCP_DEST_DIR"
+
+# layouts are looked up by absolute path
+SRC_FILE=`cd $DCP_SRC_DIR && pwd`/$DCP_TMP_FILE
+DEST_FILE=$DCP_DEST_DIR/$DCP_TMP_FILE
+LAYOUT_FILE=$DCP_DEST_DIR/$DCP_TMP_FILE.layout
+
+function cleanup {
+	rm -f $SRC_FILE
+	rm -f $DEST_FILE
+	rm -f $LAYOUT_FILE
+}
+
+function test_layout {
+	MFU_LAYOUT=$1 $DCP_MPIRUN_BIN -np 4 $DCP_TEST_BIN -k 1MB $SRC_FILE $DCP_DEST_DIR
+	if [[ $? -ne 0 ]]; then
+		echo "Failed to run cmd: MFU_LAYOUT=$1 $DCP_MPIRUN_BIN -np 4 $DCP_TEST_BIN -k 1MB $SRC_FILE $DCP_DEST_DIR"
+		cleanup
+		exit 1
+	fi
+
+	$DCP_CMP_BIN $SRC_FILE $DEST_FILE
+	if [[ $? -ne 0 ]]; then
+		echo "CMP mismatch: $SRC_FILE $DEST_FILE with MFU_LAYOUT=$1"
+		cleanup
+		exit 1
+	fi
+
+	rm -f $DEST_FILE
+}
+
+cleanup
+
+# Create a source file that does not end on a stripe or chunk boundary.
+dd if=/dev/urandom of=$SRC_FILE bs=1M count=37
+dd if=/dev/urandom of=$SRC_FILE bs=1 count=12345 seek=38797312 conv=notrunc
+
+echo "Subtest 1, plain layout."
+test_layout plain
+
+echo "Subtest 2, mock layout with stripe size smaller than chunk size."
+echo "$SRC_FILE 0 EOF 65536 0,1,2,3,4,5,6" > $LAYOUT_FILE
+test_layout mock:$LAYOUT_FILE
+
+echo "Subtest 3, mock layout with several components."
+cat > $LAYOUT_FILE <<LAYOUT
+# first component on a single OST
+$SRC_FILE 0 1048576 1048576 3
+$SRC_FILE 1048576 8388608 3145728 0,2
+$SRC_FILE 8388608 EOF 4194304 1,5,7,11,13
+LAYOUT
+test_layout mock:$LAYOUT_FILE
+
+echo "Subtest 4, layouts queried by several threads."
+MFU_LAYOUT_THREADS=3 test_layout mock:$LAYOUT_FILE
+
+echo "Subtest 5, file below the size at which layouts are queried."
+MFU_LAYOUT_MIN_SIZE=1GB test_layout mock:$LAYOUT_FILE
+MFU_LAYOUT_MIN_SIZE=1GB MFU_LAYOUT=mock:$LAYOUT_FILE $DCP_MPIRUN_BIN -np 4 $DCP_TEST_BIN -k 1MB $SRC_FILE $DCP_DEST_DIR 2>&1 | grep -q "(0 queried)"
+if [[ $? -ne 0 ]]; then
+	echo "Layout queried for file smaller than MFU_LAYOUT_MIN_SIZE"
+	cleanup
+	exit 1
+fi
+rm -f $DEST_FILE
+
+echo "Subtest 6, mock layout with OST indices too large to schedule."
+echo "$SRC_FILE 0 EOF 1048576 0,4000000000,18446744073709551614,2" > $LAYOUT_FILE
+test_layout mock:$LAYOUT_FILE
+MFU_OST_COUNT=4000000000 MFU_LAYOUT=mock:$LAYOUT_FILE $DCP_MPIRUN_BIN -np 4 $DCP_TEST_BIN -k 1MB $SRC_FILE $DCP_DEST_DIR 2>&1 | grep -q "Ignoring 2 stripes"
+if [[ $? -ne 0 ]]; then
+	echo "No warning for OST indices above the limit"
+	cleanup
+	exit 1
+fi
+$DCP_CMP_BIN $SRC_FILE $DEST_FILE
+if [[ $? -ne 0 ]]; then
+	echo "CMP mismatch: $SRC_FILE $DEST_FILE with MFU_OST_COUNT=4000000000"
+	cleanup
+	exit 1
+fi
+rm -f $DEST_FILE
+
+echo "Subtest 7, layout in extended attribute."
+setfattr -n user.mfu.layout -v "0 4194304 1048576 0,1;4194304 EOF 2097152 2,3,4" $SRC_FILE
+if [[ $? -ne 0 ]]; then
+	echo "Source filesystem $DCP_SRC_DIR does not support user xattrs, skip testing"
+else
+	test_layout xattr
+
+	echo "Subtest 8, layout that can't be used is treated as a single object."
+	setfattr -n user.mfu.layout -v "0 EOF 0 1" $SRC_FILE
+	test_layout xattr
+fi
+
+cleanup
+
+exit 0
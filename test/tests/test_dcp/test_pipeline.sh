@@ -0,0 +1,74 @@
+#!/bin/bash
+
+##############################################################################
+# Description:
+#
+#   A test to check dcp --pipeline.  Files of several chunks are copied
+#   and compared, then a write error is forced by limiting the file size
+#   each process may write, and dcp must exit with an error.
+#
+##############################################################################
+
+# Turn on verbose output
+#set -x
+
+DCP_TEST_BIN=${DCP_TEST_BIN:-${1}}
+DCP_MPIRUN_BIN=${DCP_MPIRUN_BIN:-${2}}
+DCP_CMP_BIN=${DCP_CMP_BIN:-${3}}
+DCP_SRC_DIR=${DCP_SRC_DIR:-${4}}
+DCP_DEST_DIR=${DCP_DEST_DIR:-${5}}
+DCP_TMP_FILE=${DCP_TMP_FILE:-${6}}
+
+echo "Using dcp binary at: $DCP_TEST_BIN"
+echo "Using mpirun binary at: $DCP_MPIRUN_BIN"
+echo "Using cmp binary at: $DCP_CMP_BIN"
+echo "Using src directory at: $DCP_SRC_DIR"
+echo "Using dest directory at: $DCP_DEST_DIR"
+
+SRC_FILE1=$DCP_SRC_DIR/$DCP_TMP_FILE.1
+SRC_FILE2=$DCP_SRC_DIR/$DCP_TMP_FILE.2
+DEST_FILE1=$DCP_DEST_DIR/$DCP_TMP_FILE.1
+DEST_FILE2=$DCP_DEST_DIR/$DCP_TMP_FILE.2
+
+function cleanup {
+	rm -f $SRC_FILE1 $SRC_FILE2
+	rm -f $DEST_FILE1 $DEST_FILE2
+}
+
+cleanup
+
+# Create source files that do not end on a buffer or chunk boundary.
+dd if=/dev/urandom of=$SRC_FILE1 bs=1M count=9
+dd if=/dev/urandom of=$SRC_FILE1 bs=1 count=4321 seek=9437184 conv=notrunc
+dd if=/dev/urandom of=$SRC_FILE2 bs=1M count=5
+
+echo "Subtest 1, pipelined copy of several chunks per file."
+$DCP_MPIRUN_BIN -np 3 $DCP_TEST_BIN --pipeline -k 2MB -b 256KB $SRC_FILE1 $SRC_FILE2 $DCP_DEST_DIR
+if [[ $? -ne 0 ]]; then
+	echo "Failed to run cmd: $DCP_MPIRUN_BIN -np 3 $DCP_TEST_BIN --pipeline -k 2MB -b 256KB $SRC_FILE1 $SRC_FILE2 $DCP_DEST_DIR"
+	cleanup
+	exit 1
+fi
+
+for i in 1 2; do
+	$DCP_CMP_BIN $DCP_SRC_DIR/$DCP_TMP_FILE.$i $DCP_DEST_DIR/$DCP_TMP_FILE.$i
+	if [[ $? -ne 0 ]]; then
+		echo "CMP mismatch: $DCP_SRC_DIR/$DCP_TMP_FILE.$i $DCP_DEST_DIR/$DCP_TMP_FILE.$i"
+		cleanup
+		exit 1
+	fi
+done
+rm -f $DEST_FILE1 $DEST_FILE2
+
+echo "Subtest 2, write error in a pipelined copy."
+# each process may only write files up to 4MB, ignoring SIGXFSZ
+# makes writes past the limit fail with EFBIG instead
+$DCP_MPIRUN_BIN -np 2 bash -c "trap '' XFSZ; ulimit -f 4096; exec $DCP_TEST_BIN --pipeline $SRC_FILE1 $DCP_DEST_DIR"
+if [[ $? -eq 0 ]]; then
+	echo "Expected dcp to fail when writes to $DEST_FILE1 fail"
+	cleanup
+	exit 1
+fi
+
+cleanup
+exit 0
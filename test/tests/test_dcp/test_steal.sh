@@ -0,0 +1,92 @@
+#!/bin/bash
+
+##############################################################################
+# Description:
+#
+#   A test to check dcp --steal.  Files of many chunks are copied by
+#   several processes that take chunks from each other and compared.
+#   A layout that puts all stripes of the largest file on one OST leaves
+#   most processes idle early, so they have chunks to take.
+#
+##############################################################################
+
+# Turn on verbose output
+#set -x
+
+DCP_TEST_BIN=${DCP_TEST_BIN:-${1}}
+DCP_MPIRUN_BIN=${DCP_MPIRUN_BIN:-${2}}
+DCP_CMP_BIN=${DCP_CMP_BIN:-${3}}
+DCP_SRC_DIR=${DCP_SRC_DIR:-${4}}
+DCP_DEST_DIR=${DCP_DEST_DIR:-${5}}
+DCP_TMP_FILE=${DCP_TMP_FILE:-${6}}
+
+echo "Using dcp binary at: $DCP_TEST_BIN"
+echo "Using mpirun binary at: $DCP_MPIRUN_BIN"
+echo "Using cmp binary at: $DCP_CMP_BIN"
+echo "Using src directory at: $DCP_SRC_DIR"
+echo "Using dest directory at: $DCP_DEST_DIR"
+
+# layouts are looked up by absolute path
+SRC_BASE=`cd $DCP_SRC_DIR && pwd`/$DCP_TMP_FILE
+LAYOUT_FILE=$DCP_DEST_DIR/$DCP_TMP_FILE.layout
+LOG_FILE=$DCP_DEST_DIR/$DCP_TMP_FILE.log
+
+function cleanup {
+	rm -f $SRC_BASE.1 $SRC_BASE.2
+	rm -f $DCP_DEST_DIR/$DCP_TMP_FILE.1 $DCP_DEST_DIR/$DCP_TMP_FILE.2
+	rm -f $LAYOUT_FILE $LOG_FILE
+}
+
+# run dcp with the given options, compare the copies, and
+# check that the number of stolen chunks is reported
+function test_steal {
+	$DCP_MPIRUN_BIN -np 4 $DCP_TEST_BIN --steal -k 1MB $@ $SRC_BASE.1 $SRC_BASE.2 $DCP_DEST_DIR > $LOG_FILE 2>&1
+	if [[ $? -ne 0 ]]; then
+		cat $LOG_FILE
+		echo "Failed to run cmd: $DCP_MPIRUN_BIN -np 4 $DCP_TEST_BIN --steal -k 1MB $@ $SRC_BASE.1 $SRC_BASE.2 $DCP_DEST_DIR"
+		cleanup
+		exit 1
+	fi
+
+	grep -q "Stole [0-9]* chunks" $LOG_FILE
+	if [[ $? -ne 0 ]]; then
+		cat $LOG_FILE
+		echo "No report of stolen chunks with --steal $@"
+		cleanup
+		exit 1
+	fi
+
+	for i in 1 2; do
+		$DCP_CMP_BIN $SRC_BASE.$i $DCP_DEST_DIR/$DCP_TMP_FILE.$i
+		if [[ $? -ne 0 ]]; then
+			echo "CMP mismatch: $SRC_BASE.$i $DCP_DEST_DIR/$DCP_TMP_FILE.$i with --steal $@"
+			cleanup
+			exit 1
+		fi
+	done
+
+	rm -f $DCP_DEST_DIR/$DCP_TMP_FILE.1 $DCP_DEST_DIR/$DCP_TMP_FILE.2
+}
+
+cleanup
+
+# Create source files that do not end on a chunk boundary.
+dd if=/dev/urandom of=$SRC_BASE.1 bs=1M count=31
+dd if=/dev/urandom of=$SRC_BASE.1 bs=1 count=2021 seek=32505856 conv=notrunc
+dd if=/dev/urandom of=$SRC_BASE.2 bs=1M count=3
+
+echo "Subtest 1, steal chunks of a plain layout."
+test_steal
+
+echo "Subtest 2, steal chunks from the processes of a busy OST."
+cat > $LAYOUT_FILE <<LAYOUT
+$SRC_BASE.1 0 EOF 1048576 0
+$SRC_BASE.2 0 EOF 1048576 1,2,3
+LAYOUT
+MFU_OST_COUNT=4 MFU_LAYOUT=mock:$LAYOUT_FILE test_steal
+
+echo "Subtest 3, steal chunks with pipelined writes."
+test_steal --pipeline -b 256KB
+
+cleanup
+exit 0
@@ -0,0 +1,5 @@
+#!/usr/bin/env python2
+from subprocess import call
+
+def test_dcp1_stream_dir_to_single_dir():
+        rc = call("~/mpifileutils/test/legacy/dcp1_tests/test_dcp1_stream_dir_to_single_dir/test.sh", shell=True)
@@ -0,0 +1,15 @@
+#!/usr/bin/env python2
+import subprocess
+
+# change paths here for bash script as necessary
+mpifu_path       = "~/mpifileutils/test/tests/test_dwalk/test_cache.sh"
+
+# vars in bash script
+dwalk_test_bin   = "/root/mpifileutils/install/bin/dwalk"
+dwalk_mpirun_bin = "mpirun"
+dwalk_src_dir    = "/tmp"
+dwalk_tmp_dir    = "/tmp"
+
+def test_cache():
+        p = subprocess.Popen(["%s %s %s %s %s" % (mpifu_path, dwalk_test_bin, dwalk_mpirun_bin,
+          dwalk_src_dir, dwalk_tmp_dir)], shell=True, executable="/bin/bash").communicate()
@@ -0,0 +1,100 @@
+#!/bin/bash
+
+##############################################################################
+# Description:
+#
+#   A test to check that a list written by dwalk --output reads back the
+#   same with dwalk --input, for each cache file version: version 4 by
+#   default, version 5 with MFU_CACHE_MAP=1, and version 6 with
+#   MFU_CACHE_COMPRESS (which falls back to version 4 without zstd).
+#   Each file is read with a different number of ranks than wrote it.
+#
+##############################################################################
+
+# Turn on verbose output
+#set -x
+
+DWALK_TEST_BIN=${DWALK_TEST_BIN:-${1}}
+DWALK_MPIRUN_BIN=${DWALK_MPIRUN_BIN:-${2}}
+DWALK_SRC_DIR=${DWALK_SRC_DIR:-${3}}
+DWALK_TMP_DIR=${DWALK_TMP_DIR:-${4}}
+
+echo "Using dwalk binary at: $DWALK_TEST_BIN"
+echo "Using mpirun binary at: $DWALK_MPIRUN_BIN"
+echo "Using src directory at: $DWALK_SRC_DIR"
+echo "Using tmp directory at: $DWALK_TMP_DIR"
+
+TREE=$DWALK_SRC_DIR/dwalk_test_cache.$$
+CACHE_FILE=$DWALK_TMP_DIR/dwalk_test_cache.$$.mfu
+WALK_TEXT=$DWALK_TMP_DIR/dwalk_test_cache.$$.walk
+READ_TEXT=$DWALK_TMP_DIR/dwalk_test_cache.$$.read
+
+function cleanup {
+	rm -rf $TREE
+	rm -f $CACHE_FILE $WALK_TEXT $WALK_TEXT.sorted $READ_TEXT $READ_TEXT.sorted
+}
+
+# write a cache file of the tree with the given environment,
+# then read it back with several process counts and compare
+# the listing to that of the walk
+function test_cache {
+	env $1 $DWALK_MPIRUN_BIN -np 3 $DWALK_TEST_BIN --output $CACHE_FILE $TREE
+	if [[ $? -ne 0 ]]; then
+		echo "Failed to run cmd: $1 $DWALK_MPIRUN_BIN -np 3 $DWALK_TEST_BIN --output $CACHE_FILE $TREE"
+		cleanup
+		exit 1
+	fi
+
+	for NP in 1 2 4; do
+		$DWALK_MPIRUN_BIN -np $NP $DWALK_TEST_BIN --input $CACHE_FILE --text --output $READ_TEXT
+		if [[ $? -ne 0 ]]; then
+			echo "Failed to read cache file written with $1 on $NP ranks"
+			cleanup
+			exit 1
+		fi
+
+		sort $READ_TEXT > $READ_TEXT.sorted
+		cmp $WALK_TEXT.sorted $READ_TEXT.sorted
+		if [[ $? -ne 0 ]]; then
+			echo "Listing mismatch: cache file written with $1, read on $NP ranks"
+			cleanup
+			exit 1
+		fi
+	done
+
+	rm -f $CACHE_FILE
+}
+
+cleanup
+
+# Create a tree with files, links, and directories at a few depths,
+# with names of different lengths.
+mkdir -p $TREE/a/b/c $TREE/d
+for i in 1 2 3 4 5; do
+	dd if=/dev/urandom of=$TREE/a/file$i bs=1K count=$i
+	dd if=/dev/urandom of=$TREE/a/b/c/a_longer_file_name_$i bs=1 count=$i
+	touch $TREE/d/empty$i
+done
+ln -s a/file1 $TREE/link
+chmod 750 $TREE/a/b
+touch -d "2001-02-03 04:05:06" $TREE/a/b/c
+
+$DWALK_MPIRUN_BIN -np 3 $DWALK_TEST_BIN --text --output $WALK_TEXT $TREE
+if [[ $? -ne 0 ]]; then
+	echo "Failed to run cmd: $DWALK_MPIRUN_BIN -np 3 $DWALK_TEST_BIN --text --output $WALK_TEXT $TREE"
+	cleanup
+	exit 1
+fi
+sort $WALK_TEXT > $WALK_TEXT.sorted
+
+echo "Subtest 1, version 4."
+test_cache MFU_CACHE_MAP=0
+
+echo "Subtest 2, version 5."
+test_cache MFU_CACHE_MAP=1
+
+echo "Subtest 3, version 6."
+test_cache MFU_CACHE_COMPRESS=3
+
+cleanup
+exit 0